@@ -1031,6 +1031,42 @@ dm35425_get_interrupt_info(struct dm35425_device_descriptor *dm35425_device,
 
 
 
+/******************************************************************************
+Send the number of queued interrupts back to user, leaving the queue untouched.
+This is cheap enough to be called in a busy-poll loop.
+ ******************************************************************************/
+static int
+dm35425_get_interrupt_pending(struct dm35425_device_descriptor *dm35425_device,
+			      unsigned long ioctl_param)
+{
+	unsigned long irq_flags;
+	union dm35425_ioctl_argument ioctl_arg;
+
+	memset(&ioctl_arg, 0, sizeof(union dm35425_ioctl_argument));
+
+	spin_lock_irqsave(&(dm35425_device->device_lock), irq_flags);
+
+	ioctl_arg.interrupt.interrupts_remaining = dm35425_device->int_queue_count;
+
+	spin_unlock_irqrestore(&(dm35425_device->device_lock), irq_flags);
+
+	ioctl_arg.interrupt.valid_interrupt =
+		(ioctl_arg.interrupt.interrupts_remaining > 0);
+
+	/*
+	 * Copy the interrupt status back to user space
+	 */
+	if (copy_to_user((union dm35425_ioctl_argument *) ioctl_param,
+			 &ioctl_arg,
+			 sizeof(union dm35425_ioctl_argument))) {
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+
+
 /******************************************************************************
 Read from DMA (Copy DMA buffer to user space)
  ******************************************************************************/
@@ -1394,6 +1430,10 @@ static long dm35425_ioctl(struct file *file,
 		result = dm35425_get_interrupt_info(dm35425_device, ioctl_param);
 		break;
 
+	case DM35425_IOCTL_INTERRUPT_PENDING:
+		result = dm35425_get_interrupt_pending(dm35425_device, ioctl_param);
+		break;
+
 	case DM35425_IOCTL_DMA_FUNCTION:
 		result = dm35425_dma_function(dm35425_device, ioctl_param);
 		break;
@@ -0,0 +1,920 @@
+/**
+    @file
+
+    @brief
+        Fast conversion of recordings to text, in columns.
+
+    @verbatim
+
+        This program converts recording files written by
+        dm35425_adc_multiboard_dma --record or dm35425_adc_continuous_dma
+        --binary to text, one line per sample position of a board:
+
+            position   channel   channel   ...
+
+        where the position counts the board's samples since the ISR was
+        installed, so gaps show where frames were dropped.  The values are
+        raw ADC codes, or volts with --volts.  Columns are separated by
+        tabs, after a header line starting with '#' so gnuplot skips it,
+        or by commas after a plain header line with --csv.  Files given
+        one after the other are converted as one recording.
+
+        Each file is memory-mapped and cut into pieces of about a megabyte
+        of text, which worker threads format with table-driven number
+        conversion rather than printf while the main thread writes the
+        finished pieces in order.  A compressed file is decoded chunk by
+        chunk as it is converted, and each decoded chunk is released once
+        its last piece is written, so memory does not grow with the file.
+        A chunk that fails its checksum is left out with a warning, like a
+        dropped frame, and once the rest is converted the program reports
+        how many were skipped and exits with an error.
+
+        No board is needed to run this program.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "dm35425_adc_library.h"
+#include "dm35425_adc_recording.h"
+#include "dm35425_examples.h"
+#include "dm35425_util_library.h"
+
+/**
+ * Approximate size of the text of one piece of work, in bytes.
+ */
+#define UNIT_BYTES		(1 << 20)
+
+/**
+ * Pieces of work in flight per worker thread.
+ */
+#define SLOTS_PER_THREAD	4
+
+/**
+ * Longest position, in characters.
+ */
+#define POSITION_CHARS		20
+
+/**
+ * Longest value, raw code or volts, in characters.
+ */
+#define VALUE_CHARS		16
+
+/**
+ * Two ASCII digits of every number from 0 to 99.
+ */
+static const char digit_pairs[201] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+/**
+ * A piece of text being formatted or waiting to be written.
+ */
+struct slot {
+	/**
+	 * Formatted text.
+	 */
+	char *text;
+
+	/**
+	 * Bytes of text.
+	 */
+	size_t length;
+
+	/**
+	 * The piece of work the slot holds, or is free for.
+	 */
+	size_t unit;
+
+	/**
+	 * Whether the text is ready to be written.
+	 */
+	int ready;
+
+	/**
+	 * Whether the piece's chunk is corrupt, in which case it has no text.
+	 */
+	int corrupt;
+};
+
+/**
+ * State shared between the main thread and the worker threads.
+ */
+struct converter {
+	/**
+	 * The file being converted.
+	 */
+	DM35425_Recording_Map *map;
+
+	/**
+	 * Its index.
+	 */
+	const struct DM35425_Recording_Index_Entry *index;
+
+	/**
+	 * Board index.
+	 */
+	int board;
+
+	/**
+	 * Raw samples per chunk of board 0 and of the board.
+	 */
+	uint32_t board0_samples;
+	uint32_t frame_samples;
+
+	/**
+	 * Number of columns, and the board's channel index and input range of
+	 * each.
+	 */
+	int num_columns;
+	int columns[DM35425_NUM_ADC_DMA_CHANNELS];
+	enum DM35425_Input_Ranges ranges[DM35425_NUM_ADC_DMA_CHANNELS];
+
+	/**
+	 * Whether to print volts rather than raw codes.
+	 */
+	int volts;
+
+	/**
+	 * Column separator.
+	 */
+	char separator;
+
+	/**
+	 * Lines per piece of work, pieces per chunk and pieces in the file.
+	 */
+	size_t unit_rows;
+	size_t units_per_chunk;
+	size_t num_units;
+
+	/**
+	 * Next piece of work for a worker to take.
+	 */
+	size_t next_unit;
+
+	/**
+	 * Slots; piece n goes into slot n % num_slots.
+	 */
+	struct slot *slots;
+	int num_slots;
+
+	/**
+	 * errno of the first failure of a worker, 0 if none.
+	 */
+	int error;
+
+	/**
+	 * Protects the slots and the error.
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * Signalled when a slot is filled or freed, or a worker fails.
+	 */
+	pthread_cond_t cond;
+};
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS] FILE...\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--board NUM\n");
+	fprintf(stderr,
+		"\t\tBoard index in the recording.  Defaults to 0.\n");
+
+	fprintf(stderr, "\t--channel NUM\n");
+	fprintf(stderr,
+		"\t\tIndex into the board's recorded channels to print as a column.\n");
+	fprintf(stderr,
+		"\t\tMay be repeated.  Defaults to every channel in order.\n");
+
+	fprintf(stderr, "\t--volts\n");
+	fprintf(stderr, "\t\tPrint volts instead of raw ADC codes.\n");
+
+	fprintf(stderr, "\t--csv\n");
+	fprintf(stderr,
+		"\t\tSeparate columns with commas instead of tabs.\n");
+
+	fprintf(stderr, "\t--ofile FILE\n");
+	fprintf(stderr,
+		"\t\tWrite the text to FILE instead of standard output.\n");
+
+	fprintf(stderr, "\t--threads NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of worker threads.  Defaults to the number of CPUs.\n");
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse an integer option argument of at least a minimum, exiting through
+    usage() if it is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name, unsigned long minimum)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value < minimum) {
+		error(0, 0, "ERROR: %s must be an integer of at least %lu", name,
+		      minimum);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    Format an unsigned integer in decimal, two digits at a time.
+
+@param
+    text
+
+    Where to put the digits.
+
+@param
+    value
+
+    The number.
+
+@retval
+    The end of the digits.
+ *******************************************************************************
+*/
+
+static char *format_unsigned(char *text, uint64_t value)
+{
+	char digits[POSITION_CHARS];
+	char *first = digits + sizeof(digits);
+	size_t length;
+
+	while (value >= 100) {
+		first -= 2;
+		memcpy(first, &digit_pairs[2 * (value % 100)], 2);
+		value /= 100;
+	}
+	if (value >= 10) {
+		first -= 2;
+		memcpy(first, &digit_pairs[2 * value], 2);
+	} else {
+		*--first = (char) ('0' + value);
+	}
+
+	length = digits + sizeof(digits) - first;
+	memcpy(text, first, length);
+	return text + length;
+}
+
+/**
+*******************************************************************************
+@brief
+    Format a raw ADC code in decimal.
+ *******************************************************************************
+*/
+
+static char *format_code(char *text, int16_t code)
+{
+	int32_t value = code;
+
+	if (value < 0) {
+		*text++ = '-';
+		value = -value;
+	}
+	return format_unsigned(text, (uint64_t) value);
+}
+
+/**
+*******************************************************************************
+@brief
+    Format volts with six decimals, like printf("%.6f").
+ *******************************************************************************
+*/
+
+static char *format_volts(char *text, float volts)
+{
+	long long micro = llrint((double) volts * 1e6);
+	unsigned long fraction;
+
+	if (micro < 0) {
+		*text++ = '-';
+		micro = -micro;
+	}
+	text = format_unsigned(text, (uint64_t) micro / 1000000);
+	*text++ = '.';
+
+	fraction = (unsigned long) (micro % 1000000);
+	memcpy(text, &digit_pairs[2 * (fraction / 10000)], 2);
+	memcpy(text + 2, &digit_pairs[2 * (fraction / 100 % 100)], 2);
+	memcpy(text + 4, &digit_pairs[2 * (fraction % 100)], 2);
+	return text + 6;
+}
+
+/**
+*******************************************************************************
+@brief
+    Record the failure of a worker thread, for the main thread to report.
+ *******************************************************************************
+*/
+
+static void fail(struct converter *conv, int err)
+{
+	pthread_mutex_lock(&conv->lock);
+	if (conv->error == 0) {
+		conv->error = err;
+	}
+	pthread_cond_broadcast(&conv->cond);
+	pthread_mutex_unlock(&conv->lock);
+}
+
+/**
+*******************************************************************************
+@brief
+    Worker thread: take pieces of work in turn, and format each into its
+    slot once the main thread has written what the slot held before.
+
+@param
+    arg
+
+    The converter.
+
+@retval
+    NULL
+ *******************************************************************************
+*/
+
+static void *convert_units(void *arg)
+{
+	struct converter *conv = (struct converter *) arg;
+	const int16_t *raw[DM35425_NUM_ADC_DMA_CHANNELS];
+	struct DM35425_Recording_View view;
+	struct slot *slot;
+	int32_t *codes;
+	float *volts;
+	uint64_t position;
+	size_t unit, chunk, row, rows, i;
+	char *text;
+	int column, err;
+
+	codes = (int32_t *) malloc(conv->unit_rows * sizeof(int32_t));
+	volts = (float *) malloc(conv->num_columns * conv->unit_rows *
+				 sizeof(float));
+	if (codes == NULL || volts == NULL) {
+		fail(conv, ENOMEM);
+		goto done;
+	}
+
+	while (1) {
+		unit = __atomic_fetch_add(&conv->next_unit, 1,
+					  __ATOMIC_RELAXED);
+		if (unit >= conv->num_units) {
+			break;
+		}
+		slot = &conv->slots[unit % conv->num_slots];
+
+		pthread_mutex_lock(&conv->lock);
+		while (slot->unit != unit && conv->error == 0) {
+			pthread_cond_wait(&conv->cond, &conv->lock);
+		}
+		err = conv->error;
+		pthread_mutex_unlock(&conv->lock);
+		if (err != 0) {
+			break;
+		}
+
+		/*
+		 * Index positions are board 0's
+		 */
+		chunk = unit / conv->units_per_chunk;
+		row = unit % conv->units_per_chunk * conv->unit_rows;
+		rows = conv->frame_samples - row < conv->unit_rows ?
+		       conv->frame_samples - row : conv->unit_rows;
+		position = conv->index[chunk].first_sample /
+			   conv->board0_samples * conv->frame_samples + row;
+
+		text = slot->text;
+		slot->corrupt = 0;
+		for (column = 0; column < conv->num_columns; column++) {
+			if (DM35425_Recording_Map_View(conv->map, conv->board,
+						       conv->columns[column],
+						       position, false,
+						       &view) != 0) {
+				if (errno != EBADMSG) {
+					fail(conv, errno);
+					goto done;
+				}
+				slot->corrupt = 1;
+			} else if (view.count < rows) {
+				slot->corrupt = 1;
+			}
+			if (slot->corrupt) {
+				/*
+				 * Left out, and reported by the main thread
+				 */
+				rows = 0;
+				break;
+			}
+			raw[column] = view.raw;
+
+			if (conv->volts) {
+				for (i = 0; i < rows; i++) {
+					codes[i] = view.raw[i];
+				}
+				DM35425_Adc_Samples_To_Volts_Bulk(
+					conv->ranges[column], codes,
+					&volts[column * conv->unit_rows],
+					rows);
+			}
+		}
+
+		for (i = 0; i < rows; i++) {
+			text = format_unsigned(text, position + i);
+			for (column = 0; column < conv->num_columns; column++) {
+				*text++ = conv->separator;
+				if (conv->volts) {
+					text = format_volts(text,
+						volts[column * conv->unit_rows + i]);
+				} else {
+					text = format_code(text, raw[column][i]);
+				}
+			}
+			*text++ = '\n';
+		}
+
+		pthread_mutex_lock(&conv->lock);
+		slot->length = text - slot->text;
+		slot->ready = 1;
+		pthread_cond_broadcast(&conv->cond);
+		pthread_mutex_unlock(&conv->lock);
+	}
+
+done:
+	free(codes);
+	free(volts);
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    Write all of a buffer, exiting if that fails.
+ *******************************************************************************
+*/
+
+static void write_all(int fd, const char *text, size_t length)
+{
+	ssize_t written;
+
+	while (length > 0) {
+		written = write(fd, text, length);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			error(EXIT_FAILURE, errno, "ERROR: Could not write the text");
+		}
+		text += written;
+		length -= written;
+	}
+}
+
+/**
+*******************************************************************************
+@brief
+    Convert one mapped file with the worker threads, writing the pieces in
+    order as they are finished.
+
+@param
+    conv
+
+    The converter, with the map and layout of the file set.
+
+@param
+    file
+
+    File name, for messages.
+
+@param
+    num_threads
+
+    Number of worker threads.
+
+@param
+    fd
+
+    Where to write the text.
+
+@param
+    skipped
+
+    Returned number of corrupt chunks left out.
+
+@retval
+    Number of lines written.
+ *******************************************************************************
+*/
+
+static uint64_t convert_file(struct converter *conv, const char *file,
+			     int num_threads, int fd, size_t *skipped)
+{
+	pthread_t *threads;
+	struct slot *slot;
+	size_t num_chunks, unit, chunk;
+	uint64_t position;
+	int thread, err;
+
+	conv->index = DM35425_Recording_Get_Index(
+		DM35425_Recording_Map_Get_Recording(conv->map), &num_chunks);
+	conv->num_units = num_chunks * conv->units_per_chunk;
+	conv->next_unit = 0;
+	conv->error = 0;
+	for (unit = 0; unit < (size_t) conv->num_slots; unit++) {
+		conv->slots[unit].unit = unit;
+		conv->slots[unit].ready = 0;
+	}
+
+	DM35425_Recording_Map_Advise(conv->map,
+				     DM35425_RECORDING_ACCESS_SEQUENTIAL);
+
+	threads = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+	if (threads == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+	for (thread = 0; thread < num_threads; thread++) {
+		err = pthread_create(&threads[thread], NULL, convert_units,
+				     conv);
+		if (err != 0) {
+			error(EXIT_FAILURE, err,
+			      "ERROR: Could not start a worker thread");
+		}
+	}
+
+	for (unit = 0; unit < conv->num_units; unit++) {
+		slot = &conv->slots[unit % conv->num_slots];
+
+		pthread_mutex_lock(&conv->lock);
+		while (!slot->ready && conv->error == 0) {
+			pthread_cond_wait(&conv->cond, &conv->lock);
+		}
+		err = conv->error;
+		pthread_mutex_unlock(&conv->lock);
+		if (err != 0) {
+			error(EXIT_FAILURE, err, "ERROR: Could not convert %s",
+			      file);
+		}
+
+		/*
+		 * Every piece of a corrupt chunk is corrupt; report it at the first
+		 */
+		chunk = unit / conv->units_per_chunk;
+		if (slot->corrupt && unit % conv->units_per_chunk == 0) {
+			position = conv->index[chunk].first_sample /
+				   conv->board0_samples * conv->frame_samples;
+			error(0, 0,
+			      "WARNING: Skipped corrupt chunk %lu of %s, positions %lu to %lu",
+			      (unsigned long) chunk, file,
+			      (unsigned long) position,
+			      (unsigned long) (position + conv->frame_samples - 1));
+			(*skipped)++;
+		}
+
+		write_all(fd, slot->text, slot->length);
+
+		/*
+		 * Every piece of the chunk is formatted, so no worker views it
+		 */
+		if ((unit + 1) % conv->units_per_chunk == 0) {
+			DM35425_Recording_Map_Release(conv->map, chunk, 1);
+		}
+
+		pthread_mutex_lock(&conv->lock);
+		slot->ready = 0;
+		slot->unit = unit + conv->num_slots;
+		pthread_cond_broadcast(&conv->cond);
+		pthread_mutex_unlock(&conv->lock);
+	}
+
+	for (thread = 0; thread < num_threads; thread++) {
+		pthread_join(threads[thread], NULL);
+	}
+	free(threads);
+
+	return (uint64_t) (num_chunks - *skipped) * conv->frame_samples;
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long board = 0;
+	unsigned long channels[DM35425_NUM_ADC_DMA_CHANNELS];
+	int num_channels = 0;
+	long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *output = NULL;
+	struct converter conv;
+	struct DM35425_Recording_Board first;
+	const struct DM35425_Recording_Board *layout;
+	DM35425_Recording *recording;
+	uint64_t lines = 0;
+	size_t skipped, total_skipped = 0;
+	uint64_t begin_ns;
+	size_t row_bytes;
+	char header[64 + DM35425_NUM_ADC_DMA_CHANNELS * 16];
+	char *text;
+	double seconds;
+	off_t bytes;
+	int fd = STDOUT_FILENO;
+	int file, column, slot;
+	int status;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"board", 1, 0, BOARD_OPTION},
+		{"channel", 1, 0, CHANNEL_OPTION},
+		{"volts", 0, 0, VOLTS_OPTION},
+		{"csv", 0, 0, CSV_OPTION},
+		{"ofile", 1, 0, OFILE_OPTION},
+		{"threads", 1, 0, THREADS_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	memset(&conv, 0, sizeof(conv));
+	conv.separator = '\t';
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case BOARD_OPTION:
+			board = parse_count("Board", 0);
+			break;
+		case CHANNEL_OPTION:
+			if (num_channels == DM35425_NUM_ADC_DMA_CHANNELS) {
+				error(0, 0, "ERROR: Too many channels");
+				usage();
+			}
+			channels[num_channels++] = parse_count("Channel", 0);
+			break;
+		case VOLTS_OPTION:
+			conv.volts = 1;
+			break;
+		case CSV_OPTION:
+			conv.separator = ',';
+			break;
+		case OFILE_OPTION:
+			output = optarg;
+			break;
+		case THREADS_OPTION:
+			num_threads = parse_count("Number of threads", 1);
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	if (optind == argument_count) {
+		error(0, 0, "ERROR: At least one recording file must be given");
+		usage();
+	}
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+
+	if (output != NULL) {
+		fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			error(EXIT_FAILURE, errno, "ERROR: Could not open %s",
+			      output);
+		}
+	}
+
+	pthread_mutex_init(&conv.lock, NULL);
+	pthread_cond_init(&conv.cond, NULL);
+	conv.board = (int) board;
+
+	begin_ns = DM35425_Get_Monotonic_Ns();
+	for (file = optind; file < argument_count; file++) {
+
+		if (DM35425_Recording_Map_Open(&conv.map, arguments[file]) != 0) {
+			error(EXIT_FAILURE, errno, "ERROR: Could not open %s",
+			      arguments[file]);
+		}
+		recording = DM35425_Recording_Map_Get_Recording(conv.map);
+		layout = DM35425_Recording_Get_Board(recording, conv.board);
+		if (board > INT_MAX || layout == NULL) {
+			error(EXIT_FAILURE, 0,
+			      "ERROR: %s has no board %lu", arguments[file],
+			      board);
+		}
+
+		if (file == optind) {
+			/*
+			 * The first file sets the columns; the others must match
+			 */
+			first = *layout;
+			conv.board0_samples =
+			    DM35425_Recording_Get_Board(recording, 0)->frame_samples;
+			conv.frame_samples = layout->frame_samples;
+
+			if (num_channels == 0) {
+				for (column = 0;
+				     column < (int) layout->num_channels;
+				     column++) {
+					channels[num_channels++] = column;
+				}
+			}
+			conv.num_columns = num_channels;
+			for (column = 0; column < num_channels; column++) {
+				if (channels[column] >= layout->num_channels) {
+					error(EXIT_FAILURE, 0,
+					      "ERROR: The recording has no board %lu channel %lu",
+					      board, channels[column]);
+				}
+				conv.columns[column] = (int) channels[column];
+				conv.ranges[column] = (enum DM35425_Input_Ranges)
+					layout->ranges[channels[column]];
+			}
+
+			/*
+			 * Pieces of about UNIT_BYTES of text, none larger than
+			 * a chunk
+			 */
+			row_bytes = POSITION_CHARS +
+				    conv.num_columns * (1 + VALUE_CHARS) + 1;
+			conv.unit_rows = UNIT_BYTES / row_bytes;
+			if (conv.unit_rows == 0) {
+				conv.unit_rows = 1;
+			}
+			if (conv.unit_rows > conv.frame_samples) {
+				conv.unit_rows = conv.frame_samples;
+			}
+			conv.units_per_chunk =
+			    (conv.frame_samples + conv.unit_rows - 1) /
+			    conv.unit_rows;
+
+			conv.num_slots = SLOTS_PER_THREAD * num_threads;
+			conv.slots = (struct slot *)
+				     calloc(conv.num_slots, sizeof(struct slot));
+			if (conv.slots == NULL) {
+				error(EXIT_FAILURE, ENOMEM,
+				      "ERROR: Could not allocate buffers");
+			}
+			for (slot = 0; slot < conv.num_slots; slot++) {
+				conv.slots[slot].text = (char *)
+					malloc(conv.unit_rows * row_bytes);
+				if (conv.slots[slot].text == NULL) {
+					error(EXIT_FAILURE, ENOMEM,
+					      "ERROR: Could not allocate buffers");
+				}
+			}
+
+			text = header;
+			if (conv.separator == '\t') {
+				text += sprintf(text, "# ");
+			}
+			text += sprintf(text, "position");
+			for (column = 0; column < conv.num_columns; column++) {
+				text += sprintf(text, "%cch%d%s",
+						conv.separator,
+						layout->channels[conv.columns[column]],
+						conv.volts ? " (V)" : "");
+			}
+			text += sprintf(text, "\n");
+			write_all(fd, header, text - header);
+
+		} else if (layout->num_channels != first.num_channels ||
+			   layout->frame_samples != first.frame_samples ||
+			   DM35425_Recording_Get_Board(recording, 0)->frame_samples !=
+			   conv.board0_samples ||
+			   memcmp(layout->channels, first.channels,
+				  sizeof(first.channels)) != 0) {
+			error(EXIT_FAILURE, 0,
+			      "ERROR: %s was recorded with other channels than %s",
+			      arguments[file], arguments[optind]);
+		}
+
+		skipped = 0;
+		lines += convert_file(&conv, arguments[file], (int) num_threads,
+				      fd, &skipped);
+		total_skipped += skipped;
+
+		DM35425_Recording_Map_Close(conv.map);
+	}
+
+	bytes = lseek(fd, 0, SEEK_CUR);
+	if (output != NULL && close(fd) != 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not write %s", output);
+	}
+	seconds = (DM35425_Get_Monotonic_Ns() - begin_ns) / 1e9;
+
+	fprintf(stderr, "Converted %lu lines of %d columns in %.2f s",
+		(unsigned long) lines, conv.num_columns, seconds);
+	if (bytes > 0) {
+		fprintf(stderr, " (%.1f MB/s of text)",
+			bytes / seconds / 1e6);
+	}
+	fprintf(stderr, "\n");
+	if (total_skipped > 0) {
+		error(0, 0, "ERROR: Skipped %lu corrupt chunks",
+		      (unsigned long) total_skipped);
+	}
+
+	for (slot = 0; slot < conv.num_slots; slot++) {
+		free(conv.slots[slot].text);
+	}
+	free(conv.slots);
+	pthread_mutex_destroy(&conv.lock);
+	pthread_cond_destroy(&conv.cond);
+
+	return total_skipped > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+/**
+    @file
+
+    @brief
+        Benchmark of the lossless codec the recorder compresses with.
+
+    @verbatim
+
+        This program codes one channel of synthetic ADC codes with
+        DM35425_Codec_Encode(), decodes it again with DM35425_Codec_Decode()
+        and checks that every sample comes back.  It does so for three
+        signals: full-scale noise, which does not compress, a sine with a
+        little noise, and a quiet input.  For each it prints the
+        compression ratio against 16-bit samples and the encode and decode
+        rates in MB of 16-bit samples per second, next to the rate one
+        board produces with all 32 channels at the maximum sample rate.
+
+        No board is needed to run this program.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+
+#include "dm35425_adc_library.h"
+#include "dm35425_adc_codec.h"
+#include "dm35425_examples.h"
+#include "dm35425_util_library.h"
+
+/**
+ * Number of samples per call, if the user does not provide one.  This
+ * matches one channel of a 64k sample DMA buffer.
+ */
+#define DEFAULT_SAMPLES		65536
+
+/**
+ * Number of times each call is repeated, if the user does not provide one.
+ */
+#define DEFAULT_COUNT		500
+
+/**
+ * Number of synthetic signals.
+ */
+#define NUM_SIGNALS		3
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS]\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--samples NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of samples per call.  Defaults to %d.\n",
+		DEFAULT_SAMPLES);
+
+	fprintf(stderr, "\t--count NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of times to repeat each call.  Defaults to %d.\n",
+		DEFAULT_COUNT);
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse a positive integer option argument, exiting through usage() if it
+    is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value == 0) {
+		error(0, 0, "ERROR: %s must be a positive integer", name);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    Fill a channel with one of the synthetic signals.
+ *******************************************************************************
+*/
+
+static const char *make_signal(int signal, int16_t *samples,
+			       unsigned long count)
+{
+	unsigned long i;
+
+	switch (signal) {
+	case 0:
+		for (i = 0; i < count; i++) {
+			samples[i] = (int16_t) ((rand() %
+				(DM35425_ADC_BIPOLAR_MAX -
+				 DM35425_ADC_BIPOLAR_MIN + 1)) +
+				DM35425_ADC_BIPOLAR_MIN);
+		}
+		return "noise";
+	case 1:
+		for (i = 0; i < count; i++) {
+			samples[i] = (int16_t) lrint(1500.0 *
+				sin(2 * M_PI * i / 1000.0)) +
+				(rand() % 17) - 8;
+		}
+		return "sine";
+	default:
+		for (i = 0; i < count; i++) {
+			samples[i] = (int16_t) (100 + (rand() % 5) - 2);
+		}
+		return "quiet";
+	}
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long samples = DEFAULT_SAMPLES;
+	unsigned long count = DEFAULT_COUNT;
+	unsigned long iteration;
+	int16_t *original;
+	int16_t *decoded;
+	uint8_t *coded;
+	const char *name;
+	size_t size = 0;
+	ssize_t used = 0;
+	uint64_t start, encode_ns, decode_ns;
+	double bytes;
+	int status;
+	int failed = 0;
+	int signal;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"samples", 1, 0, SAMPLES_OPTION},
+		{"count", 1, 0, COUNT_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case SAMPLES_OPTION:
+			samples = parse_count("Sample count");
+			break;
+		case COUNT_OPTION:
+			count = parse_count("Repeat count");
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	original = (int16_t *) malloc(samples * sizeof(int16_t));
+	decoded = (int16_t *) malloc(samples * sizeof(int16_t));
+	coded = (uint8_t *) malloc(DM35425_Codec_Bound(samples));
+
+	if (original == NULL || decoded == NULL || coded == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	/*
+	 * Every rate is of the samples as 16-bit codes, like the recording
+	 */
+	bytes = (double) samples * count * sizeof(int16_t);
+
+	printf("Coding %lu samples, %lu times; one board at full rate is %.0f MB/s\n\n",
+	       samples, count,
+	       32.0 * DM35425_ADC_MAX_RATE * sizeof(int16_t) / 1e6);
+	printf("%-8s %8s %12s %12s\n", "signal", "ratio", "encode MB/s",
+	       "decode MB/s");
+
+	srand(35425);
+	for (signal = 0; signal < NUM_SIGNALS; signal++) {
+
+		name = make_signal(signal, original, samples);
+
+		start = DM35425_Get_Monotonic_Ns();
+		for (iteration = 0; iteration < count; iteration++) {
+			size = DM35425_Codec_Encode(original, samples, coded);
+		}
+		encode_ns = DM35425_Get_Monotonic_Ns() - start;
+
+		memset(decoded, 0, samples * sizeof(int16_t));
+		start = DM35425_Get_Monotonic_Ns();
+		for (iteration = 0; iteration < count; iteration++) {
+			used = DM35425_Codec_Decode(coded, size, decoded,
+						    samples);
+		}
+		decode_ns = DM35425_Get_Monotonic_Ns() - start;
+
+		status = used == (ssize_t) size &&
+			 memcmp(original, decoded,
+				samples * sizeof(int16_t)) == 0;
+		if (!status) {
+			failed = 1;
+		}
+
+		printf("%-8s %7.2f:1 %12.0f %12.0f   %s\n", name,
+		       (double) samples * sizeof(int16_t) / size,
+		       bytes * 1e3 / encode_ns, bytes * 1e3 / decode_ns,
+		       status ? "lossless" : "MISMATCH");
+	}
+
+	free(original);
+	free(decoded);
+	free(coded);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -58,6 +58,7 @@
 #include "dm35425_ioctl.h"
 #include "dm35425_examples.h"
 #include "dm35425_dma_library.h"
+#include "dm35425_adc_recorder.h"
 #include "dm35425.h"
 #include "dm35425_util_library.h"
 #include "dm35425_os.h"
@@ -100,9 +101,10 @@
 #define ASCII_FILE_NAME "./adc_dma.txt"
 
 /**
- * Name of file when saving as binary
+ * Name prefix of the recording files when saving as binary; the files are
+ * ./adc_dma_000000.dat, ./adc_dma_000001.dat and so on.
  */
-#define BIN_FILE_NAME "./adc_dma.bin"
+#define BIN_FILE_NAME "./adc_dma"
 
 /**
  * Name of the program as invoked on the command line
@@ -194,18 +196,14 @@ static void usage(void)
 	fprintf(stderr, "\t--binary\n");
 	fprintf(stderr,
 		"\t\tWrite data to file in binary format, instead of default ASCII.\n");
+	fprintf(stderr,
+		"\t\tThe files are self-describing recordings, see\n");
+	fprintf(stderr, "\t\tdm35425_adc_recording.h.\n");
 
 	fprintf(stderr, "\t--bin2txt\n");
-	fprintf(stderr, "\t\tThe program will convert the %s file to\n",
+	fprintf(stderr, "\t\tThe program will convert the %s_*.dat files to\n",
 		BIN_FILE_NAME);
 	fprintf(stderr, "\t\t%s and exit.\n\n", ASCII_FILE_NAME);
-	fprintf(stderr,
-		"\t\tNote: Because the rate affects the buffer size, and the\n");
-	fprintf(stderr,
-		"\t\tnumber of ADC affects data layout, you must include the\n");
-	fprintf(stderr,
-		"\t\t--rate and --num_adc arguments as well, IF they were used\n");
-	fprintf(stderr, "\t\tto create the binary file in the first place.\n");
 
 	fprintf(stderr, "\t--channel CHAN\n");
 	fprintf(stderr,
@@ -547,36 +545,28 @@ static void setup_dacs()
 /**
 *******************************************************************************
 @brief
-    Convert a binary data file to ASCII values.  The format will be the same
-    as the data file produced without the --binary argument.  The example
+    Convert the binary recording files to ASCII values.  The format will be
+    the same as the data file produced without the --binary argument.  The
+    buffer size and channel are read from the recording.  The example
     program will exit after finishing.
 
  @retval
     None.
  *******************************************************************************
 */
-void convert_bin_to_txt(unsigned int samples_in_buffer)
+void convert_bin_to_txt(void)
 {
 
-	FILE *fp_in, *fp_out;
-	unsigned long sample_num, output_index = 0;
-	int num_read = 0;
-	long total_read = 0;
-	int *buff;
-
-	buff = (int *)malloc(samples_in_buffer * sizeof(int));
-	if (buff == NULL) {
-		error(EXIT_FAILURE, errno,
-		      "Error allocating memory to read binary file contents.\n");
-	}
-
-	fp_in = fopen(BIN_FILE_NAME, "rb");
-
-	if (fp_in == NULL) {
-		error(EXIT_FAILURE, errno,
-		      "open() FAILED to open binary input file %s.\n",
-		      BIN_FILE_NAME);
-	}
+	FILE *fp_out;
+	DM35425_Recording *recording;
+	const struct DM35425_Recording_Index_Entry *index;
+	const struct DM35425_Recording_Board *layout;
+	unsigned long output_index = 0, total_read = 0;
+	unsigned int file_index;
+	size_t num_chunks, chunk, sample_num;
+	ssize_t num_read;
+	int32_t *buff;
+	char file_name[64];
 
 	fp_out = fopen(ASCII_FILE_NAME, "w");
 
@@ -586,27 +576,54 @@ void convert_bin_to_txt(unsigned int samples_in_buffer)
 		      ASCII_FILE_NAME);
 	}
 
-	num_read = fread(buff, sizeof(int), samples_in_buffer, fp_in);
-	total_read += num_read;
+	for (file_index = 0;; file_index++) {
+
+		snprintf(file_name, sizeof(file_name), "%s_%06u.dat",
+			 BIN_FILE_NAME, file_index);
+		if (DM35425_Recording_Open(&recording, file_name) != 0) {
+			if (errno == ENOENT && file_index > 0) {
+				break;
+			}
+			error(EXIT_FAILURE, errno,
+			      "Could not open recording %s.\n", file_name);
+		}
 
-	while (num_read > 0) {
+		layout = DM35425_Recording_Get_Board(recording, 0);
+		index = DM35425_Recording_Get_Index(recording, &num_chunks);
 
-		for (sample_num = 0; sample_num < samples_in_buffer;
-		     sample_num++) {
-			fprintf(fp_out, "%lu\t%d\n", output_index,
-				buff[sample_num]);
-			output_index++;
+		buff = (int32_t *)malloc(layout->frame_samples *
+					 sizeof(int32_t));
+		if (buff == NULL) {
+			error(EXIT_FAILURE, errno,
+			      "Error allocating memory to read binary file contents.\n");
 		}
-		num_read = fread(buff, sizeof(int), samples_in_buffer, fp_in);
-		total_read += num_read;
 
+		for (chunk = 0; chunk < num_chunks; chunk++) {
+			num_read = DM35425_Recording_Read(recording, 0, 0,
+							  index[chunk].first_sample,
+							  layout->frame_samples,
+							  buff);
+			if (num_read < 0) {
+				error(EXIT_FAILURE, errno,
+				      "Error reading buffer %lu of %s.\n",
+				      (unsigned long)chunk, file_name);
+			}
+
+			for (sample_num = 0; sample_num < (size_t)num_read;
+			     sample_num++) {
+				fprintf(fp_out, "%lu\t%d\n", output_index,
+					buff[sample_num]);
+				output_index++;
+			}
+			total_read += num_read;
+		}
+
+		free(buff);
+		DM35425_Recording_Close(recording);
 	}
-	printf("Total bytes converted to ASCII: %ld\n",
-	       total_read * sizeof(int));
 
-	free(buff);
+	printf("Total samples converted to ASCII: %lu\n", total_read);
 
-	fclose(fp_in);
 	fclose(fp_out);
 
 }
@@ -659,6 +676,12 @@ int main(int argument_count, char **arguments)
 	// Initialize this to its largest possible value.
 	unsigned long samples_to_collect = -1, samples_in_buffer = 0;
 	int store_in_binary = 0;
+	DM35425_Recorder *recorder = NULL;
+	struct DM35425_Recorder_Config recorder_config;
+	struct DM35425_ADCDMA_Readout readout;
+	int32_t *readout_raw[1];
+	enum DM35425_Input_Ranges readout_range;
+	int readout_channel;
 	unsigned int timeout_count = 0;
 
 	struct sigaction signal_action;
@@ -942,7 +965,7 @@ int main(int argument_count, char **arguments)
 	samples_in_buffer = buffer_size_bytes / sizeof(int);
 
 	if (convert_bin_file) {
-		convert_bin_to_txt(samples_in_buffer);
+		convert_bin_to_txt();
 		return 0;
 	}
 
@@ -955,14 +978,21 @@ int main(int argument_count, char **arguments)
 	}
 
 	if (store_in_binary) {
-		fp = fopen(BIN_FILE_NAME, "wb");
+		memset(&recorder_config, 0, sizeof(recorder_config));
+		recorder_config.path = BIN_FILE_NAME;
+		recorder_config.overview = true;
+		if (DM35425_Recorder_Create(&recorder, &recorder_config) != 0) {
+			error(EXIT_FAILURE, errno,
+			      "Could not create the recorder.\n");
+		}
+		fp = NULL;
 	} else {
 		fp = fopen(ASCII_FILE_NAME, "w");
-	}
 
-	if (fp == NULL) {
-		error(EXIT_FAILURE, errno,
-		      "open() FAILED on output data file.\n");
+		if (fp == NULL) {
+			error(EXIT_FAILURE, errno,
+			      "open() FAILED on output data file.\n");
+		}
 	}
 
 	printf("Opening board.....");
@@ -1103,6 +1133,20 @@ int main(int argument_count, char **arguments)
 
 	check_result(result, "Failed or timed out initializing ADC.");
 
+	/*
+	 * Describe the buffers to the recorder, one channel of one board
+	 */
+	memset(&readout, 0, sizeof(readout));
+	readout_channel = channel;
+	readout_range = range;
+	readout.num_channels = 1;
+	readout.channels = &readout_channel;
+	readout.num_samples = samples_in_buffer;
+	readout.raw = readout_raw;
+	readout.ranges = &readout_range;
+	readout.decimation = 1;
+	readout.sample_rate = actual_rate;
+
 	printf("Starting ADC\n");
 
 	result = DM35425_Adc_Start(board, &my_adc);
@@ -1147,10 +1191,26 @@ int main(int argument_count, char **arguments)
 
 		if (store_in_binary) {
 
-			fwrite(local_buffer[buffer_to_get], sizeof(int),
-			       samples_in_buffer, fp);
+			readout_raw[0] = local_buffer[buffer_to_get];
+			readout.sequence = local_buffer_count;
+			readout.first_sample = output_index;
+			readout.timestamp_ns = DM35425_Get_Monotonic_Ns();
 
-			bytes_written += buffer_size_bytes;
+			/*
+			 * Wait for the writer thread if it is behind; the
+			 * local buffers give us the time, and a refused
+			 * buffer is not counted as dropped.
+			 */
+			while (DM35425_Recorder_Try_Record(recorder, 1,
+							   &readout) != 0) {
+				if (errno != ENOBUFS) {
+					error(EXIT_FAILURE, errno,
+					      "Error recording buffer.\n");
+				}
+				DM35425_Micro_Sleep(1000);
+			}
+
+			bytes_written += samples_in_buffer * sizeof(int16_t);
 			output_index += samples_in_buffer;
 
 		} else {
@@ -1196,7 +1256,13 @@ int main(int argument_count, char **arguments)
 		fprintf(stdout, "Wrote %lu bytes to file.\n", bytes_written);
 	}
 
-	fclose(fp);
+	if (store_in_binary) {
+		if (DM35425_Recorder_Close(recorder) != 0) {
+			error(0, errno, "Error finishing the recording.");
+		}
+	} else {
+		fclose(fp);
+	}
 
 	for (buff = 0; buff < my_adc.num_dma_buffers; buff++) {
 
@@ -0,0 +1,404 @@
+/**
+    @file
+
+    @brief
+        Benchmark of the bulk ADC sample to volts conversion.
+
+    @verbatim
+
+        This program converts a buffer of pseudo-random ADC samples to
+        volts, first one sample at a time with DM35425_Adc_Sample_To_Volts()
+        and then with DM35425_Adc_Samples_To_Volts_Bulk_Isa() for every
+        instruction set the CPU supports.  Every bulk result is compared
+        against the one-sample-at-a-time reference, and the conversion rate
+        is printed in millions of samples per second.
+
+        The same samples, split into channels, are then converted to the
+        interleaved (sample-major) layout, first one sample at a time and
+        then with DM35425_Adc_Samples_To_Volts_Interleaved_Isa().
+
+        Last, the statistics of the buffer (minimum, maximum, sum and sum of
+        squares) are computed with DM35425_Adc_Samples_Stats_Isa() for every
+        instruction set and compared against the plain C result.
+
+        No board is needed to run this program.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+
+#include "dm35425_adc_library.h"
+#include "dm35425_examples.h"
+#include "dm35425_util_library.h"
+
+/**
+ * Number of samples per conversion call, if the user does not provide one.
+ * This matches 32 channels of a 64k sample DMA buffer.
+ */
+#define DEFAULT_SAMPLES		65536
+
+/**
+ * Number of times each conversion is repeated, if the user does not provide
+ * one.
+ */
+#define DEFAULT_COUNT		200
+
+/**
+ * Number of channels the samples are split into for the interleaved
+ * conversion, if the user does not provide one.
+ */
+#define DEFAULT_CHANNELS	32
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS]\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--samples NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of samples per conversion call.  Defaults to %d.\n",
+		DEFAULT_SAMPLES);
+
+	fprintf(stderr, "\t--count NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of times to repeat each conversion.  Defaults to %d.\n",
+		DEFAULT_COUNT);
+
+	fprintf(stderr, "\t--channels NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of channels to interleave.  Defaults to %d.\n",
+		DEFAULT_CHANNELS);
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse a positive integer option argument, exiting through usage() if it
+    is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value == 0) {
+		error(0, 0, "ERROR: %s must be a positive integer", name);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    Print one result line.
+ *******************************************************************************
+*/
+
+static void print_rate(const char *name, uint64_t elapsed_ns,
+		       unsigned long samples, unsigned long count,
+		       const char *check)
+{
+	double rate = (double) samples * count * 1000.0 / (double) elapsed_ns;
+
+	printf("%-12s %10.1f Msamples/s   %s\n", name, rate, check);
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long samples = DEFAULT_SAMPLES;
+	unsigned long count = DEFAULT_COUNT;
+	unsigned long channels = DEFAULT_CHANNELS;
+	unsigned long per_channel;
+	unsigned long i, iteration, channel;
+	const int32_t **channel_samples;
+	enum DM35425_Input_Ranges *ranges;
+	struct DM35425_Adc_Sample_Stats stats_reference;
+	struct DM35425_Adc_Sample_Stats stats;
+	int32_t *adc_samples;
+	float *reference;
+	float *volts;
+	uint64_t start;
+	int status;
+	int failed = 0;
+	int isa;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"samples", 1, 0, SAMPLES_OPTION},
+		{"count", 1, 0, COUNT_OPTION},
+		{"channels", 1, 0, CHANNELS_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case SAMPLES_OPTION:
+			samples = parse_count("Sample count");
+			break;
+		case COUNT_OPTION:
+			count = parse_count("Repeat count");
+			break;
+		case CHANNELS_OPTION:
+			channels = parse_count("Channel count");
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	if (channels > samples) {
+		error(0, 0, "ERROR: Channel count must not exceed sample count");
+		usage();
+	}
+
+	adc_samples = (int32_t *) malloc(samples * sizeof(int32_t));
+	reference = (float *) malloc(samples * sizeof(float));
+	volts = (float *) malloc(samples * sizeof(float));
+	channel_samples = (const int32_t **) malloc(channels * sizeof(int32_t *));
+	ranges = (enum DM35425_Input_Ranges *)
+		 malloc(channels * sizeof(enum DM35425_Input_Ranges));
+
+	if (adc_samples == NULL || reference == NULL || volts == NULL ||
+	    channel_samples == NULL || ranges == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	srand(35425);
+	for (i = 0; i < samples; i++) {
+		adc_samples[i] = (rand() % (DM35425_ADC_BIPOLAR_MAX -
+					    DM35425_ADC_BIPOLAR_MIN + 1)) +
+				 DM35425_ADC_BIPOLAR_MIN;
+	}
+
+	printf("Converting %lu samples, %lu times\n\n", samples, count);
+
+	/*
+	 * Reference: one call per sample
+	 */
+	start = DM35425_Get_Monotonic_Ns();
+	for (iteration = 0; iteration < count; iteration++) {
+		for (i = 0; i < samples; i++) {
+			DM35425_Adc_Sample_To_Volts(DM35425_ADC_RNG_BIPOLAR_5V,
+						    adc_samples[i],
+						    &reference[i]);
+		}
+	}
+	print_rate("per-sample", DM35425_Get_Monotonic_Ns() - start,
+		   samples, count, "reference");
+
+	for (isa = DM35425_SIMD_SCALAR; isa < DM35425_SIMD_NUM_ISA; isa++) {
+
+		if (!DM35425_Simd_Isa_Supported(isa)) {
+			continue;
+		}
+
+		memset(volts, 0, samples * sizeof(float));
+
+		start = DM35425_Get_Monotonic_Ns();
+		for (iteration = 0; iteration < count; iteration++) {
+			status = DM35425_Adc_Samples_To_Volts_Bulk_Isa(isa,
+						DM35425_ADC_RNG_BIPOLAR_5V,
+						adc_samples, volts, samples);
+		}
+		print_rate(DM35425_Simd_Isa_Name(isa),
+			   DM35425_Get_Monotonic_Ns() - start, samples, count,
+			   (status == 0 &&
+			    memcmp(volts, reference,
+				   samples * sizeof(float)) == 0) ?
+			   "matches" : "MISMATCH");
+
+		if (status != 0 ||
+		    memcmp(volts, reference, samples * sizeof(float)) != 0) {
+			failed = 1;
+		}
+	}
+
+	/*
+	 * Interleaved: the samples are channels rows of per_channel samples,
+	 * written out as per_channel rows of channels volts
+	 */
+	per_channel = samples / channels;
+	for (channel = 0; channel < channels; channel++) {
+		channel_samples[channel] = &adc_samples[channel * per_channel];
+		ranges[channel] = DM35425_ADC_RNG_BIPOLAR_5V;
+	}
+
+	printf("\nInterleaving %lu channels of %lu samples, %lu times\n\n",
+	       channels, per_channel, count);
+
+	start = DM35425_Get_Monotonic_Ns();
+	for (iteration = 0; iteration < count; iteration++) {
+		for (channel = 0; channel < channels; channel++) {
+			for (i = 0; i < per_channel; i++) {
+				DM35425_Adc_Sample_To_Volts(ranges[channel],
+							    channel_samples[channel][i],
+							    &reference[i * channels + channel]);
+			}
+		}
+	}
+	print_rate("per-sample", DM35425_Get_Monotonic_Ns() - start,
+		   per_channel * channels, count, "reference");
+
+	for (isa = DM35425_SIMD_SCALAR; isa < DM35425_SIMD_NUM_ISA; isa++) {
+
+		if (!DM35425_Simd_Isa_Supported(isa)) {
+			continue;
+		}
+
+		memset(volts, 0, samples * sizeof(float));
+
+		start = DM35425_Get_Monotonic_Ns();
+		for (iteration = 0; iteration < count; iteration++) {
+			status = DM35425_Adc_Samples_To_Volts_Interleaved_Isa(isa,
+						channels, ranges,
+						channel_samples, volts,
+						channels, per_channel);
+		}
+		print_rate(DM35425_Simd_Isa_Name(isa),
+			   DM35425_Get_Monotonic_Ns() - start,
+			   per_channel * channels, count,
+			   (status == 0 &&
+			    memcmp(volts, reference, per_channel * channels *
+				   sizeof(float)) == 0) ?
+			   "matches" : "MISMATCH");
+
+		if (status != 0 ||
+		    memcmp(volts, reference,
+			   per_channel * channels * sizeof(float)) != 0) {
+			failed = 1;
+		}
+	}
+
+	/*
+	 * Statistics: every instruction set against plain C
+	 */
+	printf("\nStatistics of %lu samples, %lu times\n\n", samples, count);
+
+	DM35425_Adc_Stats_Init(&stats_reference);
+	DM35425_Adc_Samples_Stats_Isa(DM35425_SIMD_SCALAR, adc_samples, samples,
+				      &stats_reference);
+
+	for (isa = DM35425_SIMD_SCALAR; isa < DM35425_SIMD_NUM_ISA; isa++) {
+
+		if (!DM35425_Simd_Isa_Supported(isa)) {
+			continue;
+		}
+
+		start = DM35425_Get_Monotonic_Ns();
+		for (iteration = 0; iteration < count; iteration++) {
+			DM35425_Adc_Stats_Init(&stats);
+			status = DM35425_Adc_Samples_Stats_Isa(isa, adc_samples,
+							       samples, &stats);
+		}
+		print_rate(DM35425_Simd_Isa_Name(isa),
+			   DM35425_Get_Monotonic_Ns() - start, samples, count,
+			   (status == 0 &&
+			    memcmp(&stats, &stats_reference,
+				   sizeof(stats)) == 0) ?
+			   "matches" : "MISMATCH");
+
+		if (status != 0 ||
+		    memcmp(&stats, &stats_reference, sizeof(stats)) != 0) {
+			failed = 1;
+		}
+	}
+
+	printf("\nDefault instruction set: %s\n",
+	       DM35425_Simd_Isa_Name(DM35425_Simd_Best_Isa()));
+
+	free(channel_samples);
+	free(ranges);
+	free(adc_samples);
+	free(reference);
+	free(volts);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
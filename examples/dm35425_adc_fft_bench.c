@@ -0,0 +1,468 @@
+/**
+    @file
+
+    @brief
+        Benchmark of the real FFT and the Welch power spectral density.
+
+    @verbatim
+
+        This program first checks DM35425_Fft_Forward() against a direct
+        double precision DFT for every power of two size up to the benchmark
+        size (at most 4096 points).
+
+        It then transforms a block of pseudo-random samples per channel with
+        DM35425_Fft_Forward(), and feeds sine waves per channel through a
+        Hann-windowed, 50% overlapped Welch PSD with DM35425_Psd_Process_All(),
+        on the calling thread alone and then with worker threads.  Rates are
+        printed in millions of channels x points per second.  The total power
+        of the PSD of channel 0 is checked against that of its sine wave.
+
+        No board is needed to run this program.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+
+#include "dm35425_adc_spectrum.h"
+#include "dm35425_examples.h"
+#include "dm35425_util_library.h"
+
+/**
+ * FFT size, if the user does not provide one.
+ */
+#define DEFAULT_SIZE		4096
+
+/**
+ * Number of channels, if the user does not provide one.
+ */
+#define DEFAULT_CHANNELS	32
+
+/**
+ * Number of times each benchmark is repeated, if the user does not provide
+ * one.
+ */
+#define DEFAULT_COUNT		100
+
+/**
+ * Number of PSD worker threads, if the user does not provide one.
+ */
+#define DEFAULT_THREADS		3
+
+/**
+ * Largest size checked against the direct DFT
+ */
+#define MAX_CHECK_SIZE		4096
+
+/**
+ * Largest error allowed against the direct DFT, relative to the largest bin
+ */
+#define FFT_TOLERANCE		1e-5
+
+/**
+ * Sample rate given to the PSD, in Hz
+ */
+#define PSD_SAMPLE_RATE		100000.0
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS]\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--size NUM\n");
+	fprintf(stderr,
+		"\t\tFFT size, a power of two of at least 4.  Defaults to %d.\n",
+		DEFAULT_SIZE);
+
+	fprintf(stderr, "\t--channels NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of channels.  Defaults to %d.\n",
+		DEFAULT_CHANNELS);
+
+	fprintf(stderr, "\t--count NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of times to repeat each benchmark.  Defaults to %d.\n",
+		DEFAULT_COUNT);
+
+	fprintf(stderr, "\t--threads NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of PSD worker threads.  Defaults to %d.\n",
+		DEFAULT_THREADS);
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse a positive integer option argument, exiting through usage() if it
+    is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value == 0) {
+		error(0, 0, "ERROR: %s must be a positive integer", name);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    Print one result line.
+ *******************************************************************************
+*/
+
+static void print_rate(const char *name, uint64_t elapsed_ns,
+		       unsigned long channels, unsigned long size,
+		       unsigned long count, const char *check)
+{
+	double rate = (double) channels * size * count * 1000.0 /
+		      (double) elapsed_ns;
+
+	printf("%-20s %10.1f Mpoints/s   %s\n", name, rate, check);
+}
+
+/**
+*******************************************************************************
+@brief
+    Compare the FFT of pseudo-random samples against a direct DFT.
+
+@param
+    size
+
+    Transform size.
+
+@retval
+    double
+
+    Largest error relative to the largest bin, or a negative value if the
+    plan could not be created.
+ *******************************************************************************
+*/
+
+static double check_fft(unsigned long size)
+{
+	DM35425_Fft *fft;
+	float *in;
+	float *out;
+	double largest = 0;
+	double worst = 0;
+	unsigned long k, n;
+
+	if (DM35425_Fft_Create(&fft, size) != 0) {
+		return -1;
+	}
+
+	in = (float *) malloc(size * sizeof(float));
+	out = (float *) malloc((size + 2) * sizeof(float));
+
+	if (in == NULL || out == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	for (n = 0; n < size; n++) {
+		in[n] = (float) rand() / RAND_MAX - 0.5f;
+	}
+
+	DM35425_Fft_Forward(fft, in, out);
+
+	for (k = 0; k <= size / 2; k++) {
+		double re = 0, im = 0;
+
+		for (n = 0; n < size; n++) {
+			double angle = -2.0 * M_PI * (double) ((k * n) % size) /
+				       (double) size;
+
+			re += in[n] * cos(angle);
+			im += in[n] * sin(angle);
+		}
+
+		largest = fmax(largest, hypot(re, im));
+		worst = fmax(worst, hypot(out[2 * k] - re, out[2 * k + 1] - im));
+	}
+
+	free(in);
+	free(out);
+	DM35425_Fft_Destroy(fft);
+
+	return worst / largest;
+}
+
+/**
+*******************************************************************************
+@brief
+    Feed every channel to a PSD count times and print the rate.
+
+@retval
+    int
+
+    0 if the total power of channel 0 matches its sine wave, 1 otherwise.
+ *******************************************************************************
+*/
+
+static int bench_psd(const char *name, float **volts, unsigned long channels,
+		     unsigned long size, unsigned long count, int threads)
+{
+	DM35425_Psd *psd;
+	double *density;
+	double power = 0;
+	uint64_t segments;
+	uint64_t start;
+	unsigned long iteration, k;
+	int ok;
+
+	if (DM35425_Psd_Create(&psd, channels, size, size / 2,
+			       DM35425_WINDOW_HANN, PSD_SAMPLE_RATE,
+			       threads) != 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not create the PSD");
+	}
+
+	density = (double *) malloc((size / 2 + 1) * sizeof(double));
+
+	if (density == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	start = DM35425_Get_Monotonic_Ns();
+	for (iteration = 0; iteration < count; iteration++) {
+		DM35425_Psd_Process_All(psd, (const float *const *) volts,
+					size);
+	}
+	uint64_t elapsed = DM35425_Get_Monotonic_Ns() - start;
+
+	/*
+	 * A 1 V amplitude sine has a power of 0.5 V^2
+	 */
+	DM35425_Psd_Get(psd, 0, density, &segments);
+	for (k = 0; k <= size / 2; k++) {
+		power += density[k] * PSD_SAMPLE_RATE / size;
+	}
+	ok = fabs(power - 0.5) < 0.005;
+
+	print_rate(name, elapsed, channels, size, count,
+		   ok ? "power matches" : "POWER MISMATCH");
+
+	free(density);
+	DM35425_Psd_Destroy(psd);
+
+	return !ok;
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long size = DEFAULT_SIZE;
+	unsigned long channels = DEFAULT_CHANNELS;
+	unsigned long count = DEFAULT_COUNT;
+	unsigned long threads = DEFAULT_THREADS;
+	unsigned long check_size, iteration, channel, n;
+	DM35425_Fft *fft;
+	float **volts;
+	float *spectrum;
+	char name[32];
+	uint64_t start;
+	double error_ratio;
+	int status;
+	int failed = 0;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"size", 1, 0, SIZE_OPTION},
+		{"channels", 1, 0, CHANNELS_OPTION},
+		{"count", 1, 0, COUNT_OPTION},
+		{"threads", 1, 0, THREADS_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case SIZE_OPTION:
+			size = parse_count("FFT size");
+			break;
+		case CHANNELS_OPTION:
+			channels = parse_count("Channel count");
+			break;
+		case COUNT_OPTION:
+			count = parse_count("Repeat count");
+			break;
+		case THREADS_OPTION:
+			threads = parse_count("Thread count");
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	if (DM35425_Fft_Create(&fft, size) != 0) {
+		error(0, 0, "ERROR: FFT size must be a power of two from 4 to 2^24");
+		usage();
+	}
+
+	/*
+	 * Accuracy against the direct DFT
+	 */
+	srand(35425);
+	for (check_size = 4; check_size <= size && check_size <= MAX_CHECK_SIZE;
+	     check_size *= 2) {
+		error_ratio = check_fft(check_size);
+		if (error_ratio < 0 || error_ratio > FFT_TOLERANCE) {
+			printf("FFT of %lu points: relative error %g  MISMATCH\n",
+			       check_size, error_ratio);
+			failed = 1;
+		}
+	}
+	if (!failed) {
+		printf("FFT matches the direct DFT up to %lu points\n",
+		       check_size / 2);
+	}
+
+	volts = (float **) malloc(channels * sizeof(float *));
+	spectrum = (float *) malloc((size + 2) * sizeof(float));
+
+	if (volts == NULL || spectrum == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	for (channel = 0; channel < channels; channel++) {
+		volts[channel] = (float *) malloc(size * sizeof(float));
+		if (volts[channel] == NULL) {
+			error(EXIT_FAILURE, ENOMEM,
+			      "ERROR: Could not allocate buffers");
+		}
+		for (n = 0; n < size; n++) {
+			volts[channel][n] = (float) rand() / RAND_MAX - 0.5f;
+		}
+	}
+
+	printf("\n%lu channels of %lu points, %lu times\n\n", channels, size,
+	       count);
+
+	/*
+	 * Bare transforms
+	 */
+	start = DM35425_Get_Monotonic_Ns();
+	for (iteration = 0; iteration < count; iteration++) {
+		for (channel = 0; channel < channels; channel++) {
+			DM35425_Fft_Forward(fft, volts[channel], spectrum);
+		}
+	}
+	print_rate("fft", DM35425_Get_Monotonic_Ns() - start, channels, size,
+		   count, "");
+
+	/*
+	 * Welch PSD of a sine wave per channel, a whole number of periods per
+	 * block so the segments line up across blocks.  Channel 0 sits at a
+	 * quarter of the sample rate, well clear of DC and Nyquist.
+	 */
+	for (channel = 0; channel < channels; channel++) {
+		unsigned long cycles = (size / 4) >> (channel % 3);
+
+		for (n = 0; n < size; n++) {
+			volts[channel][n] = (float) sin(2.0 * M_PI * n *
+							cycles / size);
+		}
+	}
+
+	failed |= bench_psd("psd, 1 thread", volts, channels, size, count, 0);
+
+	snprintf(name, sizeof(name), "psd, %lu threads", threads + 1);
+	failed |= bench_psd(name, volts, channels, size, count, threads);
+
+	for (channel = 0; channel < channels; channel++) {
+		free(volts[channel]);
+	}
+	free(volts);
+	free(spectrum);
+	DM35425_Fft_Destroy(fft);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -12,6 +12,8 @@
 #include <time.h>
 
 #include "dm35425_adc_multiboard.h"
+#include "dm35425_adc_trigger.h"
+#include "dm35425_adc_recorder.h"
 
 volatile sig_atomic_t done = 0;
 
@@ -20,23 +22,6 @@ void sigint_handler(int sig)
     done = 1;
 }
 
-/**
- * @fn timespec_diff(struct timespec *, struct timespec *, struct timespec *)
- * @brief Compute the diff of two timespecs, that is a - b = result.
- * @param a the minuend
- * @param b the subtrahend
- * @param result a - b
- */
-static inline void timespec_diff(struct timespec *a, struct timespec *b,
-    struct timespec *result) {
-    result->tv_sec  = a->tv_sec  - b->tv_sec;
-    result->tv_nsec = a->tv_nsec - b->tv_nsec;
-    if (result->tv_nsec < 0) {
-        --result->tv_sec;
-        result->tv_nsec += 1000000000L;
-    }
-}
-
 /**
  * @brief Interrupt service routine for the ADCs. This function is called every time the ADCs have a full buffer of data.
  *
@@ -46,45 +31,54 @@ static inline void timespec_diff(struct timespec *a, struct timespec *b,
  */
 void ISR(int num_boards, struct DM35425_ADCDMA_Readout *readouts, void *user_data)
 {
-    static int call_ct = 0;
-    static struct timespec lstart, last, now, diff;
+    static uint64_t start_ns = 0, last_ns = 0;
     FILE **fp = (FILE **)user_data;
-    clock_gettime(CLOCK_MONOTONIC, &now); // get time now
     if (num_boards <= 0)
     {
         printf("Error: ISR called with error %d\n", num_boards);
         return;
     }
-    for (int i = 0; i < num_boards; i++)
+    if (readouts[0].stats != NULL)
+    {
+        struct DM35425_Adc_Volt_Stats stats;
+        if (DM35425_Adc_Stats_To_Volts(readouts[0].ranges[0], &readouts[0].stats[0], &stats) == 0)
+            printf("Board 0 channel %d: mean %f V, RMS %f V, peak-to-peak %f V\n", readouts[0].channels[0], stats.mean, stats.rms, stats.peak_to_peak);
+    }
+    bool have_volts = readouts[0].voltages != NULL || readouts[0].interleaved != NULL;
+    for (int i = 0; i < num_boards && have_volts; i++)
     {
         for (int j = 0; j < readouts[i].num_channels; j++)
         {
             for (int k = 0; k < readouts[i].num_samples; k++)
             {
-                fprintf(fp[i * DM35425_NUM_ADC_DMA_CHANNELS + j], "%u %f\n", (unsigned int)(call_ct * readouts[i].num_samples + k), readouts[i].voltages[j][k]);
+                float volts = readouts[i].voltages != NULL ? readouts[i].voltages[j][k]
+                                                           : readouts[i].interleaved[k * readouts[i].frame_channels + readouts[i].column + j];
+                fprintf(fp[i * DM35425_NUM_ADC_DMA_CHANNELS + readouts[i].channels[j]], "%lu %f\n", (unsigned long)(readouts[i].first_sample + k), volts);
             }
         }
     }
-    if (call_ct)
+    uint64_t now_ns = readouts[0].timestamp_ns; // when board 0 filled this buffer
+    if (last_ns)
     {
-        timespec_diff(&now, &last, &diff);
-        printf("Callback (%d): %lu.%09lu s since last, ", call_ct, diff.tv_sec, diff.tv_nsec);
-        timespec_diff(&now, &lstart, &diff);
-        printf("%lu.%09lu s since start\n", diff.tv_sec, diff.tv_nsec);
-        last = now;
+        printf("Callback (%lu): %.9f s since last, %.9f s since start, sample count %u\n", (unsigned long)readouts[0].sequence, (now_ns - last_ns) * 1e-9, (now_ns - start_ns) * 1e-9, readouts[0].sample_count);
     }
     else
     {
-        lstart = now;
-        last = now;
-        printf("Callback (0): 0.0 s\n");
+        start_ns = now_ns;
+        printf("Callback (%lu): 0.0 s\n", (unsigned long)readouts[0].sequence);
     }
-    call_ct++;
+    last_ns = now_ns;
+}
+
+static void print_summary(const char *name, const struct DM35425_Latency_Summary *summary)
+{
+    printf("%-20s %9lu %9lu %9lu %9lu\n", name, (unsigned long)summary->p50_ns, (unsigned long)summary->p99_ns,
+           (unsigned long)summary->p999_ns, (unsigned long)summary->max_ns);
 }
 
 #define NUM_BOARDS 3
 
-int main()
+int main(int argc, char *argv[])
 {
     // Open files for readout data
     FILE **fp = NULL;
@@ -118,6 +112,68 @@ int main()
     // Combine the boards
     struct _DM35425_Multiboard_Descriptor *mbd = NULL;
     DM35425_ADC_Multiboard_Init(&mbd, NUM_BOARDS, first_brd, second_brd, third_brd);
+    // Read each board on its own thread, write the files from this thread through a frame ring, convert into one
+    // sample-major frame, decimate, only compute statistics, capture events around a software trigger, and/or record
+    // the raw codes to disk (compressed or not), if asked to
+    bool ring = false;
+    bool compress = false;
+    DM35425_Trigger *trigger = NULL;
+    DM35425_Recorder *recorder = NULL;
+    for (int i = 1; i < argc; i++)
+        compress = compress || strcmp(argv[i], "--compress") == 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--parallel") == 0)
+        {
+            DM35425_ADC_Multiboard_Set_Parallel(mbd, true, NULL, 0);
+        }
+        else if (strcmp(argv[i], "--ring") == 0)
+        {
+            DM35425_ADC_Multiboard_Set_Frame_Ring(mbd, 16);
+            ring = true;
+        }
+        else if (strcmp(argv[i], "--interleaved") == 0)
+        {
+            DM35425_ADC_Multiboard_Set_Interleaved(mbd, true);
+        }
+        else if (strcmp(argv[i], "--decimate") == 0)
+        {
+            // 10 samples per buffer become 2, through a third order CIC
+            struct DM35425_Decimation decimation = {.filter = DM35425_DECIMATE_CIC, .factor = 5, .order = 3};
+            DM35425_ADCDMA_Set_Decimation(first_brd, &decimation);
+            DM35425_ADCDMA_Set_Decimation(second_brd, &decimation);
+            DM35425_ADCDMA_Set_Decimation(third_brd, &decimation);
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            // Statistics only, no voltages
+            DM35425_ADC_Multiboard_Set_Statistics(mbd, true);
+            DM35425_ADC_Multiboard_Set_Readout_Mode(mbd, DM35425_READOUT_RAW);
+        }
+        else if (strcmp(argv[i], "--trigger") == 0 && trigger == NULL)
+        {
+            // Rising edge through 0 V on the first channel of board 0, with 0.1 V of hysteresis; keep 10 samples
+            // before and 20 from the trigger on every board
+            struct DM35425_Trigger_Condition condition = {.type = DM35425_TRIGGER_RISING, .board = 0, .channel = 0};
+            DM35425_Adc_Volts_To_Sample(DM35425_ADC_RNG_BIPOLAR_5V, 0.1f, &condition.hysteresis);
+            struct DM35425_Trigger_Config config = {.num_conditions = 1, .conditions = &condition, .pre_samples = 10, .post_samples = 20, .queue_depth = 8};
+            if (DM35425_Trigger_Create(&trigger, &config) == 0)
+                DM35425_Trigger_Add_Stage(mbd, trigger);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc && recorder == NULL)
+        {
+            // Raw codes only, into PREFIX_000000.dat and on, a new file every GiB or minute
+            struct DM35425_Recorder_Config config = {.path = argv[++i], .rotate_bytes = 1UL << 30, .rotate_ns = 60000000000ULL, .overview = true,
+                                                     .compress = compress};
+            if (DM35425_Recorder_Create(&recorder, &config) == 0)
+            {
+                DM35425_ADC_Multiboard_Set_Readout_Mode(mbd, DM35425_READOUT_RAW);
+                DM35425_Recorder_Add_Stage(mbd, recorder);
+            }
+            else
+                perror("Recorder");
+        }
+    }
     // Install the SIGINT handler
     signal(SIGINT, sigint_handler);
     // Install the interrupt service routine and do not block
@@ -125,13 +181,81 @@ int main()
     // Wait for things to happen
     while (!done)
     {
-        sleep(1);
+        struct DM35425_Trigger_Event *event;
+        while (trigger != NULL && !done && DM35425_Trigger_Get_Event(trigger, &event, ring ? 0 : 1000000000LL) == 0)
+        {
+            printf("Trigger %lu at sample %lu%s: %zu samples per channel, %zu before the trigger\n", (unsigned long)event->sequence,
+                   (unsigned long)event->trigger_sample, event->gap ? " (with lost buffers)" : "", event->captures[0].num_samples,
+                   event->captures[0].pre_samples);
+            DM35425_Trigger_Release_Event(trigger);
+        }
+        if (!ring)
+        {
+            if (trigger == NULL)
+                sleep(1);
+            continue;
+        }
+        struct DM35425_Multiboard_Frame *frame;
+        if (DM35425_ADC_Multiboard_Get_Frame(mbd, &frame, 1000000000LL) != 0)
+        {
+            if (errno == ESHUTDOWN)
+                break;
+            continue;
+        }
+        if (frame->dropped)
+        {
+            printf("Dropped %lu frames\n", (unsigned long)frame->dropped);
+        }
+        ISR(frame->num_boards, frame->readouts, (void *)fp);
+        DM35425_ADC_Multiboard_Release_Frame(mbd);
     }
     printf("Received SIGINT, exiting...\n");
+    // Print the acquisition loop timing
+    struct DM35425_Multiboard_Stats stats;
+    struct DM35425_Latency_Summary readout[NUM_BOARDS];
+    if (DM35425_Multiboard_Get_Stats(mbd, &stats, readout, NUM_BOARDS) == 0)
+    {
+        printf("%lu callbacks (ns):      p50       p99      p99.9      max\n", (unsigned long)stats.callbacks);
+        print_summary("select to readout", &stats.select_to_readout);
+        print_summary("conversion", &stats.conversion);
+        print_summary("stages", &stats.stages);
+        print_summary("callback", &stats.callback);
+        print_summary("period", &stats.period);
+        printf("%lu frames with boards out of step\n", (unsigned long)stats.sequence_mismatches);
+        printf("%lu frames dropped by the frame ring\n", (unsigned long)stats.frames_dropped);
+        printf("%lu frames held back by stages\n", (unsigned long)stats.frames_held);
+        printf("%lu DMA overruns, %lu buffers dropped\n", (unsigned long)stats.overruns, (unsigned long)stats.buffers_dropped);
+        for (int i = 0; i < NUM_BOARDS; i++)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "readout board %d", i);
+            print_summary(name, &readout[i]);
+        }
+    }
     // Remove the ISR
     DM35425_ADC_Multiboard_RemoveISR(mbd);
+    // Finish the recording
+    struct DM35425_Recorder_Stats recorded;
+    if (recorder != NULL && DM35425_Recorder_Get_Stats(recorder, &recorded) == 0)
+    {
+        printf("Recorded %lu frames (%lu dropped) in %lu files, %.1f MB/s, at most %d blocks behind\n", (unsigned long)recorded.frames,
+               (unsigned long)recorded.frames_dropped, (unsigned long)recorded.files, recorded.throughput * 1e-6, recorded.max_backlog);
+        print_summary("block write", &recorded.write);
+        if (recorded.overview_error != 0)
+            printf("Overviews stopped: %s\n", strerror(recorded.overview_error));
+        struct DM35425_Recorder_Channel_Stats coded;
+        for (int i = 0; i < NUM_BOARDS; i++)
+        {
+            for (int j = 0; DM35425_Recorder_Get_Channel_Stats(recorder, i, j, &coded) == 0; j++)
+                printf("Board %d channel %d: %lu samples compressed %.2f:1 at %.0f MB/s\n", i, j, (unsigned long)coded.samples,
+                       coded.ratio, coded.encode_rate);
+        }
+    }
+    if (DM35425_Recorder_Close(recorder) != 0)
+        perror("Recording");
     // Destroy the combined boards
     DM35425_ADC_Multiboard_Destroy(mbd);
+    DM35425_Trigger_Destroy(trigger);
     // Close the individual boards
     DM35425_ADCDMA_Close(first_brd);
     DM35425_ADCDMA_Close(second_brd);
@@ -0,0 +1,381 @@
+/**
+    @file
+
+    @brief
+        Plot-ready min/max/mean envelope of a recording, from its overview.
+
+    @verbatim
+
+        This program prints an envelope of one channel of a recording file
+        written by dm35425_adc_multiboard_dma --record or
+        dm35425_adc_continuous_dma --binary, as lines of
+
+            time (s)   minimum (V)   maximum (V)   mean (V)
+
+        over a span of the file, with a fixed number of points whatever the
+        length of the span.  The points come from the overview the recorder
+        writes next to each file (.ovw), which is built here first if the
+        file has none, so plotting a multi-gigabyte recording takes about as
+        long as plotting a few thousand samples.  Spans that were not
+        recorded are left as blank lines, which gnuplot draws as breaks:
+
+            dm35425_adc_overview adc_dma_000000.dat > envelope.txt
+            gnuplot -p -e "plot 'envelope.txt' using 1:2:3 with filledcurves \
+                title 'min/max', '' using 1:4 with lines title 'mean'"
+
+        No board is needed to run this program.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <math.h>
+
+#include "dm35425_adc_library.h"
+#include "dm35425_adc_overview.h"
+#include "dm35425_examples.h"
+#include "dm35425_util_library.h"
+
+/**
+ * Number of points, if the user does not provide one.
+ */
+#define DEFAULT_POINTS		2000
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS] FILE\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--board NUM\n");
+	fprintf(stderr,
+		"\t\tBoard index in the recording.  Defaults to 0.\n");
+
+	fprintf(stderr, "\t--channel NUM\n");
+	fprintf(stderr,
+		"\t\tIndex into the board's recorded channels.  Defaults to 0.\n");
+
+	fprintf(stderr, "\t--from SECONDS\n");
+	fprintf(stderr,
+		"\t\tStart of the span, from the start of the file.  Defaults to 0.\n");
+
+	fprintf(stderr, "\t--to SECONDS\n");
+	fprintf(stderr,
+		"\t\tEnd of the span, from the start of the file.  Defaults to the end.\n");
+	fprintf(stderr,
+		"\t\tSpans are in samples if the recording has no sample rate.\n");
+
+	fprintf(stderr, "\t--points NUM\n");
+	fprintf(stderr,
+		"\t\tNumber of points.  Defaults to %d.\n", DEFAULT_POINTS);
+
+	fprintf(stderr, "\t--build\n");
+	fprintf(stderr,
+		"\t\tBuild the overview again even if the file has one.\n");
+
+	fprintf(stderr, "\t--factor NUM\n");
+	fprintf(stderr,
+		"\t\tFactor between overview levels when building, 2 or more.  Defaults to 16.\n");
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse an integer option argument of at least a minimum, exiting through
+    usage() if it is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name, unsigned long minimum)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value < minimum) {
+		error(0, 0, "ERROR: %s must be an integer of at least %lu", name,
+		      minimum);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse a non-negative number of seconds, exiting through usage() if it is
+    not valid.
+ *******************************************************************************
+*/
+
+static double parse_seconds(const char *name)
+{
+	char *invalid_char_p;
+	double value;
+
+	value = strtod(optarg, &invalid_char_p);
+
+	if (*invalid_char_p != '\0' || !(value >= 0)) {
+		error(0, 0, "ERROR: %s must be a non-negative number", name);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long board = 0;
+	unsigned long channel = 0;
+	unsigned long points = DEFAULT_POINTS;
+	unsigned long factor = 0;
+	double from = 0;
+	double to = -1;
+	int build = 0;
+	const char *file;
+	DM35425_Overview *overview;
+	DM35425_Recording *recording;
+	const struct DM35425_Recording_Board *layout;
+	const struct DM35425_Recording_Board *layout0;
+	const struct DM35425_Recording_Index_Entry *index;
+	struct DM35425_Overview_Point *envelope;
+	size_t num_chunks;
+	uint64_t start, end, first, last;
+	uint64_t begin_ns;
+	float zero, one, low, high;
+	double rate, scale;
+	ssize_t count, i;
+	int status;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"board", 1, 0, BOARD_OPTION},
+		{"channel", 1, 0, CHANNEL_OPTION},
+		{"from", 1, 0, FROM_OPTION},
+		{"to", 1, 0, TO_OPTION},
+		{"points", 1, 0, POINTS_OPTION},
+		{"build", 0, 0, BUILD_OPTION},
+		{"factor", 1, 0, FACTOR_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case BOARD_OPTION:
+			board = parse_count("Board", 0);
+			break;
+		case CHANNEL_OPTION:
+			channel = parse_count("Channel", 0);
+			break;
+		case FROM_OPTION:
+			from = parse_seconds("Start");
+			break;
+		case TO_OPTION:
+			to = parse_seconds("End");
+			break;
+		case POINTS_OPTION:
+			points = parse_count("Number of points", 1);
+			break;
+		case BUILD_OPTION:
+			build = 1;
+			break;
+		case FACTOR_OPTION:
+			factor = parse_count("Factor", 2);
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	if (optind != argument_count - 1) {
+		error(0, 0, "ERROR: Exactly one recording file must be given");
+		usage();
+	}
+	file = arguments[optind];
+
+	/*
+	 * Build the overview if the file has none, e.g. because the recording
+	 * was not closed
+	 */
+	if (build || DM35425_Overview_Open(&overview, file) != 0) {
+		if (!build && errno != ENOENT && errno != EBADMSG) {
+			error(EXIT_FAILURE, errno, "ERROR: Could not open %s",
+			      file);
+		}
+
+		begin_ns = DM35425_Get_Monotonic_Ns();
+		if (DM35425_Overview_Build(file, factor) != 0) {
+			error(EXIT_FAILURE, errno,
+			      "ERROR: Could not build the overview of %s", file);
+		}
+		fprintf(stderr, "Built the overview of %s in %.1f ms\n", file,
+			(DM35425_Get_Monotonic_Ns() - begin_ns) / 1e6);
+
+		if (DM35425_Overview_Open(&overview, file) != 0) {
+			error(EXIT_FAILURE, errno, "ERROR: Could not open %s",
+			      file);
+		}
+	}
+
+	recording =
+	    DM35425_Recording_Map_Get_Recording(DM35425_Overview_Get_Map(overview));
+	layout = DM35425_Recording_Get_Board(recording, (int) board);
+	if (board > INT_MAX || layout == NULL ||
+	    channel >= layout->num_channels) {
+		error(EXIT_FAILURE, 0,
+		      "ERROR: The recording has no board %lu channel %lu",
+		      board, channel);
+	}
+	layout0 = DM35425_Recording_Get_Board(recording, 0);
+
+	index = DM35425_Recording_Get_Index(recording, &num_chunks);
+	if (num_chunks == 0) {
+		error(EXIT_FAILURE, 0, "ERROR: %s holds no samples", file);
+	}
+
+	/*
+	 * The span of the file on this board; index positions are board 0's
+	 */
+	start = index[0].first_sample / layout0->frame_samples *
+		layout->frame_samples;
+	end = index[num_chunks - 1].first_sample / layout0->frame_samples *
+	      layout->frame_samples + layout->frame_samples;
+	rate = layout->sample_rate != 0 ? layout->sample_rate : 1;
+	first = start + (uint64_t) llround(from * rate);
+	last = to < 0 ? end : start + (uint64_t) llround(to * rate);
+	if (last > end) {
+		last = end;
+	}
+	if (first >= last) {
+		error(EXIT_FAILURE, 0, "ERROR: The span holds no samples");
+	}
+
+	envelope = (struct DM35425_Overview_Point *)
+		   malloc(points * sizeof(struct DM35425_Overview_Point));
+	if (envelope == NULL) {
+		error(EXIT_FAILURE, ENOMEM, "ERROR: Could not allocate buffers");
+	}
+
+	begin_ns = DM35425_Get_Monotonic_Ns();
+	count = DM35425_Overview_Envelope(overview, (int) board, (int) channel,
+					  first, last - first, points,
+					  envelope);
+	if (count < 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not compute the envelope");
+	}
+	fprintf(stderr, "%zd points of %lu samples in %.3f ms, from buckets of %lu samples\n",
+		count, (unsigned long) (last - first),
+		(DM35425_Get_Monotonic_Ns() - begin_ns) / 1e6,
+		(unsigned long) envelope[0].bucket_samples);
+
+	/*
+	 * The conversion is linear, which gives the mean in volts too
+	 */
+	DM35425_Adc_Sample_To_Volts(layout->ranges[channel], 0, &zero);
+	DM35425_Adc_Sample_To_Volts(layout->ranges[channel], 1, &one);
+	scale = one - zero;
+
+	printf("# %s board %lu channel %d: time (%s), min (V), max (V), mean (V)\n",
+	       file, board, layout->channels[channel],
+	       layout->sample_rate != 0 ? "s" : "samples");
+	for (i = 0; i < count; i++) {
+		if (envelope[i].min > envelope[i].max) {
+			printf("\n");
+			continue;
+		}
+		DM35425_Adc_Sample_To_Volts(layout->ranges[channel],
+					    envelope[i].min, &low);
+		DM35425_Adc_Sample_To_Volts(layout->ranges[channel],
+					    envelope[i].max, &high);
+		printf("%.9f %.6f %.6f %.6f\n",
+		       (envelope[i].first_sample - start) / rate, low, high,
+		       zero + scale * envelope[i].mean);
+	}
+
+	free(envelope);
+	DM35425_Overview_Close(overview);
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file dm35425_adc_codec.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Lossless codec for raw ADC codes: delta coding, zigzag and bit-packing of fixed-size groups.
+ * @version 1.0
+ * @date 2023-06-12
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * A channel is coded as follows. Each sample is replaced by its difference from the previous one (the first by its
+ * difference from 0), and the differences are zigzag coded (0, -1, 1, -2, 2 become 0, 1, 2, 3, 4) so small ones of
+ * either sign have few bits. The values are cut into groups of {@link DM35425_CODEC_GROUP}, the last one possibly
+ * shorter. The coded channel is one byte per group with the number of bits w (0 to 17) of its largest value, followed
+ * by each group packed. A whole group is packed into w 16-byte words: value i of the group is in 32-bit lane i % 4 of
+ * the words, and each lane holds its 32 values back to back from the least significant bit up. The layout lets four
+ * values be packed or unpacked per vector instruction. A shorter last group of n values is packed as one stream of
+ * n x w bits from the least significant bit up, in (n x w + 7) / 8 bytes.
+ *
+ * A channel that would not code to fewer bytes than its raw samples, such as noise or a short frame, is stored instead
+ * as the byte {@link DM35425_CODEC_RAW} followed by the samples as int16_t, so it grows by one byte at most.
+ */
+
+#ifndef _DM35425_ADC_CODEC__H_
+#define _DM35425_ADC_CODEC__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief Samples per group.
+ *
+ */
+#define DM35425_CODEC_GROUP 128
+
+/**
+ * @brief Largest number of bits per value. Differences of 16-bit samples take 17 bits after zigzag coding.
+ *
+ */
+#define DM35425_CODEC_MAX_BITS 17
+
+/**
+ * @brief First byte of a channel stored raw, in place of the first group's width.
+ *
+ */
+#define DM35425_CODEC_RAW 0xFF
+
+/**
+ * @brief Get the most bytes a number of samples can code to.
+ *
+ * @param count Number of samples.
+ * @return size_t Bytes.
+ */
+size_t DM35425_Codec_Bound(size_t count);
+
+/**
+ * @brief Code one channel.
+ *
+ * @param samples Raw codes.
+ * @param count Number of samples.
+ * @param out Coded bytes, room for {@link DM35425_Codec_Bound}(count) of them.
+ * @return size_t Bytes written.
+ */
+size_t DM35425_Codec_Encode(const int16_t *_Nonnull samples, size_t count, void *_Nonnull out);
+
+/**
+ * @brief Decode one channel.
+ *
+ * @param in Coded bytes.
+ * @param size Bytes available, at least those of the channel.
+ * @param samples Returned raw codes.
+ * @param count Number of samples, as given to {@link DM35425_Codec_Encode}.
+ * @return ssize_t Bytes the channel took, or -1 with errno EBADMSG if they are not a valid coding of count samples
+ * within size bytes.
+ */
+ssize_t DM35425_Codec_Decode(const void *_Nonnull in, size_t size, int16_t *_Nonnull samples, size_t count);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_CODEC__H_
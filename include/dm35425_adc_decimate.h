@@ -0,0 +1,125 @@
+/**
+ * @file dm35425_adc_decimate.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Multi-channel decimating filters for the DM35425 ADC, run on the raw ADC codes and producing volts.
+ * @version 1.0
+ * @date 2023-05-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef _DM35425_ADC_DECIMATE__H_
+#define _DM35425_ADC_DECIMATE__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dm35425_adc_library.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief Anti-alias filter of a decimator, see {@link DM35425_Decimation}.
+ *
+ */
+enum DM35425_Decimation_Filter
+{
+    DM35425_DECIMATE_NONE = 0, /*!< No decimation. */
+    DM35425_DECIMATE_FIR,      /*!< Polyphase FIR with user taps, only computed at the output rate. */
+    DM35425_DECIMATE_CIC,      /*!< CIC (cascaded integrator-comb) filter followed by a 3-tap droop compensator. */
+};
+
+/**
+ * @brief Decimation settings.
+ *
+ */
+struct DM35425_Decimation
+{
+    enum DM35425_Decimation_Filter filter; /*!< Filter type */
+    int factor;                            /*!< Decimation factor, 1 or more. One output sample per `factor` input samples. */
+    int order;                             /*!< CIC: number of integrator/comb stages, 1 to 6. The gain factor^order must fit 45 bits. */
+    int num_taps;                          /*!< FIR: number of taps */
+    const float *_Nullable taps;           /*!< FIR: taps, `num_taps` of them; y[n] = sum of taps[k] * x[n - k]. Copied. Should sum to 1 for unity DC gain. */
+};
+
+/**
+ * @brief Opaque decimator state: the filter history of every channel, kept across calls.
+ *
+ */
+typedef struct _DM35425_Decimator DM35425_Decimator;
+
+/**
+ * @brief Create a decimator for a set of channels. The FIR converts the raw codes to volts on the way into its
+ * history and filters all channels at once with vector instructions. The CIC runs on the raw codes in exact 64-bit
+ * integer arithmetic, converts at the output rate and compensates the CIC passband droop with a 3-tap FIR.
+ *
+ * @param dec Pointer to the decimator to create.
+ * @param num_channels Number of channels, 1 or more.
+ * @param ranges Input range of each channel, used to convert to volts. Copied.
+ * @param config Decimation settings. The filter must not be {@link DM35425_DECIMATE_NONE}.
+ * @return int 0 on success, -1 with errno EINVAL for bad settings or ENOMEM.
+ */
+int DM35425_Decimator_Create(DM35425_Decimator *_Nullable *_Nonnull dec, int num_channels, const enum DM35425_Input_Ranges *_Nonnull ranges, const struct DM35425_Decimation *_Nonnull config);
+
+/**
+ * @brief Free a decimator.
+ *
+ * @param dec Decimator, may be NULL.
+ */
+void DM35425_Decimator_Destroy(DM35425_Decimator *_Nullable dec);
+
+/**
+ * @brief Clear the filter history, e.g. after a gap in the input. The next outputs show the filter's start-up transient.
+ *
+ * @param dec Decimator.
+ */
+void DM35425_Decimator_Reset(DM35425_Decimator *_Nonnull dec);
+
+/**
+ * @brief Decimate the next `num_samples` samples of every channel. Input need not be a multiple of the factor; the
+ * phase carries over to the next call.
+ *
+ * @param dec Decimator.
+ * @param raw Raw ADC codes, raw[channel][num_samples].
+ * @param num_samples Number of input samples per channel.
+ * @param volts Output rows, volts[channel][...], each with room for num_samples / factor + 1 samples.
+ * @return size_t Number of output samples written per channel.
+ */
+size_t DM35425_Decimator_Process(DM35425_Decimator *_Nonnull dec, const int32_t *const *_Nonnull raw, size_t num_samples, float *const *_Nonnull volts);
+
+/**
+ * @brief Decimate like {@link DM35425_Decimator_Process}, writing sample-major rows: output sample j of channel c to
+ * volts[j * stride + c].
+ *
+ * @param dec Decimator.
+ * @param raw Raw ADC codes, raw[channel][num_samples].
+ * @param num_samples Number of input samples per channel.
+ * @param volts First column of the output.
+ * @param stride Floats from one output row to the next, at least the number of channels.
+ * @return size_t Number of output samples written per channel.
+ */
+size_t DM35425_Decimator_Process_Interleaved(DM35425_Decimator *_Nonnull dec, const int32_t *const *_Nonnull raw, size_t num_samples, float *_Nonnull volts, size_t stride);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_DECIMATE__H_
@@ -25,7 +25,10 @@
 #ifndef _DM35425_ADC_LIBRARY__H_
 #define _DM35425_ADC_LIBRARY__H_
 
+#include <stddef.h>
+
 #include "dm35425_gbc_library.h"
+#include "dm35425_util_library.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -2584,6 +2587,488 @@ int DM35425_Adc_Sample_To_Volts(
 				float *volts);
 
 
+/**
+*******************************************************************************
+@brief
+    Running statistics of a channel's raw ADC samples, see
+    DM35425_Adc_Samples_Stats().
+ *******************************************************************************
+*/
+struct DM35425_Adc_Sample_Stats {
+
+	/**
+	 * Smallest sample, INT32_MAX if there were none
+	 */
+	int32_t min;
+
+	/**
+	 * Largest sample, INT32_MIN if there were none
+	 */
+	int32_t max;
+
+	/**
+	 * Sum of the samples
+	 */
+	int64_t sum;
+
+	/**
+	 * Sum of the squares of the samples
+	 */
+	uint64_t sum_squares;
+
+	/**
+	 * Number of samples
+	 */
+	uint64_t count;
+};
+
+
+/**
+*******************************************************************************
+@brief
+    Statistics of a channel in volts, see DM35425_Adc_Stats_To_Volts().
+ *******************************************************************************
+*/
+struct DM35425_Adc_Volt_Stats {
+
+	/**
+	 * Smallest value
+	 */
+	float min;
+
+	/**
+	 * Largest value
+	 */
+	float max;
+
+	/**
+	 * Mean value
+	 */
+	float mean;
+
+	/**
+	 * Root mean square value
+	 */
+	float rms;
+
+	/**
+	 * Largest minus smallest value
+	 */
+	float peak_to_peak;
+
+	/**
+	 * Number of samples
+	 */
+	uint64_t count;
+};
+
+
+/**
+*******************************************************************************
+@brief
+    Convert a block of ADC samples to volts.  The input range is looked up
+    once and the samples are converted with the widest vector instruction set
+    the CPU supports (see DM35425_Simd_Best_Isa()).  Results are identical to
+    calling DM35425_Adc_Sample_To_Volts() on each sample.
+
+@param
+    input_range
+
+    Enumerated value indicating what range the ADC channel has been set to.
+
+@param
+    samples
+
+    Array of signed values from the ADC.
+
+@param
+    volts
+
+    Array of count floats to receive the values in volts.  May not overlap
+    samples.
+
+@param
+    count
+
+    Number of samples to convert.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            EINVAL	input_range is not valid.  Nothing was converted.
+        @arg \c
+            ERANGE	At least one sample was outside the valid range for
+                        input_range.  All samples were still converted.
+ */
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Bulk(
+				enum DM35425_Input_Ranges input_range,
+				const int32_t *samples,
+				float *volts,
+				size_t count);
+
+
+/**
+*******************************************************************************
+@brief
+    Convert a block of ADC samples to volts using a specific instruction set.
+    Intended for benchmarking and testing; use
+    DM35425_Adc_Samples_To_Volts_Bulk() otherwise.
+
+@param
+    isa
+
+    Instruction set to use.
+
+@param
+    input_range
+
+    Enumerated value indicating what range the ADC channel has been set to.
+
+@param
+    samples
+
+    Array of signed values from the ADC.
+
+@param
+    volts
+
+    Array of count floats to receive the values in volts.
+
+@param
+    count
+
+    Number of samples to convert.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            EINVAL	input_range is not valid.
+        @arg \c
+            ENOTSUP	isa is not supported by this CPU or library build.
+        @arg \c
+            ERANGE	At least one sample was outside the valid range.
+ */
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Bulk_Isa(
+				enum DM35425_Simd_Isa isa,
+				enum DM35425_Input_Ranges input_range,
+				const int32_t *samples,
+				float *volts,
+				size_t count);
+
+
+/**
+*******************************************************************************
+@brief
+    Convert blocks of ADC samples from several channels to volts, writing
+    them interleaved: sample i of channel c goes to volts[i * stride + c].
+    Blocks of channels by samples are converted and transposed in vector
+    registers, so the result is written once, already in sample-major order.
+    Results are identical to calling DM35425_Adc_Sample_To_Volts() on each
+    sample.
+
+@param
+    num_channels
+
+    Number of channels.
+
+@param
+    input_ranges
+
+    Array of num_channels enumerated values indicating what range each
+    channel has been set to.
+
+@param
+    samples
+
+    Array of num_channels pointers, each to count signed values from the ADC.
+
+@param
+    volts
+
+    Array receiving the values in volts.  Row i starts at volts[i * stride].
+    To interleave into columns further along a wider row, pass a pointer to
+    the first column.  May not overlap samples.
+
+@param
+    stride
+
+    Number of floats from the start of one row of volts to the next.  Must
+    be at least num_channels.
+
+@param
+    count
+
+    Number of samples of each channel to convert.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            EINVAL	An input range is not valid, num_channels is negative
+                        or stride is smaller than num_channels.  Nothing was
+                        converted.
+        @arg \c
+            ERANGE	At least one sample was outside the valid range for
+                        its channel.  All samples were still converted.
+ */
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Interleaved(
+				int num_channels,
+				const enum DM35425_Input_Ranges *input_ranges,
+				const int32_t *const *samples,
+				float *volts,
+				size_t stride,
+				size_t count);
+
+
+/**
+*******************************************************************************
+@brief
+    Convert and interleave blocks of ADC samples using a specific instruction
+    set.  Intended for benchmarking and testing; use
+    DM35425_Adc_Samples_To_Volts_Interleaved() otherwise.
+
+@param
+    isa
+
+    Instruction set to use.
+
+@param
+    num_channels
+
+    Number of channels.
+
+@param
+    input_ranges
+
+    Array of num_channels input ranges, one per channel.
+
+@param
+    samples
+
+    Array of num_channels pointers, each to count signed values from the ADC.
+
+@param
+    volts
+
+    Array receiving the values in volts, sample i of channel c at
+    volts[i * stride + c].
+
+@param
+    stride
+
+    Number of floats from one row of volts to the next.
+
+@param
+    count
+
+    Number of samples of each channel to convert.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            EINVAL	An input range, num_channels or stride is not valid.
+        @arg \c
+            ENOTSUP	isa is not supported by this CPU or library build.
+        @arg \c
+            ERANGE	At least one sample was outside the valid range.
+ */
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Interleaved_Isa(
+				enum DM35425_Simd_Isa isa,
+				int num_channels,
+				const enum DM35425_Input_Ranges *input_ranges,
+				const int32_t *const *samples,
+				float *volts,
+				size_t stride,
+				size_t count);
+
+
+/**
+*******************************************************************************
+@brief
+    Empty a statistics record, so that samples can be added to it.
+
+@param
+    stats
+
+    Record to empty.
+ */
+DM35425LIB_API
+void DM35425_Adc_Stats_Init(struct DM35425_Adc_Sample_Stats *stats);
+
+
+/**
+*******************************************************************************
+@brief
+    Add a block of raw ADC samples to a statistics record: minimum, maximum,
+    sum, sum of squares and count, in one pass with the widest vector
+    instruction set the CPU supports.  Sums are kept in 64 bits; they are
+    exact for samples in the ADC range.
+
+@param
+    samples
+
+    Array of signed values from the ADC.
+
+@param
+    count
+
+    Number of samples.
+
+@param
+    stats
+
+    Record to add to, set up with DM35425_Adc_Stats_Init().
+ */
+DM35425LIB_API
+void DM35425_Adc_Samples_Stats(const int32_t *samples,
+			       size_t count,
+			       struct DM35425_Adc_Sample_Stats *stats);
+
+
+/**
+*******************************************************************************
+@brief
+    Add a block of raw ADC samples to a statistics record using a specific
+    instruction set.  Intended for benchmarking and testing; use
+    DM35425_Adc_Samples_Stats() otherwise.
+
+@param
+    isa
+
+    Instruction set to use.
+
+@param
+    samples
+
+    Array of signed values from the ADC.
+
+@param
+    count
+
+    Number of samples.
+
+@param
+    stats
+
+    Record to add to.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            ENOTSUP	isa is not supported by this CPU or library build.
+ */
+DM35425LIB_API
+int DM35425_Adc_Samples_Stats_Isa(enum DM35425_Simd_Isa isa,
+				  const int32_t *samples,
+				  size_t count,
+				  struct DM35425_Adc_Sample_Stats *stats);
+
+
+/**
+*******************************************************************************
+@brief
+    Add one statistics record to another, e.g. a buffer's to a running total.
+
+@param
+    total
+
+    Record to add to.
+
+@param
+    stats
+
+    Record to add.
+ */
+DM35425LIB_API
+void DM35425_Adc_Stats_Merge(struct DM35425_Adc_Sample_Stats *total,
+			     const struct DM35425_Adc_Sample_Stats *stats);
+
+
+/**
+*******************************************************************************
+@brief
+    Express a statistics record in volts: minimum, maximum, mean, RMS and
+    peak-to-peak.
+
+@param
+    input_range
+
+    Enumerated value indicating what range the ADC channel has been set to.
+
+@param
+    stats
+
+    Record of raw samples.
+
+@param
+    volts
+
+    Receives the statistics in volts.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.@n@n
+    errno may be set as follows:
+        @arg \c
+            EINVAL	input_range is not valid.
+        @arg \c
+            ENODATA	The record holds no samples.
+ */
+DM35425LIB_API
+int DM35425_Adc_Stats_To_Volts(enum DM35425_Input_Ranges input_range,
+			       const struct DM35425_Adc_Sample_Stats *stats,
+			       struct DM35425_Adc_Volt_Stats *volts);
+
+
 /**
 *******************************************************************************
 @brief
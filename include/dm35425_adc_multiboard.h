@@ -20,6 +20,8 @@
 #include <pthread.h>
 #include "dm35425.h"
 #include "dm35425_adc_library.h"
+#include "dm35425_adc_decimate.h"
+#include "dm35425_os.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +72,17 @@ enum DM35425_ERROR
     DM35425_INVALID_IRQ_IO,            /*!< Could not perform I/O after receiving interrupt. */
     DM35425_INVALID_IRQ_TIMEOUT,       /*!< Timed out while waiting for interrupt. */
     DM35425_INVALID_IRQ_SELECT,        /*!< Select failed on the ADC board handle. */
+    DM35425_ERROR_SAMPLE_COUNT,        /*!< Could not read the ADC sample count. */
+};
+
+/**
+ * @brief Selects what the multi-board ISR hands to the callback. See {@link DM35425_ADC_Multiboard_Set_Readout_Mode}.
+ *
+ */
+enum DM35425_Readout_Mode
+{
+    DM35425_READOUT_VOLTS = 0, /*!< Convert every sample to volts. Raw codes are available as well. This is the default. */
+    DM35425_READOUT_RAW,       /*!< Only raw ADC codes; no conversion is done and `voltages` is NULL. */
 };
 
 /**
@@ -78,9 +91,24 @@ enum DM35425_ERROR
  */
 struct DM35425_ADCDMA_Readout
 {
-    int num_channels;   /*!< Number of channels */
-    size_t num_samples; /*!< Number of samples per channel */
-    float **voltages;   /*!< Array of voltages[num_channels][num_samples] */
+    int num_channels;                     /*!< Number of active channels, see {@link DM35425_ADCDMA_Configure_ADC_Mask} */
+    const int *channels;                  /*!< Channel number of each entry, in ascending order: the input in single-ended mode, the differential pair in differential mode */
+    size_t num_samples;                   /*!< Number of samples per channel: samples_per_buf, times the buffers per frame with {@link DM35425_ADC_Multiboard_Set_Batching}, divided by `decimation` */
+    float **voltages;                     /*!< Array of voltages[num_channels][num_samples], indexed like `channels`. NULL in {@link DM35425_READOUT_RAW} mode and when interleaved. */
+    int32_t **raw;                        /*!< Array of raw ADC codes raw[num_channels][num_samples * decimation]. These point into the library's DMA copy and are only valid until the ISR returns. */
+    enum DM35425_Input_Ranges *ranges;    /*!< Input range of each channel, for converting `raw` with {@link DM35425_Adc_Sample_To_Volts}. */
+    uint64_t sequence;                    /*!< Number of this (or, when batching, the first) DMA buffer since the ISR was installed, starting at 0, counting dropped buffers */
+    uint64_t dropped;                     /*!< Number of buffers of this board not handed out just before this one, because of a DMA overrun or because more buffers were read than fit in this frame. A batch with an overrun inside it is not contiguous. */
+    uint64_t first_sample;                /*!< Index of the first (decimated) sample since the ISR was installed, i.e. sequence * samples_per_buf / decimation */
+    uint64_t timestamp_ns;                /*!< CLOCK_MONOTONIC time (ns) at which the (last) buffer was found full, see {@link DM35425_Get_Monotonic_Ns} */
+    uint32_t sample_count;                /*!< Hardware sample counter ({@link DM35425_Adc_Get_Sample_Count}) read at the same time */
+    uint32_t sample_rate;                 /*!< Raw sample rate the board achieved (Hz), see {@link DM35425_Adc_Set_Sample_Rate} */
+    float *interleaved;                   /*!< With {@link DM35425_ADC_Multiboard_Set_Interleaved}, the voltages of every board in the frame as interleaved[num_samples][frame_channels]; the same pointer in every readout of the frame. NULL otherwise. */
+    int column;                           /*!< Column of this board's first channel in `interleaved`: channel j of sample k is interleaved[k * frame_channels + column + j] */
+    int frame_channels;                   /*!< Number of columns of `interleaved`, the active channels of all boards */
+    int decimation;                       /*!< Raw samples per voltage sample, see {@link DM35425_ADCDMA_Set_Decimation}; 1 without decimation */
+    struct DM35425_Adc_Sample_Stats *stats;  /*!< With {@link DM35425_ADC_Multiboard_Set_Statistics}, statistics of the raw samples of each channel in this readout, indexed like `channels`. NULL otherwise. */
+    struct DM35425_Adc_Sample_Stats *totals; /*!< Running statistics of each channel since the ISR was installed, including this readout. NULL without statistics. */
 };
 
 /**
@@ -92,6 +120,56 @@ struct DM35425_ADCDMA_Readout
  */
 typedef void (*DM35425_Multiboard_ISR)(int num_boards, struct DM35425_ADCDMA_Readout *_Nullable readouts, void *_Nullable user_data);
 
+/**
+ * @brief Maximum number of processing stages, see {@link DM35425_ADC_Multiboard_Add_Stage}.
+ *
+ */
+#define DM35425_MULTIBOARD_MAX_STAGES 8
+
+/**
+ * @brief A processing stage, run on every frame after conversion and before the frame reaches the ISR or the frame
+ * ring. Runs on the acquisition thread, so it must keep up with the frame rate.
+ *
+ * @param num_boards Number of boards.
+ * @param readouts The frame, as it will be passed to the ISR. A stage may modify the samples in place.
+ * @param ctx Context given to {@link DM35425_ADC_Multiboard_Add_Stage}.
+ * @return int 0 to pass the frame on, non-zero to hold it back: the remaining stages and the ISR do not see it.
+ */
+typedef int (*DM35425_Multiboard_Stage)(int num_boards, struct DM35425_ADCDMA_Readout *_Nonnull readouts, void *_Nullable ctx);
+
+/**
+ * @brief Timing of the multi-board acquisition loop, see {@link DM35425_Multiboard_Get_Stats}. All times are in nanoseconds.
+ *
+ */
+struct DM35425_Multiboard_Stats
+{
+    uint64_t callbacks;                               /*!< Number of times the ISR was called with data, or frames published to the frame ring */
+    struct DM35425_Latency_Summary select_to_readout; /*!< From the wakeup that completed a frame to the last board being read out. With parallel readers, from the first reader waking up to the last one reaching the barrier. */
+    struct DM35425_Latency_Summary conversion;        /*!< Conversion of all boards to volts. With parallel readers, of one board, recorded by each reader. */
+    struct DM35425_Latency_Summary stages;            /*!< Time spent in the processing stages, see {@link DM35425_ADC_Multiboard_Add_Stage} */
+    struct DM35425_Latency_Summary callback;          /*!< Time spent in the user ISR, or copying a frame into the frame ring */
+    struct DM35425_Latency_Summary period;            /*!< Interval between the starts of consecutive ISR calls */
+    uint64_t stalls;                                  /*!< Number of watchdog timeouts, over all boards */
+    uint64_t rearms;                                  /*!< Number of ADCs restarted by the watchdog */
+    uint64_t sequence_mismatches;                     /*!< Number of frames in which the boards had not all advanced by the same number of DMA buffers, read or dropped */
+    uint64_t frames_dropped;                          /*!< Number of frames dropped because the frame ring was full */
+    uint64_t overruns;                                /*!< Number of DMA overruns (a board's DMA lapping the reader, or overflowing) recovered from, over all boards */
+    uint64_t buffers_dropped;                         /*!< Number of DMA buffers lost to those overruns, over all boards */
+    uint64_t frames_held;                             /*!< Number of frames a processing stage held back from the ISR */
+};
+
+/**
+ * @brief A frame taken from the frame ring with {@link DM35425_ADC_Multiboard_Get_Frame}: one buffer from every board.
+ *
+ */
+struct DM35425_Multiboard_Frame
+{
+    uint64_t sequence;                        /*!< Frame number since the ISR was installed, counting dropped frames */
+    uint64_t dropped;                         /*!< Number of frames dropped just before this one because the consumer fell behind */
+    int num_boards;                           /*!< Number of boards */
+    struct DM35425_ADCDMA_Readout *readouts;  /*!< Array of num_boards readouts. The samples are owned by the ring and stay valid until the frame is released. */
+};
+
 /**
  * @brief ADC DMA Descriptor (combines all necessary structures and fields to interact with ADC channels in one structure.)
  *
@@ -104,6 +182,27 @@ typedef struct _DM35425_ADCDMA_Descriptor DM35425_ADCDMA_Descriptor;
  */
 typedef struct _DM35425_Multiboard_Descriptor DM35425_Multiboard_Descriptor;
 
+/**
+ * @brief What the multi-board ISR thread does when a board stalls. See {@link DM35425_ADC_Multiboard_Set_Watchdog}.
+ *
+ */
+enum DM35425_Watchdog_Action
+{
+    DM35425_WATCHDOG_REPORT = 0, /*!< Call the stall handler and keep waiting. */
+    DM35425_WATCHDOG_REARM,      /*!< Call the stall handler and restart the stalled ADC with {@link DM35425_Adc_Start_Rearm}. */
+    DM35425_WATCHDOG_ABORT,      /*!< Call the stall handler, pass -DM35425_INVALID_IRQ_TIMEOUT to the ISR and stop acquisition. */
+};
+
+/**
+ * @brief Called from the ISR thread when a board has not interrupted within the watchdog timeout.
+ *
+ * @param board Index of the stalled board, in the order given to {@link DM35425_ADC_Multiboard_Init}.
+ * @param handle Handle of the stalled board.
+ * @param waited_ns Time since the last interrupt from this board (or since the ISR was installed), in nanoseconds.
+ * @param user_data User data passed to {@link DM35425_ADC_Multiboard_InstallISR}.
+ */
+typedef void (*DM35425_Multiboard_Stall_Handler)(int board, DM35425_ADCDMA_Descriptor *_Nonnull handle, uint64_t waited_ns, void *_Nullable user_data);
+
 /**
  * @brief Open a single ADC board.
  *
@@ -134,6 +233,89 @@ int DM35425_ADCDMA_Close(DM35425_ADCDMA_Descriptor *_Nonnull handle);
  */
 int DM35425_ADCDMA_Configure_ADC(DM35425_ADCDMA_Descriptor *_Nonnull handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, enum DM35425_Input_Mode input_mode, enum DM35425_Input_Ranges range);
 
+/**
+ * @brief Configure a single ADC board with only some channels active. Only the active channels get DMA, local buffers,
+ * readout and conversion, and only they are reported in {@link DM35425_ADCDMA_Readout}; the others are disabled.
+ *
+ * In differential mode, channel n (0-15) is the pair AIN(m)+ / AIN(m+8)- with m = n % 8 + (n / 8) * 16, i.e. pairs 0-7
+ * are AIN0-7 against AIN8-15 and pairs 8-15 are AIN16-23 against AIN24-31.
+ *
+ * @param handle Handle to the ADC board.
+ * @param rate Sample rate of the ADC board (in Hz).
+ * @param samples_per_buf Number of samples to be collected before the ADC board triggers an interrupt.
+ * @param delay Delay between sampling of different channels. See {@link DM35425_Channel_Delay} for possible values.
+ * @param input_mode Input mode of the ADC board, see {@link DM35425_ADCDMA_Configure_ADC}.
+ * @param range Input range of the ADC board. See {@link DM35425_Input_Ranges} for possible values.
+ * @param channel_mask Bit n selects channel n. Bits 0-31 in single-ended mode, 0-15 in differential mode. Must not be 0.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADCDMA_Configure_ADC_Mask(DM35425_ADCDMA_Descriptor *_Nonnull handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, enum DM35425_Input_Mode input_mode, enum DM35425_Input_Ranges range, uint32_t channel_mask);
+
+/**
+ * @brief Input mode and range of one channel, see {@link DM35425_ADCDMA_Configure_ADC_Channels}.
+ *
+ */
+struct DM35425_ADCDMA_Channel_Config
+{
+    int channel;                        /*!< Physical input, 0-31. A differential channel is given by its positive input, one of 0-7 or 16-23, and also takes input channel + 8. */
+    enum DM35425_Input_Mode input_mode; /*!< Single-ended or differential */
+    enum DM35425_Input_Ranges range;    /*!< Input range */
+};
+
+/**
+ * @brief Configure a single ADC board with its own input mode and range for every channel, for example a few
+ * differential channels at a low range next to single-ended ones at +/-10 V. Channels that are not listed are disabled.
+ * Readouts list the active channels in ascending order of physical input, with `channels` giving the physical input
+ * and `ranges` the range of each.
+ *
+ * @param handle Handle to the ADC board.
+ * @param rate Sample rate of the ADC board (in Hz).
+ * @param samples_per_buf Number of samples to be collected before the ADC board triggers an interrupt.
+ * @param delay Delay between sampling of different channels. See {@link DM35425_Channel_Delay} for possible values.
+ * @param num_channels Number of entries in `channels`, 1 to 32.
+ * @param channels Channels to sample. Inputs must not repeat or overlap with the negative input of a differential channel.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADCDMA_Configure_ADC_Channels(DM35425_ADCDMA_Descriptor *_Nonnull handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, int num_channels, const struct DM35425_ADCDMA_Channel_Config *_Nonnull channels);
+
+/**
+ * @brief How the sample memory of a board is allocated, see {@link DM35425_ADCDMA_Set_Buffer_Memory}. The flags can be or-ed together.
+ *
+ */
+enum DM35425_Buffer_Memory
+{
+    DM35425_BUFFER_MEMORY_DEFAULT = 0,  /*!< 64-byte aligned heap memory. */
+    DM35425_BUFFER_MEMORY_HUGEPAGE = 1, /*!< Back the buffers with huge pages: explicit huge pages if any are reserved, transparent huge pages otherwise. */
+    DM35425_BUFFER_MEMORY_MLOCK = 2,    /*!< Lock the buffers in RAM. Configuring fails if they cannot be locked (see RLIMIT_MEMLOCK). */
+};
+
+/**
+ * @brief Select how the sample memory of a board is allocated. All local DMA buffers and voltage buffers of a board
+ * are carved from one 64-byte aligned block, with every channel in its own 64-byte aligned row, that is allocated by
+ * {@link DM35425_ADCDMA_Configure_ADC_Mask} and kept until the board is configured again or closed. The flags take
+ * effect at the next configure.
+ *
+ * @param handle Handle to the ADC board.
+ * @param flags Or-ed {@link DM35425_Buffer_Memory} flags.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADCDMA_Set_Buffer_Memory(DM35425_ADCDMA_Descriptor *_Nonnull handle, unsigned int flags);
+
+/**
+ * @brief Decimate the voltages of a board in the multi-board ISR. Each channel is low-pass filtered and resampled
+ * by the decimation factor on the raw codes (see {@link DM35425_Decimator_Create}), so readouts carry
+ * samples_per_buf / factor voltages per channel, or the same number of interleaved rows. The filter history
+ * carries over from one buffer to the next and is cleared after an overrun. `raw` still holds every sample.
+ *
+ * Takes effect at the next {@link DM35425_ADC_Multiboard_InstallISR}, which fails with EINVAL if samples_per_buf is
+ * not a multiple of the factor or in {@link DM35425_READOUT_RAW} mode.
+ *
+ * @param handle Handle to the ADC board.
+ * @param decimation Decimation settings, copied. NULL or {@link DM35425_DECIMATE_NONE} to turn decimation off (the default).
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADCDMA_Set_Decimation(DM35425_ADCDMA_Descriptor *_Nonnull handle, const struct DM35425_Decimation *_Nullable decimation);
+
 /**
  * @brief Combine multiple ADC boards into a single structure.
  *
@@ -168,6 +350,20 @@ int DM35425_ADC_Multiboard_Destroy(DM35425_Multiboard_Descriptor *_Nonnull mbd);
  */
 int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Multiboard_ISR isr, void *_Nullable user_data, bool block);
 
+/**
+ * @brief Install the interrupt service routine for the multi-board ADCs with real-time thread settings.
+ * Scheduling policy, CPU set, stack size, memory locking and buffer prefaulting from `attr` are all applied
+ * before the ADCs are started, and a failure to apply any of them fails the install.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param isr Interrupt service routine. See {@link DM35425_Multiboard_ISR} for details.
+ * @param user_data Pointer to user data to be passed to the ISR. Can be NULL.
+ * @param block Whether the installer blocks indefinitely. See {@link DM35425_ADC_Multiboard_InstallISR}.
+ * @param attr Thread settings, see {@link DM35425_ISR_Attr}. NULL for the defaults. Busy-polling (`attr->poll`) is not supported here.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_InstallISR_Attr(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Multiboard_ISR isr, void *_Nullable user_data, bool block, const struct DM35425_ISR_Attr *_Nullable attr);
+
 /**
  * @brief Remove the interrupt service routine for the multi-board ADCs. This function is called automatically by {@link DM35425_ADC_Multiboard_Destroy}.
  *
@@ -176,15 +372,179 @@ int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *_Nonnull mb
  */
 int DM35425_ADC_Multiboard_RemoveISR(DM35425_Multiboard_Descriptor *_Nonnull mbd);
 
+/**
+ * @brief Choose whether the multi-board ISR converts samples to volts before calling the ISR. In {@link DM35425_READOUT_RAW} mode
+ * the conversion pass and the voltage buffers are skipped entirely, and the ISR only gets `raw` and `ranges`.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param mode Readout mode, see {@link DM35425_Readout_Mode}.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Readout_Mode(DM35425_Multiboard_Descriptor *_Nonnull mbd, enum DM35425_Readout_Mode mode);
+
+/**
+ * @brief Enable the stall watchdog for the multi-board ISR. Each board is expected to interrupt once every
+ * samples_per_buf / rate seconds, using the requested rate. If a board has not interrupted
+ * within `timeout_factor` of those periods, `handler` is called and `action` is taken.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param timeout_factor Stall timeout in expected buffer periods, e.g. 3.0. 0 disables the watchdog (the default).
+ * @param action What to do once a stall is detected. See {@link DM35425_Watchdog_Action}.
+ * @param handler Stall handler. Can be NULL.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Watchdog(DM35425_Multiboard_Descriptor *_Nonnull mbd, double timeout_factor, enum DM35425_Watchdog_Action action, DM35425_Multiboard_Stall_Handler _Nullable handler);
+
+/**
+ * @brief Read each board on its own thread instead of servicing all boards from one select() loop.
+ * Each reader waits on, reads out and converts its own board, then waits at a barrier. The last reader to
+ * arrive calls the ISR once every board has delivered a buffer for the frame, and releases the others when it returns.
+ * Readout and conversion of different boards then overlap on different CPUs.
+ *
+ * The stall handler, if any, may be called from several readers at once. {@link DM35425_Multiboard_SetISRPriority}
+ * and {@link DM35425_Multiboard_SetISRAffinity} apply to every reader.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param parallel true for one reader thread per board, false for the single ISR thread (the default).
+ * @param cpusets Array of one CPU set per board, in the order given to {@link DM35425_ADC_Multiboard_Init}, to pin each reader
+ * to CPUs close to its board (e.g. the `local_cpulist` of the board's PCI device). The sets are copied. NULL keeps the CPU set
+ * from the attributes passed to {@link DM35425_ADC_Multiboard_InstallISR_Attr}.
+ * @param cpusetsize Size in bytes of each set in `cpusets`.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Parallel(DM35425_Multiboard_Descriptor *_Nonnull mbd, bool parallel, const cpu_set_t *_Nullable cpusets, size_t cpusetsize);
+
+/**
+ * @brief Hand frames to a consumer thread through a ring instead of calling the ISR with them. Each frame is copied
+ * into a preallocated slot of a single-producer/single-consumer ring, so a slow consumer never holds up the DMA readout.
+ * When the ring is full the new frame is dropped and counted. The ISR is then only called with errors.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param depth Number of frames the ring holds. 0 disables the ring (the default).
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Frame_Ring(DM35425_Multiboard_Descriptor *_Nonnull mbd, size_t depth);
+
+/**
+ * @brief Let boards run at integer multiples of each other's buffer rate. The frame period becomes the longest buffer
+ * period (samples_per_buf / rate) of any board, and a board whose buffer period is k times shorter delivers its last k
+ * buffers per frame, joined into one readout of k * samples_per_buf samples per channel. Every frame then covers the
+ * same stretch of time on every board. Without batching every board delivers one buffer per frame.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}, which fails with EINVAL if a ratio is not an
+ * integer or is larger than the number of DMA buffers. Ratios are taken from the requested rates, so choose rates the
+ * sample clock can produce exactly.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param batching true to batch buffers of faster boards.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Batching(DM35425_Multiboard_Descriptor *_Nonnull mbd, bool batching);
+
+/**
+ * @brief Compute the minimum, maximum, sum, sum of squares and count of the raw samples of every channel in every
+ * readout, in one vectorized pass (see {@link DM35425_Adc_Samples_Stats}), and keep running totals since install.
+ * Readouts point to both in `stats` and `totals`; {@link DM35425_Adc_Stats_To_Volts} gives mean, RMS and
+ * peak-to-peak. Combine with {@link DM35425_READOUT_RAW} to get statistics without converting any voltages.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param statistics true to compute statistics, false not to (the default).
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Statistics(DM35425_Multiboard_Descriptor *_Nonnull mbd, bool statistics);
+
+/**
+ * @brief Convert the boards into one sample-major frame, `interleaved[num_samples][frame_channels]`, instead of a
+ * row of voltages per channel. Board 0's channels come first, then board 1's and so on. Conversion and transpose are
+ * done in one pass, see {@link DM35425_Adc_Samples_To_Volts_Interleaved}. `voltages` is NULL in every readout; `raw`
+ * is unchanged.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}, which fails with EINVAL in
+ * {@link DM35425_READOUT_RAW} mode or if the boards deliver different numbers of samples per frame.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param interleaved true for an interleaved frame, false for per-channel voltages (the default).
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Set_Interleaved(DM35425_Multiboard_Descriptor *_Nonnull mbd, bool interleaved);
+
+/**
+ * @brief Append a processing stage. Stages run in the order they were added, on the acquisition thread, after every
+ * board of a frame has been converted and before the frame is passed to the ISR or copied into the frame ring.
+ *
+ * Must be called before {@link DM35425_ADC_Multiboard_InstallISR}. Stages stay installed until
+ * {@link DM35425_ADC_Multiboard_Clear_Stages}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param stage Stage function.
+ * @param ctx Context passed to the stage, may be NULL.
+ * @return int 0 on success, -1 on failure. Errno is ENOSPC if {@link DM35425_MULTIBOARD_MAX_STAGES} stages are
+ * already installed.
+ */
+int DM35425_ADC_Multiboard_Add_Stage(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Multiboard_Stage _Nonnull stage, void *_Nullable ctx);
+
+/**
+ * @brief Remove every processing stage. Must be called before {@link DM35425_ADC_Multiboard_InstallISR}.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Clear_Stages(DM35425_Multiboard_Descriptor *_Nonnull mbd);
+
+/**
+ * @brief Get the oldest frame from the frame ring. The same frame is returned until it is released with
+ * {@link DM35425_ADC_Multiboard_Release_Frame}. Only one thread may consume frames.
+ *
+ * Frames left in the ring can still be taken after acquisition stops, until the ISR is installed again or the descriptor is destroyed.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param frame Returned frame.
+ * @param timeout_ns How long to wait for a frame, in nanoseconds. 0 polls, negative waits forever.
+ * @return int 0 on success, -1 on failure. Errno is EAGAIN when polling an empty ring, ETIMEDOUT when the wait timed out,
+ * ESHUTDOWN when the ring is empty and acquisition has stopped, EINVAL if the ring is not enabled.
+ */
+int DM35425_ADC_Multiboard_Get_Frame(DM35425_Multiboard_Descriptor *_Nonnull mbd, struct DM35425_Multiboard_Frame *_Nonnull *_Nonnull frame, int64_t timeout_ns);
+
+/**
+ * @brief Give the frame returned by {@link DM35425_ADC_Multiboard_Get_Frame} back to the ring.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_ADC_Multiboard_Release_Frame(DM35425_Multiboard_Descriptor *_Nonnull mbd);
+
 /**
  * @brief Set the priority of the interrupt service routine for the multi-board ADCs.
+ * Prefer setting `sched_policy` through {@link DM35425_ADC_Multiboard_InstallISR_Attr}, which takes effect before the first interrupt.
  * 
  * @param handle Handle to the multi-board descriptor.
  * @param priority ISR thread priority. See {@link pthread_setschedparam} for details.
- * @return int 0 on success, non-zero on failure.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
  */
 int DM35425_Multiboard_SetISRPriority(DM35425_Multiboard_Descriptor *_Nonnull handle, int priority);
 
+/**
+ * @brief Snapshot the acquisition loop timing. Safe to call from any thread while the ISR is running; the histograms are
+ * recorded without locks, so a snapshot may be off by the frame in flight. The statistics are reset when the ISR is installed.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param stats Loop-wide timing.
+ * @param readout Array of per-board DMA readout durations, in the order the boards were given to {@link DM35425_ADC_Multiboard_Init}. Can be NULL if `num_readout` is 0.
+ * @param num_readout Length of `readout`. Boards beyond this are not reported.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Multiboard_Get_Stats(DM35425_Multiboard_Descriptor *_Nonnull mbd, struct DM35425_Multiboard_Stats *_Nonnull stats, struct DM35425_Latency_Summary *_Nullable readout, int num_readout);
+
 #if (defined(__linux__ ) || defined(_POSIX_VERSION)) && defined(_GNU_SOURCE)
 
 /**
@@ -0,0 +1,243 @@
+/**
+ * @file dm35425_adc_overview.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Multi-resolution min/max/mean overview of a recording, for plotting long captures.
+ * @version 1.0
+ * @date 2023-06-09
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * An overview is a pyramid per channel: level 0 summarizes every `bucket_samples` raw samples (the smallest power of
+ * the factor k of at least {@link DM35425_OVERVIEW_MIN_BUCKET}) into a {@link DM35425_Overview_Bucket}, and each level
+ * above summarizes k buckets of the one below. Buckets are aligned to multiples of their length in sample position,
+ * so a bucket of a level lines up with k of the level below, and positions that were not recorded get empty buckets.
+ * The recorder builds the overview of each file while recording and writes it next to the file as <name>.ovw when the
+ * file ends; {@link DM35425_Overview_Build} builds it from the file afterwards. Level 0 adds 8 bytes per
+ * `bucket_samples` samples per channel, about 3% of the recording for k = 16.
+ *
+ * An overview file holds a {@link DM35425_Overview_Header}, then a {@link DM35425_Overview_Level} per level per channel
+ * (levels[num_columns][num_levels], the channels of board 0 first), then the buckets the levels point to. All fields
+ * are in host byte order.
+ */
+
+#ifndef _DM35425_ADC_OVERVIEW__H_
+#define _DM35425_ADC_OVERVIEW__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "dm35425_adc_recording.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief First bytes of an overview file.
+ *
+ */
+#define DM35425_OVERVIEW_MAGIC "DM35425O"
+
+/**
+ * @brief Version of the overview file layout.
+ *
+ */
+#define DM35425_OVERVIEW_VERSION 1
+
+/**
+ * @brief Fewest raw samples per bucket of level 0. Finer envelopes are computed from the samples.
+ *
+ */
+#define DM35425_OVERVIEW_MIN_BUCKET 256
+
+/**
+ * @brief Most levels of an overview.
+ *
+ */
+#define DM35425_OVERVIEW_MAX_LEVELS 24
+
+/**
+ * @brief Start of an overview file.
+ *
+ */
+struct DM35425_Overview_Header
+{
+    char magic[8];        /*!< {@link DM35425_OVERVIEW_MAGIC}, not NUL terminated */
+    uint32_t version;     /*!< {@link DM35425_OVERVIEW_VERSION} */
+    uint32_t factor;      /*!< Buckets of a level per bucket of the level above */
+    uint32_t num_columns; /*!< Channels of all boards */
+    uint32_t num_levels;  /*!< Levels per channel */
+    uint64_t reserved;    /*!< 0 */
+};
+
+/**
+ * @brief One level of one channel.
+ *
+ */
+struct DM35425_Overview_Level
+{
+    uint64_t bucket_samples; /*!< Raw samples per bucket */
+    uint64_t first_bucket;   /*!< Sample position of the first bucket divided by bucket_samples */
+    uint64_t num_buckets;    /*!< Number of buckets */
+    uint64_t offset;         /*!< Position of the buckets in the file */
+};
+
+/**
+ * @brief Summary of the samples of one bucket. A bucket with nothing recorded has min greater than max.
+ *
+ */
+struct DM35425_Overview_Bucket
+{
+    int16_t min; /*!< Smallest raw code */
+    int16_t max; /*!< Largest raw code */
+    float mean;  /*!< Mean raw code */
+};
+
+/**
+ * @brief One point of an envelope, see {@link DM35425_Overview_Envelope}.
+ *
+ */
+struct DM35425_Overview_Point
+{
+    uint64_t first_sample;   /*!< Position of the first sample the point covers */
+    uint64_t bucket_samples; /*!< Raw samples per bucket the point was computed from, 1 if from the samples */
+    int16_t min;             /*!< Smallest raw code, greater than max if nothing was recorded */
+    int16_t max;             /*!< Largest raw code */
+    float mean;              /*!< Mean of the buckets (or samples) that were recorded */
+};
+
+/**
+ * @brief Opaque overview builder.
+ *
+ */
+typedef struct _DM35425_Overview_Builder DM35425_Overview_Builder;
+
+/**
+ * @brief Create an empty overview for a recording layout.
+ *
+ * @param builder Pointer to the builder to create.
+ * @param factor Buckets of a level per bucket of the level above, 2 or more. 0 for 16.
+ * @param num_boards Number of boards.
+ * @param layout Layout of each board, as in the recording header.
+ * @return int 0 on success, -1 with errno EINVAL or ENOMEM.
+ */
+int DM35425_Overview_Builder_Create(DM35425_Overview_Builder *_Nullable *_Nonnull builder, unsigned factor, int num_boards, const struct DM35425_Recording_Board *_Nonnull layout);
+
+/**
+ * @brief Add consecutive samples of one channel. Positions must grow for each channel; a jump forward is a gap.
+ *
+ * @param builder Builder.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param first_sample Position of the first sample on the board.
+ * @param samples Raw codes.
+ * @param count Number of samples.
+ * @return int 0 on success, -1 with errno EINVAL for a bad channel or a position before the last one added, or ENOMEM.
+ */
+int DM35425_Overview_Builder_Add(DM35425_Overview_Builder *_Nonnull builder, int board, int channel, uint64_t first_sample, const int32_t *_Nonnull samples, size_t count);
+
+/**
+ * @brief Close the last buckets and write the overview file. The builder cannot be added to afterwards.
+ *
+ * @param builder Builder.
+ * @param path Name of the overview file.
+ * @return int 0 on success, -1 with errno set by open or write.
+ */
+int DM35425_Overview_Builder_Write(DM35425_Overview_Builder *_Nonnull builder, const char *_Nonnull path);
+
+/**
+ * @brief Free a builder.
+ *
+ * @param builder Builder, may be NULL.
+ */
+void DM35425_Overview_Builder_Free(DM35425_Overview_Builder *_Nullable builder);
+
+/**
+ * @brief Get the name of the overview of a recording file: the name with its .dat extension, if any, replaced by .ovw.
+ *
+ * @param recording Name of the recording file.
+ * @return char* Name to be freed, or NULL with errno ENOMEM.
+ */
+char *_Nullable DM35425_Overview_Path(const char *_Nonnull recording);
+
+/**
+ * @brief Build the overview of a recording file from its samples and write it next to the file.
+ *
+ * @param recording Name of the recording file.
+ * @param factor Buckets of a level per bucket of the level above, 2 or more. 0 for 16.
+ * @return int 0 on success, -1 with errno set as by {@link DM35425_Recording_Map_Open} or
+ * {@link DM35425_Overview_Builder_Write}.
+ */
+int DM35425_Overview_Build(const char *_Nonnull recording, unsigned factor);
+
+/**
+ * @brief Opaque overview opened for queries.
+ *
+ */
+typedef struct _DM35425_Overview DM35425_Overview;
+
+/**
+ * @brief Map a recording file and its overview. Several threads may query one overview.
+ *
+ * @param ovw Pointer to the overview to open.
+ * @param recording Name of the recording file.
+ * @return int 0 on success, -1 on failure. Errno is ENOENT if the file has no overview, EBADMSG if the overview is
+ * corrupt or of another recording, or as for {@link DM35425_Recording_Map_Open}.
+ */
+int DM35425_Overview_Open(DM35425_Overview *_Nullable *_Nonnull ovw, const char *_Nonnull recording);
+
+/**
+ * @brief Unmap an overview and its recording.
+ *
+ * @param ovw Overview, may be NULL.
+ */
+void DM35425_Overview_Close(DM35425_Overview *_Nullable ovw);
+
+/**
+ * @brief Get the mapped recording, e.g. for its header and layout.
+ *
+ * @param ovw Overview.
+ * @return DM35425_Recording_Map* Map, valid until the overview is closed.
+ */
+DM35425_Recording_Map *_Nonnull DM35425_Overview_Get_Map(DM35425_Overview *_Nonnull ovw);
+
+/**
+ * @brief Summarize a span of one channel into evenly spaced points for plotting. Each point is computed from the
+ * coarsest level whose buckets are no longer than the point, or from the samples when a point is shorter than a
+ * level 0 bucket, so at most about factor x num_points buckets or DM35425_OVERVIEW_MIN_BUCKET x num_points samples
+ * are read whatever the length of the span. Points where buckets straddle their edges include the whole bucket.
+ * Samples are read through the overview's map, which keeps decoded chunks of a compressed recording; release them with
+ * {@link DM35425_Recording_Map_Release} while no query is running to bound memory over many queries.
+ *
+ * @param ovw Overview.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param first_sample Position of the first sample of the span on the board.
+ * @param count Samples in the span.
+ * @param num_points Number of points wanted.
+ * @param points Returned points, num_points of them.
+ * @return ssize_t Number of points, num_points or count if that is smaller, or -1 with errno EINVAL.
+ */
+ssize_t DM35425_Overview_Envelope(DM35425_Overview *_Nonnull ovw, int board, int channel, uint64_t first_sample, uint64_t count, size_t num_points, struct DM35425_Overview_Point *_Nonnull points);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_OVERVIEW__H_
@@ -0,0 +1,186 @@
+/**
+ * @file dm35425_adc_recorder.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Binary recorder for the multiboard ADC stream, writing from its own thread with large aligned (O_DIRECT) writes.
+ * The file format is described in dm35425_adc_recording.h.
+ * @version 1.0
+ * @date 2023-06-01
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef _DM35425_ADC_RECORDER__H_
+#define _DM35425_ADC_RECORDER__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm35425_adc_multiboard.h"
+#include "dm35425_adc_recording.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief Recorder settings.
+ *
+ */
+struct DM35425_Recorder_Config
+{
+    const char *_Nonnull path;  /*!< File name prefix; files are named <path>_000000.dat, <path>_000001.dat and so on */
+    size_t block_size;          /*!< Bytes per write, a multiple of 4096. 0 for 4 MiB. */
+    int num_blocks;             /*!< Blocks queued between the producer and the writer thread, 4 or more. 0 for 16. */
+    uint64_t rotate_bytes;      /*!< Start a new file before one grows past this size, 0 never to rotate by size. A file also
+                                     ends when its index would take up half the blocks. */
+    uint64_t rotate_ns;         /*!< Start a new file once the first frame in the file is this old, 0 never to rotate by time */
+    uint64_t preallocate_bytes; /*!< Space reserved with fallocate for each file, 0 for rotate_bytes. The file is truncated when it is closed. */
+    bool buffered;              /*!< Write through the page cache instead of with O_DIRECT */
+    bool overview;              /*!< Build the min/max/mean overview of each file while recording and write it next to
+                                     the file as <path>_000000.ovw and so on, see dm35425_adc_overview.h */
+    unsigned overview_factor;   /*!< Factor between overview levels, 2 or more. 0 for 16. */
+    bool compress;              /*!< Store the samples losslessly compressed (see dm35425_adc_codec.h), encoding them on a
+                                     thread of their own */
+    int compress_frames;        /*!< Frames queued between the producer and the encoder thread, 2 or more. 0 for 8. */
+};
+
+/**
+ * @brief Recorder statistics, see {@link DM35425_Recorder_Get_Stats}.
+ *
+ */
+struct DM35425_Recorder_Stats
+{
+    uint64_t frames;                      /*!< Frames recorded */
+    uint64_t frames_dropped;              /*!< Frames dropped because every block (or frame of the encoder) was waiting, or after a write error */
+    uint64_t bytes_written;               /*!< Bytes written to disk */
+    uint64_t files;                       /*!< Files opened */
+    int backlog;                          /*!< Blocks waiting for the writer thread now */
+    int max_backlog;                      /*!< Most blocks ever waiting for the writer thread */
+    double throughput;                    /*!< Bytes written per second, from the start of the first write to the end of the last */
+    struct DM35425_Latency_Summary write; /*!< Duration of each block write (ns) */
+    int error;                            /*!< errno of the first failed file operation, 0 if none */
+    int overview_error;                   /*!< errno of the first overview that could not be built or written, 0 if
+                                               none. The recording goes on without it. */
+};
+
+/**
+ * @brief Compression statistics of one channel, see {@link DM35425_Recorder_Get_Channel_Stats}.
+ *
+ */
+struct DM35425_Recorder_Channel_Stats
+{
+    uint64_t samples;       /*!< Samples encoded and recorded */
+    uint64_t encoded_bytes; /*!< Bytes they were encoded to */
+    double ratio;           /*!< Bytes of the samples as int16_t per encoded byte */
+    double encode_rate;     /*!< MB of samples as int16_t encoded per second spent encoding */
+};
+
+/**
+ * @brief Opaque recorder.
+ *
+ */
+typedef struct _DM35425_Recorder DM35425_Recorder;
+
+/**
+ * @brief Create a recorder and start its writer thread. Frames are packed into large page-aligned blocks by the
+ * producer, and the writer thread writes full blocks with O_DIRECT (falling back to buffered writes where the file
+ * system does not support it). A frame that does not fit in the free blocks is dropped rather than making the
+ * producer wait, so the acquisition thread never blocks on the disk. With `compress`, the producer only copies each
+ * frame into a queue, and an encoder thread compresses it and packs it into the blocks; a frame that finds the queue
+ * full is dropped.
+ *
+ * @param rec Pointer to the recorder to create.
+ * @param config Settings.
+ * @return int 0 on success, -1 with errno EINVAL for bad settings, ENOMEM, or an error from pthread_create.
+ */
+int DM35425_Recorder_Create(DM35425_Recorder *_Nullable *_Nonnull rec, const struct DM35425_Recorder_Config *_Nonnull config);
+
+/**
+ * @brief Record one frame as a chunk. The layout of the recording is taken from the first frame; later frames must
+ * have the same boards, channels and lengths. Only one thread may record.
+ *
+ * @param rec Recorder.
+ * @param num_boards Number of boards.
+ * @param readouts The frame, e.g. from {@link DM35425_ADC_Multiboard_Get_Frame}.
+ * @return int 0 on success, -1 on failure. Errno is ENOBUFS if the frame was dropped because the writer (or the
+ * encoder) is behind, EINVAL if the layout changed or a frame is too large for the blocks, or the error that stopped
+ * the writer. A compressed frame can still be dropped by the encoder, which is counted in the statistics.
+ */
+int DM35425_Recorder_Record(DM35425_Recorder *_Nonnull rec, int num_boards, const struct DM35425_ADCDMA_Readout *_Nonnull readouts);
+
+/**
+ * @brief Record one frame like {@link DM35425_Recorder_Record}, but refuse a frame that finds the blocks (or the
+ * encoder's queue) full without side effects: it is not counted as dropped and takes no sequence number, so the
+ * caller can wait and offer the same frame again. For producers that can afford to wait, such as one with DMA buffers
+ * to spare.
+ *
+ * @param rec Recorder.
+ * @param num_boards Number of boards.
+ * @param readouts The frame.
+ * @return int 0 on success, -1 on failure. Errno is ENOBUFS if the frame was refused and may be offered again, or as
+ * for {@link DM35425_Recorder_Record}, which counts the frame as dropped.
+ */
+int DM35425_Recorder_Try_Record(DM35425_Recorder *_Nonnull rec, int num_boards, const struct DM35425_ADCDMA_Readout *_Nonnull readouts);
+
+/**
+ * @brief Install the recorder as a processing stage (see {@link DM35425_ADC_Multiboard_Add_Stage}) that records every
+ * frame on the acquisition thread. It never holds a frame back. Dropped frames are counted in the statistics.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param rec Recorder; must outlive the acquisition.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Recorder_Add_Stage(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Recorder *_Nonnull rec);
+
+/**
+ * @brief Snapshot the recorder statistics. Safe to call from any thread.
+ *
+ * @param rec Recorder.
+ * @param stats Returned statistics.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Recorder_Get_Stats(DM35425_Recorder *_Nonnull rec, struct DM35425_Recorder_Stats *_Nonnull stats);
+
+/**
+ * @brief Snapshot the compression statistics of one channel. Safe to call from any thread.
+ *
+ * @param rec Recorder.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param stats Returned statistics.
+ * @return int 0 on success, -1 on failure. Errno is ENODATA if the recorder does not compress or has not had a frame
+ * yet, or EINVAL for a bad board or channel.
+ */
+int DM35425_Recorder_Get_Channel_Stats(DM35425_Recorder *_Nonnull rec, int board, int channel, struct DM35425_Recorder_Channel_Stats *_Nonnull stats);
+
+/**
+ * @brief Write the index of the current file and everything queued, stop the writer thread and free the recorder.
+ * Recording must have stopped.
+ *
+ * @param rec Recorder, may be NULL.
+ * @return int 0 on success, -1 with errno set to the first write error.
+ */
+int DM35425_Recorder_Close(DM35425_Recorder *_Nullable rec);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_RECORDER__H_
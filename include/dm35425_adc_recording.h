@@ -0,0 +1,406 @@
+/**
+ * @file dm35425_adc_recording.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Recording file format written by {@link DM35425_Recorder_Create}, and a reader for it.
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * A recording file is self-describing. It holds, in order:
+ *
+ * 1. A {@link DM35425_Recording_Header}, followed by one {@link DM35425_Recording_Board} per board: channels, input
+ *    ranges and sample rates.
+ * 2. Chunks, all of the header's `chunk_size` bytes, one per frame of the acquisition. A chunk is a
+ *    {@link DM35425_Recording_Chunk}; per board a {@link DM35425_Recording_Readout} followed by the raw codes as
+ *    int16_t, channel-major (samples[num_channels][frame_samples]) and padded with zeros to a multiple of 8 bytes; and
+ *    a {@link DM35425_Recording_Chunk_End} with the CRC-32C of everything before it in the chunk.
+ * 3. An index of one {@link DM35425_Recording_Index_Entry} per chunk.
+ * 4. A {@link DM35425_Recording_Trailer}, in the last bytes of the file.
+ *
+ * All fields are in host byte order, and every structure starts on a multiple of 8 bytes. A file that was not closed
+ * has no index; the reader then rebuilds it by walking the chunks.
+ *
+ * A file whose header has `codec` {@link DM35425_RECORDING_CODEC_DELTA} stores each board's samples compressed: the
+ * {@link DM35425_Recording_Readout} is followed by every channel coded by {@link DM35425_Codec_Encode}, back to back,
+ * and then zeros to a multiple of 8 bytes. Its chunks then vary in length, each chunk's `size` giving its own, and
+ * `chunk_size` is the length of a chunk once decoded. The reader decodes such chunks into the uncompressed layout, so
+ * callers see no difference.
+ */
+
+#ifndef _DM35425_ADC_RECORDING__H_
+#define _DM35425_ADC_RECORDING__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "dm35425.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief First bytes of a recording file.
+ *
+ */
+#define DM35425_RECORDING_MAGIC "DM35425R"
+
+/**
+ * @brief First bytes of the trailer of a recording file.
+ *
+ */
+#define DM35425_RECORDING_INDEX_MAGIC "DM35425I"
+
+/**
+ * @brief Version of the recording file layout.
+ *
+ */
+#define DM35425_RECORDING_VERSION 2
+
+/**
+ * @brief First word of every chunk.
+ *
+ */
+#define DM35425_RECORDING_CHUNK_MAGIC 0x4B4E4843U
+
+/**
+ * @brief How the samples of a recording are stored.
+ *
+ */
+enum DM35425_Recording_Codec
+{
+    DM35425_RECORDING_CODEC_RAW = 0, /*!< Raw codes as int16_t */
+    DM35425_RECORDING_CODEC_DELTA,   /*!< Each channel delta coded and bit-packed, see dm35425_adc_codec.h */
+};
+
+/**
+ * @brief Start of a recording file.
+ *
+ */
+struct DM35425_Recording_Header
+{
+    char magic[8];        /*!< {@link DM35425_RECORDING_MAGIC}, not NUL terminated */
+    uint32_t version;     /*!< {@link DM35425_RECORDING_VERSION} */
+    uint32_t num_boards;  /*!< Number of boards in every chunk */
+    uint32_t file_index;  /*!< Position of this file in a rotated recording, from 0 */
+    uint32_t header_size; /*!< Bytes from the start of the file to the first chunk */
+    uint64_t start_ns;    /*!< Timestamp of the first chunk of the file, CLOCK_MONOTONIC (ns) */
+    uint32_t chunk_size;  /*!< Bytes of every chunk, once decoded */
+    uint32_t codec;       /*!< How the samples are stored, a {@link DM35425_Recording_Codec} value */
+};
+
+/**
+ * @brief Layout of one board in a recording.
+ *
+ */
+struct DM35425_Recording_Board
+{
+    uint32_t num_channels;                          /*!< Number of active channels */
+    uint32_t frame_samples;                         /*!< Raw samples per channel in each chunk */
+    uint32_t sample_rate;                           /*!< Raw sample rate (Hz), 0 if unknown */
+    uint32_t reserved;                              /*!< 0 */
+    int32_t channels[DM35425_NUM_ADC_DMA_CHANNELS]; /*!< Channel number of each row, like the readout's `channels` */
+    int32_t ranges[DM35425_NUM_ADC_DMA_CHANNELS];   /*!< Input range of each row, an {@link DM35425_Input_Ranges} value */
+};
+
+/**
+ * @brief Start of a chunk.
+ *
+ */
+struct DM35425_Recording_Chunk
+{
+    uint32_t magic;        /*!< {@link DM35425_RECORDING_CHUNK_MAGIC} */
+    uint32_t size;         /*!< Bytes of the chunk as stored, the header's `chunk_size` unless it is compressed */
+    uint64_t sequence;     /*!< Frame number since the recorder was created, counting dropped frames */
+    uint64_t first_sample; /*!< Position of the chunk's first raw sample on board 0, since the ISR was installed */
+    uint64_t timestamp_ns; /*!< Timestamp of board 0's samples, CLOCK_MONOTONIC (ns) */
+};
+
+/**
+ * @brief One board of a chunk, followed by its samples.
+ *
+ */
+struct DM35425_Recording_Readout
+{
+    uint64_t sequence;     /*!< The readout's `sequence` */
+    uint64_t first_sample; /*!< Position of the first raw sample on this board, since the ISR was installed */
+    uint64_t timestamp_ns; /*!< The readout's `timestamp_ns` */
+    uint64_t dropped;      /*!< The readout's `dropped` */
+};
+
+/**
+ * @brief End of a chunk.
+ *
+ */
+struct DM35425_Recording_Chunk_End
+{
+    uint32_t crc;      /*!< CRC-32C of the chunk up to here, see {@link DM35425_Recording_Crc} */
+    uint32_t reserved; /*!< 0 */
+};
+
+/**
+ * @brief Index entry of one chunk. Entries are in file order, so `sequence`, `first_sample` and `timestamp_ns` only
+ * grow.
+ *
+ */
+struct DM35425_Recording_Index_Entry
+{
+    uint64_t sequence;     /*!< The chunk's `sequence` */
+    uint64_t first_sample; /*!< The chunk's `first_sample` */
+    uint64_t timestamp_ns; /*!< The chunk's `timestamp_ns` */
+    uint64_t offset;       /*!< Position of the chunk in the file */
+};
+
+/**
+ * @brief End of a recording file.
+ *
+ */
+struct DM35425_Recording_Trailer
+{
+    char magic[8];         /*!< {@link DM35425_RECORDING_INDEX_MAGIC}, not NUL terminated */
+    uint64_t num_chunks;   /*!< Number of chunks and index entries */
+    uint64_t index_offset; /*!< Position of the index in the file */
+    uint32_t crc;          /*!< CRC-32C of the index */
+    uint32_t reserved;     /*!< 0 */
+};
+
+/**
+ * @brief Compute a CRC-32C (Castagnoli), using the SSE4.2 instruction where the CPU has it.
+ *
+ * @param crc CRC of the data before this, 0 to start.
+ * @param data Data.
+ * @param size Bytes of data.
+ * @return uint32_t CRC of the data so far.
+ */
+uint32_t DM35425_Recording_Crc(uint32_t crc, const void *_Nonnull data, size_t size);
+
+/**
+ * @brief Opaque recording file opened for reading.
+ *
+ */
+typedef struct _DM35425_Recording DM35425_Recording;
+
+/**
+ * @brief Open a recording file and load its index, or rebuild the index by walking the chunks if the file was not
+ * closed. Chunk checksums are checked when chunks are read.
+ *
+ * @param rec Pointer to the recording to open.
+ * @param path File name.
+ * @return int 0 on success, -1 on failure. Errno is EBADMSG if the file is not a recording of this version, or set
+ * by open, read or malloc.
+ */
+int DM35425_Recording_Open(DM35425_Recording *_Nullable *_Nonnull rec, const char *_Nonnull path);
+
+/**
+ * @brief Close a recording file.
+ *
+ * @param rec Recording, may be NULL.
+ */
+void DM35425_Recording_Close(DM35425_Recording *_Nullable rec);
+
+/**
+ * @brief Get the file header.
+ *
+ * @param rec Recording.
+ * @return const struct DM35425_Recording_Header* Header, valid until the recording is closed.
+ */
+const struct DM35425_Recording_Header *_Nonnull DM35425_Recording_Get_Header(DM35425_Recording *_Nonnull rec);
+
+/**
+ * @brief Get the layout of a board.
+ *
+ * @param rec Recording.
+ * @param board Board index.
+ * @return const struct DM35425_Recording_Board* Layout, valid until the recording is closed, or NULL with errno
+ * EINVAL for a board the recording does not have.
+ */
+const struct DM35425_Recording_Board *_Nullable DM35425_Recording_Get_Board(DM35425_Recording *_Nonnull rec, int board);
+
+/**
+ * @brief Get the chunk index.
+ *
+ * @param rec Recording.
+ * @param num_chunks Returned number of chunks.
+ * @return const struct DM35425_Recording_Index_Entry* Entries, valid until the recording is closed.
+ */
+const struct DM35425_Recording_Index_Entry *_Nullable DM35425_Recording_Get_Index(DM35425_Recording *_Nonnull rec, size_t *_Nonnull num_chunks);
+
+/**
+ * @brief Find the chunk holding a sample position of board 0 with a binary search of the index.
+ *
+ * @param rec Recording.
+ * @param sample Position on board 0.
+ * @return ssize_t Index of the last chunk starting at or before the position, or -1 with errno ENOENT if the
+ * recording starts after it. The chunk ends before the position if it fell into dropped frames or after the end.
+ */
+ssize_t DM35425_Recording_Find_Sample(DM35425_Recording *_Nonnull rec, uint64_t sample);
+
+/**
+ * @brief Find the chunk recorded at a time with a binary search of the index.
+ *
+ * @param rec Recording.
+ * @param timestamp_ns CLOCK_MONOTONIC time (ns).
+ * @return ssize_t Index of the last chunk with a timestamp at or before the time, or -1 with errno ENOENT if the
+ * recording starts after it.
+ */
+ssize_t DM35425_Recording_Find_Time(DM35425_Recording *_Nonnull rec, uint64_t timestamp_ns);
+
+/**
+ * @brief Read a whole chunk and check its checksum. A compressed chunk is decoded into the uncompressed layout, with
+ * `size` set to the header's `chunk_size` and the {@link DM35425_Recording_Chunk_End} zeroed.
+ *
+ * @param rec Recording.
+ * @param chunk Chunk index.
+ * @param buffer Buffer of the header's `chunk_size` bytes, aligned to 8 bytes.
+ * @return int 0 on success, -1 on failure. Errno is EINVAL for a chunk past the end, EBADMSG if the chunk is
+ * corrupt, or set by read.
+ */
+int DM35425_Recording_Read_Chunk(DM35425_Recording *_Nonnull rec, size_t chunk, void *_Nonnull buffer);
+
+/**
+ * @brief Read the raw codes of one channel from a sample position on, across chunks, up to the first position that
+ * was not recorded. Not for concurrent use on one recording.
+ *
+ * @param rec Recording.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param first_sample Position of the first sample on the board.
+ * @param count Number of samples wanted.
+ * @param samples Returned samples, count of them.
+ * @return ssize_t Number of samples read, 0 if the position is after the end of the recording, or -1 on failure.
+ * Errno is EINVAL for a bad board or channel, ENODATA if the position was not recorded, or as for
+ * {@link DM35425_Recording_Read_Chunk}.
+ */
+ssize_t DM35425_Recording_Read(DM35425_Recording *_Nonnull rec, int board, int channel, uint64_t first_sample, size_t count, int32_t *_Nonnull samples);
+
+/**
+ * @brief Access pattern hint for a mapped recording, see {@link DM35425_Recording_Map_Advise}.
+ *
+ */
+enum DM35425_Recording_Access
+{
+    DM35425_RECORDING_ACCESS_NORMAL = 0, /*!< No hint */
+    DM35425_RECORDING_ACCESS_SEQUENTIAL, /*!< Reading through in order: read ahead aggressively and drop pages behind */
+    DM35425_RECORDING_ACCESS_RANDOM,     /*!< Jumping around: do not read ahead */
+};
+
+/**
+ * @brief A run of samples of one channel inside one chunk of a mapped recording.
+ *
+ */
+struct DM35425_Recording_View
+{
+    uint64_t first_sample;  /*!< Position of the first sample of the view on its board */
+    size_t count;           /*!< Number of samples, up to the end of the chunk */
+    const int16_t *raw;     /*!< Raw ADC codes, pointing into the mapped file, or into the decoded chunk */
+    const float *volts;     /*!< The same samples in volts, if asked for, NULL otherwise */
+    size_t chunk;           /*!< Chunk index */
+};
+
+/**
+ * @brief Opaque recording file mapped into memory.
+ *
+ */
+typedef struct _DM35425_Recording_Map DM35425_Recording_Map;
+
+/**
+ * @brief Map a recording file into memory for random access. The index is loaded as by
+ * {@link DM35425_Recording_Open}; the samples are only read from disk when a view touches them. Views of a map may be
+ * taken from any number of threads at once.
+ *
+ * @param map Pointer to the map to create.
+ * @param path File name.
+ * @return int 0 on success, -1 on failure. Errno is set as by {@link DM35425_Recording_Open} or mmap.
+ */
+int DM35425_Recording_Map_Open(DM35425_Recording_Map *_Nullable *_Nonnull map, const char *_Nonnull path);
+
+/**
+ * @brief Unmap a recording and free the converted volts. Views taken from it become invalid.
+ *
+ * @param map Map, may be NULL.
+ */
+void DM35425_Recording_Map_Close(DM35425_Recording_Map *_Nullable map);
+
+/**
+ * @brief Get the recording behind a map, for its header, layout and index. Do not use its Read functions from more
+ * than one thread.
+ *
+ * @param map Map.
+ * @return DM35425_Recording* The recording, valid until the map is closed.
+ */
+DM35425_Recording *_Nonnull DM35425_Recording_Map_Get_Recording(DM35425_Recording_Map *_Nonnull map);
+
+/**
+ * @brief Tell the kernel how the mapped file will be read (madvise).
+ *
+ * @param map Map.
+ * @param access Access pattern.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Recording_Map_Advise(DM35425_Recording_Map *_Nonnull map, enum DM35425_Recording_Access access);
+
+/**
+ * @brief Start reading chunks from disk in the background (MADV_WILLNEED), ahead of taking views of them.
+ *
+ * @param map Map.
+ * @param first_chunk First chunk index.
+ * @param num_chunks Number of chunks; clipped to the end of the recording.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Recording_Map_Prefetch(DM35425_Recording_Map *_Nonnull map, size_t first_chunk, size_t num_chunks);
+
+/**
+ * @brief Get a view of the samples of one channel from a position to the end of the chunk holding it, without
+ * copying. The chunk's checksum is checked the first time it is viewed, and a compressed chunk is decoded then and
+ * kept until the map is closed or the chunk released. With `volts`, the channel's samples in the chunk are converted
+ * with {@link DM35425_Adc_Samples_To_Volts_Bulk} the first time they are asked for, and kept likewise. A pass over a
+ * long compressed recording, or over its volts, should release chunks behind it with
+ * {@link DM35425_Recording_Map_Release}, or it keeps them all on the heap.
+ *
+ * To read a longer window, take the next view at `first_sample + count` until it fails with ENODATA.
+ *
+ * @param map Map.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param sample Position on the board.
+ * @param volts Also convert the samples to volts.
+ * @param view Returned view, valid until the map is closed.
+ * @return int 0 on success, -1 on failure. Errno is EINVAL for a bad board or channel, ENODATA if the position was
+ * not recorded, EBADMSG if the chunk is corrupt, or ENOMEM.
+ */
+int DM35425_Recording_Map_View(DM35425_Recording_Map *_Nonnull map, int board, int channel, uint64_t sample, bool volts, struct DM35425_Recording_View *_Nonnull view);
+
+/**
+ * @brief Free the decoded samples and converted volts kept for a run of chunks. They are made again if the chunks are
+ * viewed later. Views of the chunks become invalid, and no other thread may be taking or using views of them meanwhile.
+ *
+ * @param map Map.
+ * @param first_chunk First chunk index.
+ * @param num_chunks Number of chunks; clipped to the end of the recording.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Recording_Map_Release(DM35425_Recording_Map *_Nonnull map, size_t first_chunk, size_t num_chunks);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_RECORDING__H_
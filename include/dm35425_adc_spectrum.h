@@ -0,0 +1,192 @@
+/**
+ * @file dm35425_adc_spectrum.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Real FFT and Welch-averaged power spectral density of DM35425 ADC channels, usable as a multiboard processing stage.
+ * @version 1.0
+ * @date 2023-05-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef _DM35425_ADC_SPECTRUM__H_
+#define _DM35425_ADC_SPECTRUM__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dm35425_adc_multiboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief Window applied to every segment before the FFT.
+ *
+ */
+enum DM35425_Window
+{
+    DM35425_WINDOW_RECTANGULAR = 0, /*!< No window. */
+    DM35425_WINDOW_HANN,            /*!< Hann (raised cosine). */
+    DM35425_WINDOW_HAMMING,         /*!< Hamming. */
+    DM35425_WINDOW_BLACKMAN,        /*!< Blackman (3-term). */
+};
+
+/**
+ * @brief Opaque FFT plan: twiddle factors and bit-reversal table for one transform size. Read-only once created, so
+ * one plan can be used by several threads at once.
+ *
+ */
+typedef struct _DM35425_Fft DM35425_Fft;
+
+/**
+ * @brief Opaque Welch power spectral density accumulator for a set of channels.
+ *
+ */
+typedef struct _DM35425_Psd DM35425_Psd;
+
+/**
+ * @brief Create a plan for a real-to-complex FFT of `size` points. The real input is packed into a complex transform
+ * of half the size, computed with radix-4 passes (and one radix-2 pass when needed) over precomputed twiddles, and
+ * split into the spectrum of the real signal.
+ *
+ * @param fft Pointer to the plan to create.
+ * @param size Number of real input points, a power of two from 4 to 2^24.
+ * @return int 0 on success, -1 with errno EINVAL for a bad size or ENOMEM.
+ */
+int DM35425_Fft_Create(DM35425_Fft *_Nullable *_Nonnull fft, size_t size);
+
+/**
+ * @brief Free an FFT plan.
+ *
+ * @param fft Plan, may be NULL.
+ */
+void DM35425_Fft_Destroy(DM35425_Fft *_Nullable fft);
+
+/**
+ * @brief Get the number of real input points of a plan.
+ *
+ * @param fft Plan.
+ * @return size_t Transform size.
+ */
+size_t DM35425_Fft_Size(const DM35425_Fft *_Nonnull fft);
+
+/**
+ * @brief Forward transform of `size` real points: X[k] = sum of in[n] * exp(-2 pi i n k / size), for k from 0 to
+ * size / 2. No scaling is applied.
+ *
+ * @param fft Plan.
+ * @param in Real input, `size` floats.
+ * @param out Output, size / 2 + 1 complex bins as interleaved real and imaginary parts (size + 2 floats). Must not
+ * overlap `in`.
+ */
+void DM35425_Fft_Forward(const DM35425_Fft *_Nonnull fft, const float *_Nonnull in, float *_Nonnull out);
+
+/**
+ * @brief Fill `window` with `size` coefficients of a window.
+ *
+ * @param type Window type.
+ * @param window Output, `size` floats.
+ * @param size Window length, the FFT size.
+ * @return int 0 on success, -1 with errno EINVAL for an unknown window.
+ */
+int DM35425_Window_Fill(enum DM35425_Window type, float *_Nonnull window, size_t size);
+
+/**
+ * @brief Create a Welch PSD accumulator. Each channel's samples are cut into segments of `size` points that start
+ * `hop` points apart, across calls to {@link DM35425_Psd_Process}; every segment is windowed, transformed, and its
+ * periodogram added to the channel's average.
+ *
+ * @param psd Pointer to the accumulator to create.
+ * @param num_channels Number of channels, 1 or more.
+ * @param size Segment (FFT) size, see {@link DM35425_Fft_Create}.
+ * @param hop Points between segment starts, 1 to `size`. size / 2 gives the usual 50% overlap.
+ * @param window Window type.
+ * @param sample_rate Sample rate in Hz, used to scale the result to V^2/Hz.
+ * @param num_threads Worker threads that {@link DM35425_Psd_Process_All} spreads the channels over, in addition to the
+ * calling thread. 0 to process on the calling thread only.
+ * @return int 0 on success, -1 with errno EINVAL for bad settings, ENOMEM, or an error from pthread_create.
+ */
+int DM35425_Psd_Create(DM35425_Psd *_Nullable *_Nonnull psd, int num_channels, size_t size, size_t hop, enum DM35425_Window window, double sample_rate, int num_threads);
+
+/**
+ * @brief Stop the worker threads and free an accumulator.
+ *
+ * @param psd Accumulator, may be NULL.
+ */
+void DM35425_Psd_Destroy(DM35425_Psd *_Nullable psd);
+
+/**
+ * @brief Feed the next samples of one channel.
+ *
+ * @param psd Accumulator.
+ * @param channel Channel index.
+ * @param volts Samples, in volts.
+ * @param count Number of samples.
+ * @return int 0 on success, -1 with errno EINVAL for a bad channel.
+ */
+int DM35425_Psd_Process(DM35425_Psd *_Nonnull psd, int channel, const float *_Nonnull volts, size_t count);
+
+/**
+ * @brief Feed the next `count` samples of every channel, spread over the worker threads.
+ *
+ * @param psd Accumulator.
+ * @param volts Samples of each channel, volts[channel][count].
+ * @param count Number of samples per channel.
+ * @return int 0 on success.
+ */
+int DM35425_Psd_Process_All(DM35425_Psd *_Nonnull psd, const float *const *_Nonnull volts, size_t count);
+
+/**
+ * @brief Get the averaged one-sided power spectral density of a channel. Bin k is at frequency k * sample_rate / size.
+ * Safe to call while another thread feeds samples.
+ *
+ * @param psd Accumulator.
+ * @param channel Channel index.
+ * @param density Output, size / 2 + 1 values in V^2/Hz.
+ * @param segments Returned number of segments averaged, may be NULL.
+ * @return int 0 on success, -1 with errno EINVAL for a bad channel or ENODATA if no segment is complete yet.
+ */
+int DM35425_Psd_Get(DM35425_Psd *_Nonnull psd, int channel, double *_Nonnull density, uint64_t *_Nullable segments);
+
+/**
+ * @brief Clear the averages and any partial segment of every channel.
+ *
+ * @param psd Accumulator.
+ */
+void DM35425_Psd_Reset(DM35425_Psd *_Nonnull psd);
+
+/**
+ * @brief Install the accumulator as a processing stage (see {@link DM35425_ADC_Multiboard_Add_Stage}) that feeds it the
+ * voltages of one board in every frame. The board's channel count must match the accumulator's, and its readouts
+ * must carry per-channel voltages (not {@link DM35425_READOUT_RAW} or interleaved); other frames are passed on
+ * untouched. Never holds a frame back.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param psd Accumulator; must outlive the acquisition.
+ * @param board Index of the board to analyse.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Psd_Add_Stage(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Psd *_Nonnull psd, int board);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_SPECTRUM__H_
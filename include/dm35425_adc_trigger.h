@@ -0,0 +1,184 @@
+/**
+ * @file dm35425_adc_trigger.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Software trigger on the multiboard ADC stream, capturing pre- and post-trigger windows of every board.
+ * @version 1.0
+ * @date 2023-05-26
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef _DM35425_ADC_TRIGGER__H_
+#define _DM35425_ADC_TRIGGER__H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dm35425_adc_multiboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef _Nullable
+/**
+ * @brief Indicates whether a pointer can be NULL.
+ *
+ */
+#define _Nullable
+#endif
+
+#ifndef _Nonnull
+/**
+ * @brief The pointer must not be NULL.
+ *
+ */
+#define _Nonnull
+#endif
+
+/**
+ * @brief Maximum number of trigger conditions.
+ *
+ */
+#define DM35425_TRIGGER_MAX_CONDITIONS 8
+
+/**
+ * @brief What a trigger condition looks for. Levels are raw ADC codes, see {@link DM35425_Adc_Volts_To_Sample}.
+ *
+ */
+enum DM35425_Trigger_Type
+{
+    DM35425_TRIGGER_ABOVE = 0, /*!< Level: a sample at or above `level`. */
+    DM35425_TRIGGER_BELOW,     /*!< Level: a sample at or below `level`. */
+    DM35425_TRIGGER_RISING,    /*!< Edge: a sample at or above `level`, after one below `level - hysteresis`. */
+    DM35425_TRIGGER_FALLING,   /*!< Edge: a sample at or below `level`, after one above `level + hysteresis`. */
+    DM35425_TRIGGER_INSIDE,    /*!< Window: a sample from `level` to `high`, inclusive. */
+    DM35425_TRIGGER_OUTSIDE,   /*!< Window: a sample below `level` or above `high`. */
+};
+
+/**
+ * @brief One trigger condition on one channel.
+ *
+ */
+struct DM35425_Trigger_Condition
+{
+    enum DM35425_Trigger_Type type; /*!< Condition type */
+    int board;                      /*!< Board index, in the order given to {@link DM35425_ADC_Multiboard_Init} */
+    int channel;                    /*!< Index into the board's active channels, like the readout's `channels` */
+    int32_t level;                  /*!< Trigger level, or the low edge of a window, in ADC codes */
+    int32_t high;                   /*!< High edge of a window, in ADC codes */
+    int32_t hysteresis;             /*!< Edges: how far past `level` the other way the signal must go to arm the edge, 0 or more */
+};
+
+/**
+ * @brief Trigger settings. Window lengths are counted in raw samples of board 0; boards running at other rates
+ * (see {@link DM35425_ADC_Multiboard_Set_Batching}) get windows of the same duration.
+ *
+ */
+struct DM35425_Trigger_Config
+{
+    int num_conditions;                                    /*!< Number of conditions, 1 to {@link DM35425_TRIGGER_MAX_CONDITIONS}. The first one met fires. */
+    const struct DM35425_Trigger_Condition *_Nonnull conditions; /*!< Conditions, copied */
+    size_t pre_samples;                                    /*!< Samples captured before the trigger */
+    size_t post_samples;                                   /*!< Samples captured from the trigger on, 1 or more */
+    size_t holdoff;                                        /*!< Samples after the end of a capture before the trigger re-arms */
+    size_t queue_depth;                                    /*!< Captured events waiting for the consumer, 1 or more. Events are dropped when it is full. */
+};
+
+/**
+ * @brief The samples of one board around a trigger.
+ *
+ */
+struct DM35425_Trigger_Capture
+{
+    int num_channels;                   /*!< Number of active channels */
+    const int *channels;                /*!< Channel number of each row, like the readout's `channels` */
+    enum DM35425_Input_Ranges *ranges;  /*!< Input range of each row, for converting with {@link DM35425_Adc_Samples_To_Volts_Bulk} */
+    size_t num_samples;                 /*!< Samples per channel */
+    size_t pre_samples;                 /*!< Samples before the trigger; raw[c][pre_samples] is the trigger instant. Fewer than configured for a trigger just after the ISR was installed. */
+    uint64_t first_sample;              /*!< Index of raw[c][0] among this board's raw samples since the ISR was installed */
+    int32_t **raw;                      /*!< Raw ADC codes, raw[num_channels][num_samples] */
+};
+
+/**
+ * @brief A triggered event, taken with {@link DM35425_Trigger_Get_Event}.
+ *
+ */
+struct DM35425_Trigger_Event
+{
+    uint64_t sequence;                        /*!< Event number, counting dropped events */
+    uint64_t dropped;                         /*!< Number of events dropped just before this one because the queue was full */
+    int condition;                            /*!< Index of the condition that fired */
+    uint64_t trigger_sample;                  /*!< Index of the triggering sample among its board's raw samples since the ISR was installed */
+    uint64_t timestamp_ns;                    /*!< CLOCK_MONOTONIC time (ns) at which the buffer holding the trigger was found full */
+    bool gap;                                 /*!< Part of a window is stale because a board lost DMA buffers inside it (or its first buffers) */
+    int num_boards;                           /*!< Number of boards */
+    struct DM35425_Trigger_Capture *captures; /*!< Captures of every board, captures[num_boards] */
+};
+
+/**
+ * @brief Opaque software trigger.
+ *
+ */
+typedef struct _DM35425_Trigger DM35425_Trigger;
+
+/**
+ * @brief Create a software trigger. Run it on the multiboard stream with {@link DM35425_Trigger_Add_Stage}. It keeps a
+ * history ring of the last frames of raw codes of every board and channel, long enough to hold a full window. The
+ * conditions are evaluated with vector instructions over the raw codes of each new frame. When one is met, the pre-
+ * and post-trigger windows of every board are copied into the event queue once the post-trigger samples have
+ * arrived, and the trigger re-arms after the holdoff, without stopping DMA. Edge conditions must see the signal arm
+ * again after re-arming.
+ *
+ * The history and queue are sized on the first frame, when the boards' frame lengths are known.
+ *
+ * @param trig Pointer to the trigger to create.
+ * @param config Settings.
+ * @return int 0 on success, -1 with errno EINVAL for bad settings or ENOMEM.
+ */
+int DM35425_Trigger_Create(DM35425_Trigger *_Nullable *_Nonnull trig, const struct DM35425_Trigger_Config *_Nonnull config);
+
+/**
+ * @brief Free a trigger. The acquisition it is installed in must have stopped.
+ *
+ * @param trig Trigger, may be NULL.
+ */
+void DM35425_Trigger_Destroy(DM35425_Trigger *_Nullable trig);
+
+/**
+ * @brief Install the trigger as a processing stage, see {@link DM35425_ADC_Multiboard_Add_Stage}. It never holds a
+ * frame back.
+ *
+ * @param mbd Handle to the multi-board descriptor.
+ * @param trig Trigger; must outlive the acquisition.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+int DM35425_Trigger_Add_Stage(DM35425_Multiboard_Descriptor *_Nonnull mbd, DM35425_Trigger *_Nonnull trig);
+
+/**
+ * @brief Get the oldest captured event. The same event is returned until it is released with
+ * {@link DM35425_Trigger_Release_Event}. Only one thread may consume events.
+ *
+ * @param trig Trigger.
+ * @param event Returned event.
+ * @param timeout_ns How long to wait for an event, in nanoseconds. 0 polls, negative waits forever.
+ * @return int 0 on success, -1 on failure. Errno is EAGAIN when polling an empty queue, ETIMEDOUT when the wait timed
+ * out, or the error that stopped the trigger (EINVAL if a condition names a board or channel the stream does not
+ * have, ENOMEM if the history could not be allocated).
+ */
+int DM35425_Trigger_Get_Event(DM35425_Trigger *_Nonnull trig, struct DM35425_Trigger_Event *_Nonnull *_Nonnull event, int64_t timeout_ns);
+
+/**
+ * @brief Give the event returned by {@link DM35425_Trigger_Get_Event} back to the queue.
+ *
+ * @param trig Trigger.
+ * @return int 0 on success, -1 with errno ENODATA if there is no event to release.
+ */
+int DM35425_Trigger_Release_Event(DM35425_Trigger *_Nonnull trig);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _DM35425_ADC_TRIGGER__H_
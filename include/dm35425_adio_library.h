@@ -1316,6 +1316,51 @@ int DM35425_Adio_Set_Output_Value(struct DM35425_Board_Descriptor *handle,
 				uint32_t value);
 
 
+/**
+*******************************************************************************
+@brief
+    Set the output value of selected ADIO pins.  Bits outside mask are left unchanged.  The
+    read-modify-write is done by the driver in one step, so other threads
+    may update other bits of the register at the same time.
+
+@param
+    handle
+
+    Address of the handle pointer, which will contain the device
+    descriptor.
+
+@param
+    func_block
+
+    Pointer to the function block representing the ADIO.
+
+@param
+    value
+
+    Bitmask of the new output values.
+
+@param
+    mask
+
+    Bitmask of the pins to change.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-Zero
+
+    Failure.
+ */
+DM35425LIB_API
+int DM35425_Adio_Modify_Output_Value(struct DM35425_Board_Descriptor *handle,
+				const struct DM35425_Function_Block *func_block,
+				uint32_t value,
+				uint32_t mask);
+
+
 /**
 *******************************************************************************
 @brief
@@ -1391,6 +1436,51 @@ int DM35425_Adio_Set_Direction(struct DM35425_Board_Descriptor *handle,
 			uint32_t direction);
 
 
+/**
+*******************************************************************************
+@brief
+    Set the direction of selected ADIO pins.  Bits outside mask are left unchanged.  The
+    read-modify-write is done by the driver in one step, so other threads
+    may update other bits of the register at the same time.
+
+@param
+    handle
+
+    Address of the handle pointer, which will contain the device
+    descriptor.
+
+@param
+    func_block
+
+    Pointer to the function block representing the ADIO.
+
+@param
+    direction
+
+    Bitmask of the new directions.  (0 = input, 1 = output)
+
+@param
+    mask
+
+    Bitmask of the pins to change.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    Non-Zero
+
+    Failure.
+ */
+DM35425LIB_API
+int DM35425_Adio_Modify_Direction(struct DM35425_Board_Descriptor *handle,
+				const struct DM35425_Function_Block *func_block,
+				uint32_t direction,
+				uint32_t mask);
+
+
 /**
 *******************************************************************************
 @brief
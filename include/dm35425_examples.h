@@ -326,6 +326,70 @@ enum Help_Options {
 	 * 	Syncbus connector option
 	 */
 	SYNC_CONN_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --threads
+	 * 	(Number of worker threads)
+	 */
+	THREADS_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --board
+	 * 	(Board index in a recording)
+	 */
+	BOARD_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --channel
+	 * 	(Channel index in a recording)
+	 */
+	CHANNEL_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameters --from and --to
+	 * 	(Span of a recording)
+	 */
+	FROM_OPTION,
+	TO_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --points
+	 * 	(Number of points to plot)
+	 */
+	POINTS_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --factor
+	 * 	(Factor between overview levels)
+	 */
+	FACTOR_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --build
+	 * 	(Build an overview)
+	 */
+	BUILD_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --volts
+	 * 	(Convert samples to volts)
+	 */
+	VOLTS_OPTION,
+
+	/**
+	 * @brief
+	 * 	Command line parameter --csv
+	 * 	(Comma separated output)
+	 */
+	CSV_OPTION,
 };
 
 /**
@@ -120,6 +120,18 @@ Macros
 	(DM35425_IOCTL_REQUEST_BASE + 6), \
 	union dm35425_ioctl_argument)
 
+/**
+ * @brief
+ *	  ioctl() request code to retrieve the number of queued interrupts
+ *	  without removing any of them from the queue
+ */
+
+#define DM35425_IOCTL_INTERRUPT_PENDING \
+	_IOR( \
+	DM35425_IOCTL_MAGIC, \
+	(DM35425_IOCTL_REQUEST_BASE + 7), \
+	union dm35425_ioctl_argument)
+
 /**
  * @} DM35425_Ioctl_Macros
  */
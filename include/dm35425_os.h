@@ -26,6 +26,20 @@
 #define _DM35425_BOARD_OS__H_
 
 #include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dm35425_util_library.h"
+
+#ifndef SCHED_DEADLINE
+/**
+ * @brief
+ * Linux earliest-deadline-first scheduling policy, for C libraries that do not
+ * define it.
+ */
+#define SCHED_DEADLINE 6
+#endif
 
 // This forward declaration is made so that board_access.h 
 // does not need to be included, which would causes circular dependencies.
@@ -40,11 +54,133 @@ extern "C" {
  * @{
  */
 
+/**
+  @brief
+  Busy-poll configuration for the user ISR thread.  Instead of sleeping in
+  select() until the driver wakes it, the thread checks the driver's interrupt
+  queue in a loop.  This removes the scheduler wakeup from the interrupt path
+  at the cost of keeping a CPU busy.
+ */
+
+struct DM35425_ISR_Poll_Config {
+
+	/**
+	 * How long to busy-spin, in nanoseconds, at the start of every wait
+	 * before falling back to the sleep phase.  Set this a little longer than
+	 * the expected interrupt period to never leave the spin phase.
+	 */
+	unsigned long spin_ns;
+
+	/**
+	 * Time to sleep between checks once the spin budget has been used up, in
+	 * nanoseconds.  0 blocks in select() until the next interrupt instead.
+	 */
+	unsigned long sleep_ns;
+
+	/**
+	 * CPU to pin the ISR thread to, or -1 to leave the affinity alone.  A
+	 * spinning thread should normally have a CPU to itself.
+	 */
+	int cpu;
+};
+
+
+/**
+  @brief
+  Real-time settings for an ISR thread.  Everything here is applied before the
+  thread waits for its first interrupt, and any failure is returned by the
+  install call instead of being ignored.  Initialize with
+  DM35425_ISR_Attr_Init() and change only the fields of interest.
+ */
+
+struct DM35425_ISR_Attr {
+
+	/**
+	 * Scheduling policy: SCHED_OTHER (default), SCHED_FIFO, SCHED_RR or
+	 * SCHED_DEADLINE.
+	 */
+	int sched_policy;
+
+	/**
+	 * Priority for SCHED_FIFO and SCHED_RR.
+	 */
+	int sched_priority;
+
+	/**
+	 * SCHED_DEADLINE runtime budget per period, in nanoseconds.
+	 */
+	uint64_t deadline_runtime_ns;
+
+	/**
+	 * SCHED_DEADLINE relative deadline, in nanoseconds.
+	 */
+	uint64_t deadline_deadline_ns;
+
+	/**
+	 * SCHED_DEADLINE period, in nanoseconds.
+	 */
+	uint64_t deadline_period_ns;
+
+	/**
+	 * CPUs the thread may run on, or NULL to leave the affinity alone.  The
+	 * kernel refuses a restricted affinity for SCHED_DEADLINE threads.
+	 */
+	const cpu_set_t *cpuset;
+
+	/**
+	 * Size in bytes of the set pointed to by cpuset.
+	 */
+	size_t cpusetsize;
+
+	/**
+	 * Thread stack size in bytes, or 0 for the default.
+	 */
+	size_t stack_size;
+
+	/**
+	 * Non-zero to lock all current and future process memory with
+	 * mlockall() before the thread is created.
+	 */
+	int lock_memory;
+
+	/**
+	 * Number of bytes of thread stack to touch before the first wait, so the
+	 * ISR path does not take stack page faults.  Must be smaller than the
+	 * stack size, or the default stack size if stack_size is 0.
+	 */
+	size_t prefault_stack;
+
+	/**
+	 * Non-zero to touch every acquisition buffer owned by the library before
+	 * the first wait.  Only used by the multi-board ADC API; the single-board
+	 * ISR has no library-owned buffers.
+	 */
+	int prefault_buffers;
+
+	/**
+	 * Busy-poll settings, or NULL for a thread that blocks in select().
+	 */
+	const struct DM35425_ISR_Poll_Config *poll;
+};
+
+
 /**
   @brief
   DM35425 board descriptor.  This structure holds information about
   the board as a whole.  It holds the file descriptor and ISR callback
   function, if applicable.
+
+  @note
+  A descriptor may be shared by several threads, for example one servicing
+  ADC DMA while another writes DAC values and a third reads ADIO.  Every
+  register access is a single ioctl that the driver performs under its
+  device spinlock, and bit-field updates use the driver's read-modify-write
+  (DM35425_Modify()), so concurrent calls on different function blocks, or
+  on different bits of one register, do not interfere.  The library keeps no
+  static or global scratch state.  Sequences of calls on the same function
+  block (configure, start, stop) are not atomic as a whole and need the
+  caller's own locking.  DM35425_Board_Close() must not race with any other
+  call on the same descriptor.
  */
 
 struct DM35425_Board_Descriptor {
@@ -63,6 +199,36 @@ struct DM35425_Board_Descriptor {
 	 * Process ID of the child process which will monitor DMA done interrupts.
 	 */
 	pthread_t pid;
+
+	/**
+	 * Busy-poll settings used by DM35425_General_PollForInterrupt().
+	 */
+	struct DM35425_ISR_Poll_Config poll_config;
+
+	/**
+	 * Interrupt dispatch latency recorded by the ISR thread.  Allocated when
+	 * the ISR is installed.
+	 */
+	struct DM35425_Histogram *isr_latency;
+
+	/**
+	 * Longest time in nanoseconds the ISR thread waits for an interrupt
+	 * before reporting a stall.  0 waits forever.
+	 */
+	uint64_t isr_timeout_ns;
+
+	/**
+	 * Called from the ISR thread when no interrupt arrived within
+	 * isr_timeout_ns.  When NULL, a stall is passed to the user ISR as an
+	 * error and the ISR thread exits.
+	 */
+	void (*isr_timeout) (struct DM35425_Board_Descriptor *handle,
+			     uint64_t waited_ns);
+
+	/**
+	 * Serializes installing and removing the ISR.
+	 */
+	pthread_mutex_t isr_lock;
 };
 
 
@@ -304,6 +470,31 @@ int DM35425_General_RemoveISR(struct DM35425_Board_Descriptor *handle);
 void *DM35425_General_WaitForInterrupt(void *ptr);
 
 
+/**
+*******************************************************************************
+@brief
+    Busy-poll the driver interrupt queue and call the user ISR for every
+    interrupt found.  This is the thread function used by
+    DM35425_General_InstallISR_Polled().
+
+    The thread spins on a status ioctl for up to poll_config.spin_ns, then
+    either sleeps poll_config.sleep_ns between checks or blocks in select() if
+    sleep_ns is 0.  Drivers without the status ioctl are polled with a
+    zero-timeout poll() instead.
+
+@param
+    ptr
+
+    A void pointer for the board descriptor.
+
+@retval
+    0
+
+    Success.
+ */
+void *DM35425_General_PollForInterrupt(void *ptr);
+
+
 /**
 *******************************************************************************
 @brief
@@ -337,6 +528,206 @@ int
 DM35425_General_InstallISR(struct DM35425_Board_Descriptor *handle, void (*isr_fnct));
 
 
+/**
+*******************************************************************************
+@brief
+    Start a thread that busy-polls the board for interrupts, and calls the
+    user ISR when one is found.  Use this in place of
+    DM35425_General_InstallISR() when wakeup jitter matters more than CPU
+    usage.
+
+@param
+    handle
+
+    Pointer to the device descriptor, which contains the open file id.
+
+@param
+    isr_fnct
+
+    Pointer to the user ISR function that will be executed when an interrupt happens.
+
+@param
+    poll_config
+
+    Pointer to the spin and sleep thresholds and CPU to pin the thread to.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.
+    errno may be set as follows:
+        @arg \c
+            EINVAL	poll_config is NULL or names an invalid CPU.
+            ENOMEM	Could not allocate the latency histogram.
+            EFAULT	Could not create thread.
+ */
+int
+DM35425_General_InstallISR_Polled(struct DM35425_Board_Descriptor *handle,
+				void (*isr_fnct),
+				const struct DM35425_ISR_Poll_Config *poll_config);
+
+
+/**
+*******************************************************************************
+@brief
+    Set an ISR attribute structure to the defaults: normal scheduling, no
+    affinity, default stack, no memory locking or prefaulting, and a thread
+    that blocks in select().
+
+@param
+    attr
+
+    Pointer to the attributes to initialize.
+
+@retval
+    None
+ */
+void DM35425_ISR_Attr_Init(struct DM35425_ISR_Attr *attr);
+
+
+/**
+*******************************************************************************
+@brief
+    Create a thread with the real-time settings in attr.  Policy, priority,
+    affinity and stack size are applied at creation; SCHED_DEADLINE, stack
+    prefaulting and the optional setup function run on the new thread before
+    this function returns.  start_routine is only entered once all of them
+    have succeeded.
+
+@param
+    thread
+
+    Pointer to the returned thread id.
+
+@param
+    attr
+
+    Pointer to the thread settings, or NULL for the defaults.
+
+@param
+    setup
+
+    Optional function run on the new thread before start_routine, for
+    example to prefault buffers.  A non-zero return is treated as an errno
+    value and fails the creation.
+
+@param
+    start_routine
+
+    Thread function.
+
+@param
+    arg
+
+    Argument for setup and start_routine.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.
+    errno may be set as follows:
+        @arg \c
+            EINVAL	Invalid policy, priority, stack size, prefault size or CPU set.
+            EPERM	Not permitted to use the requested scheduling.
+            ENOMEM	mlockall() failed.
+            ENOSYS	SCHED_DEADLINE is not supported by this system.
+ */
+int
+DM35425_Thread_Create_RT(pthread_t *thread,
+			const struct DM35425_ISR_Attr *attr,
+			int (*setup)(void *),
+			void *(*start_routine)(void *),
+			void *arg);
+
+
+/**
+*******************************************************************************
+@brief
+    Start a thread that will wait for interrupts from the board and call the
+    user ISR, with its scheduling, affinity, stack and memory settings applied
+    before the first wait.  If attr->poll is set the thread busy-polls as in
+    DM35425_General_InstallISR_Polled().
+
+@param
+    handle
+
+    Pointer to the device descriptor, which contains the open file id.
+
+@param
+    isr_fnct
+
+    Pointer to the user ISR function that will be executed when an interrupt happens.
+
+@param
+    attr
+
+    Pointer to the thread settings, or NULL for the defaults.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.  errno is set as for DM35425_Thread_Create_RT().
+ */
+int
+DM35425_General_InstallISR_Attr(struct DM35425_Board_Descriptor *handle,
+				void (*isr_fnct),
+				const struct DM35425_ISR_Attr *attr);
+
+
+/**
+*******************************************************************************
+@brief
+    Get the interrupt dispatch latency of the user ISR thread.
+
+    For a polled ISR thread each value is an upper bound on the time from the
+    interrupt being queued by the driver to the user ISR being called: it runs
+    from the last status check that found the queue empty.  For a blocking ISR
+    thread each value runs from select() returning to the user ISR being
+    called, and does not include the kernel wakeup.
+
+@param
+    handle
+
+    Pointer to the device descriptor, which contains the open file id.
+
+@param
+    summary
+
+    Pointer to the returned latency percentiles.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.
+    errno may be set as follows:
+        @arg \c
+            EFAULT	No ISR has been installed on this board.
+ */
+int
+DM35425_General_GetISRLatency(struct DM35425_Board_Descriptor *handle,
+			struct DM35425_Latency_Summary *summary);
+
+
 /**
 *******************************************************************************
 @brief
@@ -353,7 +744,9 @@ DM35425_General_InstallISR(struct DM35425_Board_Descriptor *handle, void (*isr_f
     Attempt to set the priority of the user ISR thread.
 
 @note
-    This may require root priviledges
+    This needs root or CAP_SYS_NICE, or a suitable RLIMIT_RTPRIO.  Prefer
+    passing sched_policy in DM35425_General_InstallISR_Attr(), which applies
+    it before the first interrupt.
 
 @retval
     0
@@ -367,10 +760,96 @@ DM35425_General_InstallISR(struct DM35425_Board_Descriptor *handle, void (*isr_f
     errno may be set as follows:
         @arg \c
             EFAULT	User ISR did not exist.
+            EPERM	Not permitted to set a real-time priority.
  */
 	int DM35425_General_SetISRPriority(struct DM35425_Board_Descriptor
 					   *handle, int priority);
 
+
+/**
+*******************************************************************************
+@brief
+    Set the CPU affinity of the user ISR thread
+
+@param
+    handle
+
+    Pointer to the device descriptor, which contains the open file id.
+
+@param
+    cpusetsize
+
+    Size in bytes of the set pointed to by cpuset.
+
+@param
+    cpuset
+
+    CPUs the ISR thread may run on.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.
+    errno may be set as follows:
+        @arg \c
+            EFAULT	User ISR did not exist.
+            EINVAL	cpuset names no online CPU.
+ */
+int DM35425_General_SetISRAffinity(struct DM35425_Board_Descriptor *handle,
+				   size_t cpusetsize,
+				   const cpu_set_t *cpuset);
+
+/**
+*******************************************************************************
+@brief
+    Bound the time the ISR thread waits for an interrupt.  If no interrupt
+    arrives for timeout_ns nanoseconds, timeout_fnct is called from the ISR
+    thread with the time waited, and waiting starts over.  If timeout_fnct
+    is NULL, the user ISR is instead called with error_occurred set to 3 and
+    the ISR thread exits.
+
+    Call this before installing the ISR, or from within the ISR or the
+    timeout function.
+
+@param
+    handle
+
+    Pointer to the device descriptor, which contains the open file id.
+
+@param
+    timeout_ns
+
+    Longest wait in nanoseconds.  0 disables the timeout.
+
+@param
+    timeout_fnct
+
+    Function to call on a stall, or NULL.  It may call
+    DM35425_Adc_Start_Rearm() or similar to try to recover.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.
+    errno may be set as follows:
+        @arg \c
+            EINVAL	handle is NULL.
+ */
+int DM35425_General_SetISRTimeout(struct DM35425_Board_Descriptor *handle,
+				  uint64_t timeout_ns,
+				  void (*timeout_fnct) (struct DM35425_Board_Descriptor *,
+							uint64_t));
+
 /**
  * @} DM35425_Board_Access_Library
  */
@@ -27,6 +27,7 @@
 #define _DM35425_UTIL__H_
 
 
+#include <stdint.h>
 #include <time.h>
 #include <sys/time.h>
 
@@ -62,6 +63,151 @@ enum DM35425_Waveforms {
 };
 
 
+/**
+ * @brief
+ *      Number of bits of linear resolution kept within each power-of-two
+ *      range of a latency histogram.  4 bits gives a worst case relative
+ *      error of about 6%.
+ */
+#define DM35425_HISTOGRAM_SUB_BUCKET_BITS	4
+
+/**
+ * @brief
+ *      Number of linear sub-buckets per power-of-two range.
+ */
+#define DM35425_HISTOGRAM_SUB_BUCKETS	(1 << DM35425_HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * @brief
+ *      Total number of buckets needed to cover the full 64-bit value range.
+ */
+#define DM35425_HISTOGRAM_NUM_BUCKETS \
+	(DM35425_HISTOGRAM_SUB_BUCKETS * (65 - DM35425_HISTOGRAM_SUB_BUCKET_BITS))
+
+
+/**
+ * @brief
+ *      Log-linear (HDR-style) histogram of nanosecond durations.
+ *
+ *      Values are recorded with relaxed atomic operations, so one or more
+ *      threads may record while another thread takes a snapshot.  A snapshot
+ *      taken during recording may be off by the few samples in flight.
+ */
+struct DM35425_Histogram {
+
+	/**
+	 * Number of values recorded.
+	 */
+	uint64_t count;
+
+	/**
+	 * Sum of all values recorded, used for the mean.
+	 */
+	uint64_t sum;
+
+	/**
+	 * Smallest value recorded.
+	 */
+	uint64_t min;
+
+	/**
+	 * Largest value recorded.
+	 */
+	uint64_t max;
+
+	/**
+	 * Bucket counts.
+	 */
+	uint64_t buckets[DM35425_HISTOGRAM_NUM_BUCKETS];
+};
+
+
+/**
+ * @brief
+ *      Summary of a latency histogram.  All times are in nanoseconds.
+ */
+struct DM35425_Latency_Summary {
+
+	/**
+	 * Number of values recorded.
+	 */
+	uint64_t count;
+
+	/**
+	 * Smallest value recorded.
+	 */
+	uint64_t min_ns;
+
+	/**
+	 * Mean of all values recorded.
+	 */
+	uint64_t mean_ns;
+
+	/**
+	 * 50th percentile (median).
+	 */
+	uint64_t p50_ns;
+
+	/**
+	 * 90th percentile.
+	 */
+	uint64_t p90_ns;
+
+	/**
+	 * 99th percentile.
+	 */
+	uint64_t p99_ns;
+
+	/**
+	 * 99.9th percentile.
+	 */
+	uint64_t p999_ns;
+
+	/**
+	 * Largest value recorded.
+	 */
+	uint64_t max_ns;
+};
+
+
+/**
+ * @brief
+ *      Vector instruction sets the library has conversion kernels for.
+ */
+enum DM35425_Simd_Isa {
+
+	/**
+	 * Plain C, no vector instructions
+	 */
+	DM35425_SIMD_SCALAR = 0,
+
+	/**
+	 * x86 SSE2 (128-bit)
+	 */
+	DM35425_SIMD_SSE2,
+
+	/**
+	 * x86 AVX2 (256-bit)
+	 */
+	DM35425_SIMD_AVX2,
+
+	/**
+	 * x86 AVX-512F (512-bit)
+	 */
+	DM35425_SIMD_AVX512,
+
+	/**
+	 * ARM NEON / Advanced SIMD (128-bit)
+	 */
+	DM35425_SIMD_NEON,
+
+	/**
+	 * Number of entries, not an instruction set
+	 */
+	DM35425_SIMD_NUM_ISA
+};
+
+
 /**
 *******************************************************************************
 @brief
@@ -220,6 +366,169 @@ int DM35425_Generate_Signal_Data(enum DM35425_Waveforms waveform,
 void check_result(int return_val, char *message);
 
 
+/**
+*******************************************************************************
+@brief
+   Read the monotonic clock.
+
+@retval
+   time
+
+   Current value of CLOCK_MONOTONIC, in nanoseconds.
+
+*/
+uint64_t DM35425_Get_Monotonic_Ns(void);
+
+
+/**
+*******************************************************************************
+@brief
+   Clear all values from a latency histogram.
+
+@param
+   hist
+
+   Pointer to the histogram to clear.
+
+@retval
+   None
+
+*/
+void DM35425_Histogram_Reset(struct DM35425_Histogram *hist);
+
+
+/**
+*******************************************************************************
+@brief
+   Record one value in a latency histogram.  This function does not block and
+   may be called from several threads at once.
+
+@param
+   hist
+
+   Pointer to the histogram.
+
+@param
+   value_ns
+
+   Value to record, in nanoseconds.
+
+@retval
+   None
+
+*/
+void DM35425_Histogram_Record(struct DM35425_Histogram *hist, uint64_t value_ns);
+
+
+/**
+*******************************************************************************
+@brief
+   Get a percentile from a latency histogram.
+
+@param
+   hist
+
+   Pointer to the histogram.
+
+@param
+   percentile
+
+   Percentile to look up, from 0.0 to 100.0.
+
+@retval
+   value
+
+   Value at the requested percentile, in nanoseconds.  0 if the histogram
+   is empty.
+
+*/
+uint64_t DM35425_Histogram_Percentile(const struct DM35425_Histogram *hist,
+					double percentile);
+
+
+/**
+*******************************************************************************
+@brief
+   Summarize a latency histogram into count, min, mean, max and the common
+   percentiles.  The histogram may be recorded into while this runs.
+
+@param
+   hist
+
+   Pointer to the histogram.
+
+@param
+   summary
+
+   Pointer to the returned summary.
+
+@retval
+   None
+
+*/
+void DM35425_Histogram_Summarize(const struct DM35425_Histogram *hist,
+				struct DM35425_Latency_Summary *summary);
+
+
+
+/**
+*******************************************************************************
+@brief
+   Check whether the running CPU (and OS) supports an instruction set.
+
+@param
+   isa
+
+   Instruction set to check.
+
+@retval
+   1
+
+   Supported.
+
+@retval
+   0
+
+   Not supported, or not compiled into this library.
+
+*/
+int DM35425_Simd_Isa_Supported(enum DM35425_Simd_Isa isa);
+
+
+/**
+*******************************************************************************
+@brief
+   Get the preferred instruction set supported by the running CPU.  AVX2 is
+   preferred over AVX-512, which lowers the clock on many parts and is no
+   faster for a conversion limited by memory bandwidth.
+
+@retval
+   isa
+
+   Instruction set the bulk conversion functions use by default.
+
+*/
+enum DM35425_Simd_Isa DM35425_Simd_Best_Isa(void);
+
+
+/**
+*******************************************************************************
+@brief
+   Get the printable name of an instruction set.
+
+@param
+   isa
+
+   Instruction set.
+
+@retval
+   name
+
+   Name, or "unknown".
+
+*/
+const char *DM35425_Simd_Isa_Name(enum DM35425_Simd_Isa isa);
+
 
 /**
  * @} DM35425_Util_Library_Functions
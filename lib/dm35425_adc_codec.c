@@ -0,0 +1,341 @@
+/**
+ * @file dm35425_adc_codec.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the lossless codec for raw ADC codes.
+ * @version 1.0
+ * @date 2023-06-12
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include "dm35425_adc_codec.h"
+
+#define DM35425_CODEC_LANES 4                                          /*!< 32-bit lanes per vector */
+#define DM35425_CODEC_VECTORS (DM35425_CODEC_GROUP / DM35425_CODEC_LANES) /*!< Vectors per group */
+#define DM35425_CODEC_WORD 16                                          /*!< Bytes per packed word */
+
+/**
+ * @brief Four unsigned lanes. GCC lowers operations on it to SSE2 or NEON, or to scalar code elsewhere.
+ *
+ */
+typedef uint32_t DM35425_Codec_Vec __attribute__((vector_size(DM35425_CODEC_LANES * sizeof(uint32_t))));
+
+/**
+ * @brief Four signed lanes, for differences and prefix sums.
+ *
+ */
+typedef int32_t DM35425_Codec_Ivec __attribute__((vector_size(DM35425_CODEC_LANES * sizeof(int32_t))));
+
+/**
+ * @brief Pack a group of values of a given width. Inlined for each width, so every shift is by a constant.
+ *
+ * @param values Group of values, lane layout.
+ * @param width Bits per value, 1 to 31.
+ * @param out Room for width words.
+ */
+static inline __attribute__((always_inline)) void DM35425_Codec_Pack(const DM35425_Codec_Vec *values, int width, uint8_t *out)
+{
+    DM35425_Codec_Vec word = values[0];
+    int used = width; // bits of word filled
+
+    for (int j = 1; j < DM35425_CODEC_VECTORS; j++)
+    {
+        if (used == 32)
+        {
+            memcpy(out, &word, sizeof(word));
+            out += sizeof(word);
+            word = values[j];
+            used = width;
+            continue;
+        }
+        word |= values[j] << used;
+        used += width;
+        if (used > 32) // the value straddles two words
+        {
+            memcpy(out, &word, sizeof(word));
+            out += sizeof(word);
+            used -= 32;
+            word = values[j] >> (width - used);
+        }
+    }
+    // 32 values per lane fill whole words
+    memcpy(out, &word, sizeof(word));
+}
+
+/**
+ * @brief Unpack a group of values of a given width. Inlined for each width, so every shift is by a constant.
+ *
+ * @param in Packed words.
+ * @param width Bits per value, 1 to 31.
+ * @param values Returned group of values, lane layout.
+ */
+static inline __attribute__((always_inline)) void DM35425_Codec_Unpack(const uint8_t *in, int width, DM35425_Codec_Vec *values)
+{
+    const DM35425_Codec_Vec mask = (DM35425_Codec_Vec){1, 1, 1, 1} * ((1U << width) - 1);
+    DM35425_Codec_Vec word;
+    int used = 0; // bits of word consumed
+
+    memcpy(&word, in, sizeof(word));
+    in += sizeof(word);
+    for (int j = 0; j < DM35425_CODEC_VECTORS; j++)
+    {
+        DM35425_Codec_Vec v = word >> used;
+        used += width;
+        if (used >= 32 && j + 1 < DM35425_CODEC_VECTORS)
+        {
+            memcpy(&word, in, sizeof(word));
+            in += sizeof(word);
+            used -= 32;
+            if (used > 0) // the rest of the value is at the bottom of the next word
+                v |= word << (width - used);
+        }
+        values[j] = v & mask;
+    }
+}
+
+/**
+ * @brief Specialize a packing routine for every width.
+ *
+ */
+#define DM35425_CODEC_WIDTHS(op, a, b) \
+    case 1: op(a, 1, b); break;        \
+    case 2: op(a, 2, b); break;        \
+    case 3: op(a, 3, b); break;        \
+    case 4: op(a, 4, b); break;        \
+    case 5: op(a, 5, b); break;        \
+    case 6: op(a, 6, b); break;        \
+    case 7: op(a, 7, b); break;        \
+    case 8: op(a, 8, b); break;        \
+    case 9: op(a, 9, b); break;        \
+    case 10: op(a, 10, b); break;      \
+    case 11: op(a, 11, b); break;      \
+    case 12: op(a, 12, b); break;      \
+    case 13: op(a, 13, b); break;      \
+    case 14: op(a, 14, b); break;      \
+    case 15: op(a, 15, b); break;      \
+    case 16: op(a, 16, b); break;      \
+    case 17: op(a, 17, b); break;
+
+/**
+ * @brief Bytes a group of values takes packed, the last group of a channel at its real length.
+ *
+ * @param n Values in the group.
+ * @param width Bits per value.
+ * @return size_t Bytes.
+ */
+static inline size_t DM35425_Codec_Group_Size(size_t n, int width)
+{
+    if (n == DM35425_CODEC_GROUP)
+        return (size_t)width * DM35425_CODEC_WORD;
+    return (n * width + 7) / 8;
+}
+
+/**
+ * @brief Pack a partial group as one stream of n values of a given width, from the least significant bit up.
+ *
+ * @param values Group of values, lane layout.
+ * @param n Values in the group, fewer than a group.
+ * @param width Bits per value, 1 to 17.
+ * @param out Room for {@link DM35425_Codec_Group_Size}(n, width) bytes.
+ */
+static void DM35425_Codec_Pack_Tail(const DM35425_Codec_Vec *values, size_t n, int width, uint8_t *out)
+{
+    uint64_t bits = 0;
+    int used = 0; // bits of bits filled
+
+    for (size_t i = 0; i < n; i++)
+    {
+        bits |= (uint64_t)values[i / DM35425_CODEC_LANES][i % DM35425_CODEC_LANES] << used;
+        used += width;
+        while (used >= 8)
+        {
+            *out++ = (uint8_t)bits;
+            bits >>= 8;
+            used -= 8;
+        }
+    }
+    if (used > 0)
+        *out = (uint8_t)bits;
+}
+
+/**
+ * @brief Unpack a partial group packed by {@link DM35425_Codec_Pack_Tail}. Values past n are zero.
+ *
+ * @param in Packed bytes.
+ * @param n Values in the group, fewer than a group.
+ * @param width Bits per value, 1 to 17.
+ * @param values Returned group of values, lane layout.
+ */
+static void DM35425_Codec_Unpack_Tail(const uint8_t *in, size_t n, int width, DM35425_Codec_Vec *values)
+{
+    uint64_t bits = 0;
+    int used = 0; // bits of bits not yet consumed
+
+    memset(values, 0, DM35425_CODEC_VECTORS * sizeof(*values));
+    for (size_t i = 0; i < n; i++)
+    {
+        while (used < width)
+        {
+            bits |= (uint64_t)*in++ << used;
+            used += 8;
+        }
+        values[i / DM35425_CODEC_LANES][i % DM35425_CODEC_LANES] = (uint32_t)bits & ((1U << width) - 1);
+        bits >>= width;
+        used -= width;
+    }
+}
+
+size_t DM35425_Codec_Bound(size_t count)
+{
+    // Anything that would not code smaller is stored raw behind a marker
+    return count == 0 ? 0 : 1 + count * sizeof(int16_t);
+}
+
+size_t DM35425_Codec_Encode(const int16_t *samples, size_t count, void *_out)
+{
+    size_t groups = (count + DM35425_CODEC_GROUP - 1) / DM35425_CODEC_GROUP;
+    size_t limit = count * sizeof(int16_t); // packed sizes from here on are stored raw
+    uint8_t *out = _out;
+    uint8_t *widths = out;   // one byte per group first
+    uint8_t *p = out + groups; // then the packed groups
+    int32_t block[DM35425_CODEC_GROUP + 1]; // the sample before the group, then the group
+    DM35425_Codec_Vec values[DM35425_CODEC_VECTORS];
+
+    if (count == 0)
+        return 0;
+    if (groups >= limit)
+        goto raw;
+    block[DM35425_CODEC_GROUP] = 0;
+    for (size_t g = 0; g < groups; g++)
+    {
+        const int16_t *x = samples + g * DM35425_CODEC_GROUP;
+        size_t n = count - g * DM35425_CODEC_GROUP < DM35425_CODEC_GROUP ? count - g * DM35425_CODEC_GROUP : DM35425_CODEC_GROUP;
+
+        block[0] = block[DM35425_CODEC_GROUP];
+        for (size_t i = 0; i < n; i++)
+            block[i + 1] = x[i];
+        for (size_t i = n; i < DM35425_CODEC_GROUP; i++) // repeating the last sample pads with zero differences
+            block[i + 1] = block[n];
+
+        DM35425_Codec_Vec any = {0, 0, 0, 0};
+        for (int j = 0; j < DM35425_CODEC_VECTORS; j++)
+        {
+            DM35425_Codec_Ivec before, current;
+            memcpy(&before, &block[j * DM35425_CODEC_LANES], sizeof(before));
+            memcpy(&current, &block[j * DM35425_CODEC_LANES + 1], sizeof(current));
+            DM35425_Codec_Ivec d = current - before;
+            values[j] = (DM35425_Codec_Vec)((d << 1) ^ (d >> 31)); // zigzag
+            any |= values[j];
+        }
+        uint32_t all = any[0] | any[1] | any[2] | any[3];
+        int width = all != 0 ? 32 - __builtin_clz(all) : 0;
+        size_t bytes = DM35425_Codec_Group_Size(n, width);
+
+        if ((size_t)(p - out) + bytes >= limit)
+            goto raw;
+        widths[g] = (uint8_t)width;
+        if (width == 0) // every difference is zero, nothing to store
+            continue;
+        if (n < DM35425_CODEC_GROUP)
+            DM35425_Codec_Pack_Tail(values, n, width, p);
+        else
+        {
+            switch (width)
+            {
+                DM35425_CODEC_WIDTHS(DM35425_Codec_Pack, values, p)
+            default:
+                break;
+            }
+        }
+        p += bytes;
+    }
+    return (size_t)(p - out);
+raw:
+    out[0] = DM35425_CODEC_RAW;
+    memcpy(out + 1, samples, limit);
+    return 1 + limit;
+}
+
+ssize_t DM35425_Codec_Decode(const void *_in, size_t size, int16_t *samples, size_t count)
+{
+    size_t groups = (count + DM35425_CODEC_GROUP - 1) / DM35425_CODEC_GROUP;
+    const uint8_t *in = _in;
+    const uint8_t *widths = in;
+    const uint8_t *p = in + groups;
+    size_t total = groups;
+    DM35425_Codec_Vec values[DM35425_CODEC_VECTORS];
+    int32_t block[DM35425_CODEC_GROUP];
+
+    if (size < groups)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    if (groups > 0 && widths[0] == DM35425_CODEC_RAW)
+    {
+        if (size - 1 < count * sizeof(int16_t))
+        {
+            errno = EBADMSG;
+            return -1;
+        }
+        memcpy(samples, in + 1, count * sizeof(int16_t));
+        return (ssize_t)(1 + count * sizeof(int16_t));
+    }
+    for (size_t g = 0; g < groups; g++)
+    {
+        size_t n = count - g * DM35425_CODEC_GROUP < DM35425_CODEC_GROUP ? count - g * DM35425_CODEC_GROUP : DM35425_CODEC_GROUP;
+        if (widths[g] > DM35425_CODEC_MAX_BITS)
+        {
+            errno = EBADMSG;
+            return -1;
+        }
+        total += DM35425_Codec_Group_Size(n, widths[g]);
+    }
+    if (total > size)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+
+    const DM35425_Codec_Ivec zero = {0, 0, 0, 0};
+    DM35425_Codec_Ivec carry = zero; // the previous sample in every lane
+    for (size_t g = 0; g < groups; g++)
+    {
+        size_t n = count - g * DM35425_CODEC_GROUP < DM35425_CODEC_GROUP ? count - g * DM35425_CODEC_GROUP : DM35425_CODEC_GROUP;
+
+        if (widths[g] == 0)
+            memset(values, 0, sizeof(values));
+        else if (n < DM35425_CODEC_GROUP)
+            DM35425_Codec_Unpack_Tail(p, n, widths[g], values);
+        else
+        {
+            switch (widths[g])
+            {
+                DM35425_CODEC_WIDTHS(DM35425_Codec_Unpack, p, values)
+            default:
+                break;
+            }
+        }
+        p += DM35425_Codec_Group_Size(n, widths[g]);
+
+        for (int j = 0; j < DM35425_CODEC_VECTORS; j++)
+        {
+            DM35425_Codec_Ivec d = (DM35425_Codec_Ivec)((values[j] >> 1) ^ -(values[j] & 1));
+            // Running sum across the lanes in two steps, then on top of the previous sample
+            d += __builtin_shuffle(d, zero, (DM35425_Codec_Ivec){4, 0, 1, 2});
+            d += __builtin_shuffle(d, zero, (DM35425_Codec_Ivec){4, 5, 0, 1});
+            d += carry;
+            memcpy(&block[j * DM35425_CODEC_LANES], &d, sizeof(d));
+            carry = __builtin_shuffle(d, (DM35425_Codec_Ivec){3, 3, 3, 3});
+        }
+
+        int16_t *x = samples + g * DM35425_CODEC_GROUP;
+        for (size_t i = 0; i < n; i++)
+            x[i] = (int16_t)block[i];
+    }
+    return (ssize_t)total;
+}
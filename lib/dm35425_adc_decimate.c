@@ -0,0 +1,361 @@
+/**
+ * @file dm35425_adc_decimate.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the multi-channel decimating filters for the DM35425 ADC.
+ * @version 1.0
+ * @date 2023-05-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include "dm35425_adc_decimate.h"
+#include "dm35425_util_library.h"
+
+#define DM35425_DECIMATE_LANES 8         /*!< Channels per vector; the FIR history is padded to a multiple of this */
+#define DM35425_DECIMATE_CHUNK 512       /*!< Input samples converted into the FIR history at a time, at least */
+#define DM35425_DECIMATE_MAX_GAIN (1ULL << 45) /*!< Largest CIC gain factor^order, leaving room for 12-bit codes in 64 bits */
+
+/**
+ * @brief Eight floats, one per channel. GCC lowers operations on it to whatever vector unit the function is built for.
+ *
+ */
+typedef float DM35425_Decimate_Vec __attribute__((vector_size(DM35425_DECIMATE_LANES * sizeof(float))));
+
+struct _DM35425_Decimator
+{
+    enum DM35425_Decimation_Filter filter; // FIR or CIC
+    int num_channels;                      // number of channels
+    int factor;                            // decimation factor
+    int phase;                             // input samples consumed since the last output, 0 to factor - 1
+    enum DM35425_Input_Ranges *ranges;     // ranges[num_channels]
+    const int32_t **rows;                  // scratch input row pointers, rows[num_channels]
+    float **outputs;                       // scratch output row pointers, outputs[num_channels]
+    // FIR
+    int num_taps;                          // number of taps
+    float *taps;                           // taps[num_taps]
+    size_t padded;                         // channels rounded up to whole vectors, the row length of history
+    size_t chunk;                          // input samples converted into history at a time
+    float *history;                        // (num_taps - 1 + chunk) rows of padded volts, oldest first
+    float *acc;                            // one output row of padded volts
+    bool wide;                             // use the AVX2 build of the FIR kernel
+    // CIC
+    int order;                             // number of integrator/comb stages
+    uint64_t *integrators;                 // integrators[num_channels][order], modulo 2^64
+    uint64_t *combs;                       // combs[num_channels][order], previous comb inputs
+    float *compensator;                    // compensator[num_channels][2], previous two CIC outputs in volts
+    double *scale;                         // scale[num_channels], volts per CIC output count: lsb / factor^order
+    float comp_edge;                       // outer taps of the droop compensator
+    float comp_center;                     // center tap of the droop compensator
+};
+
+/**
+ * @brief Compute one FIR output row: acc[c] = sum of taps[k] * x[-k][c] over all channels, a vector of channels at a time.
+ *
+ * @param dec Decimator.
+ * @param x Row of the newest input sample in the history.
+ */
+static inline void DM35425_Decimate_Fir_Row(DM35425_Decimator *dec, const float *x)
+{
+    const float *taps = dec->taps;
+    size_t padded = dec->padded;
+
+    for (size_t c = 0; c < padded; c += DM35425_DECIMATE_LANES)
+    {
+        DM35425_Decimate_Vec acc = {0}, v;
+        const float *p = x + c;
+        for (int k = 0; k < dec->num_taps; k++, p -= padded)
+        {
+            memcpy(&v, p, sizeof(v));
+            acc += taps[k] * v;
+        }
+        memcpy(&dec->acc[c], &acc, sizeof(acc));
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief {@link DM35425_Decimate_Fir_Row} with 256-bit registers.
+ *
+ * @param dec Decimator.
+ * @param x Row of the newest input sample in the history.
+ */
+__attribute__((target("avx2"))) static void DM35425_Decimate_Fir_Row_Avx2(DM35425_Decimator *dec, const float *x)
+{
+    DM35425_Decimate_Fir_Row(dec, x);
+}
+#endif
+
+/**
+ * @brief Compute one FIR output row with the widest build of {@link DM35425_Decimate_Fir_Row} the CPU runs.
+ *
+ * @param dec Decimator.
+ * @param x Row of the newest input sample in the history.
+ */
+static void DM35425_Decimate_Fir_Output(DM35425_Decimator *dec, const float *x)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (dec->wide)
+    {
+        DM35425_Decimate_Fir_Row_Avx2(dec, x);
+        return;
+    }
+#endif
+    DM35425_Decimate_Fir_Row(dec, x);
+}
+
+/**
+ * @brief Run the FIR. Input is converted to volts and interleaved into the history a chunk at a time, and an output
+ * is computed at every `factor`-th input only.
+ *
+ * @param dec Decimator.
+ * @param raw Raw ADC codes, raw[channel][num_samples].
+ * @param num_samples Number of input samples per channel.
+ * @param outputs Output rows; output j of channel c goes to outputs[c][j * step].
+ * @param step Floats between consecutive outputs of a channel.
+ * @return size_t Number of outputs per channel.
+ */
+static size_t DM35425_Decimate_Fir(DM35425_Decimator *dec, const int32_t *const *raw, size_t num_samples, float *const *outputs, size_t step)
+{
+    size_t keep = (size_t)(dec->num_taps - 1) * dec->padded; // history the next chunk needs
+    float *fresh = dec->history + keep;                     // where the chunk goes
+    size_t out = 0;
+
+    for (size_t pos = 0; pos < num_samples; pos += dec->chunk)
+    {
+        size_t len = num_samples - pos < dec->chunk ? num_samples - pos : dec->chunk;
+        for (int c = 0; c < dec->num_channels; c++)
+        {
+            dec->rows[c] = raw[c] + pos;
+        }
+        DM35425_Adc_Samples_To_Volts_Interleaved(dec->num_channels, dec->ranges, dec->rows, fresh, dec->padded, len);
+
+        for (size_t i = dec->factor - 1 - dec->phase; i < len; i += dec->factor, out++)
+        {
+            DM35425_Decimate_Fir_Output(dec, fresh + i * dec->padded);
+            for (int c = 0; c < dec->num_channels; c++)
+            {
+                outputs[c][out * step] = dec->acc[c];
+            }
+        }
+        dec->phase = (int)((dec->phase + len) % dec->factor);
+        memmove(dec->history, dec->history + len * dec->padded, keep * sizeof(float));
+    }
+    return out;
+}
+
+/**
+ * @brief Run the CIC and its compensator, one channel at a time: the integrators are a serial recursion in time, so
+ * a channel's state stays in registers for the whole block.
+ *
+ * @param dec Decimator.
+ * @param raw Raw ADC codes, raw[channel][num_samples].
+ * @param num_samples Number of input samples per channel.
+ * @param outputs Output rows; output j of channel c goes to outputs[c][j * step].
+ * @param step Floats between consecutive outputs of a channel.
+ * @return size_t Number of outputs per channel.
+ */
+static size_t DM35425_Decimate_Cic(DM35425_Decimator *dec, const int32_t *const *raw, size_t num_samples, float *const *outputs, size_t step)
+{
+    int order = dec->order;
+    size_t out = 0;
+
+    for (int c = 0; c < dec->num_channels; c++)
+    {
+        uint64_t *integrators = &dec->integrators[c * order];
+        uint64_t *combs = &dec->combs[c * order];
+        float *previous = &dec->compensator[c * 2];
+        const int32_t *x = raw[c];
+        float *y = outputs[c];
+        int phase = dec->phase;
+
+        out = 0;
+        for (size_t i = 0; i < num_samples; i++)
+        {
+            uint64_t v = (uint64_t)(int64_t)x[i]; // wraps like two's complement, so the comb differences come out exact
+            for (int s = 0; s < order; s++)
+            {
+                integrators[s] += v;
+                v = integrators[s];
+            }
+            if (++phase < dec->factor)
+                continue;
+            phase = 0;
+            for (int s = 0; s < order; s++)
+            {
+                uint64_t d = v - combs[s];
+                combs[s] = v;
+                v = d;
+            }
+            float volts = (float)((double)(int64_t)v * dec->scale[c]);
+            y[out++ * step] = dec->comp_edge * (volts + previous[1]) + dec->comp_center * previous[0];
+            previous[1] = previous[0];
+            previous[0] = volts;
+        }
+    }
+    dec->phase = (int)((dec->phase + num_samples) % dec->factor);
+    return out;
+}
+
+int DM35425_Decimator_Create(DM35425_Decimator **_dec, int num_channels, const enum DM35425_Input_Ranges *ranges, const struct DM35425_Decimation *config)
+{
+    if (_dec == NULL || ranges == NULL || config == NULL || num_channels < 1 || config->factor < 1)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int c = 0; c < num_channels; c++) // check the ranges now rather than on every buffer
+    {
+        float volts;
+        if (DM35425_Adc_Sample_To_Volts(ranges[c], 0, &volts) != 0)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    uint64_t gain = 1;
+    switch (config->filter)
+    {
+    case DM35425_DECIMATE_FIR:
+        if (config->num_taps < 1 || config->taps == NULL)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        break;
+    case DM35425_DECIMATE_CIC:
+        if (config->order < 1 || config->order > 6)
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        for (int s = 0; s < config->order; s++)
+        {
+            gain *= (uint64_t)config->factor;
+            if (gain > DM35425_DECIMATE_MAX_GAIN)
+            {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    DM35425_Decimator *dec = (DM35425_Decimator *)calloc(1, sizeof(DM35425_Decimator));
+    if (dec == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    dec->filter = config->filter;
+    dec->num_channels = num_channels;
+    dec->factor = config->factor;
+    dec->ranges = (enum DM35425_Input_Ranges *)malloc(num_channels * sizeof(enum DM35425_Input_Ranges));
+    dec->rows = (const int32_t **)malloc(num_channels * sizeof(int32_t *));
+    dec->outputs = (float **)malloc(num_channels * sizeof(float *));
+    if (dec->ranges == NULL || dec->rows == NULL || dec->outputs == NULL)
+        goto errored;
+    memcpy(dec->ranges, ranges, num_channels * sizeof(enum DM35425_Input_Ranges));
+
+    if (dec->filter == DM35425_DECIMATE_FIR)
+    {
+        dec->num_taps = config->num_taps;
+        dec->padded = (num_channels + DM35425_DECIMATE_LANES - 1) / DM35425_DECIMATE_LANES * DM35425_DECIMATE_LANES;
+        // Chunks at least as long as the filter, so shifting the history costs no more than converting into it
+        dec->chunk = (size_t)dec->num_taps > DM35425_DECIMATE_CHUNK ? (size_t)dec->num_taps : DM35425_DECIMATE_CHUNK;
+        dec->taps = (float *)malloc(dec->num_taps * sizeof(float));
+        dec->acc = (float *)malloc(dec->padded * sizeof(float));
+        if (dec->taps == NULL || dec->acc == NULL ||
+            posix_memalign((void **)&dec->history, 64, (dec->num_taps - 1 + dec->chunk) * dec->padded * sizeof(float)) != 0)
+            goto errored;
+        memcpy(dec->taps, config->taps, dec->num_taps * sizeof(float));
+#if defined(__x86_64__) || defined(__i386__)
+        enum DM35425_Simd_Isa isa = DM35425_Simd_Best_Isa();
+        dec->wide = (isa == DM35425_SIMD_AVX2 || isa == DM35425_SIMD_AVX512);
+#endif
+    }
+    else
+    {
+        // A 3-tap [-a, 1 + 2a, -a] compensator with a = order / 24 cancels the CIC droop (1 - order * w^2 / 24) to
+        // second order in the output frequency w
+        dec->order = config->order;
+        dec->comp_edge = -(float)dec->order / 24.0f;
+        dec->comp_center = 1.0f + (float)dec->order / 12.0f;
+        dec->integrators = (uint64_t *)malloc(num_channels * dec->order * sizeof(uint64_t));
+        dec->combs = (uint64_t *)malloc(num_channels * dec->order * sizeof(uint64_t));
+        dec->compensator = (float *)malloc(num_channels * 2 * sizeof(float));
+        dec->scale = (double *)malloc(num_channels * sizeof(double));
+        if (dec->integrators == NULL || dec->combs == NULL || dec->compensator == NULL || dec->scale == NULL)
+            goto errored;
+        for (int c = 0; c < num_channels; c++)
+        {
+            float lsb;
+            DM35425_Adc_Sample_To_Volts(ranges[c], 1, &lsb);
+            dec->scale[c] = (double)lsb / (double)gain;
+        }
+    }
+    DM35425_Decimator_Reset(dec);
+    *_dec = dec;
+    return 0;
+
+errored:
+    DM35425_Decimator_Destroy(dec);
+    errno = ENOMEM;
+    return -1;
+}
+
+void DM35425_Decimator_Destroy(DM35425_Decimator *dec)
+{
+    if (dec == NULL)
+        return;
+    free(dec->ranges);
+    free(dec->rows);
+    free(dec->outputs);
+    free(dec->taps);
+    free(dec->history);
+    free(dec->acc);
+    free(dec->integrators);
+    free(dec->combs);
+    free(dec->compensator);
+    free(dec->scale);
+    free(dec);
+}
+
+void DM35425_Decimator_Reset(DM35425_Decimator *dec)
+{
+    dec->phase = 0;
+    if (dec->filter == DM35425_DECIMATE_FIR)
+    {
+        memset(dec->history, 0, (dec->num_taps - 1 + dec->chunk) * dec->padded * sizeof(float)); // padding columns stay 0
+        return;
+    }
+    memset(dec->integrators, 0, dec->num_channels * dec->order * sizeof(uint64_t));
+    memset(dec->combs, 0, dec->num_channels * dec->order * sizeof(uint64_t));
+    memset(dec->compensator, 0, dec->num_channels * 2 * sizeof(float));
+}
+
+size_t DM35425_Decimator_Process(DM35425_Decimator *dec, const int32_t *const *raw, size_t num_samples, float *const *volts)
+{
+    if (dec->filter == DM35425_DECIMATE_FIR)
+        return DM35425_Decimate_Fir(dec, raw, num_samples, volts, 1);
+    return DM35425_Decimate_Cic(dec, raw, num_samples, volts, 1);
+}
+
+size_t DM35425_Decimator_Process_Interleaved(DM35425_Decimator *dec, const int32_t *const *raw, size_t num_samples, float *volts, size_t stride)
+{
+    for (int c = 0; c < dec->num_channels; c++)
+    {
+        dec->outputs[c] = volts + c;
+    }
+    if (dec->filter == DM35425_DECIMATE_FIR)
+        return DM35425_Decimate_Fir(dec, raw, num_samples, dec->outputs, stride);
+    return DM35425_Decimate_Cic(dec, raw, num_samples, dec->outputs, stride);
+}
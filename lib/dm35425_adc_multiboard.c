@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <sys/mman.h>
 
 #include "dm35425_adc_multiboard.h"
 #include "dm35425_board_access.h"
@@ -86,23 +87,16 @@
 #endif
 
 /**
- * @fn timespec_diff(struct timespec *, struct timespec *, struct timespec *)
- * @brief Compute the diff of two timespecs, that is a - b = result.
- * @param a the minuend
- * @param b the subtrahend
- * @param result a - b
+ * @brief A block of sample memory, aligned to at least 64 bytes.
+ *
  */
-static inline void timespec_diff(struct timespec *a, struct timespec *b,
-                                 struct timespec *result)
+struct DM35425_Arena
 {
-    result->tv_sec = a->tv_sec - b->tv_sec;
-    result->tv_nsec = a->tv_nsec - b->tv_nsec;
-    if (result->tv_nsec < 0)
-    {
-        --result->tv_sec;
-        result->tv_nsec += 1000000000L;
-    }
-}
+    void *base;  // start of the block, NULL if not allocated
+    size_t size; // size of the block in bytes
+    bool mapped; // block is an explicit huge page mapping and must be unmapped
+    bool locked; // block is locked in RAM
+};
 
 struct _DM35425_ADCDMA_Descriptor
 {
@@ -111,34 +105,186 @@ struct _DM35425_ADCDMA_Descriptor
     size_t buf_sz;                                       // buffer size in bytes
     size_t buf_ct;                                       // buffer count
     int next_buf;                                        // next buffer index
-    int **local_buf[DM35425_NUM_ADC_DMA_CHANNELS];       // local buffer
+    struct DM35425_Arena arena;                          // local DMA buffers followed by the voltage buffers
+    unsigned int memory_flags;                           // DM35425_BUFFER_MEMORY_* flags for the next arena
+    size_t stride;                                       // samples from one channel row of the arena to the next
+    int32_t *local_buf;                                  // local DMA buffers, row (buff * num_active + idx) is active channel idx of DMA buffer buff
+    float *volts[DM35425_NUM_ADC_DMA_CHANNELS];          // voltage row of each active channel
+    int batch;                                           // buffers per frame
+    uint64_t frame_read;                                 // buffers_read when the current frame started
+    struct DM35425_Arena batch_arena;                    // with batch > 1, a joined raw row then a joined voltage row per active channel
+    size_t batch_stride;                                 // samples from one row of batch_arena to the next
+    float *batch_volts[DM35425_NUM_ADC_DMA_CHANNELS];    // joined voltage row of each active channel
+    struct DM35425_Decimation decimation;                // decimation settings, FIR taps in decimation_taps
+    float *decimation_taps;                              // copy of the FIR taps
+    DM35425_Decimator *decimator;                        // decimator while the ISR is installed, NULL without decimation
+    struct DM35425_Arena decimated_arena;                // decimated voltage row of each active channel
+    float *decimated[DM35425_NUM_ADC_DMA_CHANNELS];      // decimated voltage rows
+    struct DM35425_Adc_Sample_Stats stats[DM35425_NUM_ADC_DMA_CHANNELS];  // statistics of each active channel in the last frame
+    struct DM35425_Adc_Sample_Stats totals[DM35425_NUM_ADC_DMA_CHANNELS]; // statistics of each active channel since the ISR was installed
     int num_samples_taken[DM35425_NUM_ADC_DMA_CHANNELS]; // number of samples taken
+    uint64_t buffers_read;                               // DMA buffers read since the ISR was installed
+    uint64_t sequence;                                   // DMA buffers read or dropped since the ISR was installed
+    uint64_t delivered;                                  // sequence number of the next buffer the ISR expects
+    uint64_t read_ns;                                    // time the last buffer read was found full
+    uint32_t sample_count;                               // hardware sample count when the last buffer read was found full
+    uint32_t consumed_count;                             // hardware sample count at the end of the last buffer read or dropped
+    bool resynced;                                       // no buffer read since the last resync, so stale interrupts are expected
+    uint64_t overruns;                                   // DMA overruns recovered from since the ISR was installed
+    uint64_t buffers_dropped;                            // DMA buffers dropped by those recoveries
+    int num_active;                                      // number of active channels
+    int active[DM35425_NUM_ADC_DMA_CHANNELS];            // physical DMA channel of each active channel
+    int channels[DM35425_NUM_ADC_DMA_CHANNELS];          // channel (or differential pair) number of each active channel
     uint32_t rate;                                       // sampling rate
     uint32_t actual_rate;                                // set sampling rate
     bool started;                                        // acquisition started
     enum DM35425_Channel_Delay delay;                    // channel delay
-    enum DM35425_Input_Mode input_mode;                  // input mode
-    enum DM35425_Input_Ranges range;                     // input range
+    enum DM35425_Input_Mode modes[DM35425_NUM_ADC_DMA_CHANNELS];    // input mode of each active channel
+    enum DM35425_Input_Ranges ranges[DM35425_NUM_ADC_DMA_CHANNELS]; // input range of each active channel
+};
+
+/**
+ * @brief Histograms filled by the acquisition loop. Recording is lock-free, so {@link DM35425_Multiboard_Get_Stats} can read them at any time.
+ *
+ */
+struct DM35425_Multiboard_Timing
+{
+    uint64_t callbacks;                         // number of successful ISR calls
+    uint64_t last_callback_ns;                  // start of the previous ISR call, 0 before the first one
+    uint64_t stalls;                            // number of watchdog timeouts
+    uint64_t rearms;                            // number of ADCs restarted by the watchdog
+    uint64_t sequence_mismatches;               // frames in which the boards read different numbers of buffers
+    uint64_t frames_dropped;                    // frames dropped because the frame ring was full
+    struct DM35425_Histogram select_to_readout; // select() return to last board read out
+    struct DM35425_Histogram conversion;        // conversion of all boards (of one board per reader in parallel mode) to volts
+    uint64_t frames_held;                       // frames held back by a processing stage
+    struct DM35425_Histogram stages;            // processing stages duration
+    struct DM35425_Histogram callback;          // user ISR duration
+    struct DM35425_Histogram period;            // start of one ISR call to the next
+    struct DM35425_Histogram readout[];         // DMA readout duration per board
+};
+
+/**
+ * @brief Single-producer/single-consumer ring of frames. The acquisition thread only advances `head` and the consumer
+ * only advances `tail`; the lock and condition are used only to put a waiting consumer to sleep.
+ *
+ */
+struct DM35425_Multiboard_Ring
+{
+    size_t depth;                             // number of slots
+    struct DM35425_Multiboard_Frame *frames;  // frames[depth]
+    struct DM35425_ADCDMA_Readout *readouts;  // readouts[depth][num_boards]
+    struct DM35425_Arena arena;               // sample buffers of every slot
+    uint64_t sequence;                        // frames produced, including dropped ones (producer only)
+    uint64_t dropped;                         // frames dropped since the last published one (producer only)
+    uint64_t head __attribute__((aligned(64))); // frames published
+    uint64_t tail __attribute__((aligned(64))); // frames released
+    int waiting;                              // the consumer is asleep in Get_Frame
+    int stopped;                              // acquisition has stopped, no more frames will be published
+    pthread_mutex_t lock;                     // protects waiting consumers
+    pthread_cond_t cond;                      // signalled on publish and on stop
+};
+
+/**
+ * @brief One per-board reader thread in parallel mode.
+ *
+ */
+struct DM35425_Multiboard_Reader
+{
+    DM35425_Multiboard_Descriptor *mbd; // owning multiboard descriptor
+    int board;                          // index of the board this thread reads
+    pthread_t pid;                      // thread id, 0 if not running
 };
 
 struct _DM35425_Multiboard_Descriptor
 {
-    volatile sig_atomic_t done;              // flag to indicate thread is done
+    volatile sig_atomic_t done;              // flag to indicate thread is done, read with DM35425_Multiboard_Done
     int num_boards;                          // number of boards
     DM35425_Multiboard_ISR isr;              // ISR function
     void *user_data;                         // user data
     DM35425_ADCDMA_Descriptor **boards;      // array of board descriptors
     struct DM35425_ADCDMA_Readout *readouts; // array of readouts
+    enum DM35425_Readout_Mode readout_mode;  // whether to convert to volts and/or hand out raw codes
+    int32_t ***raw;                          // raw[board][channel], pointers into the local buffers
+    enum DM35425_Input_Ranges **ranges;      // ranges[board][channel]
+    int *irqs;                               // per-board interrupt received flags
+    bool prefault_buffers;                   // touch buffers before the first wait
+    struct DM35425_Multiboard_Timing *timing; // acquisition loop histograms
+    double watchdog_factor;                  // stall timeout in buffer periods, 0 if disabled
+    enum DM35425_Watchdog_Action watchdog_action; // action on a stall
+    DM35425_Multiboard_Stall_Handler stall_handler; // called on a stall
+    uint64_t *last_activity;                 // per-board time of the last interrupt (ns)
+    uint64_t *stall_timeout;                 // per-board stall timeout (ns)
+    uint64_t *frame_buffers;                 // per-board sequence at the previous frame
+    bool parallel;                           // one reader thread per board instead of one ISR thread
+    bool batching;                           // boards deliver as many buffers per frame as fit in the longest buffer period
+    bool interleaved;                        // convert every board into one sample-major frame instead of per-channel rows
+    bool statistics;                         // compute per-channel statistics of every frame
+    DM35425_Multiboard_Stage stages[DM35425_MULTIBOARD_MAX_STAGES]; // processing stages, in order
+    void *stage_ctx[DM35425_MULTIBOARD_MAX_STAGES]; // context of each stage
+    int num_stages;                          // number of processing stages
+    struct DM35425_Arena frame_arena;        // interleaved frame, num_samples rows of frame_channels volts
+    int frame_channels;                      // active channels over all boards
+    char *reader_cpus;                       // per-board reader CPU sets, reader_cpusetsize bytes each, NULL to use the ISR attributes
+    size_t reader_cpusetsize;                // size of each set in reader_cpus
+    struct DM35425_Multiboard_Reader *readers; // per-board readers in parallel mode
+    pthread_mutex_t frame_lock;              // protects the frame barrier below
+    pthread_cond_t frame_cond;               // signalled when a frame has been delivered or acquisition stops
+    int arrived;                             // readers waiting at the barrier for the current frame
+    bool delivering;                         // the last reader of the current frame is calling the ISR
+    int stop_error;                          // error a reader stopped with during a delivery, reported once it returns; 0 if none
+    uint64_t frame;                          // number of frames released by the barrier
+    uint64_t frame_start;                    // earliest reader wakeup of the current frame (ns)
+    size_t ring_depth;                       // frame ring depth, 0 to call the ISR with every frame
+    struct DM35425_Multiboard_Ring *ring;    // frame ring, kept after RemoveISR so the consumer can drain it
     pthread_t pid;                           // thread id
 };
 
 /**
- * @brief Convert ADC values to voltages
+ * @brief Get the installed ISR. {@link DM35425_ADC_Multiboard_RemoveISR} clears it from another thread.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return DM35425_Multiboard_ISR The ISR, or NULL once removed.
+ */
+static inline DM35425_Multiboard_ISR DM35425_Multiboard_Get_ISR(DM35425_Multiboard_Descriptor *mbd)
+{
+    return __atomic_load_n(&mbd->isr, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Check whether acquisition has stopped. Readers check this without frame_lock.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return bool true once acquisition has stopped.
+ */
+static inline bool DM35425_Multiboard_Done(DM35425_Multiboard_Descriptor *mbd)
+{
+    return __atomic_load_n(&mbd->done, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * @brief Call the ISR unless it has been removed, loading the pointer once.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param num_boards Number of boards, or a negative {@link DM35425_ERROR}.
+ * @param readouts Readouts, NULL on error.
+ */
+static inline void DM35425_Multiboard_Call_ISR(DM35425_Multiboard_Descriptor *mbd, int num_boards, struct DM35425_ADCDMA_Readout *readouts)
+{
+    DM35425_Multiboard_ISR isr = DM35425_Multiboard_Get_ISR(mbd);
+    if (isr != NULL)
+        isr(num_boards, readouts, mbd->user_data);
+}
+
+/**
+ * @brief Point the readout at the last buffer read from the board, compute its statistics if asked to, and convert it to
+ * voltages unless the readout is raw-only.
  *
  * @param handle Handle to ADCDMA device
- * @param voltages Pointer to float array to store voltages
+ * @param readout Readout to fill. Voltages are written to `readout->voltages` and/or the board's columns of
+ * `readout->interleaved`, whichever is not NULL.
  */
-static void DM35425_Convert_ADC(DM35425_ADCDMA_Descriptor *_Nonnull handle, float **_Nonnull voltages);
+static void DM35425_Convert_ADC(DM35425_ADCDMA_Descriptor *_Nonnull handle, struct DM35425_ADCDMA_Readout *_Nonnull readout);
 
 /**
  * @brief Read out ADC raw values
@@ -157,6 +303,19 @@ static int DM35425_Read_Out_ADC(DM35425_ADCDMA_Descriptor *_Nonnull handle, stru
  */
 static void *DM35425_Multiboard_WaitForIRQ(void *ptr);
 
+/**
+ * @brief The thread function for one board in parallel mode.
+ *
+ * @param ptr Pointer to the {@link DM35425_Multiboard_Reader}.
+ * @return void* NULL.
+ */
+static void *DM35425_Multiboard_Reader(void *ptr);
+static void DM35425_Multiboard_Free_Readouts(DM35425_Multiboard_Descriptor *mbd);
+static int DM35425_Multiboard_Join_Threads(DM35425_Multiboard_Descriptor *mbd);
+static void DM35425_Multiboard_Free_Ring(DM35425_Multiboard_Descriptor *mbd);
+static void DM35425_Multiboard_Close_Ring(DM35425_Multiboard_Descriptor *mbd);
+static void DM35425_Arena_Free(struct DM35425_Arena *_Nonnull arena);
+
 #define ADC_0 0              /*!< ADC 0 */
 #define DAC_0 0              /*!< DAC 0 */
 #define NOT_IGNORE_USED 0    /*!< Do not ignore used channels */
@@ -165,12 +324,144 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr);
 #define INTERRUPT_ENABLE 1   /*!< Enable interrupt */
 #define ERROR_INTR_ENABLE 1  /*!< Enable error interrupt */
 #define CHANNEL_0 0          /*!< Channel 0 */
+#define NUM_DIFF_CHANNELS 16 /*!< Number of differential pairs */
 #define NO_CLEAR_INTERRUPT 0 /*!< Do not clear interrupt */
 #define CLEAR_INTERRUPT 1    /*!< Clear interrupt */
+#define DM35425_ARENA_ALIGN 64                 /*!< Alignment of every row of sample memory (a cache line) */
+#define DM35425_HUGEPAGE_SIZE (2UL * 1024 * 1024) /*!< Huge page size the arenas are rounded up to */
+#define DM35425_ARENA_ROW(samples) (((samples) + DM35425_ARENA_ALIGN / sizeof(int32_t) - 1) & ~(DM35425_ARENA_ALIGN / sizeof(int32_t) - 1)) /*!< Samples in a row of `samples` padded to the alignment */
+
+/**
+ * @brief Allocate an arena. With {@link DM35425_BUFFER_MEMORY_HUGEPAGE} explicit huge pages are tried first, and
+ * otherwise the block is aligned to a huge page and marked for transparent huge pages.
+ *
+ * @param arena Arena to fill.
+ * @param size Size in bytes.
+ * @param flags Or-ed {@link DM35425_Buffer_Memory} flags.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+static int DM35425_Arena_Alloc(struct DM35425_Arena *_Nonnull arena, size_t size, unsigned int flags)
+{
+    size_t align = DM35425_ARENA_ALIGN;
+
+    memset(arena, 0x00, sizeof(struct DM35425_Arena));
+    if (flags & DM35425_BUFFER_MEMORY_HUGEPAGE)
+    {
+        align = DM35425_HUGEPAGE_SIZE;
+        size = (size + align - 1) & ~(align - 1);
+#ifdef MAP_HUGETLB
+        void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED)
+        {
+            arena->base = base;
+            arena->mapped = true;
+        }
+        else
+        {
+            MULTIBRD_DBG_INFO("No explicit huge pages for %lu bytes, using transparent huge pages", (unsigned long)size);
+        }
+#endif
+    }
+    if (arena->base == NULL)
+    {
+        int rc = posix_memalign(&arena->base, align, size);
+        if (rc != 0)
+        {
+            arena->base = NULL;
+            errno = rc;
+            return -1;
+        }
+#ifdef MADV_HUGEPAGE
+        if (flags & DM35425_BUFFER_MEMORY_HUGEPAGE)
+            madvise(arena->base, size, MADV_HUGEPAGE); // advisory only
+#endif
+    }
+    arena->size = size;
+
+    if (flags & DM35425_BUFFER_MEMORY_MLOCK)
+    {
+        if (mlock(arena->base, size) != 0)
+        {
+            int err = errno;
+            MULTIBRD_DBG_ERR("Failed to lock %lu bytes [%s]", (unsigned long)size, strerror(err));
+            DM35425_Arena_Free(arena);
+            errno = err;
+            return -1;
+        }
+        arena->locked = true;
+    }
+    return 0;
+}
+
+/**
+ * @brief Free an arena. Does nothing if it is not allocated.
+ *
+ * @param arena Arena to free.
+ */
+static void DM35425_Arena_Free(struct DM35425_Arena *_Nonnull arena)
+{
+    if (arena->base == NULL)
+        return;
+    if (arena->locked)
+        munlock(arena->base, arena->size);
+    if (arena->mapped)
+        munmap(arena->base, arena->size);
+    else
+        free(arena->base);
+    memset(arena, 0x00, sizeof(struct DM35425_Arena));
+}
+
+/**
+ * @brief Local copy of one active channel of one DMA buffer.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @param buff DMA buffer index.
+ * @param idx Active channel index.
+ * @return int32_t* Start of the row, 64-byte aligned.
+ */
+static inline int32_t *DM35425_ADCDMA_Local_Buf(DM35425_ADCDMA_Descriptor *_Nonnull handle, int buff, int idx)
+{
+    return handle->local_buf + ((size_t)buff * handle->num_active + idx) * handle->stride;
+}
+
+/**
+ * @brief Joined raw row of one active channel, when batching.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @param idx Active channel index.
+ * @return int32_t* Start of the row, 64-byte aligned.
+ */
+static inline int32_t *DM35425_ADCDMA_Batch_Raw(DM35425_ADCDMA_Descriptor *_Nonnull handle, int idx)
+{
+    return (int32_t *)handle->batch_arena.base + (size_t)idx * handle->batch_stride;
+}
+
+/**
+ * @brief Joined voltage row of one active channel, when batching.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @param idx Active channel index.
+ * @return float* Start of the row, 64-byte aligned.
+ */
+static inline float *DM35425_ADCDMA_Batch_Volts(DM35425_ADCDMA_Descriptor *_Nonnull handle, int idx)
+{
+    return (float *)handle->batch_arena.base + (size_t)(handle->num_active + idx) * handle->batch_stride;
+}
+
+/**
+ * @brief Whether a board has read all the buffers it delivers in the current frame.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @return bool true once the frame is complete for this board.
+ */
+static inline bool DM35425_ADCDMA_Frame_Ready(DM35425_ADCDMA_Descriptor *_Nonnull handle)
+{
+    return handle->buffers_read - handle->frame_read >= (uint64_t)handle->batch;
+}
 
 int DM35425_ADCDMA_Open(int minor, DM35425_ADCDMA_Descriptor **handle_)
 {
-    DM35425_ADCDMA_Descriptor *handle = (DM35425_ADCDMA_Descriptor *)malloc(sizeof(DM35425_ADCDMA_Descriptor));
+    DM35425_ADCDMA_Descriptor *handle = (DM35425_ADCDMA_Descriptor *)calloc(1, sizeof(DM35425_ADCDMA_Descriptor)); // no local buffers yet
     if (handle == NULL)
     {
         errno = ENOMEM;
@@ -236,23 +527,8 @@ int DM35425_ADCDMA_Close(DM35425_ADCDMA_Descriptor *handle)
     // Close board
     DM35425_Board_Close(handle->board);
     // Free local buffers
-    if (handle->local_buf != NULL)
-    {
-        for (int channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++)
-        {
-            if (handle->local_buf[channel] != NULL)
-            {
-                for (int buff = 0; buff < handle->fb->num_dma_buffers; buff++)
-                {
-                    if (handle->local_buf[channel][buff] != NULL)
-                    {
-                        free(handle->local_buf[channel][buff]);
-                    }
-                }
-                free(handle->local_buf[channel]);
-            }
-        }
-    }
+    DM35425_Arena_Free(&handle->arena);
+    free(handle->decimation_taps);
     // Free ADC function block
     free(handle->fb);
     // Free handle
@@ -262,10 +538,41 @@ int DM35425_ADCDMA_Close(DM35425_ADCDMA_Descriptor *handle)
 
 int DM35425_ADCDMA_Configure_ADC(DM35425_ADCDMA_Descriptor *handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, enum DM35425_Input_Mode input_mode, enum DM35425_Input_Ranges range)
 {
-    if (handle == NULL)
+    uint32_t all_channels = input_mode == DM35425_ADC_INPUT_DIFFERENTIAL ? (1U << NUM_DIFF_CHANNELS) - 1 : 0xFFFFFFFF;
+    return DM35425_ADCDMA_Configure_ADC_Mask(handle, rate, samples_per_buf, delay, input_mode, range, all_channels);
+}
+
+/**
+ * @brief Physical input channel that carries channel `channel` in the given input mode. A differential pair is read
+ * from its positive (lower) input.
+ *
+ * @param input_mode Input mode.
+ * @param channel Channel, or differential pair, number.
+ * @return int Physical DMA channel.
+ */
+static inline int DM35425_ADCDMA_Physical_Channel(enum DM35425_Input_Mode input_mode, int channel)
+{
+    return input_mode == DM35425_ADC_INPUT_DIFFERENTIAL ? channel % 8 + (channel / 8) * 16 : channel;
+}
+
+/**
+ * @brief Configure a board with the given channels.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @param rate Sample rate (Hz).
+ * @param samples_per_buf Samples per channel per DMA buffer.
+ * @param delay Channel delay.
+ * @param num_channels Number of entries in `config`.
+ * @param config Channels to sample, by physical input.
+ * @param numbers Channel number to report for each entry of `config`, NULL to report the physical input.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+static int DM35425_ADCDMA_Configure(DM35425_ADCDMA_Descriptor *_Nonnull handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, int num_channels, const struct DM35425_ADCDMA_Channel_Config *_Nonnull config, const int *_Nullable numbers)
+{
+    if (num_channels < 1 || num_channels > DM35425_NUM_ADC_DMA_CHANNELS)
     {
-        MULTIBRD_DBG_ERR("Handle is NULL");
-        errno = ENODATA;
+        MULTIBRD_DBG_INFO("Invalid number of channels %d", num_channels);
+        errno = EINVAL;
         return -1;
     }
     if (rate < 1 || rate > DM35425_ADC_MAX_RATE)
@@ -280,12 +587,60 @@ int DM35425_ADCDMA_Configure_ADC(DM35425_ADCDMA_Descriptor *handle, uint32_t rat
         errno = EINVAL;
         return -1;
     }
+    int entry[DM35425_NUM_ADC_DMA_CHANNELS]; // entry of config that samples each physical channel, -1 if none
+    bool used[DM35425_NUM_ADC_DMA_CHANNELS] = {false}; // physical inputs taken, including negative inputs of pairs
+    for (int channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++)
+    {
+        entry[channel] = -1;
+    }
+    for (int i = 0; i < num_channels; i++)
+    {
+        int channel = config[i].channel;
+        bool differential = config[i].input_mode == DM35425_ADC_INPUT_DIFFERENTIAL;
+        if (channel < 0 || channel >= DM35425_NUM_ADC_DMA_CHANNELS || (differential && channel % 16 >= 8) ||
+            used[channel] || (differential && used[channel + 8]))
+        {
+            MULTIBRD_DBG_INFO("Invalid or overlapping channel %d (input mode %d)", channel, config[i].input_mode);
+            errno = EINVAL;
+            return -1;
+        }
+        used[channel] = true;
+        if (differential)
+            used[channel + 8] = true;
+        entry[channel] = i;
+    }
+
     size_t buf_sz = samples_per_buf * sizeof(int32_t);
     int channel = 0, result;
     struct DM35425_Board_Descriptor *board = handle->board;
     struct DM35425_Function_Block *fb = handle->fb;
-    for (channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++) // for each channel, TODO: Check if channel number depends on input mode
+    DM35425_Arena_Free(&handle->arena); // left over from a previous configuration, the board is unconfigured until this one succeeds
+    handle->local_buf = NULL;
+    handle->num_active = 0;
+    for (channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++) // active channels in ascending physical order
     {
+        int i = entry[channel];
+        if (i < 0)
+            continue;
+        handle->active[handle->num_active] = channel;
+        handle->channels[handle->num_active] = numbers != NULL ? numbers[i] : channel;
+        handle->modes[handle->num_active] = config[i].input_mode;
+        handle->ranges[handle->num_active] = config[i].range;
+        handle->num_active++;
+    }
+    for (channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++) // for each channel
+    {
+        int i = entry[channel];
+        if (i < 0) // switch off the front end of unused channels so they take no DMA bandwidth
+        {
+            result = DM35425_Adc_Channel_Reset(board, fb, channel);
+            if (result != 0)
+            {
+                MULTIBRD_DBG_ERR("Failed to disable ADC channel %d", channel);
+                return result;
+            }
+            continue;
+        }
         result = DM35425_Dma_Initialize(board, fb, channel, fb->num_dma_buffers, buf_sz); // initialize DMA for channel
         if (result != 0)
         {
@@ -333,51 +688,136 @@ int DM35425_ADCDMA_Configure_ADC(DM35425_ADCDMA_Descriptor *handle, uint32_t rat
                 MULTIBRD_DBG_INFO("Board (%p) DMA buffer %d status for channel %d: buff_stat = 0x%x, buff_ctrl = 0x%x, buff_sz = %d", board, buff, channel, buff_stat, buff_ctrl, buff_sz);
             }
         }
-        result = DM35425_Adc_Channel_Setup(board, fb, channel, delay, input_mode, range); // setup ADC channel
+        result = DM35425_Adc_Channel_Setup(board, fb, channel, delay, config[i].range, config[i].input_mode); // setup ADC channel
         if (result != 0)
         {
-            MULTIBRD_DBG_ERR("Failed to setup ADC channel %d with delay = %d, input mode = %d, range = %d", channel, delay, input_mode, range);
+            MULTIBRD_DBG_ERR("Failed to setup ADC channel %d with delay = %d, input mode = %d, range = %d", channel, delay, config[i].input_mode, config[i].range);
             return result;
         }
     }
 
-    result = DM35425_Dma_Configure_Interrupts(board, fb, CHANNEL_0, INTERRUPT_ENABLE, ERROR_INTR_ENABLE); // enable DMA interrupts for channel
+    result = DM35425_Dma_Configure_Interrupts(board, fb, handle->active[0], INTERRUPT_ENABLE, ERROR_INTR_ENABLE); // the first active channel interrupts for all of them
     if (result != 0)
     {
-        MULTIBRD_DBG_ERR("Failed to enable DMA interrupts for channel %d", CHANNEL_0);
+        MULTIBRD_DBG_ERR("Failed to enable DMA interrupts for channel %d", handle->active[0]);
         return result;
     }
-    // Now we can allocate memory for the local buffers
-    for (channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++) // this is a static allocation and will not depend on channel input mode
+    // Now we can allocate memory for the local buffers: one row per active channel for every DMA buffer, then one row of voltages per active channel
+    size_t stride = DM35425_ARENA_ROW(samples_per_buf);
+    size_t rows = (size_t)handle->num_active * (fb->num_dma_buffers + 1);
+    if (DM35425_Arena_Alloc(&handle->arena, rows * stride * sizeof(int32_t), handle->memory_flags) != 0)
     {
-        int **local_buf = (int **)malloc(sizeof(int *) * fb->num_dma_buffers);
-        if (local_buf == NULL)
-        {
-            MULTIBRD_DBG_ERR("Failed to allocate memory for local buffer for channel %d", channel);
-            errno = ENOMEM;
-            return -1;
-        }
-        for (int buff = 0; buff < fb->num_dma_buffers; buff++)
-        {
-            local_buf[buff] = (int *)malloc(buf_sz);
-            if (local_buf[buff] == NULL)
-            {
-                MULTIBRD_DBG_ERR("Failed to allocate memory for local buffer %d for channel %d", buff, channel);
-                errno = ENOMEM;
-                return -1;
-            }
-        }
-        handle->local_buf[channel] = local_buf;
+        MULTIBRD_DBG_ERR("Failed to allocate %lu bytes for the local buffers [%s]", (unsigned long)(rows * stride * sizeof(int32_t)), strerror(errno));
+        return -1;
+    }
+    handle->stride = stride;
+    handle->local_buf = (int32_t *)handle->arena.base;
+    for (int idx = 0; idx < handle->num_active; idx++)
+    {
+        handle->volts[idx] = (float *)(handle->local_buf + ((size_t)fb->num_dma_buffers * handle->num_active + idx) * stride);
     }
     handle->buf_sz = buf_sz;
     handle->delay = delay;
-    handle->input_mode = input_mode;
-    handle->range = range;
     handle->rate = rate;
     handle->buf_ct = samples_per_buf;
     return 0;
 }
 
+int DM35425_ADCDMA_Configure_ADC_Mask(DM35425_ADCDMA_Descriptor *handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, enum DM35425_Input_Mode input_mode, enum DM35425_Input_Ranges range, uint32_t channel_mask)
+{
+    if (handle == NULL)
+    {
+        MULTIBRD_DBG_ERR("Handle is NULL");
+        errno = ENODATA;
+        return -1;
+    }
+    if (channel_mask == 0 || (input_mode == DM35425_ADC_INPUT_DIFFERENTIAL && (channel_mask >> NUM_DIFF_CHANNELS) != 0))
+    {
+        MULTIBRD_DBG_INFO("Invalid channel mask 0x%08x for input mode %d", channel_mask, input_mode);
+        errno = EINVAL;
+        return -1;
+    }
+    struct DM35425_ADCDMA_Channel_Config config[DM35425_NUM_ADC_DMA_CHANNELS];
+    int numbers[DM35425_NUM_ADC_DMA_CHANNELS];
+    int num_channels = 0;
+    for (int logical = 0; logical < DM35425_NUM_ADC_DMA_CHANNELS; logical++) // map selected channels to physical channels
+    {
+        if (!(channel_mask & (1U << logical)))
+            continue;
+        config[num_channels].channel = DM35425_ADCDMA_Physical_Channel(input_mode, logical);
+        config[num_channels].input_mode = input_mode;
+        config[num_channels].range = range;
+        numbers[num_channels] = logical;
+        num_channels++;
+    }
+    return DM35425_ADCDMA_Configure(handle, rate, samples_per_buf, delay, num_channels, config, numbers);
+}
+
+int DM35425_ADCDMA_Configure_ADC_Channels(DM35425_ADCDMA_Descriptor *handle, uint32_t rate, size_t samples_per_buf, enum DM35425_Channel_Delay delay, int num_channels, const struct DM35425_ADCDMA_Channel_Config *channels)
+{
+    if (handle == NULL)
+    {
+        MULTIBRD_DBG_ERR("Handle is NULL");
+        errno = ENODATA;
+        return -1;
+    }
+    if (channels == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return DM35425_ADCDMA_Configure(handle, rate, samples_per_buf, delay, num_channels, channels, NULL);
+}
+
+int DM35425_ADCDMA_Set_Buffer_Memory(DM35425_ADCDMA_Descriptor *handle, unsigned int flags)
+{
+    if (handle == NULL || (flags & ~(unsigned int)(DM35425_BUFFER_MEMORY_HUGEPAGE | DM35425_BUFFER_MEMORY_MLOCK)) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    handle->memory_flags = flags;
+    return 0;
+}
+
+int DM35425_ADCDMA_Set_Decimation(DM35425_ADCDMA_Descriptor *handle, const struct DM35425_Decimation *decimation)
+{
+    if (handle == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (decimation != NULL && decimation->filter != DM35425_DECIMATE_NONE)
+    {
+        // Let the decimator check the settings, for any channel
+        enum DM35425_Input_Ranges range = DM35425_ADC_RNG_BIPOLAR_10V;
+        DM35425_Decimator *dec = NULL;
+        if (DM35425_Decimator_Create(&dec, 1, &range, decimation) != 0)
+            return -1;
+        DM35425_Decimator_Destroy(dec);
+    }
+
+    float *taps = NULL;
+    if (decimation != NULL && decimation->filter == DM35425_DECIMATE_FIR)
+    {
+        taps = (float *)malloc(decimation->num_taps * sizeof(float));
+        if (taps == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        memcpy(taps, decimation->taps, decimation->num_taps * sizeof(float));
+    }
+    free(handle->decimation_taps);
+    handle->decimation_taps = taps;
+    if (decimation != NULL)
+        handle->decimation = *decimation;
+    else
+        handle->decimation.filter = DM35425_DECIMATE_NONE;
+    handle->decimation.taps = taps;
+    return 0;
+}
+
 int DM35425_ADC_Multiboard_Init(DM35425_Multiboard_Descriptor **_mbd, int num_boards, DM35425_ADCDMA_Descriptor *first_board, ...)
 {
     if (first_board == NULL)
@@ -421,6 +861,14 @@ int DM35425_ADC_Multiboard_Init(DM35425_Multiboard_Descriptor **_mbd, int num_bo
         goto errored_boards;
     }
 
+    mbd->timing = (struct DM35425_Multiboard_Timing *)calloc(1, sizeof(struct DM35425_Multiboard_Timing) + sizeof(struct DM35425_Histogram) * num_boards);
+
+    if (mbd->timing == NULL)
+    {
+        errno = ENOMEM;
+        goto errored_readouts;
+    }
+
     boards[0] = first_board;
     for (int i = 1; i < num_boards; i++) // itreate over and copy ptrs to each board descriptor
     {
@@ -429,7 +877,7 @@ int DM35425_ADC_Multiboard_Init(DM35425_Multiboard_Descriptor **_mbd, int num_bo
         {
             errno = ENODATA;
             va_end(args);
-            goto errored_boards;
+            goto errored_timing;
         }
         boards[i] = board;
     }
@@ -439,10 +887,16 @@ int DM35425_ADC_Multiboard_Init(DM35425_Multiboard_Descriptor **_mbd, int num_bo
     mbd->boards = boards;         // copy over boards
     mbd->num_boards = num_boards; // copy over num_boards
     mbd->readouts = readouts;     // copy over readouts
+    pthread_mutex_init(&mbd->frame_lock, NULL);
+    pthread_cond_init(&mbd->frame_cond, NULL);
     *_mbd = mbd;
 
     return 0;
 
+errored_timing:
+    free(mbd->timing);
+errored_readouts:
+    free(readouts);
 errored_boards:
     free(boards);
 errored:
@@ -461,6 +915,11 @@ int DM35425_ADC_Multiboard_Destroy(DM35425_Multiboard_Descriptor *mbd)
         return status;
     }
 
+    DM35425_Multiboard_Free_Ring(mbd);
+    pthread_cond_destroy(&mbd->frame_cond);
+    pthread_mutex_destroy(&mbd->frame_lock);
+    free(mbd->reader_cpus);
+    free(mbd->timing);
     free(mbd->boards);
     free(mbd);
     return 0;
@@ -473,26 +932,23 @@ int DM35425_ADC_Multiboard_RemoveISR(DM35425_Multiboard_Descriptor *mbd)
         errno = ENODATA;
         return -1;
     }
-    mbd->isr = NULL; // set ISR to NULL
-    mbd->done = 1;   // set done flag
+    __atomic_store_n(&mbd->isr, NULL, __ATOMIC_RELEASE); // set ISR to NULL
+    pthread_mutex_lock(&mbd->frame_lock);
+    __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);   // set done flag
+    pthread_cond_broadcast(&mbd->frame_cond); // release readers waiting at the barrier
+    pthread_mutex_unlock(&mbd->frame_lock);
 
     for (int i = 0; i < mbd->num_boards; i++) // Disable multiboard ISR
     {
         ioctl(mbd->boards[i]->board->file_descriptor, DM35425_IOCTL_WAKEUP); // wake up ISR
     }
 
-    if (mbd->pid) // pthread was not joined already
+    if (DM35425_Multiboard_Join_Threads(mbd) != 0)
     {
-        MULTIBRD_DBG_INFO("Joining thread for multiboard ISR: %p", (void *)mbd->pid);
-        int rc = pthread_join(mbd->pid, NULL);
-        if (rc != 0)
-        {
-            MULTIBRD_DBG_ERR("Failed to join thread for multiboard ISR: %d", rc);
-            errno = rc;
-            return -1;
-        }
+        return -1;
     }
-    mbd->pid = 0; // set pid to 0 if called again
+    DM35425_Multiboard_Close_Ring(mbd);
+    DM35425_Multiboard_Free_Readouts(mbd);
     return 0;
 }
 
@@ -516,43 +972,879 @@ static void *_start_adc_fcn(void *arg)
         MULTIBRD_DBG_ERR("Board %p: Failed to start ADC.", board);
         return (void *)1;
     }
+    result = DM35425_Adc_Get_Sample_Count(board, fb, &adc->consumed_count); // overrun detection counts from here
+    if (result != 0)
+    {
+        MULTIBRD_DBG_ERR("Board %p: Failed to read sample count.", board);
+        return (void *)1;
+    }
     adc->started = true;
     return NULL;
 }
 
-int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *mbd, DM35425_Multiboard_ISR isr, void *user_data, bool block)
+static void DM35425_Multiboard_Free_Readouts(DM35425_Multiboard_Descriptor *mbd)
 {
-    if (mbd == NULL)
+    if (mbd->raw != NULL)
     {
-        errno = ENODATA;
-        return -1;
+        for (int i = 0; i < mbd->num_boards; i++)
+        {
+            free(mbd->raw[i]);
+        }
+        free(mbd->raw);
+        mbd->raw = NULL;
     }
-    // Check if ISR is already installed
-    if (mbd->isr != NULL)
+    if (mbd->ranges != NULL)
     {
-        MULTIBRD_DBG_ERR("ISR already installed");
-        errno = EEXIST;
-        return -1;
+        for (int i = 0; i < mbd->num_boards; i++)
+        {
+            free(mbd->ranges[i]);
+        }
+        free(mbd->ranges);
+        mbd->ranges = NULL;
     }
-    mbd->isr = isr;
-    mbd->user_data = user_data;
-
-    pthread_t *trig_thr = (pthread_t *)malloc(sizeof(pthread_t) * mbd->num_boards);
-    if (trig_thr == NULL)
+    free(mbd->irqs);
+    mbd->irqs = NULL;
+    free(mbd->last_activity);
+    mbd->last_activity = NULL;
+    free(mbd->stall_timeout);
+    mbd->stall_timeout = NULL;
+    free(mbd->frame_buffers);
+    mbd->frame_buffers = NULL;
+    free(mbd->readers);
+    mbd->readers = NULL;
+    for (int i = 0; i < mbd->num_boards; i++)
     {
-        MULTIBRD_DBG_ERR("Failed to allocate memory for trigger threads");
-        return -1;
+        DM35425_Arena_Free(&mbd->boards[i]->batch_arena);
+        DM35425_Arena_Free(&mbd->boards[i]->decimated_arena);
+        DM35425_Decimator_Destroy(mbd->boards[i]->decimator);
+        mbd->boards[i]->decimator = NULL;
     }
+    DM35425_Arena_Free(&mbd->frame_arena);
+}
 
-    pthread_t pid = 0;
-    int rc = pthread_create(&pid, NULL, DM35425_Multiboard_WaitForIRQ, (void *)mbd);
-    if (rc != 0)
+/**
+ * @brief Work out how many buffers each board delivers per frame. Without batching that is one. With batching the
+ * frame period is the longest buffer period, and every other board's buffer period must divide it.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return int 0 on success, -1 with errno EINVAL if the buffer periods are not integer multiples.
+ */
+static int DM35425_Multiboard_Set_Batches(DM35425_Multiboard_Descriptor *mbd)
+{
+    int slowest = 0;
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        mbd->boards[i]->batch = 1;
+    }
+    if (!mbd->batching)
+        return 0;
+
+    for (int i = 1; i < mbd->num_boards; i++) // buffer period is buf_ct / rate
+    {
+        if ((uint64_t)mbd->boards[i]->buf_ct * mbd->boards[slowest]->rate > (uint64_t)mbd->boards[slowest]->buf_ct * mbd->boards[i]->rate)
+            slowest = i;
+    }
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        DM35425_ADCDMA_Descriptor *handle = mbd->boards[i];
+        uint64_t num = (uint64_t)mbd->boards[slowest]->buf_ct * handle->rate;
+        uint64_t den = (uint64_t)handle->buf_ct * mbd->boards[slowest]->rate;
+        if (num % den != 0 || num / den > (uint64_t)handle->fb->num_dma_buffers)
+        {
+            MULTIBRD_DBG_ERR("Board %d: buffer period is not 1 to %d times shorter than board %d's", i, handle->fb->num_dma_buffers, slowest);
+            errno = EINVAL;
+            return -1;
+        }
+        handle->batch = (int)(num / den);
+        MULTIBRD_DBG_INFO("Board %d delivers %d buffers per frame", i, handle->batch);
+    }
+    return 0;
+}
+
+/**
+ * @brief Create a board's decimator, and the rows its readout's voltages are decimated into.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param board Board index, with its readout set up.
+ * @return int 0 on success, -1 on failure.
+ */
+static int DM35425_Multiboard_Alloc_Decimator(DM35425_Multiboard_Descriptor *mbd, int board)
+{
+    DM35425_ADCDMA_Descriptor *handle = mbd->boards[board];
+    size_t stride = DM35425_ARENA_ROW(mbd->readouts[board].num_samples);
+
+    if (DM35425_Decimator_Create(&handle->decimator, handle->num_active, handle->ranges, &handle->decimation) != 0)
+    {
+        MULTIBRD_DBG_ERR("Failed to create the decimator of board %d [%s]", board, strerror(errno));
+        return -1;
+    }
+    if (DM35425_Arena_Alloc(&handle->decimated_arena, handle->num_active * stride * sizeof(float), handle->memory_flags) != 0)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for the decimated voltages of board %d [%s]", board, strerror(errno));
+        return -1;
+    }
+    for (int j = 0; j < handle->num_active; j++)
+    {
+        handle->decimated[j] = (float *)handle->decimated_arena.base + j * stride;
+    }
+    if (mbd->readouts[board].voltages != NULL)
+        mbd->readouts[board].voltages = handle->decimated;
+    return 0;
+}
+
+/**
+ * @brief Allocate the interleaved frame and give every board its columns in it, in board order. Every board must
+ * deliver the same number of samples per frame.
+ *
+ * @param mbd Pointer to the multiboard descriptor, with the readouts set up.
+ * @return int 0 on success, -1 with errno EINVAL if the boards deliver different numbers of samples or the readout is
+ * raw-only, or ENOMEM.
+ */
+static int DM35425_Multiboard_Alloc_Interleaved(DM35425_Multiboard_Descriptor *mbd)
+{
+    size_t num_samples = mbd->readouts[0].num_samples;
+
+    if (mbd->readout_mode == DM35425_READOUT_RAW)
+    {
+        MULTIBRD_DBG_ERR("Interleaved readouts need volts");
+        errno = EINVAL;
+        return -1;
+    }
+    mbd->frame_channels = 0;
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        if (mbd->readouts[i].num_samples != num_samples)
+        {
+            MULTIBRD_DBG_ERR("Board %d delivers %zu samples per frame, board 0 delivers %zu", i, mbd->readouts[i].num_samples, num_samples);
+            errno = EINVAL;
+            return -1;
+        }
+        mbd->readouts[i].column = mbd->frame_channels;
+        mbd->frame_channels += mbd->boards[i]->num_active;
+    }
+    // The frame is written every frame like the local buffers, so it goes in the same kind of memory
+    if (DM35425_Arena_Alloc(&mbd->frame_arena, num_samples * mbd->frame_channels * sizeof(float), mbd->boards[0]->memory_flags) != 0)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for the interleaved frame [%s]", strerror(errno));
+        return -1;
+    }
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        mbd->readouts[i].interleaved = (float *)mbd->frame_arena.base;
+        mbd->readouts[i].frame_channels = mbd->frame_channels;
+    }
+    return 0;
+}
+
+static int DM35425_Multiboard_Alloc_Readouts(DM35425_Multiboard_Descriptor *mbd)
+{
+    int num_boards = mbd->num_boards;
+
+    DM35425_Multiboard_Free_Readouts(mbd); // left over from a previous run
+
+    if (DM35425_Multiboard_Set_Batches(mbd) != 0)
+        return -1;
+
+    mbd->irqs = (int *)calloc(num_boards, sizeof(int)); // interrupt has not triggered yet
+    if (mbd->irqs == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for irqs");
+        errno = ENOMEM;
+        return -1;
+    }
+
+    mbd->last_activity = (uint64_t *)calloc(num_boards, sizeof(uint64_t));
+    mbd->stall_timeout = (uint64_t *)calloc(num_boards, sizeof(uint64_t));
+    if (mbd->last_activity == NULL || mbd->stall_timeout == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for the watchdog");
+        errno = ENOMEM;
+        goto errored;
+    }
+
+    mbd->frame_buffers = (uint64_t *)calloc(num_boards, sizeof(uint64_t));
+    if (mbd->frame_buffers == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for frame sequence numbers");
+        errno = ENOMEM;
+        goto errored;
+    }
+
+    if (mbd->parallel)
+    {
+        mbd->readers = (struct DM35425_Multiboard_Reader *)calloc(num_boards, sizeof(struct DM35425_Multiboard_Reader));
+        if (mbd->readers == NULL)
+        {
+            MULTIBRD_DBG_ERR("Failed to allocate memory for readers");
+            errno = ENOMEM;
+            goto errored;
+        }
+        for (int i = 0; i < num_boards; i++)
+        {
+            mbd->readers[i].mbd = mbd;
+            mbd->readers[i].board = i;
+        }
+    }
+
+    mbd->raw = (int32_t ***)calloc(num_boards, sizeof(int32_t **));
+    mbd->ranges = (enum DM35425_Input_Ranges **)calloc(num_boards, sizeof(enum DM35425_Input_Ranges *));
+    if (mbd->raw == NULL || mbd->ranges == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for raw readouts");
+        errno = ENOMEM;
+        goto errored;
+    }
+    for (int i = 0; i < num_boards; i++)
+    {
+        mbd->raw[i] = (int32_t **)calloc(DM35425_NUM_ADC_DMA_CHANNELS, sizeof(int32_t *));
+        mbd->ranges[i] = (enum DM35425_Input_Ranges *)calloc(DM35425_NUM_ADC_DMA_CHANNELS, sizeof(enum DM35425_Input_Ranges));
+        if (mbd->raw[i] == NULL || mbd->ranges[i] == NULL)
+        {
+            MULTIBRD_DBG_ERR("Failed to allocate memory for raw readouts of board %d", i);
+            errno = ENOMEM;
+            goto errored;
+        }
+        DM35425_ADCDMA_Descriptor *handle = mbd->boards[i];
+        for (int j = 0; j < handle->num_active; j++)
+        {
+            mbd->ranges[i][j] = handle->ranges[j];
+        }
+        int factor = handle->decimation.filter != DM35425_DECIMATE_NONE ? handle->decimation.factor : 1;
+        if (handle->buf_ct % factor != 0 || (factor > 1 && mbd->readout_mode == DM35425_READOUT_RAW))
+        {
+            MULTIBRD_DBG_ERR("Board %d: cannot decimate %zu samples per buffer by %d in this readout mode", i, handle->buf_ct, factor);
+            errno = EINVAL;
+            goto errored;
+        }
+        mbd->readouts[i].num_channels = handle->num_active;
+        mbd->readouts[i].channels = handle->channels;
+        mbd->readouts[i].num_samples = handle->batch * handle->buf_ct / factor;
+        mbd->readouts[i].decimation = factor;
+        mbd->readouts[i].raw = mbd->raw[i];
+        mbd->readouts[i].ranges = mbd->ranges[i];
+        mbd->readouts[i].voltages = mbd->readout_mode == DM35425_READOUT_RAW || mbd->interleaved ? NULL : handle->volts;
+        mbd->readouts[i].interleaved = NULL;
+        mbd->readouts[i].column = 0;
+        mbd->readouts[i].frame_channels = 0;
+        mbd->readouts[i].stats = mbd->statistics ? handle->stats : NULL;
+        mbd->readouts[i].totals = mbd->statistics ? handle->totals : NULL;
+        for (int j = 0; j < handle->num_active; j++)
+        {
+            DM35425_Adc_Stats_Init(&handle->totals[j]);
+        }
+        if (handle->batch > 1)
+        {
+            // Buffers of a batch are joined into rows of their own; the local buffers stay a ring of single buffers
+            handle->batch_stride = DM35425_ARENA_ROW(handle->batch * handle->buf_ct);
+            if (DM35425_Arena_Alloc(&handle->batch_arena, 2 * handle->num_active * handle->batch_stride * sizeof(int32_t), handle->memory_flags) != 0)
+            {
+                MULTIBRD_DBG_ERR("Failed to allocate memory for the batches of board %d [%s]", i, strerror(errno));
+                goto errored;
+            }
+            for (int j = 0; j < handle->num_active; j++)
+            {
+                handle->batch_volts[j] = DM35425_ADCDMA_Batch_Volts(handle, j);
+            }
+            if (mbd->readouts[i].voltages != NULL)
+                mbd->readouts[i].voltages = handle->batch_volts;
+        }
+        if (factor > 1 && DM35425_Multiboard_Alloc_Decimator(mbd, i) != 0)
+            goto errored;
+    }
+    if (mbd->interleaved && DM35425_Multiboard_Alloc_Interleaved(mbd) != 0)
+        goto errored;
+    return 0;
+
+errored:
+    DM35425_Multiboard_Free_Readouts(mbd);
+    return -1;
+}
+
+/**
+ * @brief Free the frame ring.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ */
+static void DM35425_Multiboard_Free_Ring(DM35425_Multiboard_Descriptor *mbd)
+{
+    struct DM35425_Multiboard_Ring *ring = mbd->ring;
+
+    if (ring == NULL)
+        return;
+    for (size_t i = 0; ring->readouts != NULL && i < ring->depth * mbd->num_boards; i++)
+    {
+        free(ring->readouts[i].raw);
+        free(ring->readouts[i].voltages);
+        free(ring->readouts[i].ranges);
+        free(ring->readouts[i].stats); // totals share the allocation
+    }
+    DM35425_Arena_Free(&ring->arena);
+    free(ring->readouts);
+    free(ring->frames);
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->lock);
+    free(ring);
+    mbd->ring = NULL;
+}
+
+/**
+ * @brief Allocate the frame ring and every sample buffer in it, so that nothing is allocated while acquiring.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return int 0 on success, -1 on failure.
+ */
+static int DM35425_Multiboard_Alloc_Ring(DM35425_Multiboard_Descriptor *mbd)
+{
+    DM35425_Multiboard_Free_Ring(mbd); // left over from a previous run
+
+    if (mbd->ring_depth == 0)
+        return 0;
+
+    struct DM35425_Multiboard_Ring *ring = (struct DM35425_Multiboard_Ring *)calloc(1, sizeof(struct DM35425_Multiboard_Ring));
+    if (ring == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for the frame ring");
+        errno = ENOMEM;
+        return -1;
+    }
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ring->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_mutex_init(&ring->lock, NULL);
+    ring->depth = mbd->ring_depth;
+    mbd->ring = ring;
+
+    ring->frames = (struct DM35425_Multiboard_Frame *)calloc(ring->depth, sizeof(struct DM35425_Multiboard_Frame));
+    ring->readouts = (struct DM35425_ADCDMA_Readout *)calloc(ring->depth * mbd->num_boards, sizeof(struct DM35425_ADCDMA_Readout));
+    if (ring->frames == NULL || ring->readouts == NULL)
+        goto errored;
+
+    // Every slot holds the interleaved frame if there is one, then a raw row, and a voltage row unless in raw or
+    // interleaved mode, per active channel of every board
+    size_t rows_per_channel = mbd->readout_mode == DM35425_READOUT_RAW || mbd->interleaved ? 1 : 2;
+    size_t frame_sz = mbd->interleaved ? DM35425_ARENA_ROW(mbd->readouts[0].num_samples * mbd->frame_channels) * sizeof(float) : 0;
+    size_t slot_sz = frame_sz;
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        size_t volts_sz = (rows_per_channel - 1) * DM35425_ARENA_ROW(mbd->readouts[i].num_samples);
+        slot_sz += mbd->boards[i]->num_active * (DM35425_ARENA_ROW(mbd->readouts[i].num_samples * mbd->readouts[i].decimation) + volts_sz) * sizeof(int32_t);
+    }
+    if (DM35425_Arena_Alloc(&ring->arena, ring->depth * slot_sz, DM35425_BUFFER_MEMORY_DEFAULT) != 0)
+        goto errored;
+
+    char *row = (char *)ring->arena.base;
+    for (size_t slot = 0; slot < ring->depth; slot++)
+    {
+        float *frame = frame_sz != 0 ? (float *)row : NULL;
+        row += frame_sz;
+        ring->frames[slot].num_boards = mbd->num_boards;
+        ring->frames[slot].readouts = &ring->readouts[slot * mbd->num_boards];
+        for (int i = 0; i < mbd->num_boards; i++)
+        {
+            struct DM35425_ADCDMA_Readout *readout = &ring->frames[slot].readouts[i];
+            size_t raw_sz = DM35425_ARENA_ROW(mbd->readouts[i].num_samples * mbd->readouts[i].decimation) * sizeof(int32_t);
+            size_t volts_sz = DM35425_ARENA_ROW(mbd->readouts[i].num_samples) * sizeof(float);
+
+            readout->num_channels = mbd->boards[i]->num_active;
+            readout->channels = mbd->boards[i]->channels;
+            readout->num_samples = mbd->readouts[i].num_samples;
+            readout->decimation = mbd->readouts[i].decimation;
+            readout->interleaved = frame;
+            readout->column = mbd->readouts[i].column;
+            readout->frame_channels = mbd->readouts[i].frame_channels;
+            readout->raw = (int32_t **)calloc(DM35425_NUM_ADC_DMA_CHANNELS, sizeof(int32_t *));
+            readout->ranges = (enum DM35425_Input_Ranges *)calloc(DM35425_NUM_ADC_DMA_CHANNELS, sizeof(enum DM35425_Input_Ranges));
+            if (readout->raw == NULL || readout->ranges == NULL)
+                goto errored;
+            if (mbd->statistics)
+            {
+                readout->stats = (struct DM35425_Adc_Sample_Stats *)calloc(2 * DM35425_NUM_ADC_DMA_CHANNELS, sizeof(struct DM35425_Adc_Sample_Stats));
+                if (readout->stats == NULL)
+                    goto errored;
+                readout->totals = readout->stats + DM35425_NUM_ADC_DMA_CHANNELS;
+            }
+            if (mbd->readouts[i].voltages != NULL)
+            {
+                readout->voltages = (float **)calloc(DM35425_NUM_ADC_DMA_CHANNELS, sizeof(float *));
+                if (readout->voltages == NULL)
+                    goto errored;
+            }
+            for (int j = 0; j < readout->num_channels; j++, row += raw_sz)
+            {
+                readout->raw[j] = (int32_t *)row;
+            }
+            for (int j = 0; readout->voltages != NULL && j < readout->num_channels; j++, row += volts_sz)
+            {
+                readout->voltages[j] = (float *)row;
+            }
+        }
+    }
+    return 0;
+
+errored:
+    MULTIBRD_DBG_ERR("Failed to allocate memory for the frame ring");
+    DM35425_Multiboard_Free_Ring(mbd);
+    errno = ENOMEM;
+    return -1;
+}
+
+/**
+ * @brief Copy the current frame into the next free slot of the ring and publish it, or drop it if the consumer has not released any.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ */
+static void DM35425_Multiboard_Publish(DM35425_Multiboard_Descriptor *mbd)
+{
+    struct DM35425_Multiboard_Ring *ring = mbd->ring;
+    uint64_t head = ring->head;
+    uint64_t sequence = ring->sequence++;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->depth)
+    {
+        ring->dropped++;
+        __atomic_fetch_add(&mbd->timing->frames_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct DM35425_Multiboard_Frame *frame = &ring->frames[head % ring->depth];
+    frame->sequence = sequence;
+    frame->dropped = ring->dropped;
+    ring->dropped = 0;
+    if (frame->readouts[0].interleaved != NULL)
+        memcpy(frame->readouts[0].interleaved, mbd->readouts[0].interleaved, mbd->readouts[0].num_samples * mbd->frame_channels * sizeof(float));
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        struct DM35425_ADCDMA_Readout *src = &mbd->readouts[i];
+        struct DM35425_ADCDMA_Readout *dst = &frame->readouts[i];
+        for (int j = 0; j < src->num_channels; j++)
+        {
+            memcpy(dst->raw[j], src->raw[j], src->num_samples * src->decimation * sizeof(int32_t));
+            if (dst->voltages != NULL)
+                memcpy(dst->voltages[j], src->voltages[j], src->num_samples * sizeof(float));
+        }
+        memcpy(dst->ranges, src->ranges, src->num_channels * sizeof(enum DM35425_Input_Ranges));
+        if (dst->stats != NULL)
+        {
+            memcpy(dst->stats, src->stats, src->num_channels * sizeof(struct DM35425_Adc_Sample_Stats));
+            memcpy(dst->totals, src->totals, src->num_channels * sizeof(struct DM35425_Adc_Sample_Stats));
+        }
+        dst->sequence = src->sequence;
+        dst->dropped = src->dropped;
+        dst->first_sample = src->first_sample;
+        dst->timestamp_ns = src->timestamp_ns;
+        dst->sample_count = src->sample_count;
+        dst->sample_rate = src->sample_rate;
+    }
+
+    // Publishing head and checking for a sleeping consumer must not be reordered, see Get_Frame
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_signal(&ring->cond);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
+
+/**
+ * @brief Tell the consumer that no more frames will be published.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ */
+static void DM35425_Multiboard_Close_Ring(DM35425_Multiboard_Descriptor *mbd)
+{
+    struct DM35425_Multiboard_Ring *ring = mbd->ring;
+
+    if (ring == NULL)
+        return;
+    pthread_mutex_lock(&ring->lock);
+    __atomic_store_n(&ring->stopped, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void DM35425_Multiboard_Reset_Timing(DM35425_Multiboard_Descriptor *mbd)
+{
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+
+    timing->callbacks = 0;
+    timing->last_callback_ns = 0;
+    timing->stalls = 0;
+    timing->rearms = 0;
+    timing->sequence_mismatches = 0;
+    timing->frames_dropped = 0;
+    timing->frames_held = 0;
+    DM35425_Histogram_Reset(&timing->select_to_readout);
+    DM35425_Histogram_Reset(&timing->stages);
+    DM35425_Histogram_Reset(&timing->conversion);
+    DM35425_Histogram_Reset(&timing->callback);
+    DM35425_Histogram_Reset(&timing->period);
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        DM35425_Histogram_Reset(&timing->readout[i]);
+    }
+}
+
+/**
+ * @brief Work out each board's stall timeout from its requested rate and start the watchdog clock. Called before the ISR thread is created.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return bool true if the watchdog is enabled.
+ */
+static bool DM35425_Multiboard_Arm_Watchdog(DM35425_Multiboard_Descriptor *mbd)
+{
+    if (mbd->watchdog_factor <= 0)
+        return false;
+
+    uint64_t now = DM35425_Get_Monotonic_Ns();
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        DM35425_ADCDMA_Descriptor *handle = mbd->boards[i];
+        double period_ns = 1e9 * handle->buf_ct / handle->rate;
+        mbd->stall_timeout[i] = (uint64_t)(mbd->watchdog_factor * period_ns);
+        mbd->last_activity[i] = now;
+    }
+    return true;
+}
+
+/**
+ * @brief Time left until a board is due to stall.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param board Board index.
+ * @param now Current time (ns).
+ * @return uint64_t Nanoseconds left, 0 if the board is already overdue.
+ */
+static uint64_t DM35425_Multiboard_Time_Left(DM35425_Multiboard_Descriptor *mbd, int board, uint64_t now)
+{
+    uint64_t waited = now - mbd->last_activity[board];
+    return waited < mbd->stall_timeout[board] ? mbd->stall_timeout[board] - waited : 0;
+}
+
+/**
+ * @brief Convert nanoseconds to a select() timeout, rounding up.
+ *
+ * @param left Nanoseconds.
+ * @param timeout select() timeout to fill.
+ * @return struct timeval* `timeout`.
+ */
+static struct timeval *DM35425_Multiboard_To_Timeval(uint64_t left, struct timeval *timeout)
+{
+    timeout->tv_sec = left / 1000000000ULL;
+    timeout->tv_usec = (left % 1000000000ULL + 999) / 1000;
+    return timeout;
+}
+
+/**
+ * @brief Time left until the first board that has not interrupted yet is due to stall.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param timeout select() timeout to fill.
+ * @return struct timeval* `timeout`.
+ */
+static struct timeval *DM35425_Multiboard_Next_Timeout(DM35425_Multiboard_Descriptor *mbd, struct timeval *timeout)
+{
+    uint64_t now = DM35425_Get_Monotonic_Ns();
+    uint64_t left = UINT64_MAX;
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        if (mbd->irqs[i])
+            continue;
+        uint64_t board_left = DM35425_Multiboard_Time_Left(mbd, i, now);
+        if (board_left < left)
+            left = board_left;
+    }
+    if (left == UINT64_MAX)
+        left = 0;
+    return DM35425_Multiboard_To_Timeval(left, timeout);
+}
+
+/**
+ * @brief Handle a board that may have gone past its stall timeout.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param board Board index.
+ * @param now Time select() returned.
+ * @return int 0 to keep waiting, or the negative {@link DM35425_ERROR} to stop acquisition with.
+ */
+static int DM35425_Multiboard_Check_Stall(DM35425_Multiboard_Descriptor *mbd, int board, uint64_t now)
+{
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+    uint64_t waited = now - mbd->last_activity[board];
+
+    if (waited < mbd->stall_timeout[board])
+        return 0;
+
+    DM35425_ADCDMA_Descriptor *handle = mbd->boards[board];
+    MULTIBRD_DBG_WARN("Board %d (%p): no interrupt for %lu ns", board, handle->board, (unsigned long)waited);
+    __atomic_fetch_add(&timing->stalls, 1, __ATOMIC_RELAXED);
+    if (mbd->stall_handler != NULL)
+    {
+        mbd->stall_handler(board, handle, waited, mbd->user_data);
+    }
+
+    if (mbd->watchdog_action == DM35425_WATCHDOG_REARM)
+    {
+        if (DM35425_Adc_Start_Rearm(handle->board, handle->fb) != 0)
+        {
+            MULTIBRD_DBG_ERR("Board %d (%p): failed to re-arm ADC [%s]", board, handle->board, strerror(errno));
+            return -DM35425_INVALID_IRQ_TIMEOUT;
+        }
+        __atomic_fetch_add(&timing->rearms, 1, __ATOMIC_RELAXED);
+    }
+    else if (mbd->watchdog_action == DM35425_WATCHDOG_ABORT)
+    {
+        errno = ETIMEDOUT;
+        return -DM35425_INVALID_IRQ_TIMEOUT;
+    }
+    mbd->last_activity[board] = DM35425_Get_Monotonic_Ns();
+    return 0;
+}
+
+/**
+ * @brief Handle boards that have not interrupted within their stall timeout.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param now Time select() returned.
+ * @return int 0 to keep waiting, or the negative {@link DM35425_ERROR} to stop acquisition with.
+ */
+static int DM35425_Multiboard_Check_Stalls(DM35425_Multiboard_Descriptor *mbd, uint64_t now)
+{
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        if (mbd->irqs[i])
+            continue;
+        int status = DM35425_Multiboard_Check_Stall(mbd, i, now);
+        if (status != 0)
+            return status;
+    }
+    return 0;
+}
+
+/**
+ * @brief Touch the local DMA and voltage buffers of one board, and for board 0 the interleaved frame.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param board Board index.
+ */
+static void DM35425_Multiboard_Prefault_Board(DM35425_Multiboard_Descriptor *mbd, int board)
+{
+    DM35425_ADCDMA_Descriptor *handle = mbd->boards[board];
+    for (int idx = 0; idx < handle->num_active; idx++)
+    {
+        for (int buff = 0; buff < handle->fb->num_dma_buffers; buff++)
+        {
+            memset(DM35425_ADCDMA_Local_Buf(handle, buff, idx), 0, handle->buf_sz);
+        }
+        if (mbd->readout_mode != DM35425_READOUT_RAW)
+            memset(handle->volts[idx], 0, handle->buf_ct * sizeof(float));
+    }
+    if (handle->batch_arena.base != NULL)
+        memset(handle->batch_arena.base, 0, handle->batch_arena.size);
+    if (handle->decimated_arena.base != NULL)
+        memset(handle->decimated_arena.base, 0, handle->decimated_arena.size);
+    if (board == 0 && mbd->frame_arena.base != NULL) // shared by every board
+        memset(mbd->frame_arena.base, 0, mbd->frame_arena.size);
+}
+
+/**
+ * @brief Touch every local DMA and voltage buffer so that the first interrupts do not take page faults. Runs on the ISR thread before its first wait.
+ *
+ * @param ptr Pointer to the multiboard descriptor.
+ * @return int 0 on success.
+ */
+static int DM35425_Multiboard_Prefault(void *ptr)
+{
+    DM35425_Multiboard_Descriptor *mbd = (DM35425_Multiboard_Descriptor *)ptr;
+
+    if (!mbd->prefault_buffers)
+        return 0;
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        DM35425_Multiboard_Prefault_Board(mbd, i);
+    }
+    return 0;
+}
+
+/**
+ * @brief Prefault the buffers of a reader's own board, on the reader's CPU. Runs on the reader before its first wait.
+ *
+ * @param ptr Pointer to the {@link DM35425_Multiboard_Reader}.
+ * @return int 0 on success.
+ */
+static int DM35425_Multiboard_Prefault_Reader(void *ptr)
+{
+    struct DM35425_Multiboard_Reader *reader = (struct DM35425_Multiboard_Reader *)ptr;
+
+    if (reader->mbd->prefault_buffers)
+        DM35425_Multiboard_Prefault_Board(reader->mbd, reader->board);
+    return 0;
+}
+
+/**
+ * @brief Start the ISR thread, or one reader per board in parallel mode.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param attr Thread settings, NULL for the defaults.
+ * @return int 0 on success, -1 on failure. Readers started before a failure are left running for the caller to stop.
+ */
+static int DM35425_Multiboard_Start_Threads(DM35425_Multiboard_Descriptor *mbd, const struct DM35425_ISR_Attr *attr)
+{
+    if (!mbd->parallel)
+    {
+        pthread_t pid = 0;
+        if (DM35425_Thread_Create_RT(&pid, attr, DM35425_Multiboard_Prefault, DM35425_Multiboard_WaitForIRQ, (void *)mbd) != 0)
+            return -1;
+        mbd->pid = pid;
+        return 0;
+    }
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        struct DM35425_ISR_Attr reader_attr;
+        pthread_t pid = 0;
+
+        if (attr != NULL)
+            reader_attr = *attr;
+        else
+            DM35425_ISR_Attr_Init(&reader_attr);
+        if (mbd->reader_cpus != NULL)
+        {
+            reader_attr.cpuset = (const cpu_set_t *)(mbd->reader_cpus + i * mbd->reader_cpusetsize);
+            reader_attr.cpusetsize = mbd->reader_cpusetsize;
+        }
+        if (DM35425_Thread_Create_RT(&pid, &reader_attr, DM35425_Multiboard_Prefault_Reader, DM35425_Multiboard_Reader, (void *)&mbd->readers[i]) != 0)
+        {
+            MULTIBRD_DBG_ERR("Failed to create reader for board %d [%s]", i, strerror(errno));
+            return -1;
+        }
+        mbd->readers[i].pid = pid;
+    }
+    return 0;
+}
+
+/**
+ * @brief Join the ISR thread or the readers. Acquisition must have been told to stop.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+static int DM35425_Multiboard_Join_Threads(DM35425_Multiboard_Descriptor *mbd)
+{
+    if (mbd->pid) // pthread was not joined already
+    {
+        MULTIBRD_DBG_INFO("Joining thread for multiboard ISR: %p", (void *)mbd->pid);
+        int rc = pthread_join(mbd->pid, NULL);
+        if (rc != 0)
+        {
+            MULTIBRD_DBG_ERR("Failed to join thread for multiboard ISR: %d", rc);
+            errno = rc;
+            return -1;
+        }
+    }
+    mbd->pid = 0; // set pid to 0 if called again
+
+    for (int i = 0; mbd->readers != NULL && i < mbd->num_boards; i++)
+    {
+        if (!mbd->readers[i].pid)
+            continue;
+        int rc = pthread_join(mbd->readers[i].pid, NULL);
+        if (rc != 0)
+        {
+            MULTIBRD_DBG_ERR("Failed to join reader for board %d: %d", i, rc);
+            errno = rc;
+            return -1;
+        }
+        mbd->readers[i].pid = 0;
+    }
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *mbd, DM35425_Multiboard_ISR isr, void *user_data, bool block)
+{
+    return DM35425_ADC_Multiboard_InstallISR_Attr(mbd, isr, user_data, block, NULL);
+}
+
+int DM35425_ADC_Multiboard_InstallISR_Attr(DM35425_Multiboard_Descriptor *mbd, DM35425_Multiboard_ISR isr, void *user_data, bool block, const struct DM35425_ISR_Attr *attr)
+{
+    if (mbd == NULL)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    // Check if ISR is already installed
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("ISR already installed");
+        errno = EEXIST;
+        return -1;
+    }
+    if (attr != NULL && attr->poll != NULL)
+    {
+        MULTIBRD_DBG_ERR("Busy-polling is not supported by the multiboard ISR");
+        errno = EINVAL;
+        return -1;
+    }
+    if (mbd->parallel && mbd->reader_cpus != NULL && attr != NULL && attr->sched_policy == SCHED_DEADLINE)
+    {
+        MULTIBRD_DBG_ERR("SCHED_DEADLINE readers cannot be pinned");
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        if (mbd->boards[i]->local_buf == NULL)
+        {
+            MULTIBRD_DBG_ERR("Board %d is not configured", i);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    pthread_t *trig_thr = (pthread_t *)malloc(sizeof(pthread_t) * mbd->num_boards);
+    if (trig_thr == NULL)
+    {
+        MULTIBRD_DBG_ERR("Failed to allocate memory for trigger threads");
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (DM35425_Multiboard_Alloc_Readouts(mbd) != 0)
+    {
+        free(trig_thr);
+        return -1;
+    }
+
+    if (DM35425_Multiboard_Alloc_Ring(mbd) != 0)
+    {
+        DM35425_Multiboard_Free_Readouts(mbd);
+        free(trig_thr);
+        return -1;
+    }
+
+    DM35425_Multiboard_Reset_Timing(mbd);
+    DM35425_Multiboard_Arm_Watchdog(mbd);
+    __atomic_store_n(&mbd->isr, isr, __ATOMIC_RELEASE);
+    mbd->user_data = user_data;
+    __atomic_store_n(&mbd->done, 0, __ATOMIC_RELEASE);
+    mbd->arrived = 0;
+    mbd->delivering = false;
+    mbd->stop_error = 0;
+    mbd->frame = 0;
+    mbd->prefault_buffers = (attr != NULL && attr->prefault_buffers);
+
+    int rc;
+    if (DM35425_Multiboard_Start_Threads(mbd, attr) != 0)
     {
-        MULTIBRD_DBG_ERR("Failed to create thread for multiboard ISR");
-        errno = rc;
-        goto clean_pthread;
+        MULTIBRD_DBG_ERR("Failed to create thread for multiboard ISR [%s]", strerror(errno));
+        goto errored;
     }
-    mbd->pid = pid;
     MULTIBRD_DBG_INFO("Created thread for multiboard ISR: %p", (void *)mbd->pid);
     // Here we need to start the ADCs etc
     for (int idx = 0; idx < mbd->num_boards; idx++)
@@ -562,8 +1854,9 @@ int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *mbd, DM3542
         struct DM35425_Function_Block *fb = mbd->boards[idx]->fb;
         int result = 0;
 
-        for (int channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++)
+        for (int ch = 0; ch < handle->num_active; ch++)
         {
+            int channel = handle->active[ch];
             result = DM35425_Dma_Start(board, fb, channel);
             if (result != 0)
             {
@@ -574,6 +1867,14 @@ int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *mbd, DM3542
             MULTIBRD_DBG_INFO("Started DMA for board %d (%p) channel %d", idx, board, channel);
         }
 
+        handle->buffers_read = 0;
+        handle->frame_read = 0;
+        handle->sequence = 0;
+        handle->delivered = 0;
+        handle->resynced = false;
+        handle->overruns = 0;
+        handle->buffers_dropped = 0;
+
         result = DM35425_Adc_Set_Start_Trigger(board, fb, DM35425_CLK_SRC_IMMEDIATE);
         if (result != 0)
         {
@@ -629,29 +1930,128 @@ int DM35425_ADC_Multiboard_InstallISR(DM35425_Multiboard_Descriptor *mbd, DM3542
 
     if (block)
     {
-        rc = pthread_join(mbd->pid, NULL);
-        if (rc != 0)
+        if (DM35425_Multiboard_Join_Threads(mbd) != 0)
         {
-            MULTIBRD_DBG_ERR("Failed to join thread for multiboard ISR");
-            errno = rc;
             return -1;
         }
-        mbd->pid = 0;
     }
     return 0;
 
 errored:
+    pthread_mutex_lock(&mbd->frame_lock);
+    __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&mbd->frame_cond);
+    pthread_mutex_unlock(&mbd->frame_lock);
     for (int idx = 0; idx < mbd->num_boards; idx++)
     {
         struct DM35425_Board_Descriptor *board = mbd->boards[idx]->board;
         ioctl(board->file_descriptor, DM35425_IOCTL_WAKEUP);
     }
-    pthread_join(mbd->pid, NULL);
-clean_pthread:
+    DM35425_Multiboard_Join_Threads(mbd);
+    __atomic_store_n(&mbd->isr, NULL, __ATOMIC_RELEASE);
+    DM35425_Multiboard_Free_Readouts(mbd);
     free(trig_thr);
     return -1;
 }
 
+/**
+ * @brief Read out every pending interrupt of a board.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param board Board index.
+ * @return int 0 on success, 1 if the interrupts were all stale (left over from an overrun resync) and no buffer was
+ * read, or the negative {@link DM35425_ERROR} to stop acquisition with.
+ */
+static int DM35425_Multiboard_Drain(DM35425_Multiboard_Descriptor *mbd, int board)
+{
+    union dm35425_ioctl_argument ioctl_arg;
+    uint64_t buffers_read = mbd->boards[board]->buffers_read;
+    int status;
+
+    do // exhaust all available IRQs for this board
+    {
+        status = ioctl(mbd->boards[board]->board->file_descriptor, DM35425_IOCTL_INTERRUPT_GET,
+                       &ioctl_arg); // get interrupt info, should have something now
+        if (status != 0)
+        {
+            MULTIBRD_DBG_WARN("Exiting ISR thread: ioctl INTERRUPT_GET returned error [%s]", strerror(errno));
+            return -DM35425_ERROR_IRQ_GET;
+        }
+        status = DM35425_Read_Out_ADC(mbd->boards[board], ioctl_arg.interrupt);
+        if (status != 0)
+        {
+            MULTIBRD_DBG_WARN("Exiting ISR thread: DM35425_Read_Out_ADC returned error [%s]", strerror(errno));
+            return status;
+        }
+    } while (ioctl_arg.interrupt.interrupts_remaining > 0); // exhaust all the pending interrupts
+    return mbd->boards[board]->buffers_read == buffers_read ? 1 : 0;
+}
+
+/**
+ * @brief Call the ISR with a complete frame and record the frame timing. A frame in which the boards did not all
+ * advance by the same number of buffers (read or dropped) since the previous one is counted as a sequence mismatch.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @return int 0 to keep going, -1 if the ISR has been removed.
+ */
+static int DM35425_Multiboard_Deliver(DM35425_Multiboard_Descriptor *mbd)
+{
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+    uint64_t *frame_buffers = mbd->frame_buffers;
+    uint64_t expected = (mbd->boards[0]->sequence - frame_buffers[0]) / mbd->boards[0]->batch; // frames board 0 advanced
+    bool mismatch = false;
+
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        uint64_t sequence = mbd->boards[i]->sequence;
+        if (sequence - frame_buffers[i] != expected * mbd->boards[i]->batch)
+        {
+            MULTIBRD_DBG_WARN("Board %d advanced %lu buffers in this frame, expected %lu", i, (unsigned long)(sequence - frame_buffers[i]), (unsigned long)(expected * mbd->boards[i]->batch));
+            mismatch = true;
+        }
+        frame_buffers[i] = sequence;
+    }
+    if (mismatch)
+    {
+        __atomic_fetch_add(&timing->sequence_mismatches, 1, __ATOMIC_RELAXED);
+    }
+
+    if (mbd->num_stages > 0)
+    {
+        uint64_t stage_start = DM35425_Get_Monotonic_Ns();
+        int held = 0;
+        for (int i = 0; i < mbd->num_stages && held == 0; i++)
+        {
+            held = mbd->stages[i](mbd->num_boards, mbd->readouts, mbd->stage_ctx[i]);
+        }
+        DM35425_Histogram_Record(&timing->stages, DM35425_Get_Monotonic_Ns() - stage_start);
+        if (held != 0)
+        {
+            __atomic_fetch_add(&timing->frames_held, 1, __ATOMIC_RELAXED);
+            return DM35425_Multiboard_Get_ISR(mbd) != NULL ? 0 : -1;
+        }
+    }
+
+    uint64_t callback_start = DM35425_Get_Monotonic_Ns();
+    if (timing->last_callback_ns != 0)
+    {
+        DM35425_Histogram_Record(&timing->period, callback_start - timing->last_callback_ns);
+    }
+    timing->last_callback_ns = callback_start;
+    DM35425_Multiboard_ISR isr = DM35425_Multiboard_Get_ISR(mbd);
+    if (isr == NULL)
+    {
+        return -1;
+    }
+    if (mbd->ring != NULL)
+        DM35425_Multiboard_Publish(mbd);
+    else
+        isr(mbd->num_boards, mbd->readouts, mbd->user_data);
+    DM35425_Histogram_Record(&timing->callback, DM35425_Get_Monotonic_Ns() - callback_start);
+    __atomic_store_n(&timing->callbacks, timing->callbacks + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
 static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
 {
     /*
@@ -667,82 +2067,20 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
         errno = EINVAL;
         return NULL;
     }
-    void *user_data = mbd->user_data;
     int num_boards = mbd->num_boards;
 
-#if MULTIBRD_DBG_LVL >= 3
-    static int isr_call_count = 0;
-    static struct timespec start;
-    struct timespec lstart = {0, 0};
-    struct timespec now;
-    struct timespec delta;
-#endif // MULTIBRD_DBG_LVL >= 3
-
-    int *irqs = (int *)malloc(sizeof(int) * num_boards);
-    if (irqs == NULL)
-    {
-        MULTIBRD_DBG_ERR("Failed to allocate memory for irqs");
-        errno = ENOMEM;
-        return NULL;
-    }
-
-    for (int i = 0; i < num_boards; i++)
-    {
-        irqs[i] = 0; // interrupt has not triggered yet
-    }
-
-    float ***voltages = (float ***)malloc(sizeof(float *) * num_boards);
-    if (voltages == NULL)
-    {
-        MULTIBRD_DBG_ERR("Failed to allocate memory for voltages");
-        errno = ENOMEM;
-        return NULL;
-    }
-    for (int i = 0; i < num_boards; i++)
-    {
-        voltages[i] = (float **)malloc(sizeof(float *) * DM35425_NUM_ADC_DMA_CHANNELS);
-        if (voltages[i] == NULL)
-        {
-            MULTIBRD_DBG_ERR("Failed to allocate memory for voltages[%d]", i);
-            errno = ENOMEM;
-            return NULL;
-        }
-        for (int j = 0; j < DM35425_NUM_ADC_DMA_CHANNELS; j++)
-        {
-            voltages[i][j] = (float *)malloc(sizeof(float) * (mbd->boards[i]->buf_sz / sizeof(int)));
-            if (voltages[i][j] == NULL)
-            {
-                MULTIBRD_DBG_ERR("Failed to allocate memory for voltages[%d][%d]", i, j);
-                errno = ENOMEM;
-                return NULL;
-            }
-            memset(voltages[i][j], 0, sizeof(float) * (mbd->boards[i]->buf_sz / sizeof(int))); // zero out the memory
-        }
-        mbd->readouts[i].num_channels = DM35425_NUM_ADC_DMA_CHANNELS; // TODO: Change to actual number of channels
-        mbd->readouts[i].num_samples = mbd->boards[i]->buf_ct;
-        mbd->readouts[i].voltages = voltages[i];
-    }
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+    int *irqs = mbd->irqs;
+    bool watchdog = mbd->watchdog_factor > 0;
+    struct timeval timeout;
 
     /* Main event loop */
-    while (!mbd->done)
+    while (!DM35425_Multiboard_Done(mbd))
     {
         bool no_error = true; // assume no error
         int avail_irq = 0;    // assume no available IRQs
-        union dm35425_ioctl_argument ioctl_arg;
 
 #if MULTIBRD_DBG_LVL >= 3
-        clock_gettime(CLOCK_MONOTONIC, &start);
-        if (!isr_call_count)
-        {
-            lstart = start;
-        }
-        else
-        {
-            clock_gettime(CLOCK_MONOTONIC, &now);
-            timespec_diff(&start, &lstart, &delta);
-            MULTIBRD_DBG_INFO_NONE("\n");
-            MULTIBRD_DBG_INFO("DMA waiting to select (%d): %ld.%09ld s (since first)\n", isr_call_count, delta.tv_sec, delta.tv_nsec);
-        }
         MULTIBRD_DBG_INFO_NONL("IRQ Status:")
         for (int i = 0; i < num_boards; i++)
         {
@@ -776,25 +2114,38 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
          */
 
         status = select(FD_SETSIZE,
-                        &read_fds, NULL, &exception_fds, NULL);
+                        &read_fds, NULL, &exception_fds, watchdog ? DM35425_Multiboard_Next_Timeout(mbd, &timeout) : NULL);
+        uint64_t woke_up = DM35425_Get_Monotonic_Ns();
 
-        if (mbd->done || mbd->isr == NULL) // this is set only when the thread is being closed
+        if (DM35425_Multiboard_Done(mbd) || DM35425_Multiboard_Get_ISR(mbd) == NULL) // this is set only when the thread is being closed
         {
-            MULTIBRD_DBG_INFO("Out of select: Done = %d, ISR = %p", mbd->done, mbd->isr);
-            mbd->done = 1; // ensure main loop breaks
-            mbd->isr = NULL;
+            MULTIBRD_DBG_INFO("Out of select: Done = %d", DM35425_Multiboard_Done(mbd));
+            __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE); // ensure main loop breaks
+            __atomic_store_n(&mbd->isr, NULL, __ATOMIC_RELEASE);
             break;
         }
 
         if (status < 0) // select failed
         {
-            mbd->done = 1;
+            __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
             // TODO: Call ISR to indicate error DM35425_INVALID_IRQ_SELECT
             MULTIBRD_DBG_WARN("Exiting ISR thread: select returned negative [%s]", strerror(errno));
-            mbd->isr(-DM35425_INVALID_IRQ_SELECT, NULL, user_data);
+            DM35425_Multiboard_Call_ISR(mbd, -DM35425_INVALID_IRQ_SELECT, NULL);
             no_error = false;
             break;
         }
+        else if (status == 0 && watchdog) // a board has not interrupted in time
+        {
+            status = DM35425_Multiboard_Check_Stalls(mbd, woke_up);
+            if (status != 0)
+            {
+                DM35425_Multiboard_Call_ISR(mbd, status, NULL);
+                no_error = false;
+                __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
+                break;
+            }
+            continue;
+        }
         else if (status == 0) // select timed out?
         {
             /*
@@ -804,13 +2155,13 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
             MULTIBRD_DBG_WARN("Exiting ISR thread: select timed out (returned 0) [%s]", strerror(errno));
             errno = ENODATA;
             // TODO: Call ISR to indicate error DM35425_INVALID_IRQ_TIMEOUT
-            mbd->isr(-DM35425_INVALID_IRQ_TIMEOUT, NULL, user_data);
+            DM35425_Multiboard_Call_ISR(mbd, -DM35425_INVALID_IRQ_TIMEOUT, NULL);
             no_error = false;
-            mbd->done = 1;
+            __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
             break;
         }
 
-        for (int i = 0; i < num_boards && !mbd->done; i++) // for each board
+        for (int i = 0; i < num_boards && !DM35425_Multiboard_Done(mbd); i++) // for each board
         {
             if (irqs[i]) // if this is set, this board has already been read from
                 continue;
@@ -820,9 +2171,9 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
                 errno = EIO;
                 // TODO: Call ISR to indicate error DM35425_INVALID_IRQ_IO
                 MULTIBRD_DBG_WARN("Exiting ISR thread: board returned exception [%s]", strerror(errno));
-                mbd->isr(-DM35425_INVALID_IRQ_IO, NULL, user_data);
+                DM35425_Multiboard_Call_ISR(mbd, -DM35425_INVALID_IRQ_IO, NULL);
                 no_error = false;
-                mbd->done = 1;
+                __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
                 break;
             }
 
@@ -846,46 +2197,32 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
                 continue;
             }
             irqs[i] = 1; // if here, interrupt has triggered for this board
-#if MULTIBRD_DBG_LVL >= 3
-            struct timespec tv_s;
-            clock_gettime(CLOCK_MONOTONIC, &tv_s);
-#endif // MULTIBRD_DBG_LVL >= 3
+            uint64_t readout_start = DM35425_Get_Monotonic_Ns();
 
-            do // exhaust all available IRQs for this board
+            status = DM35425_Multiboard_Drain(mbd, i);
+            if (status < 0)
             {
-                status = ioctl(mbd->boards[i]->board->file_descriptor, DM35425_IOCTL_INTERRUPT_GET,
-                               &ioctl_arg); // get interrupt info, should have something now
-                if (status != 0)
-                {
-                    no_error = false;
-                    mbd->done = 1;
-                    // TODO: Call ISR to indicate error DM35425_ERROR_IRQ_GET
-                    MULTIBRD_DBG_WARN("Exiting ISR thread: ioctl INTERRUPT_GET returned error [%s]", strerror(errno));
-                    mbd->isr(-DM35425_ERROR_IRQ_GET, NULL, user_data);
-                    break;
-                }
-                status = DM35425_Read_Out_ADC(mbd->boards[i], ioctl_arg.interrupt);
-                if (status != 0)
-                {
-                    no_error = false;
-                    mbd->done = 1;
-                    // TODO: Call ISR to indicate error DM35425_ERROR_DMA_READ
-                    MULTIBRD_DBG_WARN("Exiting ISR thread: DM35425_Read_Out_ADC returned error [%s]", strerror(errno));
-                    mbd->isr(status, NULL, user_data);
-                    break;
-                }
-            } while (ioctl_arg.interrupt.interrupts_remaining > 0); // exhaust all the pending interrupts
-#if MULTIBRD_DBG_LVL >= 3
-            struct timespec tv_e;
-            clock_gettime(CLOCK_MONOTONIC, &tv_e);
-            timespec_diff(&tv_e, &tv_s, &delta);
-            MULTIBRD_DBG_INFO("DMA waiting to read (%d) %d: %ld.%09ld s (after select)", i, isr_call_count, delta.tv_sec, delta.tv_nsec);
-#endif // MULTIBRD_DBG_LVL >= 3
-            if (no_error)
-                avail_irq++;
+                no_error = false;
+                __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
+                DM35425_Multiboard_Call_ISR(mbd, status, NULL);
+                break;
+            }
+            if (status > 0) // nothing new, keep waiting for this board
+            {
+                irqs[i] = 0;
+                continue;
+            }
+            DM35425_Histogram_Record(&timing->readout[i], DM35425_Get_Monotonic_Ns() - readout_start);
+            mbd->last_activity[i] = readout_start;
+            if (!DM35425_ADCDMA_Frame_Ready(mbd->boards[i])) // more buffers of the batch to come
+            {
+                irqs[i] = 0;
+                continue;
+            }
+            avail_irq++;
         }
 
-        if (mbd->done || mbd->isr == NULL)
+        if (DM35425_Multiboard_Done(mbd) || DM35425_Multiboard_Get_ISR(mbd) == NULL)
         {
             break;
         }
@@ -897,69 +2234,351 @@ static void *DM35425_Multiboard_WaitForIRQ(void *ptr)
         }
         // if here, we can clear the IRQ monitor to reset the select
         memset(irqs, 0x0, sizeof(int) * num_boards);
+        uint64_t convert_start = DM35425_Get_Monotonic_Ns();
+        DM35425_Histogram_Record(&timing->select_to_readout, convert_start - woke_up);
         // Now we have interrupts from all devices ISR can be called after voltage conversion
         for (int i = 0; i < num_boards; i++)
         {
-            DM35425_Convert_ADC(mbd->boards[i], voltages[i]);
+            DM35425_Convert_ADC(mbd->boards[i], &mbd->readouts[i]);
         }
-#if MULTIBRD_DBG_LVL >= 3
-        if (isr_call_count)
+        DM35425_Histogram_Record(&timing->conversion, DM35425_Get_Monotonic_Ns() - convert_start);
+        if (DM35425_Multiboard_Deliver(mbd) != 0)
         {
-            clock_gettime(CLOCK_MONOTONIC, &now);
-            // start = now;
-            timespec_diff(&now, &start, &delta);
-            MULTIBRD_DBG_INFO_NONE("\n");
-            MULTIBRD_DBG_INFO("DMA calling ISR %d: %ld.%09ld s (since loop)", isr_call_count, delta.tv_sec, delta.tv_nsec);
-            timespec_diff(&now, &lstart, &delta);
-            MULTIBRD_DBG_INFO("DMA calling ISR %d: %ld.%09ld s (since start)\n", isr_call_count, delta.tv_sec, delta.tv_nsec);
+            __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
         }
-        isr_call_count++;
-#endif // MULTIBRD_DBG_LVL >= 3
-       // TODO: Call ISR
-        if (mbd->isr != NULL)
+    }
+
+    DM35425_Multiboard_Close_Ring(mbd);
+    return NULL;
+}
+
+/**
+ * @brief Stop acquisition from a reader. The first reader to stop reports `error` to the ISR, or leaves it to the reader
+ * delivering a frame if there is one, and every reader is woken up so that it exits.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param error Negative {@link DM35425_ERROR} to pass to the ISR.
+ */
+static void DM35425_Multiboard_Stop(DM35425_Multiboard_Descriptor *mbd, int error)
+{
+    pthread_mutex_lock(&mbd->frame_lock);
+    bool first = !DM35425_Multiboard_Done(mbd);
+    bool report = first && !mbd->delivering; // the ISR must not run on two threads at once
+    if (first && mbd->delivering)
+        mbd->stop_error = error; // the delivering reader reports it when the ISR returns
+    __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&mbd->frame_cond);
+    pthread_mutex_unlock(&mbd->frame_lock);
+
+    if (!first)
+        return;
+    if (report)
+        DM35425_Multiboard_Call_ISR(mbd, error, NULL);
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        ioctl(mbd->boards[i]->board->file_descriptor, DM35425_IOCTL_WAKEUP); // get the other readers out of select()
+    }
+}
+
+/**
+ * @brief Frame barrier for the readers. The last reader to deliver its board's buffer calls the ISR, while the others wait for it to return.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param woke_up Time the calling reader's select() returned for this frame.
+ * @return int 0 to read the next frame, -1 once acquisition has stopped.
+ */
+static int DM35425_Multiboard_Arrive(DM35425_Multiboard_Descriptor *mbd, uint64_t woke_up)
+{
+    pthread_mutex_lock(&mbd->frame_lock);
+    if (mbd->arrived == 0 || woke_up < mbd->frame_start)
+        mbd->frame_start = woke_up;
+    if (++mbd->arrived < mbd->num_boards)
+    {
+        uint64_t frame = mbd->frame;
+        while (mbd->frame == frame && !DM35425_Multiboard_Done(mbd))
+            pthread_cond_wait(&mbd->frame_cond, &mbd->frame_lock);
+        int status = DM35425_Multiboard_Done(mbd) ? -1 : 0;
+        pthread_mutex_unlock(&mbd->frame_lock);
+        return status;
+    }
+    bool stopped = DM35425_Multiboard_Done(mbd);
+    mbd->delivering = !stopped;
+    pthread_mutex_unlock(&mbd->frame_lock);
+
+    // Every board has delivered; the other readers are parked until the frame is released
+    DM35425_Histogram_Record(&mbd->timing->select_to_readout, DM35425_Get_Monotonic_Ns() - mbd->frame_start);
+    int status = stopped ? -1 : DM35425_Multiboard_Deliver(mbd);
+
+    pthread_mutex_lock(&mbd->frame_lock);
+    if (status != 0)
+        __atomic_store_n(&mbd->done, 1, __ATOMIC_RELEASE);
+    int error = mbd->stop_error; // a reader stopped while the ISR ran
+    mbd->stop_error = 0;
+    mbd->delivering = false;
+    mbd->arrived = 0;
+    mbd->frame++;
+    pthread_cond_broadcast(&mbd->frame_cond);
+    pthread_mutex_unlock(&mbd->frame_lock);
+
+    if (error != 0)
+        DM35425_Multiboard_Call_ISR(mbd, error, NULL);
+    return status;
+}
+
+static void *DM35425_Multiboard_Reader(void *ptr)
+{
+    struct DM35425_Multiboard_Reader *reader = (struct DM35425_Multiboard_Reader *)ptr;
+    DM35425_Multiboard_Descriptor *mbd = reader->mbd;
+    int i = reader->board;
+    DM35425_ADCDMA_Descriptor *handle = mbd->boards[i];
+    int fd = handle->board->file_descriptor;
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+    bool watchdog = mbd->watchdog_factor > 0;
+    struct timeval timeout;
+    fd_set exception_fds;
+    fd_set read_fds;
+    int status;
+
+    while (!DM35425_Multiboard_Done(mbd))
+    {
+        FD_ZERO(&read_fds);
+        FD_ZERO(&exception_fds);
+        FD_SET(fd, &read_fds);
+        FD_SET(fd, &exception_fds);
+
+        status = select(fd + 1, &read_fds, NULL, &exception_fds,
+                        watchdog ? DM35425_Multiboard_To_Timeval(DM35425_Multiboard_Time_Left(mbd, i, DM35425_Get_Monotonic_Ns()), &timeout) : NULL);
+        uint64_t woke_up = DM35425_Get_Monotonic_Ns();
+
+        if (DM35425_Multiboard_Done(mbd) || DM35425_Multiboard_Get_ISR(mbd) == NULL)
+            break;
+
+        if (status < 0)
+        {
+            MULTIBRD_DBG_WARN("Exiting reader for board %d: select returned negative [%s]", i, strerror(errno));
+            DM35425_Multiboard_Stop(mbd, -DM35425_INVALID_IRQ_SELECT);
+            break;
+        }
+        else if (status == 0 && watchdog)
+        {
+            status = DM35425_Multiboard_Check_Stall(mbd, i, woke_up);
+            if (status != 0)
+            {
+                DM35425_Multiboard_Stop(mbd, status);
+                break;
+            }
+            continue;
+        }
+        else if (status == 0)
+        {
+            MULTIBRD_DBG_WARN("Exiting reader for board %d: select timed out (returned 0)", i);
+            errno = ENODATA;
+            DM35425_Multiboard_Stop(mbd, -DM35425_INVALID_IRQ_TIMEOUT);
+            break;
+        }
+
+        if (FD_ISSET(fd, &exception_fds))
+        {
+            errno = EIO;
+            MULTIBRD_DBG_WARN("Exiting reader for board %d: board returned exception [%s]", i, strerror(errno));
+            DM35425_Multiboard_Stop(mbd, -DM35425_INVALID_IRQ_IO);
+            break;
+        }
+
+        status = DM35425_Multiboard_Drain(mbd, i);
+        if (status < 0)
+        {
+            DM35425_Multiboard_Stop(mbd, status);
+            break;
+        }
+        if (status > 0) // nothing new
+            continue;
+        uint64_t convert_start = DM35425_Get_Monotonic_Ns();
+        DM35425_Histogram_Record(&timing->readout[i], convert_start - woke_up);
+        mbd->last_activity[i] = woke_up;
+        if (!DM35425_ADCDMA_Frame_Ready(handle)) // more buffers of the batch to come
+            continue;
+
+        DM35425_Convert_ADC(handle, &mbd->readouts[i]);
+        DM35425_Histogram_Record(&timing->conversion, DM35425_Get_Monotonic_Ns() - convert_start);
+
+        if (DM35425_Multiboard_Arrive(mbd, woke_up) != 0)
+            break;
+    }
+
+    DM35425_Multiboard_Close_Ring(mbd);
+    return NULL;
+}
+
+static void DM35425_Convert_ADC(DM35425_ADCDMA_Descriptor *handle, struct DM35425_ADCDMA_Readout *readout)
+{
+    struct DM35425_Function_Block *fb = handle->fb;
+    int num_buffers = fb->num_dma_buffers;
+    int first_buf = ((handle->next_buf - handle->batch) % num_buffers + num_buffers) % num_buffers; // first buffer of the batch
+    readout->sequence = handle->sequence - handle->batch;
+    readout->dropped = readout->sequence - handle->delivered;
+    handle->delivered = handle->sequence;
+    handle->frame_read = handle->buffers_read;
+    readout->first_sample = readout->sequence * handle->buf_ct / readout->decimation;
+    readout->timestamp_ns = handle->read_ns;
+    readout->sample_count = handle->sample_count;
+    readout->sample_rate = handle->actual_rate;
+    for (int idx = 0; idx < handle->num_active; idx++)
+    {
+        if (handle->batch == 1)
+        {
+            readout->raw[idx] = DM35425_ADCDMA_Local_Buf(handle, first_buf, idx);
+        }
+        else
+        {
+            readout->raw[idx] = DM35425_ADCDMA_Batch_Raw(handle, idx);
+            for (int b = 0; b < handle->batch; b++)
+            {
+                memcpy(readout->raw[idx] + b * handle->buf_ct, DM35425_ADCDMA_Local_Buf(handle, (first_buf + b) % num_buffers, idx), handle->buf_sz);
+            }
+        }
+        if (readout->stats != NULL)
+        {
+            DM35425_Adc_Stats_Init(&readout->stats[idx]);
+            DM35425_Adc_Samples_Stats(readout->raw[idx], (size_t)handle->batch * handle->buf_ct, &readout->stats[idx]);
+            DM35425_Adc_Stats_Merge(&readout->totals[idx], &readout->stats[idx]);
+        }
+        if (readout->voltages == NULL || handle->decimator != NULL)
+            continue;
+        DM35425_Adc_Samples_To_Volts_Bulk(handle->ranges[idx], readout->raw[idx], readout->voltages[idx], readout->num_samples);
+    }
+    if (handle->decimator != NULL)
+    {
+        const int32_t *const *raw = (const int32_t *const *)readout->raw;
+        size_t num_raw = (size_t)handle->batch * handle->buf_ct;
+        if (readout->dropped != 0) // the filter history is from before the gap
+            DM35425_Decimator_Reset(handle->decimator);
+        if (readout->interleaved != NULL)
+            DM35425_Decimator_Process_Interleaved(handle->decimator, raw, num_raw, readout->interleaved + readout->column, readout->frame_channels);
+        else
+            DM35425_Decimator_Process(handle->decimator, raw, num_raw, readout->voltages);
+    }
+    else if (readout->interleaved != NULL)
+        DM35425_Adc_Samples_To_Volts_Interleaved(handle->num_active, handle->ranges, (const int32_t *const *)readout->raw,
+                                                 readout->interleaved + readout->column, readout->frame_channels, readout->num_samples);
+}
+
+/**
+ * @brief Check a board for a DMA overrun: an overflow, underflow or used-buffer error on any active channel, or a
+ * hardware sample count more than all but one DMA buffer ahead of the buffer about to be read.
+ *
+ * @param handle Handle to ADCDMA device, with `sample_count` just read.
+ * @param overrun Set to true on an overrun.
+ * @return int 0 on success, or the negative {@link DM35425_ERROR} to stop acquisition with.
+ */
+static int DM35425_ADCDMA_Check_Overrun(DM35425_ADCDMA_Descriptor *_Nonnull handle, bool *_Nonnull overrun)
+{
+    struct DM35425_Board_Descriptor *board = handle->board;
+    struct DM35425_Function_Block *fb = handle->fb;
+    int32_t backlog = (int32_t)(handle->sample_count - (handle->consumed_count + (uint32_t)handle->buf_ct));
+
+    *overrun = backlog > (int32_t)((fb->num_dma_buffers - 1) * handle->buf_ct);
+    for (int idx = 0; idx < handle->num_active; idx++)
+    {
+        unsigned int channel = handle->active[idx];
+        int dma_error = 0;
+        int overflow, underflow, used, invalid;
+
+        if (DM35425_Dma_Check_For_Error(board, fb, channel, &dma_error) != 0)
         {
-            mbd->isr(num_boards, mbd->readouts, user_data);
+            MULTIBRD_DBG_ERR("Board %p: Checking for DMA error.", board);
+            return -DM35425_ERROR_CHECK_DMA_ERROR;
         }
-        else
+        if (!dma_error)
+            continue;
+        if (DM35425_Dma_Get_Errors(board, fb, channel, &overflow, &underflow, &used, &invalid) != 0)
         {
-            mbd->done = 1;
+            MULTIBRD_DBG_ERR("Board %p: Getting DMA errors on channel %d.", board, channel);
+            return -DM35425_ERROR_CHECK_DMA_ERROR;
         }
-    }
-
-    for (int i = 0; i < num_boards; i++)
-    {
-        for (int j = 0; j < DM35425_NUM_ADC_DMA_CHANNELS; j++)
+        if (invalid)
         {
-            free(voltages[i][j]);
+            MULTIBRD_DBG_ERR("Board %p: DMA error occurred on channel %d.", board, channel);
+            return -DM35425_ERROR_CHANNEL_DMA_ERROR;
         }
-        free(voltages[i]);
+        *overrun = true;
     }
-    free(voltages);
-
-    return NULL;
+    return 0;
 }
 
-static void DM35425_Convert_ADC(DM35425_ADCDMA_Descriptor *handle, float **voltages)
+/**
+ * @brief Recover from a DMA overrun. The newest complete buffer is read, every buffer is handed back to the DMA, the
+ * error status is cleared and the DMA is restarted. The buffers in between are dropped; how many is worked out from
+ * the hardware sample count, or from the DMA position if that is smaller.
+ *
+ * @param handle Handle to ADCDMA device.
+ * @return int 0 on success, or the negative {@link DM35425_ERROR} to stop acquisition with.
+ */
+static int DM35425_ADCDMA_Resync(DM35425_ADCDMA_Descriptor *_Nonnull handle)
 {
+    struct DM35425_Board_Descriptor *board = handle->board;
     struct DM35425_Function_Block *fb = handle->fb;
-    size_t num_samples = handle->buf_sz / sizeof(int);
-    int buf_idx = handle->next_buf - 1 < 0 ? fb->num_dma_buffers - 1 : handle->next_buf - 1;
-    for (int channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++)
+    int num_buffers = fb->num_dma_buffers;
+    uint32_t current_buffer, current_count;
+
+    if (DM35425_Dma_Get_Current_Buffer_Count(board, fb, handle->active[0], &current_buffer, &current_count) != 0)
+    {
+        MULTIBRD_DBG_ERR("Board %p: Getting the current DMA buffer.", board);
+        return -DM35425_ERROR_FIND_USED_BUFFER;
+    }
+    int newest = ((int)current_buffer + num_buffers - 1) % num_buffers; // last buffer the DMA completed
+
+    for (int idx = 0; idx < handle->num_active; idx++)
     {
-        int dchannel = handle->input_mode == DM35425_ADC_INPUT_DIFFERENTIAL ? channel % 8 + (channel / 16) * 8 : channel;
-        for (int i = 0; i < num_samples; i++)
+        unsigned int channel = handle->active[idx];
+
+        if (DM35425_Dma_Read(board, fb, channel, newest, handle->buf_sz, DM35425_ADCDMA_Local_Buf(handle, newest, idx)) != 0)
+        {
+            MULTIBRD_DBG_ERR("Board %p: Reading DMA buffer on channel %d.", board, channel);
+            return -DM35425_ERROR_READ_DMA_BUFFER;
+        }
+        for (int buff = 0; buff < num_buffers; buff++)
+        {
+            if (DM35425_Dma_Reset_Buffer(board, fb, channel, buff) != 0)
+            {
+                MULTIBRD_DBG_ERR("Board %p: Resetting DMA buffer on channel %d.", board, channel);
+                return -DM35425_ERROR_RESET_DMA_BUFFER;
+            }
+        }
+        if (DM35425_Dma_Clear_Interrupt(board, fb, channel, CLEAR_INTERRUPT, CLEAR_INTERRUPT, CLEAR_INTERRUPT, NO_CLEAR_INTERRUPT, CLEAR_INTERRUPT) != 0)
+        {
+            MULTIBRD_DBG_ERR("Board %p: Clearing DMA interrupt on channel %d.", board, channel);
+            return -DM35425_ERROR_CLEAR_DMA_INTERRUPT;
+        }
+        if (DM35425_Dma_Start(board, fb, channel) != 0) // resume a DMA that halted on a used buffer
         {
-            DM35425_Adc_Sample_To_Volts(handle->range, handle->local_buf[channel][buf_idx][i], &voltages[dchannel][i]);
+            MULTIBRD_DBG_ERR("Board %p: Restarting DMA on channel %d.", board, channel);
+            return -DM35425_ERROR_CHANNEL_DMA_ERROR;
         }
     }
+
+    uint64_t skipped = (uint64_t)((newest - handle->next_buf + num_buffers) % num_buffers);
+    int32_t produced = (int32_t)(handle->sample_count - handle->consumed_count);
+    if (produced > 0 && (uint64_t)produced / handle->buf_ct > skipped + 1)
+        skipped = (uint64_t)produced / handle->buf_ct - 1;
+
+    MULTIBRD_DBG_WARN("Board %p: DMA overrun, dropped %lu buffers", board, (unsigned long)skipped);
+    handle->next_buf = (newest + 1) % num_buffers;
+    handle->consumed_count += (uint32_t)((skipped + 1) * handle->buf_ct);
+    handle->sequence += skipped + 1;
+    handle->buffers_read++;
+    handle->resynced = true;
+    __atomic_store_n(&handle->overruns, handle->overruns + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&handle->buffers_dropped, handle->buffers_dropped + skipped, __ATOMIC_RELAXED);
+    return 0;
 }
 
 static int DM35425_Read_Out_ADC(DM35425_ADCDMA_Descriptor *handle, struct dm35425_ioctl_interrupt_info_request int_info)
 {
     int result = 0;
     int buffer_full = 0;
-    int dma_error = 0;
-    unsigned int channel = 0;
+    bool overrun = false;
+    unsigned int channel = handle->active[0]; // the channel that interrupts
 
     struct DM35425_Board_Descriptor *board = handle->board;
     struct DM35425_Function_Block *fb = handle->fb;
@@ -982,77 +2601,92 @@ static int DM35425_Read_Out_ADC(DM35425_ADCDMA_Descriptor *handle, struct dm3542
                 MULTIBRD_DBG_ERR("Board %p: Error finding used buffer.", board);
                 return -DM35425_ERROR_FIND_USED_BUFFER;
             }
-            if (buffer_full == 0)
+
+            handle->read_ns = DM35425_Get_Monotonic_Ns();
+            result = DM35425_Adc_Get_Sample_Count(board, fb, &handle->sample_count);
+            if (result != 0)
             {
-                MULTIBRD_DBG_ERR("Board %p: DMA Interrupt occurred, but buffer was not full.", board);
-                return -DM35425_ERROR_BUFFER_NOT_FULL;
+                MULTIBRD_DBG_ERR("Board %p: Reading sample count.", board);
+                return -DM35425_ERROR_SAMPLE_COUNT;
             }
 
-            // Read all DMA channels
-            for (channel = 0;
-                 channel < DM35425_NUM_ADC_DMA_CHANNELS;
-                 channel++)
+            result = DM35425_ADCDMA_Check_Overrun(handle, &overrun);
+            if (result != 0)
             {
+                return result;
+            }
 
-                result = DM35425_Dma_Check_For_Error(board,
-                                                     fb,
-                                                     channel,
-                                                     &dma_error);
-
+            if (overrun)
+            {
+                result = DM35425_ADCDMA_Resync(handle);
                 if (result != 0)
                 {
-                    MULTIBRD_DBG_ERR("Board %p: Checking for DMA error.", board);
-                    return -DM35425_ERROR_CHECK_DMA_ERROR;
+                    return result;
                 }
-
-                if (dma_error)
+            }
+            else if (buffer_full == 0 && handle->resynced)
+            {
+                // Interrupt for a buffer that was already handed back by the resync
+                MULTIBRD_DBG_INFO("Board %p: Stale DMA interrupt after a resync.", board);
+            }
+            else if (buffer_full == 0)
+            {
+                MULTIBRD_DBG_ERR("Board %p: DMA Interrupt occurred, but buffer was not full.", board);
+                return -DM35425_ERROR_BUFFER_NOT_FULL;
+            }
+            else
+            {
+                // Read all active DMA channels
+                for (int idx = 0; idx < handle->num_active; idx++)
                 {
-                    MULTIBRD_DBG_ERR("Board %p: DMA error occurred on channel %d.", board, channel);
-                    return -DM35425_ERROR_CHANNEL_DMA_ERROR;
-                }
+                    channel = handle->active[idx];
 
-                result = DM35425_Dma_Read(board,
-                                          fb,
-                                          channel,
-                                          handle->next_buf,
-                                          handle->buf_sz,
-                                          handle->local_buf[channel]
-                                                           [handle->next_buf]);
+                    result = DM35425_Dma_Read(board,
+                                              fb,
+                                              channel,
+                                              handle->next_buf,
+                                              handle->buf_sz,
+                                              DM35425_ADCDMA_Local_Buf(handle, handle->next_buf, idx));
 
-                if (result != 0)
-                {
-                    MULTIBRD_DBG_ERR("Board %p: Reading DMA buffer on channel %d.", board, channel);
-                    return -DM35425_ERROR_READ_DMA_BUFFER;
-                }
+                    if (result != 0)
+                    {
+                        MULTIBRD_DBG_ERR("Board %p: Reading DMA buffer on channel %d.", board, channel);
+                        return -DM35425_ERROR_READ_DMA_BUFFER;
+                    }
 
-                result = DM35425_Dma_Reset_Buffer(board,
-                                                  fb,
-                                                  channel,
-                                                  handle->next_buf);
+                    result = DM35425_Dma_Reset_Buffer(board,
+                                                      fb,
+                                                      channel,
+                                                      handle->next_buf);
 
-                if (result != 0)
-                {
-                    MULTIBRD_DBG_ERR("Board %p: Resetting DMA buffer on channel %d.", board, channel);
-                    return -DM35425_ERROR_RESET_DMA_BUFFER;
-                }
+                    if (result != 0)
+                    {
+                        MULTIBRD_DBG_ERR("Board %p: Resetting DMA buffer on channel %d.", board, channel);
+                        return -DM35425_ERROR_RESET_DMA_BUFFER;
+                    }
 
-                result = DM35425_Dma_Clear_Interrupt(board,
-                                                     fb,
-                                                     channel,
-                                                     NO_CLEAR_INTERRUPT,
-                                                     NO_CLEAR_INTERRUPT,
-                                                     NO_CLEAR_INTERRUPT,
-                                                     NO_CLEAR_INTERRUPT,
-                                                     CLEAR_INTERRUPT);
+                    result = DM35425_Dma_Clear_Interrupt(board,
+                                                         fb,
+                                                         channel,
+                                                         NO_CLEAR_INTERRUPT,
+                                                         NO_CLEAR_INTERRUPT,
+                                                         NO_CLEAR_INTERRUPT,
+                                                         NO_CLEAR_INTERRUPT,
+                                                         CLEAR_INTERRUPT);
 
-                if (result != 0)
-                {
-                    MULTIBRD_DBG_ERR("Board %p: Clearing DMA interrupt on channel %d.", board, channel);
-                    return -DM35425_ERROR_CLEAR_DMA_INTERRUPT;
+                    if (result != 0)
+                    {
+                        MULTIBRD_DBG_ERR("Board %p: Clearing DMA interrupt on channel %d.", board, channel);
+                        return -DM35425_ERROR_CLEAR_DMA_INTERRUPT;
+                    }
                 }
-            }
 
-            handle->next_buf = (handle->next_buf + 1) % fb->num_dma_buffers;
+                handle->next_buf = (handle->next_buf + 1) % fb->num_dma_buffers;
+                handle->consumed_count += (uint32_t)handle->buf_ct;
+                handle->sequence++;
+                handle->buffers_read++;
+                handle->resynced = false;
+            }
         }
         else
         {
@@ -1070,33 +2704,357 @@ static int DM35425_Read_Out_ADC(DM35425_ADCDMA_Descriptor *handle, struct dm3542
     return DM35425_SUCCESS;
 }
 
+int DM35425_ADC_Multiboard_Set_Readout_Mode(DM35425_Multiboard_Descriptor *mbd, enum DM35425_Readout_Mode mode)
+{
+    if (mbd == NULL || mode < DM35425_READOUT_VOLTS || mode > DM35425_READOUT_RAW)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Readout mode must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->readout_mode = mode;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Watchdog(DM35425_Multiboard_Descriptor *mbd, double timeout_factor, enum DM35425_Watchdog_Action action, DM35425_Multiboard_Stall_Handler handler)
+{
+    if (mbd == NULL || timeout_factor < 0 || action < DM35425_WATCHDOG_REPORT || action > DM35425_WATCHDOG_ABORT)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Watchdog must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->watchdog_factor = timeout_factor;
+    mbd->watchdog_action = action;
+    mbd->stall_handler = handler;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Parallel(DM35425_Multiboard_Descriptor *mbd, bool parallel, const cpu_set_t *cpusets, size_t cpusetsize)
+{
+    if (mbd == NULL || (cpusets != NULL && cpusetsize == 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Parallel readout must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    char *reader_cpus = NULL;
+    if (parallel && cpusets != NULL)
+    {
+        reader_cpus = (char *)malloc(cpusetsize * mbd->num_boards);
+        if (reader_cpus == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        memcpy(reader_cpus, cpusets, cpusetsize * mbd->num_boards);
+    }
+    free(mbd->reader_cpus);
+    mbd->reader_cpus = reader_cpus;
+    mbd->reader_cpusetsize = reader_cpus != NULL ? cpusetsize : 0;
+    mbd->parallel = parallel;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Batching(DM35425_Multiboard_Descriptor *mbd, bool batching)
+{
+    if (mbd == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Batching must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->batching = batching;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Interleaved(DM35425_Multiboard_Descriptor *mbd, bool interleaved)
+{
+    if (mbd == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Interleaving must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->interleaved = interleaved;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Statistics(DM35425_Multiboard_Descriptor *mbd, bool statistics)
+{
+    if (mbd == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Statistics must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->statistics = statistics;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Add_Stage(DM35425_Multiboard_Descriptor *mbd, DM35425_Multiboard_Stage stage, void *ctx)
+{
+    if (mbd == NULL || stage == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Stages must be added before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    if (mbd->num_stages >= DM35425_MULTIBOARD_MAX_STAGES)
+    {
+        MULTIBRD_DBG_ERR("At most %d stages can be added", DM35425_MULTIBOARD_MAX_STAGES);
+        errno = ENOSPC;
+        return -1;
+    }
+    mbd->stages[mbd->num_stages] = stage;
+    mbd->stage_ctx[mbd->num_stages] = ctx;
+    mbd->num_stages++;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Clear_Stages(DM35425_Multiboard_Descriptor *mbd)
+{
+    if (mbd == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Stages must be cleared before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->num_stages = 0;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Set_Frame_Ring(DM35425_Multiboard_Descriptor *mbd, size_t depth)
+{
+    if (mbd == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Multiboard_Get_ISR(mbd) != NULL)
+    {
+        MULTIBRD_DBG_ERR("Frame ring must be set before the ISR is installed");
+        errno = EBUSY;
+        return -1;
+    }
+    mbd->ring_depth = depth;
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Get_Frame(DM35425_Multiboard_Descriptor *mbd, struct DM35425_Multiboard_Frame **frame, int64_t timeout_ns)
+{
+    if (mbd == NULL || frame == NULL || mbd->ring == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    struct DM35425_Multiboard_Ring *ring = mbd->ring;
+    uint64_t tail = ring->tail;
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        if (timeout_ns == 0)
+        {
+            errno = __atomic_load_n(&ring->stopped, __ATOMIC_ACQUIRE) ? ESHUTDOWN : EAGAIN;
+            return -1;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        if (timeout_ns > 0)
+        {
+            deadline.tv_sec += timeout_ns / 1000000000LL;
+            deadline.tv_nsec += timeout_ns % 1000000000LL;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        }
+
+        int rc = 0;
+        pthread_mutex_lock(&ring->lock);
+        // Announce the wait before checking head again; Publish stores head before checking waiting
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail && !ring->stopped && rc != ETIMEDOUT)
+        {
+            if (timeout_ns < 0)
+                rc = pthread_cond_wait(&ring->cond, &ring->lock);
+            else
+                rc = pthread_cond_timedwait(&ring->cond, &ring->lock, &deadline);
+        }
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+        int stopped = ring->stopped;
+        pthread_mutex_unlock(&ring->lock);
+
+        if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+        {
+            errno = stopped ? ESHUTDOWN : ETIMEDOUT;
+            return -1;
+        }
+    }
+
+    *frame = &ring->frames[tail % ring->depth];
+    return 0;
+}
+
+int DM35425_ADC_Multiboard_Release_Frame(DM35425_Multiboard_Descriptor *mbd)
+{
+    if (mbd == NULL || mbd->ring == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    struct DM35425_Multiboard_Ring *ring = mbd->ring;
+    uint64_t tail = ring->tail;
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        errno = ENODATA; // nothing to release
+        return -1;
+    }
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int DM35425_Multiboard_Get_Stats(DM35425_Multiboard_Descriptor *mbd, struct DM35425_Multiboard_Stats *stats, struct DM35425_Latency_Summary *readout, int num_readout)
+{
+    if (mbd == NULL || stats == NULL || (readout == NULL && num_readout > 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    struct DM35425_Multiboard_Timing *timing = mbd->timing;
+
+    stats->callbacks = __atomic_load_n(&timing->callbacks, __ATOMIC_ACQUIRE);
+    stats->stalls = __atomic_load_n(&timing->stalls, __ATOMIC_RELAXED);
+    stats->rearms = __atomic_load_n(&timing->rearms, __ATOMIC_RELAXED);
+    stats->sequence_mismatches = __atomic_load_n(&timing->sequence_mismatches, __ATOMIC_RELAXED);
+    stats->frames_dropped = __atomic_load_n(&timing->frames_dropped, __ATOMIC_RELAXED);
+    stats->frames_held = __atomic_load_n(&timing->frames_held, __ATOMIC_RELAXED);
+    stats->overruns = 0;
+    stats->buffers_dropped = 0;
+    for (int i = 0; i < mbd->num_boards; i++)
+    {
+        stats->overruns += __atomic_load_n(&mbd->boards[i]->overruns, __ATOMIC_RELAXED);
+        stats->buffers_dropped += __atomic_load_n(&mbd->boards[i]->buffers_dropped, __ATOMIC_RELAXED);
+    }
+    DM35425_Histogram_Summarize(&timing->select_to_readout, &stats->select_to_readout);
+    DM35425_Histogram_Summarize(&timing->conversion, &stats->conversion);
+    DM35425_Histogram_Summarize(&timing->stages, &stats->stages);
+    DM35425_Histogram_Summarize(&timing->callback, &stats->callback);
+    DM35425_Histogram_Summarize(&timing->period, &stats->period);
+    for (int i = 0; i < num_readout && i < mbd->num_boards; i++)
+    {
+        DM35425_Histogram_Summarize(&timing->readout[i], &readout[i]);
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the ISR thread, or a reader thread in parallel mode.
+ *
+ * @param mbd Pointer to the multiboard descriptor.
+ * @param idx Thread index, from 0 to the number of threads.
+ * @param thread Returned thread id.
+ * @return bool false once `idx` is past the last thread.
+ */
+static bool DM35425_Multiboard_Get_Thread(DM35425_Multiboard_Descriptor *mbd, int idx, pthread_t *thread)
+{
+    if (mbd->readers == NULL)
+    {
+        *thread = mbd->pid;
+        return idx == 0;
+    }
+    if (idx >= mbd->num_boards)
+        return false;
+    *thread = mbd->readers[idx].pid;
+    return true;
+}
+
 int DM35425_Multiboard_SetISRPriority(DM35425_Multiboard_Descriptor *handle, int priority)
 {
     struct sched_param param;
+    pthread_t thread;
 
     param.sched_priority = priority;
     if (handle->isr == NULL)
     {
-        errno = -EFAULT;
+        errno = EFAULT;
         return -1;
     }
 
-    if (getuid() != 0)
+    for (int idx = 0; DM35425_Multiboard_Get_Thread(handle, idx, &thread); idx++)
     {
-        return 0;
+        int rc = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (rc != 0)
+        {
+            errno = rc;
+            return -1;
+        }
     }
-
-    return pthread_setschedparam(handle->pid, SCHED_FIFO, &param);
+    return 0;
 }
 
 #if (defined(__linux__) || defined(_POSIX_VERSION)) && defined(_GNU_SOURCE)
 int DM35425_Multiboard_SetISRAffinity(DM35425_Multiboard_Descriptor *_Nonnull handle, size_t cpusetsize, const cpu_set_t *cpuset)
 {
-    return pthread_setaffinity_np(handle->pid, cpusetsize, cpuset);
+    pthread_t thread;
+
+    for (int idx = 0; DM35425_Multiboard_Get_Thread(handle, idx, &thread); idx++)
+    {
+        int rc = pthread_setaffinity_np(thread, cpusetsize, cpuset);
+        if (rc != 0)
+            return rc;
+    }
+    return 0;
 }
 
 int DM35425_Multiboard_GetISRAffinity(DM35425_Multiboard_Descriptor *_Nonnull handle, size_t cpusetsize, cpu_set_t *cpuset)
 {
-    return pthread_getaffinity_np(handle->pid, cpusetsize, cpuset);
+    pthread_t thread;
+
+    DM35425_Multiboard_Get_Thread(handle, 0, &thread);
+    return pthread_getaffinity_np(thread, cpusetsize, cpuset);
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,669 @@
+/**
+ * @file dm35425_adc_overview.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the multi-resolution overview of a recording.
+ * @version 1.0
+ * @date 2023-06-09
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#define _FILE_OFFSET_BITS 64 // files larger than 2 GiB on 32-bit hosts
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "dm35425_adc_overview.h"
+#include "dm35425_adc_library.h"
+
+#define DM35425_OVERVIEW_FACTOR 16 /*!< Default factor */
+
+/**
+ * @brief One level of one channel being built.
+ *
+ */
+struct DM35425_Overview_Series
+{
+    struct DM35425_Overview_Bucket *buckets; // closed buckets
+    uint64_t first_bucket;                   // number of the first bucket
+    size_t count;                            // buckets closed
+    size_t capacity;                         // buckets allocated
+    uint64_t bucket;                         // number of the bucket being filled
+    struct DM35425_Adc_Sample_Stats stats;   // samples of the bucket being filled
+};
+
+/**
+ * @brief Every level of one channel being built.
+ *
+ */
+struct DM35425_Overview_Column
+{
+    bool started;                                                    // a sample has been added
+    uint64_t next;                                                   // position after the last sample added
+    struct DM35425_Overview_Series levels[DM35425_OVERVIEW_MAX_LEVELS]; // levels, finest first
+};
+
+struct _DM35425_Overview_Builder
+{
+    unsigned factor;                                     // buckets per bucket of the level above
+    int num_levels;                                      // levels built
+    uint64_t bucket_samples[DM35425_OVERVIEW_MAX_LEVELS]; // raw samples per bucket of each level
+    int num_boards;                                      // number of boards
+    int *board_column;                                   // board_column[num_boards + 1], first column of each board
+    struct DM35425_Overview_Column *columns;             // columns[num_columns]
+    int error;                                           // errno of a failed Add, 0 if none
+    bool finished;                                       // the last buckets are closed
+};
+
+struct _DM35425_Overview
+{
+    DM35425_Recording_Map *map;                  // the recording
+    const uint8_t *base;                         // mapped overview file
+    size_t length;                               // bytes mapped
+    const struct DM35425_Overview_Header *header; // header of the overview
+    const struct DM35425_Overview_Level *levels; // levels[num_columns][num_levels]
+    int *board_column;                           // board_column[num_boards + 1], first column of each board
+};
+
+int DM35425_Overview_Builder_Create(DM35425_Overview_Builder **_builder, unsigned factor, int num_boards, const struct DM35425_Recording_Board *layout)
+{
+    if (_builder == NULL || layout == NULL || factor == 1 || num_boards < 1)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Overview_Builder *builder = (DM35425_Overview_Builder *)calloc(1, sizeof(DM35425_Overview_Builder));
+    if (builder == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    builder->factor = factor != 0 ? factor : DM35425_OVERVIEW_FACTOR;
+    builder->num_boards = num_boards;
+    builder->board_column = (int *)malloc((num_boards + 1) * sizeof(int));
+    if (builder->board_column == NULL)
+    {
+        free(builder);
+        errno = ENOMEM;
+        return -1;
+    }
+    builder->board_column[0] = 0;
+    for (int b = 0; b < num_boards; b++)
+        builder->board_column[b + 1] = builder->board_column[b] + layout[b].num_channels;
+
+    uint64_t bucket = builder->factor;
+    while (bucket < DM35425_OVERVIEW_MIN_BUCKET)
+        bucket *= builder->factor;
+    for (; builder->num_levels < DM35425_OVERVIEW_MAX_LEVELS; builder->num_levels++)
+    {
+        builder->bucket_samples[builder->num_levels] = bucket;
+        if (bucket > (UINT64_MAX >> 8) / builder->factor) // further levels would overflow positions
+        {
+            builder->num_levels++;
+            break;
+        }
+        bucket *= builder->factor;
+    }
+
+    builder->columns = (struct DM35425_Overview_Column *)calloc(builder->board_column[num_boards] + 1, sizeof(struct DM35425_Overview_Column));
+    if (builder->columns == NULL)
+    {
+        free(builder->board_column);
+        free(builder);
+        errno = ENOMEM;
+        return -1;
+    }
+    *_builder = builder;
+    return 0;
+}
+
+/**
+ * @brief Close the bucket being filled at a level, closing the buckets above it that end before it first.
+ *
+ * @param builder Builder.
+ * @param column Column.
+ * @param level Level.
+ * @return int 0 on success, -1 with errno ENOMEM.
+ */
+static int DM35425_Overview_Close_Bucket(DM35425_Overview_Builder *builder, struct DM35425_Overview_Column *column, int level)
+{
+    struct DM35425_Overview_Series *series = &column->levels[level];
+
+    if (series->count == series->capacity)
+    {
+        size_t capacity = series->capacity != 0 ? series->capacity * 2 : 256;
+        void *buckets = realloc(series->buckets, capacity * sizeof(struct DM35425_Overview_Bucket));
+        if (buckets == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        series->buckets = (struct DM35425_Overview_Bucket *)buckets;
+        series->capacity = capacity;
+    }
+    struct DM35425_Overview_Bucket *bucket = &series->buckets[series->count++];
+    if (series->stats.count == 0)
+        *bucket = (struct DM35425_Overview_Bucket){INT16_MAX, INT16_MIN, 0};
+    else
+        *bucket = (struct DM35425_Overview_Bucket){(int16_t)series->stats.min, (int16_t)series->stats.max,
+                                                   (float)((double)series->stats.sum / series->stats.count)};
+
+    if (level + 1 < builder->num_levels)
+    {
+        struct DM35425_Overview_Series *up = &column->levels[level + 1];
+        uint64_t parent = series->bucket / builder->factor;
+        while (up->bucket < parent)
+        {
+            if (DM35425_Overview_Close_Bucket(builder, column, level + 1) != 0)
+                return -1;
+        }
+        DM35425_Adc_Stats_Merge(&up->stats, &series->stats);
+    }
+    series->bucket++;
+    DM35425_Adc_Stats_Init(&series->stats);
+    return 0;
+}
+
+int DM35425_Overview_Builder_Add(DM35425_Overview_Builder *builder, int board, int channel, uint64_t first_sample, const int32_t *samples, size_t count)
+{
+    if (builder == NULL || samples == NULL || builder->finished || board < 0 || board >= builder->num_boards || channel < 0 ||
+        channel >= builder->board_column[board + 1] - builder->board_column[board])
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (builder->error != 0)
+    {
+        errno = builder->error;
+        return -1;
+    }
+    struct DM35425_Overview_Column *column = &builder->columns[builder->board_column[board] + channel];
+    if (!column->started)
+    {
+        for (int l = 0; l < builder->num_levels; l++)
+        {
+            column->levels[l].first_bucket = column->levels[l].bucket = first_sample / builder->bucket_samples[l];
+            DM35425_Adc_Stats_Init(&column->levels[l].stats);
+        }
+        column->started = true;
+    }
+    else if (first_sample < column->next)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    column->next = first_sample + count;
+
+    struct DM35425_Overview_Series *series = &column->levels[0];
+    uint64_t bucket_samples = builder->bucket_samples[0];
+    while (count > 0)
+    {
+        uint64_t bucket = first_sample / bucket_samples;
+        while (series->bucket < bucket) // earlier buckets are complete, or were not recorded
+        {
+            if (DM35425_Overview_Close_Bucket(builder, column, 0) != 0)
+            {
+                builder->error = errno;
+                return -1;
+            }
+        }
+        uint64_t room = (bucket + 1) * bucket_samples - first_sample;
+        size_t n = room < count ? (size_t)room : count;
+        DM35425_Adc_Samples_Stats(samples, n, &series->stats);
+        samples += n;
+        first_sample += n;
+        count -= n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Close the partly filled last bucket of every level.
+ *
+ * @param builder Builder.
+ * @return int 0 on success, -1 with errno ENOMEM.
+ */
+static int DM35425_Overview_Finish(DM35425_Overview_Builder *builder)
+{
+    if (builder->finished)
+        return 0;
+    for (int c = 0; c < builder->board_column[builder->num_boards]; c++)
+    {
+        struct DM35425_Overview_Column *column = &builder->columns[c];
+        if (!column->started)
+            continue;
+        // Bottom up, so each level holds what the one below merged into it
+        for (int l = 0; l < builder->num_levels; l++)
+        {
+            if (column->levels[l].stats.count > 0 && DM35425_Overview_Close_Bucket(builder, column, l) != 0)
+                return -1;
+        }
+    }
+    builder->finished = true;
+    return 0;
+}
+
+int DM35425_Overview_Builder_Write(DM35425_Overview_Builder *builder, const char *path)
+{
+    if (builder == NULL || path == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (builder->error != 0)
+    {
+        errno = builder->error;
+        return -1;
+    }
+    if (DM35425_Overview_Finish(builder) != 0)
+        return -1;
+
+    // Levels with a single bucket add nothing to the one below
+    int num_columns = builder->board_column[builder->num_boards];
+    int num_levels = 1;
+    for (int c = 0; c < num_columns; c++)
+    {
+        for (int l = num_levels; l < builder->num_levels; l++)
+        {
+            if (builder->columns[c].levels[l - 1].count > 1)
+                num_levels = l + 1;
+        }
+    }
+
+    struct DM35425_Overview_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DM35425_OVERVIEW_MAGIC, sizeof(header.magic));
+    header.version = DM35425_OVERVIEW_VERSION;
+    header.factor = builder->factor;
+    header.num_columns = num_columns;
+    header.num_levels = num_levels;
+
+    size_t table_size = (size_t)num_columns * num_levels * sizeof(struct DM35425_Overview_Level);
+    struct DM35425_Overview_Level *table = (struct DM35425_Overview_Level *)malloc(table_size + 1);
+    if (table == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    uint64_t offset = sizeof(header) + table_size;
+    for (int c = 0; c < num_columns; c++)
+    {
+        for (int l = 0; l < num_levels; l++)
+        {
+            const struct DM35425_Overview_Series *series = &builder->columns[c].levels[l];
+            table[c * num_levels + l] = (struct DM35425_Overview_Level){builder->bucket_samples[l], series->first_bucket, series->count, offset};
+            offset += series->count * sizeof(struct DM35425_Overview_Bucket);
+        }
+    }
+
+    // Write under a temporary name, so a reader never finds a partly written overview
+    size_t length = strlen(path) + 8;
+    char *temp = (char *)malloc(length);
+    if (temp == NULL)
+    {
+        free(table);
+        errno = ENOMEM;
+        return -1;
+    }
+    snprintf(temp, length, "%s.tmp", path);
+    FILE *fp = fopen(temp, "wb");
+    if (fp == NULL)
+        goto failed;
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 && (table_size == 0 || fwrite(table, table_size, 1, fp) == 1);
+    for (int c = 0; c < num_columns && written; c++)
+    {
+        for (int l = 0; l < num_levels && written; l++)
+        {
+            const struct DM35425_Overview_Series *series = &builder->columns[c].levels[l];
+            if (series->count > 0 && fwrite(series->buckets, series->count * sizeof(struct DM35425_Overview_Bucket), 1, fp) != 1)
+                written = false;
+        }
+    }
+    if (fclose(fp) != 0 || !written || rename(temp, path) != 0)
+    {
+        int error = errno;
+        unlink(temp);
+        errno = error;
+        goto failed;
+    }
+    free(temp);
+    free(table);
+    return 0;
+
+failed:
+{
+    int error = errno;
+    free(temp);
+    free(table);
+    errno = error;
+    return -1;
+}
+}
+
+void DM35425_Overview_Builder_Free(DM35425_Overview_Builder *builder)
+{
+    if (builder == NULL)
+        return;
+    for (int c = 0; c < builder->board_column[builder->num_boards]; c++)
+    {
+        for (int l = 0; l < builder->num_levels; l++)
+            free(builder->columns[c].levels[l].buckets);
+    }
+    free(builder->columns);
+    free(builder->board_column);
+    free(builder);
+}
+
+char *DM35425_Overview_Path(const char *recording)
+{
+    size_t length = strlen(recording);
+    char *path = (char *)malloc(length + 5);
+
+    if (path == NULL)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy(path, recording, length + 1);
+    if (length >= 4 && strcmp(recording + length - 4, ".dat") == 0)
+        length -= 4;
+    memcpy(path + length, ".ovw", 5);
+    return path;
+}
+
+int DM35425_Overview_Build(const char *recording, unsigned factor)
+{
+    DM35425_Recording *rec;
+    DM35425_Overview_Builder *builder = NULL;
+    uint8_t *chunk = NULL;
+    char *path = NULL;
+    int32_t codes[1024];
+    int rc = -1;
+
+    if (recording == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (DM35425_Recording_Open(&rec, recording) != 0)
+        return -1;
+    const struct DM35425_Recording_Header *header = DM35425_Recording_Get_Header(rec);
+    const struct DM35425_Recording_Board *layout = DM35425_Recording_Get_Board(rec, 0);
+    size_t num_chunks;
+    DM35425_Recording_Get_Index(rec, &num_chunks);
+
+    path = DM35425_Overview_Path(recording);
+    chunk = (uint8_t *)malloc(header->chunk_size);
+    if (path == NULL || chunk == NULL)
+    {
+        errno = ENOMEM;
+        goto done;
+    }
+    if (DM35425_Overview_Builder_Create(&builder, factor, header->num_boards, layout) != 0)
+        goto done;
+    for (size_t i = 0; i < num_chunks; i++)
+    {
+        if (DM35425_Recording_Read_Chunk(rec, i, chunk) != 0)
+        {
+            if (errno == EBADMSG) // a corrupt chunk is left out, like a dropped frame
+                continue;
+            goto done;
+        }
+        const uint8_t *p = chunk + sizeof(struct DM35425_Recording_Chunk);
+        for (uint32_t b = 0; b < header->num_boards; b++)
+        {
+            const struct DM35425_Recording_Readout *readout = (const struct DM35425_Recording_Readout *)p;
+            const int16_t *samples = (const int16_t *)(readout + 1);
+            size_t frame_samples = layout[b].frame_samples;
+
+            for (uint32_t c = 0; c < layout[b].num_channels; c++, samples += frame_samples)
+            {
+                // Widen a block at a time, the builder takes int32_t codes like the readouts
+                for (size_t k = 0; k < frame_samples; k += 1024)
+                {
+                    size_t n = frame_samples - k < 1024 ? frame_samples - k : 1024;
+                    for (size_t s = 0; s < n; s++)
+                        codes[s] = samples[k + s];
+                    if (DM35425_Overview_Builder_Add(builder, b, c, readout->first_sample + k, codes, n) != 0)
+                        goto done;
+                }
+            }
+            p += sizeof(*readout) + (((size_t)layout[b].num_channels * frame_samples * sizeof(int16_t) + 7) & ~(size_t)7);
+        }
+    }
+    rc = DM35425_Overview_Builder_Write(builder, path);
+
+done:
+{
+    int error = errno;
+    DM35425_Overview_Builder_Free(builder);
+    DM35425_Recording_Close(rec);
+    free(chunk);
+    free(path);
+    errno = error;
+    return rc;
+}
+}
+
+int DM35425_Overview_Open(DM35425_Overview **_ovw, const char *recording)
+{
+    if (_ovw == NULL || recording == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Overview *ovw = (DM35425_Overview *)calloc(1, sizeof(DM35425_Overview));
+    char *path = DM35425_Overview_Path(recording);
+    int fd = -1;
+
+    if (ovw == NULL || path == NULL)
+    {
+        free(ovw);
+        free(path);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (DM35425_Recording_Map_Open(&ovw->map, recording) != 0)
+        goto errored;
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        goto errored;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        goto errored;
+    if ((uint64_t)st.st_size < sizeof(struct DM35425_Overview_Header) || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        errno = EBADMSG;
+        goto errored;
+    }
+    ovw->length = (size_t)st.st_size;
+    void *base = mmap(NULL, ovw->length, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+        goto errored;
+    ovw->base = (const uint8_t *)base;
+    close(fd);
+    fd = -1;
+
+    DM35425_Recording *rec = DM35425_Recording_Map_Get_Recording(ovw->map);
+    uint32_t num_boards = DM35425_Recording_Get_Header(rec)->num_boards;
+    ovw->board_column = (int *)malloc((num_boards + 1) * sizeof(int));
+    if (ovw->board_column == NULL)
+    {
+        errno = ENOMEM;
+        goto errored;
+    }
+    ovw->board_column[0] = 0;
+    for (uint32_t b = 0; b < num_boards; b++)
+        ovw->board_column[b + 1] = ovw->board_column[b] + DM35425_Recording_Get_Board(rec, b)->num_channels;
+
+    const struct DM35425_Overview_Header *header = (const struct DM35425_Overview_Header *)ovw->base;
+    if (memcmp(header->magic, DM35425_OVERVIEW_MAGIC, sizeof(header->magic)) != 0 || header->version != DM35425_OVERVIEW_VERSION ||
+        header->factor < 2 || header->num_columns != (uint32_t)ovw->board_column[num_boards] || header->num_levels < 1 ||
+        header->num_levels > DM35425_OVERVIEW_MAX_LEVELS ||
+        (ovw->length - sizeof(*header)) / sizeof(struct DM35425_Overview_Level) < (uint64_t)header->num_columns * header->num_levels)
+    {
+        errno = EBADMSG;
+        goto errored;
+    }
+    ovw->header = header;
+    ovw->levels = (const struct DM35425_Overview_Level *)(header + 1);
+    for (size_t i = 0; i < (size_t)header->num_columns * header->num_levels; i++)
+    {
+        const struct DM35425_Overview_Level *level = &ovw->levels[i];
+        if (level->bucket_samples == 0 || level->offset % sizeof(uint32_t) != 0 || level->offset > ovw->length ||
+            level->num_buckets > (ovw->length - level->offset) / sizeof(struct DM35425_Overview_Bucket))
+        {
+            errno = EBADMSG;
+            goto errored;
+        }
+    }
+    free(path);
+    *_ovw = ovw;
+    return 0;
+
+errored:
+{
+    int error = errno;
+    if (fd >= 0)
+        close(fd);
+    free(path);
+    DM35425_Overview_Close(ovw);
+    errno = error;
+    return -1;
+}
+}
+
+void DM35425_Overview_Close(DM35425_Overview *ovw)
+{
+    if (ovw == NULL)
+        return;
+    if (ovw->base != NULL)
+        munmap((void *)ovw->base, ovw->length);
+    DM35425_Recording_Map_Close(ovw->map);
+    free(ovw->board_column);
+    free(ovw);
+}
+
+DM35425_Recording_Map *DM35425_Overview_Get_Map(DM35425_Overview *ovw)
+{
+    return ovw->map;
+}
+
+/**
+ * @brief Find where the board's samples resume after the chunk holding or preceding a position, to step over dropped
+ * frames and corrupt chunks. Board positions are scaled to board 0 as in {@link DM35425_Recording_Read}.
+ *
+ * @param rec Recording.
+ * @param board Board index.
+ * @param sample Position on the board.
+ * @return uint64_t Position of the board's first sample in the next chunk, UINT64_MAX if there is none.
+ */
+static uint64_t DM35425_Overview_Next_Chunk(DM35425_Recording *rec, int board, uint64_t sample)
+{
+    uint64_t from = DM35425_Recording_Get_Board(rec, board)->frame_samples, to = DM35425_Recording_Get_Board(rec, 0)->frame_samples;
+    size_t num_chunks;
+    const struct DM35425_Recording_Index_Entry *index = DM35425_Recording_Get_Index(rec, &num_chunks);
+    ssize_t chunk = DM35425_Recording_Find_Sample(rec, sample / from * to + (sample % from) * to / from);
+    size_t next = chunk < 0 ? 0 : (size_t)chunk + 1;
+
+    if (next >= num_chunks)
+        return UINT64_MAX;
+    return index[next].first_sample / to * from + (index[next].first_sample % to) * from / to;
+}
+
+ssize_t DM35425_Overview_Envelope(DM35425_Overview *ovw, int board, int channel, uint64_t first_sample, uint64_t count, size_t num_points, struct DM35425_Overview_Point *points)
+{
+    if (ovw == NULL || points == NULL || board < 0 || (uint32_t)board >= DM35425_Recording_Get_Header(DM35425_Recording_Map_Get_Recording(ovw->map))->num_boards ||
+        channel < 0 || channel >= ovw->board_column[board + 1] - ovw->board_column[board])
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (num_points > count)
+        num_points = (size_t)count;
+    if (num_points == 0)
+        return 0;
+
+    DM35425_Recording *rec = DM35425_Recording_Map_Get_Recording(ovw->map);
+    uint32_t num_levels = ovw->header->num_levels;
+    const struct DM35425_Overview_Level *levels = &ovw->levels[(size_t)(ovw->board_column[board] + channel) * num_levels];
+    uint64_t width = count / num_points, remainder = count % num_points;
+    int level = -1;
+    for (uint32_t l = 0; l < num_levels; l++)
+    {
+        if (levels[l].bucket_samples <= width)
+            level = l;
+    }
+
+    for (size_t j = 0; j < num_points; j++)
+    {
+        struct DM35425_Overview_Point *point = &points[j];
+        uint64_t lo = first_sample + j * width + j * remainder / num_points;
+        uint64_t hi = first_sample + (j + 1) * width + (j + 1) * remainder / num_points;
+        int min = INT16_MAX, max = INT16_MIN;
+        double sum = 0;
+        uint64_t n = 0;
+
+        if (level >= 0)
+        {
+            // Every bucket that overlaps the point
+            const struct DM35425_Overview_Level *series = &levels[level];
+            const struct DM35425_Overview_Bucket *buckets = (const struct DM35425_Overview_Bucket *)(ovw->base + series->offset);
+            uint64_t b = lo / series->bucket_samples, last = (hi - 1) / series->bucket_samples;
+            if (b < series->first_bucket)
+                b = series->first_bucket;
+            if (last >= series->first_bucket + series->num_buckets)
+                last = series->first_bucket + series->num_buckets - 1;
+            for (; b <= last && series->num_buckets > 0; b++)
+            {
+                const struct DM35425_Overview_Bucket *bucket = &buckets[b - series->first_bucket];
+                if (bucket->min > bucket->max)
+                    continue;
+                min = bucket->min < min ? bucket->min : min;
+                max = bucket->max > max ? bucket->max : max;
+                sum += bucket->mean;
+                n++;
+            }
+            point->bucket_samples = series->bucket_samples;
+        }
+        else
+        {
+            // Shorter than a bucket: from the samples, stepping over what was not recorded
+            for (uint64_t position = lo; position < hi;)
+            {
+                struct DM35425_Recording_View view;
+                if (DM35425_Recording_Map_View(ovw->map, board, channel, position, false, &view) != 0)
+                {
+                    uint64_t next = DM35425_Overview_Next_Chunk(rec, board, position);
+                    if (next <= position)
+                        break;
+                    position = next;
+                    continue;
+                }
+                size_t k = view.count < hi - position ? view.count : (size_t)(hi - position);
+                for (size_t s = 0; s < k; s++)
+                {
+                    min = view.raw[s] < min ? view.raw[s] : min;
+                    max = view.raw[s] > max ? view.raw[s] : max;
+                    sum += view.raw[s];
+                }
+                n += k;
+                position += k;
+            }
+            point->bucket_samples = 1;
+        }
+        point->first_sample = lo;
+        point->min = (int16_t)min;
+        point->max = (int16_t)max;
+        point->mean = n > 0 ? (float)(sum / n) : 0;
+    }
+    return (ssize_t)num_points;
+}
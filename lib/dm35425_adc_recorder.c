@@ -0,0 +1,1185 @@
+/**
+ * @file dm35425_adc_recorder.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the binary recorder for the multiboard ADC stream.
+ * @version 1.0
+ * @date 2023-06-01
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#define _GNU_SOURCE          // O_DIRECT, fallocate
+#define _FILE_OFFSET_BITS 64 // files larger than 2 GiB on 32-bit hosts
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dm35425_adc_recorder.h"
+#include "dm35425_adc_overview.h"
+#include "dm35425_adc_codec.h"
+#include "dm35425_util_library.h"
+
+#define DM35425_RECORDER_ALIGN 4096                             /*!< Alignment of O_DIRECT buffers, file offsets and lengths */
+#define DM35425_RECORDER_BLOCK_SIZE ((size_t)4 << 20)           /*!< Default block size */
+#define DM35425_RECORDER_NUM_BLOCKS 16                          /*!< Default number of blocks */
+#define DM35425_RECORDER_NUM_FRAMES 8                           /*!< Default number of frames queued for the encoder */
+#define DM35425_RECORDER_ROUND(size) (((size) + 7) & ~(size_t)7) /*!< Round a sample block up to keep the next header aligned */
+
+/**
+ * @brief A block of the recording, filled by the producer and written in one go by the writer thread.
+ *
+ */
+struct DM35425_Recorder_Block
+{
+    uint8_t *data;       // block_size bytes, aligned for O_DIRECT
+    size_t used;         // bytes filled; only the last block of a file is written partly filled
+    bool starts_file;    // finish the open file and open file `file_index` before writing
+    uint32_t file_index; // file the block starts
+    DM35425_Overview_Builder *overview; // overview of the file the block finishes, NULL if none
+};
+
+/**
+ * @brief Compression statistics of one channel.
+ *
+ */
+struct DM35425_Recorder_Column
+{
+    uint64_t samples;       // samples encoded
+    uint64_t encoded_bytes; // bytes they were encoded to
+    uint64_t encode_ns;     // time spent encoding them
+};
+
+struct _DM35425_Recorder
+{
+    char *path;                             // file name prefix
+    size_t block_size;                      // bytes per block
+    int num_blocks;                         // number of blocks
+    uint64_t rotate_bytes;                  // file size limit, 0 for none
+    uint64_t rotate_ns;                     // file duration limit, 0 for none
+    uint64_t preallocate;                   // bytes reserved per file, 0 for none
+    bool buffered;                          // do not use O_DIRECT
+    bool overview;                          // build overviews
+    unsigned overview_factor;               // factor between overview levels
+    bool compress;                          // compress on the encoder thread
+    int compress_frames;                    // frames queued for the encoder
+    struct DM35425_Recorder_Block *blocks;  // blocks[num_blocks]
+    // producer (the encoder thread when compressing), set up on the first frame
+    int num_boards;                         // number of boards, 0 before the first frame
+    struct DM35425_Recording_Board *layout; // layout[num_boards]
+    size_t header_size;                     // bytes of the file header and layout
+    size_t chunk_size;                      // bytes of every chunk, uncompressed
+    size_t max_chunk;                       // most bytes a chunk takes in the file
+    bool in_file;                           // a file has been started
+    uint32_t file_index;                    // index of the current file
+    uint64_t file_bytes;                    // bytes of the current file so far
+    uint64_t file_start_ns;                 // timestamp of the first chunk of the current file
+    uint32_t crc;                           // CRC-32C of the chunk being put
+    DM35425_Overview_Builder *builder;      // overview of the current file, NULL if none or it failed
+    DM35425_Overview_Builder *last_overview; // overview of the last file, written when the writer thread stops
+    struct DM35425_Recording_Index_Entry *index; // index of the current file
+    size_t index_count;                     // chunks in the current file
+    size_t index_capacity;                  // entries allocated
+    size_t index_limit;                     // most chunks in a file, so its index fits in half the blocks
+    uint64_t sequence;                      // frames offered, counting dropped ones
+    uint64_t frames;                        // frames recorded
+    uint64_t frames_dropped;                // frames dropped
+    int max_backlog;                        // most blocks ever published and not yet written
+    // block queue, single producer and single consumer (the writer thread)
+    uint64_t head;                          // blocks published
+    uint64_t tail;                          // blocks written
+    int waiting;                            // the writer is asleep
+    bool stop;                              // Close was called; exit once the queue is empty
+    int error;                              // errno of the first failed file operation, 0 if none
+    int overview_error;                     // errno of the first failed overview, 0 if none
+    pthread_mutex_t lock;                   // protects a sleeping writer
+    pthread_cond_t cond;                    // signalled on publish and on stop
+    pthread_t writer;                       // writer thread
+    // frame queue to the encoder thread, single producer and single consumer
+    uint8_t *frames_queued;                 // frames_queued[compress_frames][chunk_size], frames as uncompressed chunks
+    uint8_t *coded;                         // chunk being encoded, max_chunk bytes
+    struct DM35425_Recorder_Column *coding; // statistics of the frame being encoded, per channel
+    uint64_t frame_head;                    // frames queued
+    uint64_t frame_tail;                    // frames encoded
+    int frame_waiting;                      // the encoder is asleep
+    bool frame_stop;                        // Close was called; exit once the queue is empty
+    pthread_mutex_t frame_lock;             // protects a sleeping encoder
+    pthread_cond_t frame_cond;              // signalled on queue and on stop
+    pthread_t encoder;                      // encoder thread
+    // written by the writer and encoder threads, read by Get_Stats
+    pthread_mutex_t stats_lock;             // protects the fields below
+    struct DM35425_Histogram write;         // block write durations
+    uint64_t bytes_written;                 // bytes of recording written
+    uint64_t files;                         // files opened
+    uint64_t first_write_ns;                // start of the first write
+    uint64_t last_write_ns;                 // end of the last write
+    int *board_column;                      // board_column[num_boards], column of each board's first channel
+    struct DM35425_Recorder_Column *columns; // columns[all channels], published once set up
+};
+
+/**
+ * @brief Open a recording file and reserve its space.
+ *
+ * @param rec Recorder.
+ * @param index File index.
+ * @param fd Returned file descriptor.
+ * @return int 0 on success, or the errno value of the failure.
+ */
+static int DM35425_Recorder_Open(DM35425_Recorder *rec, uint32_t index, int *fd)
+{
+    size_t length = strlen(rec->path) + 16;
+    char *name = (char *)malloc(length);
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int f = -1;
+
+    if (name == NULL)
+        return ENOMEM;
+    snprintf(name, length, "%s_%06u.dat", rec->path, index);
+    if (!rec->buffered)
+        f = open(name, flags | O_DIRECT, 0644);
+    if (f < 0 && (rec->buffered || errno == EINVAL)) // tmpfs and some network file systems refuse O_DIRECT
+        f = open(name, flags, 0644);
+    free(name);
+    if (f < 0)
+        return errno;
+    if (rec->preallocate > 0 && fallocate(f, 0, 0, (off_t)rec->preallocate) != 0 && errno != EOPNOTSUPP && errno != ENOSYS)
+    {
+        int error = errno;
+        close(f);
+        return error;
+    }
+    *fd = f;
+    return 0;
+}
+
+/**
+ * @brief Cut a recording file to the length of its contents, dropping the padding of the last write and the unused
+ * preallocated space, and close it.
+ *
+ * @param fd File descriptor.
+ * @param length Bytes of recording in the file.
+ * @return int 0 on success, or the errno value of the failure.
+ */
+static int DM35425_Recorder_Finish(int fd, uint64_t length)
+{
+    int error = 0;
+
+    if (ftruncate(fd, (off_t)length) != 0)
+        error = errno;
+    if (close(fd) != 0 && error == 0)
+        error = errno;
+    return error;
+}
+
+/**
+ * @brief Note the first overview that failed. Overviews are a convenience, so the recording goes on without them.
+ *
+ * @param rec Recorder.
+ * @param error errno value of the failure.
+ */
+static void DM35425_Recorder_Overview_Failed(DM35425_Recorder *rec, int error)
+{
+    int none = 0;
+    __atomic_compare_exchange_n(&rec->overview_error, &none, error, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Write the overview of a finished file next to it.
+ *
+ * @param rec Recorder.
+ * @param builder Overview of the file.
+ * @param index File index.
+ */
+static void DM35425_Recorder_Write_Overview(DM35425_Recorder *rec, DM35425_Overview_Builder *builder, uint32_t index)
+{
+    size_t length = strlen(rec->path) + 16;
+    char *name = (char *)malloc(length);
+
+    if (name == NULL)
+    {
+        DM35425_Recorder_Overview_Failed(rec, ENOMEM);
+        return;
+    }
+    snprintf(name, length, "%s_%06u.ovw", rec->path, index);
+    if (DM35425_Overview_Builder_Write(builder, name) != 0)
+        DM35425_Recorder_Overview_Failed(rec, errno);
+    free(name);
+}
+
+/**
+ * @brief Write one block, opening and finishing files as it says.
+ *
+ * @param rec Recorder.
+ * @param block Block.
+ * @param fd Descriptor of the open file, -1 if none.
+ * @param offset Bytes of recording in the open file.
+ * @param file Index of the open file.
+ * @return int 0 on success, or the errno value of the failure.
+ */
+static int DM35425_Recorder_Write_Block(DM35425_Recorder *rec, struct DM35425_Recorder_Block *block, int *fd, uint64_t *offset, uint32_t *file)
+{
+    if (block->starts_file)
+    {
+        if (*fd >= 0)
+        {
+            int error = DM35425_Recorder_Finish(*fd, *offset);
+            *fd = -1;
+            if (error != 0)
+                return error;
+            // Only next to a complete file
+            if (block->overview != NULL)
+                DM35425_Recorder_Write_Overview(rec, block->overview, *file);
+        }
+        *file = block->file_index;
+        int error = DM35425_Recorder_Open(rec, block->file_index, fd);
+        if (error != 0)
+            return error;
+        *offset = 0;
+        pthread_mutex_lock(&rec->stats_lock);
+        rec->files++;
+        pthread_mutex_unlock(&rec->stats_lock);
+    }
+    if (block->used == 0)
+        return 0;
+
+    // O_DIRECT needs whole pages; the padding is cut off when the file is finished
+    size_t length = (block->used + DM35425_RECORDER_ALIGN - 1) & ~(size_t)(DM35425_RECORDER_ALIGN - 1);
+    memset(block->data + block->used, 0, length - block->used);
+
+    uint64_t start = DM35425_Get_Monotonic_Ns();
+    for (size_t done = 0; done < length;)
+    {
+        ssize_t n = pwrite(*fd, block->data + done, length - done, (off_t)(*offset + done));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        done += (size_t)n;
+    }
+    uint64_t end = DM35425_Get_Monotonic_Ns();
+    *offset += block->used;
+
+    pthread_mutex_lock(&rec->stats_lock);
+    DM35425_Histogram_Record(&rec->write, end - start);
+    rec->bytes_written += block->used;
+    if (rec->first_write_ns == 0)
+        rec->first_write_ns = start;
+    rec->last_write_ns = end;
+    pthread_mutex_unlock(&rec->stats_lock);
+    return 0;
+}
+
+/**
+ * @brief Writer thread: write published blocks in order until Close, then finish the last file. After a failure the
+ * blocks are released without being written.
+ *
+ * @param arg Recorder.
+ * @return void* NULL.
+ */
+static void *DM35425_Recorder_Writer(void *arg)
+{
+    DM35425_Recorder *rec = arg;
+    uint64_t tail = rec->tail;
+    uint64_t offset = 0;
+    uint32_t file = 0;
+    int fd = -1;
+
+    for (;;)
+    {
+        if (__atomic_load_n(&rec->head, __ATOMIC_ACQUIRE) == tail)
+        {
+            bool stop;
+            pthread_mutex_lock(&rec->lock);
+            // Announce the wait before checking head again; Publish stores head before checking waiting
+            __atomic_store_n(&rec->waiting, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&rec->head, __ATOMIC_SEQ_CST) == tail && !rec->stop)
+                pthread_cond_wait(&rec->cond, &rec->lock);
+            __atomic_store_n(&rec->waiting, 0, __ATOMIC_RELAXED);
+            stop = rec->stop;
+            pthread_mutex_unlock(&rec->lock);
+            if (__atomic_load_n(&rec->head, __ATOMIC_ACQUIRE) == tail)
+            {
+                if (stop)
+                    break;
+                continue;
+            }
+        }
+
+        struct DM35425_Recorder_Block *block = &rec->blocks[tail % rec->num_blocks];
+        if (__atomic_load_n(&rec->error, __ATOMIC_RELAXED) == 0)
+        {
+            int error = DM35425_Recorder_Write_Block(rec, block, &fd, &offset, &file);
+            if (error != 0)
+                __atomic_store_n(&rec->error, error, __ATOMIC_RELEASE);
+        }
+        // Hand the block back empty, so the producer can fill it without looking at the writer's state
+        block->used = 0;
+        block->starts_file = false;
+        DM35425_Overview_Builder_Free(block->overview);
+        block->overview = NULL;
+        __atomic_store_n(&rec->tail, ++tail, __ATOMIC_RELEASE);
+    }
+
+    if (fd >= 0 && __atomic_load_n(&rec->error, __ATOMIC_RELAXED) != 0)
+        close(fd);
+    else if (fd >= 0)
+    {
+        int error = DM35425_Recorder_Finish(fd, offset);
+        if (error != 0)
+            __atomic_store_n(&rec->error, error, __ATOMIC_RELEASE);
+        else if (rec->last_overview != NULL) // set by Close before it stopped the writer
+            DM35425_Recorder_Write_Overview(rec, rec->last_overview, file);
+    }
+    return NULL;
+}
+
+static void *DM35425_Recorder_Encoder(void *arg);
+
+int DM35425_Recorder_Create(DM35425_Recorder **_rec, const struct DM35425_Recorder_Config *config)
+{
+    if (_rec == NULL || config == NULL || config->path == NULL || config->path[0] == '\0' ||
+        config->block_size % DM35425_RECORDER_ALIGN != 0 || (config->num_blocks != 0 && config->num_blocks < 4) ||
+        config->overview_factor == 1 || (config->compress && config->compress_frames != 0 && config->compress_frames < 2))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Recorder *rec = (DM35425_Recorder *)calloc(1, sizeof(DM35425_Recorder));
+    if (rec == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    rec->block_size = config->block_size != 0 ? config->block_size : DM35425_RECORDER_BLOCK_SIZE;
+    rec->num_blocks = config->num_blocks != 0 ? config->num_blocks : DM35425_RECORDER_NUM_BLOCKS;
+    rec->rotate_bytes = config->rotate_bytes;
+    rec->rotate_ns = config->rotate_ns;
+    rec->preallocate = config->preallocate_bytes != 0 ? config->preallocate_bytes : config->rotate_bytes;
+    rec->buffered = config->buffered;
+    rec->overview = config->overview;
+    rec->overview_factor = config->overview_factor;
+    rec->compress = config->compress;
+    rec->compress_frames = config->compress_frames != 0 ? config->compress_frames : DM35425_RECORDER_NUM_FRAMES;
+    rec->path = strdup(config->path);
+    rec->blocks = (struct DM35425_Recorder_Block *)calloc(rec->num_blocks, sizeof(struct DM35425_Recorder_Block));
+    if (rec->path == NULL || rec->blocks == NULL)
+        goto nomem;
+    for (int i = 0; i < rec->num_blocks; i++)
+    {
+        if (posix_memalign((void **)&rec->blocks[i].data, DM35425_RECORDER_ALIGN, rec->block_size) != 0)
+            goto nomem;
+    }
+    DM35425_Histogram_Reset(&rec->write);
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_cond_init(&rec->cond, NULL);
+    pthread_mutex_init(&rec->stats_lock, NULL);
+    pthread_mutex_init(&rec->frame_lock, NULL);
+    pthread_cond_init(&rec->frame_cond, NULL);
+
+    int rc = pthread_create(&rec->writer, NULL, DM35425_Recorder_Writer, rec);
+    if (rc == 0 && rec->compress && (rc = pthread_create(&rec->encoder, NULL, DM35425_Recorder_Encoder, rec)) != 0)
+    {
+        pthread_mutex_lock(&rec->lock);
+        rec->stop = true;
+        pthread_cond_signal(&rec->cond);
+        pthread_mutex_unlock(&rec->lock);
+        pthread_join(rec->writer, NULL);
+    }
+    if (rc != 0)
+    {
+        pthread_mutex_destroy(&rec->frame_lock);
+        pthread_cond_destroy(&rec->frame_cond);
+        pthread_mutex_destroy(&rec->lock);
+        pthread_cond_destroy(&rec->cond);
+        pthread_mutex_destroy(&rec->stats_lock);
+        for (int i = 0; i < rec->num_blocks; i++)
+            free(rec->blocks[i].data);
+        free(rec->blocks);
+        free(rec->path);
+        free(rec);
+        errno = rc;
+        return -1;
+    }
+    *_rec = rec;
+    return 0;
+
+nomem:
+    if (rec->blocks != NULL)
+    {
+        for (int i = 0; i < rec->num_blocks; i++)
+            free(rec->blocks[i].data);
+    }
+    free(rec->blocks);
+    free(rec->path);
+    free(rec);
+    errno = ENOMEM;
+    return -1;
+}
+
+/**
+ * @brief Take the layout of the recording from the first frame.
+ *
+ * @param rec Recorder.
+ * @param num_boards Number of boards.
+ * @param readouts The first frame.
+ * @return int 0 on success, -1 with errno EINVAL or ENOMEM.
+ */
+static int DM35425_Recorder_Setup(DM35425_Recorder *rec, int num_boards, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    struct DM35425_Recording_Board *layout = (struct DM35425_Recording_Board *)calloc(num_boards, sizeof(struct DM35425_Recording_Board));
+    size_t chunk_size = sizeof(struct DM35425_Recording_Chunk) + sizeof(struct DM35425_Recording_Chunk_End);
+    size_t max_chunk = chunk_size;
+    int num_columns = 0;
+
+    if (layout == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (int b = 0; b < num_boards; b++)
+    {
+        const struct DM35425_ADCDMA_Readout *readout = &readouts[b];
+        if (readout->num_channels < 0 || readout->num_channels > DM35425_NUM_ADC_DMA_CHANNELS)
+            goto invalid;
+        layout[b].num_channels = readout->num_channels;
+        layout[b].frame_samples = readout->num_samples * readout->decimation;
+        layout[b].sample_rate = readout->sample_rate;
+        for (int c = 0; c < readout->num_channels; c++)
+        {
+            layout[b].channels[c] = readout->channels[c];
+            layout[b].ranges[c] = readout->ranges[c];
+        }
+        chunk_size += sizeof(struct DM35425_Recording_Readout) +
+                      DM35425_RECORDER_ROUND((size_t)layout[b].num_channels * layout[b].frame_samples * sizeof(int16_t));
+        // Noise can code to a little more than it takes raw
+        max_chunk += sizeof(struct DM35425_Recording_Readout) +
+                     DM35425_RECORDER_ROUND(layout[b].num_channels * DM35425_Codec_Bound(layout[b].frame_samples));
+        num_columns += layout[b].num_channels;
+    }
+    if (!rec->compress)
+        max_chunk = chunk_size;
+    rec->header_size = sizeof(struct DM35425_Recording_Header) + num_boards * sizeof(struct DM35425_Recording_Board);
+
+    // Ending a file takes the rest of the block being filled, the index and the trailer, and the next file its header
+    // and first chunk. Half the blocks left after one chunk go to the index, so a file can always end once the writer
+    // has caught up.
+    size_t chunk_blocks = (rec->header_size + max_chunk + rec->block_size - 1) / rec->block_size;
+    size_t index_blocks = chunk_blocks < (size_t)rec->num_blocks ? (rec->num_blocks - chunk_blocks - 1) / 2 : 0;
+    if (max_chunk > UINT32_MAX || chunk_size > UINT32_MAX || index_blocks == 0)
+        goto invalid;
+    rec->index_limit = (index_blocks * rec->block_size - sizeof(struct DM35425_Recording_Trailer)) / sizeof(struct DM35425_Recording_Index_Entry);
+    rec->index_capacity = rec->rotate_bytes != 0 ? rec->rotate_bytes / chunk_size + 1 : 1024;
+    if (rec->index_capacity > rec->index_limit)
+        rec->index_capacity = rec->index_limit;
+    rec->index = (struct DM35425_Recording_Index_Entry *)malloc(rec->index_capacity * sizeof(struct DM35425_Recording_Index_Entry));
+    if (rec->index == NULL)
+    {
+        free(layout);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (rec->compress)
+    {
+        struct DM35425_Recorder_Column *columns = (struct DM35425_Recorder_Column *)calloc(num_columns + 1, sizeof(struct DM35425_Recorder_Column));
+        rec->board_column = (int *)malloc(num_boards * sizeof(int));
+        rec->coding = (struct DM35425_Recorder_Column *)calloc(num_columns + 1, sizeof(struct DM35425_Recorder_Column));
+        rec->frames_queued = (uint8_t *)malloc(rec->compress_frames * chunk_size);
+        rec->coded = (uint8_t *)malloc(max_chunk);
+        if (columns == NULL || rec->board_column == NULL || rec->coding == NULL || rec->frames_queued == NULL || rec->coded == NULL)
+        {
+            free(columns);
+            free(rec->board_column);
+            free(rec->coding);
+            free(rec->frames_queued);
+            free(rec->coded);
+            rec->board_column = NULL;
+            rec->coding = NULL;
+            rec->frames_queued = NULL;
+            rec->coded = NULL;
+            free(rec->index);
+            rec->index = NULL;
+            free(layout);
+            errno = ENOMEM;
+            return -1;
+        }
+        for (int b = 0, column = 0; b < num_boards; column += layout[b].num_channels, b++)
+            rec->board_column[b] = column;
+        rec->columns = columns;
+    }
+    rec->chunk_size = chunk_size;
+    rec->max_chunk = max_chunk;
+    rec->layout = layout;
+    // Get_Channel_Stats looks at the layout once the statistics are there
+    __atomic_store_n(&rec->num_boards, num_boards, __ATOMIC_RELEASE);
+    return 0;
+
+invalid:
+    free(layout);
+    errno = EINVAL;
+    return -1;
+}
+
+/**
+ * @brief Hand the block being filled to the writer thread.
+ *
+ * @param rec Recorder.
+ */
+static void DM35425_Recorder_Publish(DM35425_Recorder *rec)
+{
+    uint64_t head = rec->head + 1;
+    int backlog = (int)(head - __atomic_load_n(&rec->tail, __ATOMIC_ACQUIRE));
+
+    if (backlog > rec->max_backlog)
+        __atomic_store_n(&rec->max_backlog, backlog, __ATOMIC_RELAXED);
+    // Publishing head and checking for a sleeping writer must not be reordered, see the writer thread
+    __atomic_store_n(&rec->head, head, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&rec->waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&rec->lock);
+        pthread_cond_signal(&rec->cond);
+        pthread_mutex_unlock(&rec->lock);
+    }
+}
+
+/**
+ * @brief Append bytes to the recording and to the chunk checksum, publishing blocks as they fill. The caller has
+ * checked that they fit.
+ *
+ * @param rec Recorder.
+ * @param data Bytes.
+ * @param size Number of bytes.
+ */
+static void DM35425_Recorder_Put(DM35425_Recorder *rec, const void *data, size_t size)
+{
+    const uint8_t *src = data;
+
+    rec->crc = DM35425_Recording_Crc(rec->crc, data, size);
+    while (size > 0)
+    {
+        struct DM35425_Recorder_Block *block = &rec->blocks[rec->head % rec->num_blocks];
+        size_t n = rec->block_size - block->used < size ? rec->block_size - block->used : size;
+        memcpy(block->data + block->used, src, n);
+        block->used += n;
+        src += n;
+        size -= n;
+        if (block->used == rec->block_size)
+            DM35425_Recorder_Publish(rec);
+    }
+}
+
+/**
+ * @brief Append raw codes to the recording as int16_t and to the chunk checksum, publishing blocks as they fill. The
+ * caller has checked that they fit.
+ *
+ * @param rec Recorder.
+ * @param raw Raw ADC codes.
+ * @param count Number of codes.
+ */
+static void DM35425_Recorder_Put_Samples(DM35425_Recorder *rec, const int32_t *raw, size_t count)
+{
+    while (count > 0)
+    {
+        struct DM35425_Recorder_Block *block = &rec->blocks[rec->head % rec->num_blocks];
+        size_t space = (rec->block_size - block->used) / sizeof(int16_t); // blocks fill in whole samples, used is even
+        size_t n = space < count ? space : count;
+        int16_t *dst = (int16_t *)(block->data + block->used);
+        for (size_t i = 0; i < n; i++) // codes are 12 bits, narrowing loses nothing
+            dst[i] = (int16_t)raw[i];
+        rec->crc = DM35425_Recording_Crc(rec->crc, dst, n * sizeof(int16_t));
+        block->used += n * sizeof(int16_t);
+        raw += n;
+        count -= n;
+        if (block->used == rec->block_size)
+            DM35425_Recorder_Publish(rec);
+    }
+}
+
+/**
+ * @brief Start a new file in the block being filled, which is empty.
+ *
+ * @param rec Recorder.
+ * @param start_ns Timestamp of the first chunk of the file.
+ */
+static void DM35425_Recorder_Start_File(DM35425_Recorder *rec, uint64_t start_ns)
+{
+    struct DM35425_Recorder_Block *block = &rec->blocks[rec->head % rec->num_blocks];
+    struct DM35425_Recording_Header header;
+
+    rec->file_index = rec->in_file ? rec->file_index + 1 : 0;
+    block->starts_file = true;
+    block->file_index = rec->file_index;
+    // The writer thread writes the overview of the last file once it has finished that file
+    block->overview = rec->builder;
+    rec->builder = NULL;
+    if (rec->overview && DM35425_Overview_Builder_Create(&rec->builder, rec->overview_factor, rec->num_boards, rec->layout) != 0)
+        DM35425_Recorder_Overview_Failed(rec, errno);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DM35425_RECORDING_MAGIC, sizeof(header.magic));
+    header.version = DM35425_RECORDING_VERSION;
+    header.num_boards = rec->num_boards;
+    header.file_index = rec->file_index;
+    header.header_size = rec->header_size;
+    header.start_ns = start_ns;
+    header.chunk_size = rec->chunk_size;
+    header.codec = rec->compress ? DM35425_RECORDING_CODEC_DELTA : DM35425_RECORDING_CODEC_RAW;
+    DM35425_Recorder_Put(rec, &header, sizeof(header));
+    DM35425_Recorder_Put(rec, rec->layout, rec->num_boards * sizeof(struct DM35425_Recording_Board));
+    rec->in_file = true;
+    rec->file_bytes = rec->header_size;
+    rec->file_start_ns = start_ns;
+    rec->index_count = 0;
+}
+
+/**
+ * @brief Bytes that ending the current file puts after its last chunk.
+ *
+ * @param rec Recorder.
+ * @return size_t Bytes of the index and the trailer.
+ */
+static inline size_t DM35425_Recorder_Index_Size(const DM35425_Recorder *rec)
+{
+    return rec->index_count * sizeof(struct DM35425_Recording_Index_Entry) + sizeof(struct DM35425_Recording_Trailer);
+}
+
+/**
+ * @brief End the current file with its index and trailer, and hand in its last block. The caller has checked that
+ * they fit.
+ *
+ * @param rec Recorder.
+ */
+static void DM35425_Recorder_End_File(DM35425_Recorder *rec)
+{
+    struct DM35425_Recording_Trailer trailer;
+
+    memset(&trailer, 0, sizeof(trailer));
+    memcpy(trailer.magic, DM35425_RECORDING_INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.num_chunks = rec->index_count;
+    trailer.index_offset = rec->file_bytes;
+    rec->crc = 0;
+    DM35425_Recorder_Put(rec, rec->index, rec->index_count * sizeof(struct DM35425_Recording_Index_Entry));
+    trailer.crc = rec->crc;
+    DM35425_Recorder_Put(rec, &trailer, sizeof(trailer));
+    rec->file_bytes += DM35425_Recorder_Index_Size(rec);
+    if (rec->blocks[rec->head % rec->num_blocks].used > 0)
+        DM35425_Recorder_Publish(rec);
+}
+
+/**
+ * @brief Count the blocks that are free, including the one being filled.
+ *
+ * @param rec Recorder.
+ * @return size_t Free blocks.
+ */
+static inline size_t DM35425_Recorder_Free_Blocks(const DM35425_Recorder *rec)
+{
+    return rec->num_blocks - (size_t)(rec->head - __atomic_load_n(&rec->tail, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * @brief Count the blocks that putting some bytes fills or starts, from the current fill level.
+ *
+ * @param rec Recorder.
+ * @param used Bytes already in the block being filled.
+ * @param size Bytes to put.
+ * @return size_t Blocks needed.
+ */
+static inline size_t DM35425_Recorder_Blocks(const DM35425_Recorder *rec, size_t used, size_t size)
+{
+    return (used + size + rec->block_size - 1) / rec->block_size;
+}
+
+/**
+ * @brief Count a dropped frame.
+ *
+ * @param rec Recorder.
+ * @param error errno value to return with.
+ * @return int -1.
+ */
+static int DM35425_Recorder_Drop(DM35425_Recorder *rec, int error)
+{
+    rec->sequence++;
+    __atomic_fetch_add(&rec->frames_dropped, 1, __ATOMIC_RELAXED); // the encoder drops frames too
+    errno = error;
+    return -1;
+}
+
+/**
+ * @brief Make room for the next chunk: start a new file if it is time to, after checking that the chunk and any file
+ * change fit in the free blocks, and grow the index.
+ *
+ * @param rec Recorder.
+ * @param size Bytes of the chunk in the file.
+ * @param now Timestamp of the chunk.
+ * @return int 0 on success, or ENOBUFS or ENOMEM if the chunk must be dropped.
+ */
+static int DM35425_Recorder_Reserve(DM35425_Recorder *rec, size_t size, uint64_t now)
+{
+    bool rotate = !rec->in_file || rec->index_count == rec->index_limit ||
+                  (rec->rotate_bytes != 0 && rec->index_count > 0 &&
+                   rec->file_bytes + size + DM35425_Recorder_Index_Size(rec) + sizeof(struct DM35425_Recording_Index_Entry) > rec->rotate_bytes) ||
+                  (rec->rotate_ns != 0 && now - rec->file_start_ns >= rec->rotate_ns);
+    size_t free_blocks = DM35425_Recorder_Free_Blocks(rec);
+    size_t needed;
+
+    // Every block may be queued, and the one at head is then the writer's; there is no room in that case anyway
+    if (free_blocks == 0)
+        return ENOBUFS;
+    size_t used = rec->blocks[rec->head % rec->num_blocks].used;
+    if (!rotate)
+        needed = DM35425_Recorder_Blocks(rec, used, size);
+    else if (!rec->in_file)
+        needed = DM35425_Recorder_Blocks(rec, used, rec->header_size + size);
+    else
+        needed = DM35425_Recorder_Blocks(rec, used, DM35425_Recorder_Index_Size(rec)) + DM35425_Recorder_Blocks(rec, 0, rec->header_size + size);
+    if (needed > free_blocks)
+        return ENOBUFS;
+    if (rec->index_count == rec->index_capacity)
+    {
+        size_t capacity = rec->index_capacity * 2 < rec->index_limit ? rec->index_capacity * 2 : rec->index_limit;
+        void *index = realloc(rec->index, capacity * sizeof(struct DM35425_Recording_Index_Entry));
+        if (index == NULL)
+            return ENOMEM;
+        rec->index = (struct DM35425_Recording_Index_Entry *)index;
+        rec->index_capacity = capacity;
+    }
+
+    if (rotate)
+    {
+        if (rec->in_file)
+            DM35425_Recorder_End_File(rec);
+        DM35425_Recorder_Start_File(rec, now);
+    }
+    return 0;
+}
+
+/**
+ * @brief Copy a frame into the encoder's queue, laid out as an uncompressed chunk, and wake the encoder.
+ *
+ * @param rec Recorder.
+ * @param num_boards Number of boards.
+ * @param readouts The frame, checked against the layout.
+ * @return int 0 on success, or ENOBUFS if the queue is full.
+ */
+static int DM35425_Recorder_Queue(DM35425_Recorder *rec, int num_boards, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    uint64_t head = rec->frame_head;
+
+    if (head - __atomic_load_n(&rec->frame_tail, __ATOMIC_ACQUIRE) == (uint64_t)rec->compress_frames)
+        return ENOBUFS;
+
+    uint8_t *frame = rec->frames_queued + (head % rec->compress_frames) * rec->chunk_size;
+    struct DM35425_Recording_Chunk chunk = {DM35425_RECORDING_CHUNK_MAGIC, (uint32_t)rec->chunk_size, rec->sequence++,
+                                            readouts[0].first_sample * readouts[0].decimation, readouts[0].timestamp_ns};
+    size_t offset = sizeof(chunk);
+
+    memcpy(frame, &chunk, sizeof(chunk));
+    for (int b = 0; b < num_boards; b++)
+    {
+        const struct DM35425_ADCDMA_Readout *readout = &readouts[b];
+        struct DM35425_Recording_Readout header = {readout->sequence, readout->first_sample * readout->decimation,
+                                                   readout->timestamp_ns, readout->dropped};
+        size_t samples = rec->layout[b].frame_samples;
+        size_t bytes = (size_t)readout->num_channels * samples * sizeof(int16_t);
+
+        memcpy(frame + offset, &header, sizeof(header));
+        offset += sizeof(header);
+        int16_t *dst = (int16_t *)(frame + offset);
+        for (int c = 0; c < readout->num_channels; c++, dst += samples)
+        {
+            for (size_t i = 0; i < samples; i++) // codes are 12 bits, narrowing loses nothing
+                dst[i] = (int16_t)readout->raw[c][i];
+        }
+        memset(frame + offset + bytes, 0, DM35425_RECORDER_ROUND(bytes) - bytes);
+        offset += DM35425_RECORDER_ROUND(bytes);
+    }
+
+    // Publishing head and checking for a sleeping encoder must not be reordered, as for the writer
+    __atomic_store_n(&rec->frame_head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&rec->frame_waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&rec->frame_lock);
+        pthread_cond_signal(&rec->frame_cond);
+        pthread_mutex_unlock(&rec->frame_lock);
+    }
+    return 0;
+}
+
+/**
+ * @brief Record one frame, see {@link DM35425_Recorder_Record}.
+ *
+ * @param rec Recorder.
+ * @param num_boards Number of boards.
+ * @param readouts The frame.
+ * @param retry Refuse a frame that does not fit without counting it, so the caller can offer it again.
+ * @return int 0 on success, -1 on failure. Errno is set accordingly.
+ */
+static int DM35425_Recorder_Record_Frame(DM35425_Recorder *rec, int num_boards, const struct DM35425_ADCDMA_Readout *readouts, bool retry)
+{
+    static const uint8_t zeros[8] = {0};
+
+    if (rec == NULL || readouts == NULL || num_boards < 1)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    int error = __atomic_load_n(&rec->error, __ATOMIC_ACQUIRE);
+    if (error != 0)
+        return DM35425_Recorder_Drop(rec, error);
+    if (rec->num_boards == 0 && DM35425_Recorder_Setup(rec, num_boards, readouts) != 0)
+        return DM35425_Recorder_Drop(rec, errno);
+    if (num_boards != rec->num_boards)
+        return DM35425_Recorder_Drop(rec, EINVAL);
+    for (int b = 0; b < num_boards; b++)
+    {
+        if (readouts[b].num_channels != (int)rec->layout[b].num_channels ||
+            readouts[b].num_samples * readouts[b].decimation != rec->layout[b].frame_samples)
+            return DM35425_Recorder_Drop(rec, EINVAL);
+    }
+
+    uint64_t now = readouts[0].timestamp_ns;
+    if (rec->compress)
+        error = DM35425_Recorder_Queue(rec, num_boards, readouts);
+    else
+        error = DM35425_Recorder_Reserve(rec, rec->chunk_size, now);
+    if (error == ENOBUFS && retry)
+    {
+        errno = ENOBUFS;
+        return -1;
+    }
+    if (error != 0)
+        return DM35425_Recorder_Drop(rec, error);
+    if (rec->compress)
+        return 0;
+
+    struct DM35425_Recording_Chunk chunk = {DM35425_RECORDING_CHUNK_MAGIC, (uint32_t)rec->chunk_size, rec->sequence++,
+                                            readouts[0].first_sample * readouts[0].decimation, now};
+    rec->index[rec->index_count++] = (struct DM35425_Recording_Index_Entry){chunk.sequence, chunk.first_sample, now, rec->file_bytes};
+    rec->crc = 0;
+    DM35425_Recorder_Put(rec, &chunk, sizeof(chunk));
+    for (int b = 0; b < num_boards; b++)
+    {
+        const struct DM35425_ADCDMA_Readout *readout = &readouts[b];
+        struct DM35425_Recording_Readout header = {readout->sequence, readout->first_sample * readout->decimation,
+                                                   readout->timestamp_ns, readout->dropped};
+        size_t samples = rec->layout[b].frame_samples;
+        size_t bytes = (size_t)readout->num_channels * samples * sizeof(int16_t);
+
+        DM35425_Recorder_Put(rec, &header, sizeof(header));
+        for (int c = 0; c < readout->num_channels; c++)
+        {
+            DM35425_Recorder_Put_Samples(rec, readout->raw[c], samples);
+            if (rec->builder != NULL && DM35425_Overview_Builder_Add(rec->builder, b, c, header.first_sample, readout->raw[c], samples) != 0)
+            {
+                DM35425_Recorder_Overview_Failed(rec, errno);
+                DM35425_Overview_Builder_Free(rec->builder);
+                rec->builder = NULL;
+            }
+        }
+        DM35425_Recorder_Put(rec, zeros, DM35425_RECORDER_ROUND(bytes) - bytes);
+    }
+    struct DM35425_Recording_Chunk_End end = {rec->crc, 0};
+    DM35425_Recorder_Put(rec, &end, sizeof(end));
+    rec->file_bytes += rec->chunk_size;
+    __atomic_store_n(&rec->frames, rec->frames + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+int DM35425_Recorder_Record(DM35425_Recorder *rec, int num_boards, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    return DM35425_Recorder_Record_Frame(rec, num_boards, readouts, false);
+}
+
+int DM35425_Recorder_Try_Record(DM35425_Recorder *rec, int num_boards, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    return DM35425_Recorder_Record_Frame(rec, num_boards, readouts, true);
+}
+
+/**
+ * @brief Add samples kept as int16_t to the overview of the current file.
+ *
+ * @param rec Recorder.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param first_sample Position of the first sample on the board.
+ * @param samples Raw codes.
+ * @param count Number of samples.
+ */
+static void DM35425_Recorder_Add_Overview(DM35425_Recorder *rec, int board, int channel, uint64_t first_sample, const int16_t *samples, size_t count)
+{
+    int32_t codes[1024];
+
+    // Widen a block at a time, the builder takes int32_t codes like the readouts
+    for (size_t k = 0; k < count && rec->builder != NULL; k += 1024)
+    {
+        size_t n = count - k < 1024 ? count - k : 1024;
+        for (size_t s = 0; s < n; s++)
+            codes[s] = samples[k + s];
+        if (DM35425_Overview_Builder_Add(rec->builder, board, channel, first_sample + k, codes, n) != 0)
+        {
+            DM35425_Recorder_Overview_Failed(rec, errno);
+            DM35425_Overview_Builder_Free(rec->builder);
+            rec->builder = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Compress a queued frame and put it into the blocks as a chunk, as Record does for an uncompressed one.
+ *
+ * @param rec Recorder.
+ * @param frame The frame, as an uncompressed chunk.
+ */
+static void DM35425_Recorder_Encode(DM35425_Recorder *rec, const uint8_t *frame)
+{
+    const struct DM35425_Recording_Chunk *chunk = (const struct DM35425_Recording_Chunk *)frame;
+    size_t in = sizeof(*chunk), out = sizeof(*chunk);
+    int column = 0;
+
+    if (__atomic_load_n(&rec->error, __ATOMIC_ACQUIRE) != 0)
+    {
+        __atomic_fetch_add(&rec->frames_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(rec->coded, chunk, sizeof(*chunk));
+    for (int b = 0; b < rec->num_boards; b++)
+    {
+        size_t samples = rec->layout[b].frame_samples;
+        size_t bytes = (size_t)rec->layout[b].num_channels * samples * sizeof(int16_t);
+
+        memcpy(rec->coded + out, frame + in, sizeof(struct DM35425_Recording_Readout));
+        in += sizeof(struct DM35425_Recording_Readout);
+        out += sizeof(struct DM35425_Recording_Readout);
+        for (uint32_t c = 0; c < rec->layout[b].num_channels; c++, column++)
+        {
+            uint64_t start = DM35425_Get_Monotonic_Ns();
+            size_t n = DM35425_Codec_Encode((const int16_t *)(frame + in) + c * samples, samples, rec->coded + out);
+            rec->coding[column] = (struct DM35425_Recorder_Column){samples, n, DM35425_Get_Monotonic_Ns() - start};
+            out += n;
+        }
+        memset(rec->coded + out, 0, DM35425_RECORDER_ROUND(out) - out);
+        out = DM35425_RECORDER_ROUND(out);
+        in += DM35425_RECORDER_ROUND(bytes);
+    }
+    size_t size = out + sizeof(struct DM35425_Recording_Chunk_End);
+    ((struct DM35425_Recording_Chunk *)rec->coded)->size = (uint32_t)size;
+
+    if (DM35425_Recorder_Reserve(rec, size, chunk->timestamp_ns) != 0)
+    {
+        __atomic_fetch_add(&rec->frames_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    rec->index[rec->index_count++] = (struct DM35425_Recording_Index_Entry){chunk->sequence, chunk->first_sample, chunk->timestamp_ns, rec->file_bytes};
+    rec->crc = 0;
+    DM35425_Recorder_Put(rec, rec->coded, out);
+    struct DM35425_Recording_Chunk_End end = {rec->crc, 0};
+    DM35425_Recorder_Put(rec, &end, sizeof(end));
+    rec->file_bytes += size;
+
+    in = sizeof(*chunk);
+    for (int b = 0; b < rec->num_boards && rec->builder != NULL; b++)
+    {
+        const struct DM35425_Recording_Readout *readout = (const struct DM35425_Recording_Readout *)(frame + in);
+        size_t samples = rec->layout[b].frame_samples;
+
+        for (uint32_t c = 0; c < rec->layout[b].num_channels; c++)
+            DM35425_Recorder_Add_Overview(rec, b, c, readout->first_sample, (const int16_t *)(readout + 1) + c * samples, samples);
+        in += sizeof(*readout) + DM35425_RECORDER_ROUND((size_t)rec->layout[b].num_channels * samples * sizeof(int16_t));
+    }
+
+    pthread_mutex_lock(&rec->stats_lock);
+    for (int i = 0; i < column; i++)
+    {
+        rec->columns[i].samples += rec->coding[i].samples;
+        rec->columns[i].encoded_bytes += rec->coding[i].encoded_bytes;
+        rec->columns[i].encode_ns += rec->coding[i].encode_ns;
+    }
+    pthread_mutex_unlock(&rec->stats_lock);
+    __atomic_fetch_add(&rec->frames, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Encoder thread: compress queued frames in order until Close.
+ *
+ * @param arg Recorder.
+ * @return void* NULL.
+ */
+static void *DM35425_Recorder_Encoder(void *arg)
+{
+    DM35425_Recorder *rec = arg;
+    uint64_t tail = rec->frame_tail;
+
+    for (;;)
+    {
+        if (__atomic_load_n(&rec->frame_head, __ATOMIC_ACQUIRE) == tail)
+        {
+            bool stop;
+            pthread_mutex_lock(&rec->frame_lock);
+            // Announce the wait before checking head again, as the writer does
+            __atomic_store_n(&rec->frame_waiting, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&rec->frame_head, __ATOMIC_SEQ_CST) == tail && !rec->frame_stop)
+                pthread_cond_wait(&rec->frame_cond, &rec->frame_lock);
+            __atomic_store_n(&rec->frame_waiting, 0, __ATOMIC_RELAXED);
+            stop = rec->frame_stop;
+            pthread_mutex_unlock(&rec->frame_lock);
+            if (__atomic_load_n(&rec->frame_head, __ATOMIC_ACQUIRE) == tail)
+            {
+                if (stop)
+                    break;
+                continue;
+            }
+        }
+        DM35425_Recorder_Encode(rec, rec->frames_queued + (tail % rec->compress_frames) * rec->chunk_size);
+        __atomic_store_n(&rec->frame_tail, ++tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Processing stage that records every frame.
+ *
+ * @param num_boards Number of boards.
+ * @param readouts The frame.
+ * @param ctx The recorder.
+ * @return int 0, frames are never held back.
+ */
+static int DM35425_Recorder_Stage(int num_boards, struct DM35425_ADCDMA_Readout *readouts, void *ctx)
+{
+    DM35425_Recorder_Record((DM35425_Recorder *)ctx, num_boards, readouts); // drops are counted in the statistics
+    return 0;
+}
+
+int DM35425_Recorder_Add_Stage(DM35425_Multiboard_Descriptor *mbd, DM35425_Recorder *rec)
+{
+    if (mbd == NULL || rec == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return DM35425_ADC_Multiboard_Add_Stage(mbd, DM35425_Recorder_Stage, rec);
+}
+
+int DM35425_Recorder_Get_Stats(DM35425_Recorder *rec, struct DM35425_Recorder_Stats *stats)
+{
+    if (rec == NULL || stats == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->frames = __atomic_load_n(&rec->frames, __ATOMIC_RELAXED);
+    stats->frames_dropped = __atomic_load_n(&rec->frames_dropped, __ATOMIC_RELAXED);
+    stats->backlog = (int)(__atomic_load_n(&rec->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&rec->tail, __ATOMIC_ACQUIRE));
+    stats->max_backlog = __atomic_load_n(&rec->max_backlog, __ATOMIC_RELAXED);
+    stats->error = __atomic_load_n(&rec->error, __ATOMIC_ACQUIRE);
+    stats->overview_error = __atomic_load_n(&rec->overview_error, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&rec->stats_lock);
+    stats->bytes_written = rec->bytes_written;
+    stats->files = rec->files;
+    if (rec->last_write_ns > rec->first_write_ns)
+        stats->throughput = rec->bytes_written * 1e9 / (rec->last_write_ns - rec->first_write_ns);
+    DM35425_Histogram_Summarize(&rec->write, &stats->write);
+    pthread_mutex_unlock(&rec->stats_lock);
+    return 0;
+}
+
+int DM35425_Recorder_Get_Channel_Stats(DM35425_Recorder *rec, int board, int channel, struct DM35425_Recorder_Channel_Stats *stats)
+{
+    if (rec == NULL || stats == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    int num_boards = __atomic_load_n(&rec->num_boards, __ATOMIC_ACQUIRE);
+    if (!rec->compress || num_boards == 0)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    if (board < 0 || board >= num_boards || channel < 0 || (uint32_t)channel >= rec->layout[board].num_channels)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&rec->stats_lock);
+    struct DM35425_Recorder_Column column = rec->columns[rec->board_column[board] + channel];
+    pthread_mutex_unlock(&rec->stats_lock);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->samples = column.samples;
+    stats->encoded_bytes = column.encoded_bytes;
+    if (column.encoded_bytes > 0)
+        stats->ratio = (double)column.samples * sizeof(int16_t) / column.encoded_bytes;
+    if (column.encode_ns > 0)
+        stats->encode_rate = column.samples * sizeof(int16_t) * 1e3 / column.encode_ns;
+    return 0;
+}
+
+int DM35425_Recorder_Close(DM35425_Recorder *rec)
+{
+    if (rec == NULL)
+        return 0;
+    if (rec->compress)
+    {
+        // The encoder puts what is queued before it stops; the rest of Close then has the producer's side to itself
+        pthread_mutex_lock(&rec->frame_lock);
+        rec->frame_stop = true;
+        pthread_cond_signal(&rec->frame_cond);
+        pthread_mutex_unlock(&rec->frame_lock);
+        pthread_join(rec->encoder, NULL);
+    }
+    if (rec->in_file)
+    {
+        // Unlike Record, Close may wait for the writer to make room for the index
+        for (;;)
+        {
+            size_t free_blocks = DM35425_Recorder_Free_Blocks(rec);
+            if (free_blocks > 0 &&
+                DM35425_Recorder_Blocks(rec, rec->blocks[rec->head % rec->num_blocks].used, DM35425_Recorder_Index_Size(rec)) <= free_blocks)
+                break;
+            struct timespec wait = {0, 1000000};
+            nanosleep(&wait, NULL);
+        }
+        DM35425_Recorder_End_File(rec);
+    }
+    rec->last_overview = rec->builder;
+    rec->builder = NULL;
+    pthread_mutex_lock(&rec->lock);
+    rec->stop = true;
+    pthread_cond_signal(&rec->cond);
+    pthread_mutex_unlock(&rec->lock);
+    pthread_join(rec->writer, NULL);
+
+    int error = rec->error;
+    pthread_mutex_destroy(&rec->lock);
+    pthread_cond_destroy(&rec->cond);
+    pthread_mutex_destroy(&rec->stats_lock);
+    pthread_mutex_destroy(&rec->frame_lock);
+    pthread_cond_destroy(&rec->frame_cond);
+    for (int i = 0; i < rec->num_blocks; i++)
+        free(rec->blocks[i].data);
+    free(rec->blocks);
+    free(rec->frames_queued);
+    free(rec->coded);
+    free(rec->coding);
+    free(rec->columns);
+    free(rec->board_column);
+    DM35425_Overview_Builder_Free(rec->last_overview);
+    free(rec->layout);
+    free(rec->index);
+    free(rec->path);
+    free(rec);
+    if (error != 0)
+    {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,976 @@
+/**
+ * @file dm35425_adc_recording.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the recording file reader, memory-mapped reader and checksum.
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#define _FILE_OFFSET_BITS 64 // files larger than 2 GiB on 32-bit hosts
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "dm35425_adc_recording.h"
+#include "dm35425_adc_codec.h"
+#include "dm35425_adc_library.h"
+
+#define DM35425_RECORDING_CRC_POLY 0x82F63B78U /*!< CRC-32C polynomial, bit reversed */
+
+struct _DM35425_Recording
+{
+    int fd;                                       // file descriptor
+    struct DM35425_Recording_Header header;       // file header
+    struct DM35425_Recording_Board *boards;       // boards[num_boards]
+    size_t num_chunks;                            // number of chunks
+    struct DM35425_Recording_Index_Entry *index;  // index[num_chunks]
+    uint8_t *chunk;                               // chunk buffer for Read
+    ssize_t cached;                               // chunk held in `chunk`, -1 for none
+    size_t max_stored;                            // most bytes a chunk can take in the file
+    uint8_t *stored;                              // compressed chunk buffer for Read_Chunk, NULL if not compressed
+};
+
+static uint32_t DM35425_Crc_Table[8][256]; // slicing-by-8 tables
+static bool DM35425_Crc_Hardware;          // use the SSE4.2 crc32 instruction
+static pthread_once_t DM35425_Crc_Once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Fill the CRC tables and check for the CRC instruction.
+ *
+ */
+static void DM35425_Crc_Init(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? DM35425_RECORDING_CRC_POLY : 0);
+        DM35425_Crc_Table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (int i = 0; i < 256; i++)
+            DM35425_Crc_Table[k][i] = (DM35425_Crc_Table[k - 1][i] >> 8) ^ DM35425_Crc_Table[0][DM35425_Crc_Table[k - 1][i] & 0xFF];
+    }
+#if defined(__x86_64__)
+    DM35425_Crc_Hardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/**
+ * @brief Table-driven CRC-32C, eight bytes at a time.
+ *
+ * @param crc Inverted CRC so far.
+ * @param p Data.
+ * @param size Bytes of data.
+ * @return uint32_t Inverted CRC.
+ */
+static uint32_t DM35425_Crc_Tables(uint32_t crc, const uint8_t *p, size_t size)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = DM35425_Crc_Table[7][lo & 0xFF] ^ DM35425_Crc_Table[6][(lo >> 8) & 0xFF] ^
+              DM35425_Crc_Table[5][(lo >> 16) & 0xFF] ^ DM35425_Crc_Table[4][lo >> 24] ^
+              DM35425_Crc_Table[3][hi & 0xFF] ^ DM35425_Crc_Table[2][(hi >> 8) & 0xFF] ^
+              DM35425_Crc_Table[1][(hi >> 16) & 0xFF] ^ DM35425_Crc_Table[0][hi >> 24];
+    }
+#endif
+    for (; size > 0; p++, size--)
+        crc = DM35425_Crc_Table[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief CRC-32C with the SSE4.2 crc32 instruction.
+ *
+ * @param crc Inverted CRC so far.
+ * @param p Data.
+ * @param size Bytes of data.
+ * @return uint32_t Inverted CRC.
+ */
+__attribute__((target("sse4.2"))) static uint32_t DM35425_Crc_Sse42(uint32_t crc, const uint8_t *p, size_t size)
+{
+    uint64_t crc64 = crc;
+
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+    for (; size > 0; p++, size--)
+        crc = __builtin_ia32_crc32qi(crc, *p);
+    return crc;
+}
+#endif
+
+uint32_t DM35425_Recording_Crc(uint32_t crc, const void *data, size_t size)
+{
+    pthread_once(&DM35425_Crc_Once, DM35425_Crc_Init);
+#if defined(__x86_64__)
+    if (DM35425_Crc_Hardware)
+        return ~DM35425_Crc_Sse42(~crc, data, size);
+#endif
+    return ~DM35425_Crc_Tables(~crc, data, size);
+}
+
+/**
+ * @brief Read exactly `size` bytes at a position.
+ *
+ * @param fd File descriptor.
+ * @param buffer Buffer.
+ * @param size Bytes to read.
+ * @param offset Position in the file.
+ * @return int 0 on success, -1 on failure with errno set; EBADMSG if the file ends first.
+ */
+static int DM35425_Recording_Pread(int fd, void *buffer, size_t size, uint64_t offset)
+{
+    uint8_t *dst = buffer;
+
+    while (size > 0)
+    {
+        ssize_t n = pread(fd, dst, size, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+        {
+            errno = EBADMSG; // truncated
+            return -1;
+        }
+        dst += n;
+        size -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Load the index from the trailer of a closed file.
+ *
+ * @param rec Recording.
+ * @param length File size.
+ * @return int 0 on success, -1 if there is no valid index, with errno ENOMEM or EBADMSG.
+ */
+static int DM35425_Recording_Load_Index(DM35425_Recording *rec, uint64_t length)
+{
+    struct DM35425_Recording_Trailer trailer;
+    uint64_t chunks_end;
+
+    if (length < rec->header.header_size + sizeof(trailer) ||
+        DM35425_Recording_Pread(rec->fd, &trailer, sizeof(trailer), length - sizeof(trailer)) != 0 ||
+        memcmp(trailer.magic, DM35425_RECORDING_INDEX_MAGIC, sizeof(trailer.magic)) != 0 ||
+        trailer.num_chunks > (length - sizeof(trailer)) / sizeof(struct DM35425_Recording_Index_Entry))
+        goto bad;
+    // Compressed chunks vary in length, so only their bounds can be checked
+    chunks_end = rec->header.header_size + trailer.num_chunks * rec->header.chunk_size;
+    if (rec->stored != NULL)
+        chunks_end = trailer.index_offset;
+    if (trailer.index_offset != chunks_end || chunks_end < rec->header.header_size ||
+        chunks_end + trailer.num_chunks * sizeof(struct DM35425_Recording_Index_Entry) + sizeof(trailer) != length)
+        goto bad;
+    rec->index = (struct DM35425_Recording_Index_Entry *)malloc((trailer.num_chunks + 1) * sizeof(struct DM35425_Recording_Index_Entry));
+    if (rec->index == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (DM35425_Recording_Pread(rec->fd, rec->index, trailer.num_chunks * sizeof(struct DM35425_Recording_Index_Entry), trailer.index_offset) != 0 ||
+        DM35425_Recording_Crc(0, rec->index, trailer.num_chunks * sizeof(struct DM35425_Recording_Index_Entry)) != trailer.crc)
+    {
+        free(rec->index);
+        rec->index = NULL;
+        goto bad;
+    }
+    rec->num_chunks = trailer.num_chunks;
+    return 0;
+
+bad:
+    errno = EBADMSG;
+    return -1;
+}
+
+/**
+ * @brief Rebuild the index of a file that was not closed from the chunk headers, up to the first chunk that is
+ * missing or was not completely written.
+ *
+ * @param rec Recording.
+ * @param length File size.
+ * @return int 0 on success, -1 with errno ENOMEM or set by read.
+ */
+static int DM35425_Recording_Rebuild_Index(DM35425_Recording *rec, uint64_t length)
+{
+    // Uncompressed chunks all take chunk_size, compressed ones at least their headers and a width byte per channel
+    size_t min_stored = rec->header.chunk_size;
+    if (rec->stored != NULL)
+        min_stored = sizeof(struct DM35425_Recording_Chunk) + sizeof(struct DM35425_Recording_Chunk_End) +
+                     rec->header.num_boards * (sizeof(struct DM35425_Recording_Readout) + 8);
+    size_t capacity = (length - rec->header.header_size) / min_stored;
+    uint64_t offset = rec->header.header_size;
+
+    rec->index = (struct DM35425_Recording_Index_Entry *)malloc((capacity + 1) * sizeof(struct DM35425_Recording_Index_Entry));
+    if (rec->index == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    rec->num_chunks = 0;
+    for (size_t i = 0; i < capacity && offset + sizeof(struct DM35425_Recording_Chunk) <= length; i++)
+    {
+        struct DM35425_Recording_Chunk chunk;
+        if (DM35425_Recording_Pread(rec->fd, &chunk, sizeof(chunk), offset) != 0)
+            return -1;
+        // A preallocated file that was not truncated reads as zeros past the last chunk
+        bool size_ok = rec->stored != NULL ? chunk.size >= min_stored && chunk.size <= rec->max_stored && chunk.size % 8 == 0
+                                           : chunk.size == rec->header.chunk_size;
+        if (chunk.magic != DM35425_RECORDING_CHUNK_MAGIC || !size_ok || offset + chunk.size > length ||
+            (i > 0 && chunk.sequence <= rec->index[i - 1].sequence))
+            break;
+        rec->index[i] = (struct DM35425_Recording_Index_Entry){chunk.sequence, chunk.first_sample, chunk.timestamp_ns, offset};
+        rec->num_chunks++;
+        offset += chunk.size;
+    }
+    return 0;
+}
+
+int DM35425_Recording_Open(DM35425_Recording **_rec, const char *path)
+{
+    if (_rec == NULL || path == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Recording *rec = (DM35425_Recording *)calloc(1, sizeof(DM35425_Recording));
+    if (rec == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    rec->cached = -1;
+    rec->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (rec->fd < 0)
+    {
+        free(rec);
+        return -1;
+    }
+
+    struct stat st;
+    struct DM35425_Recording_Header *header = &rec->header;
+    size_t min_chunk = sizeof(struct DM35425_Recording_Chunk) + sizeof(struct DM35425_Recording_Chunk_End);
+    if (fstat(rec->fd, &st) != 0 || DM35425_Recording_Pread(rec->fd, header, sizeof(*header), 0) != 0)
+        goto errored;
+    if (memcmp(header->magic, DM35425_RECORDING_MAGIC, sizeof(header->magic)) != 0 || header->version != DM35425_RECORDING_VERSION ||
+        header->num_boards < 1 || header->num_boards > 1024 ||
+        header->header_size != sizeof(*header) + header->num_boards * sizeof(struct DM35425_Recording_Board) ||
+        header->chunk_size < min_chunk + header->num_boards * sizeof(struct DM35425_Recording_Readout) || header->chunk_size % 8 != 0 ||
+        header->codec > DM35425_RECORDING_CODEC_DELTA)
+    {
+        errno = EBADMSG;
+        goto errored;
+    }
+    rec->boards = (struct DM35425_Recording_Board *)malloc(header->num_boards * sizeof(struct DM35425_Recording_Board));
+    rec->chunk = (uint8_t *)malloc(header->chunk_size);
+    if (rec->boards == NULL || rec->chunk == NULL)
+    {
+        errno = ENOMEM;
+        goto errored;
+    }
+    if (DM35425_Recording_Pread(rec->fd, rec->boards, header->num_boards * sizeof(struct DM35425_Recording_Board), sizeof(*header)) != 0)
+        goto errored;
+    size_t payload = min_chunk;
+    rec->max_stored = min_chunk;
+    for (uint32_t b = 0; b < header->num_boards; b++)
+    {
+        if (rec->boards[b].num_channels > DM35425_NUM_ADC_DMA_CHANNELS || rec->boards[b].frame_samples == 0)
+        {
+            errno = EBADMSG;
+            goto errored;
+        }
+        payload += sizeof(struct DM35425_Recording_Readout) +
+                   (((size_t)rec->boards[b].num_channels * rec->boards[b].frame_samples * sizeof(int16_t) + 7) & ~(size_t)7);
+        rec->max_stored += sizeof(struct DM35425_Recording_Readout) +
+                           ((rec->boards[b].num_channels * DM35425_Codec_Bound(rec->boards[b].frame_samples) + 7) & ~(size_t)7);
+    }
+    if (payload != header->chunk_size)
+    {
+        errno = EBADMSG;
+        goto errored;
+    }
+    if (header->codec == DM35425_RECORDING_CODEC_RAW)
+        rec->max_stored = header->chunk_size;
+    else if ((rec->stored = (uint8_t *)malloc(rec->max_stored)) == NULL)
+    {
+        errno = ENOMEM;
+        goto errored;
+    }
+    if (DM35425_Recording_Load_Index(rec, (uint64_t)st.st_size) != 0)
+    {
+        if (errno != EBADMSG || DM35425_Recording_Rebuild_Index(rec, (uint64_t)st.st_size) != 0)
+            goto errored;
+    }
+    *_rec = rec;
+    return 0;
+
+errored:
+{
+    int error = errno;
+    DM35425_Recording_Close(rec);
+    errno = error;
+    return -1;
+}
+}
+
+void DM35425_Recording_Close(DM35425_Recording *rec)
+{
+    if (rec == NULL)
+        return;
+    if (rec->fd >= 0)
+        close(rec->fd);
+    free(rec->boards);
+    free(rec->index);
+    free(rec->chunk);
+    free(rec->stored);
+    free(rec);
+}
+
+const struct DM35425_Recording_Header *DM35425_Recording_Get_Header(DM35425_Recording *rec)
+{
+    return &rec->header;
+}
+
+const struct DM35425_Recording_Board *DM35425_Recording_Get_Board(DM35425_Recording *rec, int board)
+{
+    if (rec == NULL || board < 0 || (uint32_t)board >= rec->header.num_boards)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    return &rec->boards[board];
+}
+
+const struct DM35425_Recording_Index_Entry *DM35425_Recording_Get_Index(DM35425_Recording *rec, size_t *num_chunks)
+{
+    if (rec == NULL || num_chunks == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    *num_chunks = rec->num_chunks;
+    return rec->index;
+}
+
+/**
+ * @brief Binary search the index for the last entry whose key is at or before a value.
+ *
+ * @param rec Recording.
+ * @param key Offset of the key in an index entry.
+ * @param value Value to look for.
+ * @return ssize_t Entry, or -1 with errno ENOENT if every entry is after the value.
+ */
+static ssize_t DM35425_Recording_Search(DM35425_Recording *rec, size_t key, uint64_t value)
+{
+    size_t low = 0, high = rec->num_chunks; // the answer is below high
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        uint64_t at;
+        memcpy(&at, (const uint8_t *)&rec->index[mid] + key, sizeof(at));
+        if (at <= value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == 0)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+    return (ssize_t)low - 1;
+}
+
+ssize_t DM35425_Recording_Find_Sample(DM35425_Recording *rec, uint64_t sample)
+{
+    if (rec == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return DM35425_Recording_Search(rec, offsetof(struct DM35425_Recording_Index_Entry, first_sample), sample);
+}
+
+ssize_t DM35425_Recording_Find_Time(DM35425_Recording *rec, uint64_t timestamp_ns)
+{
+    if (rec == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return DM35425_Recording_Search(rec, offsetof(struct DM35425_Recording_Index_Entry, timestamp_ns), timestamp_ns);
+}
+
+/**
+ * @brief Check a stored chunk: its header, its length for this recording and its checksum.
+ *
+ * @param rec Recording.
+ * @param stored The chunk as stored.
+ * @param available Bytes of file from the start of the chunk.
+ * @return bool The chunk is whole and intact.
+ */
+static bool DM35425_Recording_Check_Chunk(DM35425_Recording *rec, const uint8_t *stored, uint64_t available)
+{
+    const struct DM35425_Recording_Chunk *head = (const struct DM35425_Recording_Chunk *)stored;
+    const struct DM35425_Recording_Chunk_End *end;
+    size_t size = head->size;
+
+    if (head->magic != DM35425_RECORDING_CHUNK_MAGIC || size > available || size % 8 != 0 ||
+        (rec->stored == NULL ? size != rec->header.chunk_size
+                             : size > rec->max_stored || size < sizeof(*head) + sizeof(*end)))
+        return false;
+    end = (const struct DM35425_Recording_Chunk_End *)(stored + size - sizeof(*end));
+    return DM35425_Recording_Crc(0, stored, size - sizeof(*end)) == end->crc;
+}
+
+/**
+ * @brief Decode a checked compressed chunk into the uncompressed layout.
+ *
+ * @param rec Recording.
+ * @param stored The chunk as stored.
+ * @param buffer Returned chunk, of the header's `chunk_size` bytes.
+ * @return int 0 on success, -1 with errno EBADMSG if the channels do not decode to exactly the chunk.
+ */
+static int DM35425_Recording_Decode_Chunk(DM35425_Recording *rec, const uint8_t *stored, uint8_t *buffer)
+{
+    const struct DM35425_Recording_Chunk *head = (const struct DM35425_Recording_Chunk *)stored;
+    size_t end = head->size - sizeof(struct DM35425_Recording_Chunk_End); // end of the coded boards
+    size_t in = sizeof(*head), out = sizeof(*head);
+
+    memcpy(buffer, head, sizeof(*head));
+    ((struct DM35425_Recording_Chunk *)buffer)->size = rec->header.chunk_size;
+    for (uint32_t b = 0; b < rec->header.num_boards; b++)
+    {
+        size_t frame_samples = rec->boards[b].frame_samples;
+        size_t bytes = (size_t)rec->boards[b].num_channels * frame_samples * sizeof(int16_t);
+
+        if (in + sizeof(struct DM35425_Recording_Readout) > end)
+            goto bad;
+        memcpy(buffer + out, stored + in, sizeof(struct DM35425_Recording_Readout));
+        in += sizeof(struct DM35425_Recording_Readout);
+        out += sizeof(struct DM35425_Recording_Readout);
+        for (uint32_t c = 0; c < rec->boards[b].num_channels; c++)
+        {
+            ssize_t n = DM35425_Codec_Decode(stored + in, end - in, (int16_t *)(buffer + out) + c * frame_samples, frame_samples);
+            if (n < 0)
+                return -1;
+            in += (size_t)n;
+        }
+        in = (in + 7) & ~(size_t)7;
+        memset(buffer + out + bytes, 0, ((bytes + 7) & ~(size_t)7) - bytes);
+        out += (bytes + 7) & ~(size_t)7;
+    }
+    if (in != end)
+        goto bad;
+    memset(buffer + out, 0, sizeof(struct DM35425_Recording_Chunk_End));
+    return 0;
+
+bad:
+    errno = EBADMSG;
+    return -1;
+}
+
+int DM35425_Recording_Read_Chunk(DM35425_Recording *rec, size_t chunk, void *buffer)
+{
+    if (rec == NULL || buffer == NULL || chunk >= rec->num_chunks)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    uint64_t offset = rec->index[chunk].offset;
+    uint8_t *stored = rec->stored != NULL ? rec->stored : (uint8_t *)buffer;
+    const struct DM35425_Recording_Chunk *head = (const struct DM35425_Recording_Chunk *)stored;
+
+    // The header first, for the length of a compressed chunk
+    if (DM35425_Recording_Pread(rec->fd, stored, sizeof(*head), offset) != 0)
+        return -1;
+    if (head->magic != DM35425_RECORDING_CHUNK_MAGIC || head->size > rec->max_stored || head->size < sizeof(*head) ||
+        head->sequence != rec->index[chunk].sequence)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    if (DM35425_Recording_Pread(rec->fd, stored + sizeof(*head), head->size - sizeof(*head), offset + sizeof(*head)) != 0)
+        return -1;
+    if (!DM35425_Recording_Check_Chunk(rec, stored, head->size))
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    if (rec->stored != NULL)
+        return DM35425_Recording_Decode_Chunk(rec, stored, (uint8_t *)buffer);
+    return 0;
+}
+
+/**
+ * @brief Find a board's part of a chunk.
+ *
+ * @param rec Recording.
+ * @param chunk Chunk contents.
+ * @param board Board index.
+ * @return const struct DM35425_Recording_Readout* The board's readout header, followed by its samples.
+ */
+static const struct DM35425_Recording_Readout *DM35425_Recording_Board_Readout(DM35425_Recording *rec, const uint8_t *chunk, int board)
+{
+    const uint8_t *p = chunk + sizeof(struct DM35425_Recording_Chunk);
+
+    for (int b = 0; b < board; b++)
+        p += sizeof(struct DM35425_Recording_Readout) +
+             (((size_t)rec->boards[b].num_channels * rec->boards[b].frame_samples * sizeof(int16_t) + 7) & ~(size_t)7);
+    return (const struct DM35425_Recording_Readout *)p;
+}
+
+ssize_t DM35425_Recording_Read(DM35425_Recording *rec, int board, int channel, uint64_t first_sample, size_t count, int32_t *samples)
+{
+    if (rec == NULL || samples == NULL || board < 0 || (uint32_t)board >= rec->header.num_boards || channel < 0 ||
+        (uint32_t)channel >= rec->boards[board].num_channels)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    const struct DM35425_Recording_Board *layout = &rec->boards[board];
+    uint64_t from = layout->frame_samples, to = rec->boards[0].frame_samples;
+    // Board 0 position of the same time, rounding down, in whole chunks and the remainder so it cannot overflow
+    uint64_t position = first_sample / from * to + (first_sample % from) * to / from;
+    ssize_t chunk = DM35425_Recording_Search(rec, offsetof(struct DM35425_Recording_Index_Entry, first_sample), position);
+    size_t done = 0;
+
+    if (chunk < 0 || rec->num_chunks == 0)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    while (done < count && (size_t)chunk < rec->num_chunks)
+    {
+        if (rec->cached != chunk)
+        {
+            rec->cached = -1;
+            if (DM35425_Recording_Read_Chunk(rec, (size_t)chunk, rec->chunk) != 0)
+                return done > 0 ? (ssize_t)done : -1;
+            rec->cached = chunk;
+        }
+        const struct DM35425_Recording_Readout *readout = DM35425_Recording_Board_Readout(rec, rec->chunk, board);
+        uint64_t at = first_sample + done;
+        if (at < readout->first_sample || at >= readout->first_sample + layout->frame_samples)
+        {
+            if (done > 0 || (size_t)chunk + 1 < rec->num_chunks || at < readout->first_sample)
+                break;
+            return 0; // after the end
+        }
+        const int16_t *src = (const int16_t *)(readout + 1) + (size_t)channel * layout->frame_samples + (at - readout->first_sample);
+        size_t n = layout->frame_samples - (size_t)(at - readout->first_sample);
+        if (n > count - done)
+            n = count - done;
+        for (size_t i = 0; i < n; i++)
+            samples[done + i] = src[i];
+        done += n;
+        chunk++;
+    }
+    if (done == 0)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    return (ssize_t)done;
+}
+
+struct _DM35425_Recording_Map
+{
+    DM35425_Recording *rec; // header, layout and index
+    const uint8_t *base;    // mapped file
+    size_t length;          // bytes mapped
+    size_t *board_offset;   // board_offset[num_boards], position of each board's readout in a chunk
+    int *board_column;      // board_column[num_boards], column of each board's first channel among all channels
+    int num_columns;        // channels of all boards
+    uint8_t *checked;       // checked[num_chunks]: 0 not yet, 1 checksum good, 2 corrupt
+    uint8_t **decoded;      // decoded[num_chunks], compressed chunks decoded on first use
+    float ***volts;         // volts[num_chunks][num_columns], converted on first use
+};
+
+int DM35425_Recording_Map_Open(DM35425_Recording_Map **_map, const char *path)
+{
+    if (_map == NULL || path == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Recording_Map *map = (DM35425_Recording_Map *)calloc(1, sizeof(DM35425_Recording_Map));
+    if (map == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (DM35425_Recording_Open(&map->rec, path) != 0)
+    {
+        free(map);
+        return -1;
+    }
+
+    DM35425_Recording *rec = map->rec;
+    struct stat st;
+    if (fstat(rec->fd, &st) != 0)
+        goto errored;
+    if ((uint64_t)st.st_size > SIZE_MAX)
+    {
+        errno = EFBIG; // larger than the address space
+        goto errored;
+    }
+    map->length = (size_t)st.st_size;
+    void *base = mmap(NULL, map->length, PROT_READ, MAP_SHARED, rec->fd, 0);
+    if (base == MAP_FAILED)
+        goto errored;
+    map->base = (const uint8_t *)base;
+
+    map->board_offset = (size_t *)malloc(rec->header.num_boards * sizeof(size_t));
+    map->board_column = (int *)malloc(rec->header.num_boards * sizeof(int));
+    map->checked = (uint8_t *)calloc(rec->num_chunks + 1, sizeof(uint8_t));
+    map->decoded = (uint8_t **)calloc(rec->num_chunks + 1, sizeof(uint8_t *));
+    map->volts = (float ***)calloc(rec->num_chunks + 1, sizeof(float **));
+    if (map->board_offset == NULL || map->board_column == NULL || map->checked == NULL || map->decoded == NULL ||
+        map->volts == NULL)
+    {
+        errno = ENOMEM;
+        goto errored;
+    }
+    size_t offset = sizeof(struct DM35425_Recording_Chunk);
+    for (uint32_t b = 0; b < rec->header.num_boards; b++)
+    {
+        map->board_offset[b] = offset;
+        map->board_column[b] = map->num_columns;
+        map->num_columns += rec->boards[b].num_channels;
+        offset += sizeof(struct DM35425_Recording_Readout) +
+                  (((size_t)rec->boards[b].num_channels * rec->boards[b].frame_samples * sizeof(int16_t) + 7) & ~(size_t)7);
+    }
+    // A rebuilt index only holds whole chunks, but a loaded one is taken at its word; the length of a compressed
+    // chunk is checked when it is viewed
+    size_t last = rec->stored != NULL ? sizeof(struct DM35425_Recording_Chunk) : rec->header.chunk_size;
+    if (rec->num_chunks > 0 && rec->index[rec->num_chunks - 1].offset + last > map->length)
+    {
+        errno = EBADMSG;
+        goto errored;
+    }
+    *_map = map;
+    return 0;
+
+errored:
+{
+    int error = errno;
+    DM35425_Recording_Map_Close(map);
+    errno = error;
+    return -1;
+}
+}
+
+void DM35425_Recording_Map_Close(DM35425_Recording_Map *map)
+{
+    if (map == NULL)
+        return;
+    if (map->volts != NULL)
+    {
+        for (size_t i = 0; i < map->rec->num_chunks; i++)
+        {
+            if (map->volts[i] == NULL)
+                continue;
+            for (int c = 0; c < map->num_columns; c++)
+                free(map->volts[i][c]);
+            free(map->volts[i]);
+        }
+    }
+    if (map->decoded != NULL)
+    {
+        for (size_t i = 0; i < map->rec->num_chunks; i++)
+            free(map->decoded[i]);
+    }
+    if (map->base != NULL)
+        munmap((void *)map->base, map->length);
+    DM35425_Recording_Close(map->rec);
+    free(map->board_offset);
+    free(map->board_column);
+    free(map->checked);
+    free(map->decoded);
+    free(map->volts);
+    free(map);
+}
+
+DM35425_Recording *DM35425_Recording_Map_Get_Recording(DM35425_Recording_Map *map)
+{
+    return map->rec;
+}
+
+int DM35425_Recording_Map_Advise(DM35425_Recording_Map *map, enum DM35425_Recording_Access access)
+{
+    int advice;
+
+    if (map == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (access)
+    {
+    case DM35425_RECORDING_ACCESS_NORMAL:
+        advice = MADV_NORMAL;
+        break;
+    case DM35425_RECORDING_ACCESS_SEQUENTIAL:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case DM35425_RECORDING_ACCESS_RANDOM:
+        advice = MADV_RANDOM;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+    return madvise((void *)map->base, map->length, advice);
+}
+
+int DM35425_Recording_Map_Prefetch(DM35425_Recording_Map *map, size_t first_chunk, size_t num_chunks)
+{
+    if (map == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Recording *rec = map->rec;
+    if (first_chunk >= rec->num_chunks || num_chunks == 0)
+        return 0;
+    if (num_chunks > rec->num_chunks - first_chunk)
+        num_chunks = rec->num_chunks - first_chunk;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = rec->index[first_chunk].offset & ~(uint64_t)(page - 1);
+    size_t end = rec->index[first_chunk + num_chunks - 1].offset + rec->header.chunk_size;
+    if (rec->stored != NULL) // up to the next chunk, or the index
+        end = first_chunk + num_chunks < rec->num_chunks ? rec->index[first_chunk + num_chunks].offset : map->length;
+    if (end > map->length)
+        end = map->length;
+    return madvise((void *)(map->base + start), end - start, MADV_WILLNEED);
+}
+
+/**
+ * @brief Convert one channel of a chunk to volts on first use. Threads racing to convert the same samples each do
+ * the work, and all but the first to publish throw theirs away.
+ *
+ * @param map Map.
+ * @param chunk Chunk index.
+ * @param board Board index.
+ * @param channel Index into the board's active channels.
+ * @param raw The channel's samples in the chunk.
+ * @return const float* Volts of the channel's samples in the chunk, or NULL with errno ENOMEM.
+ */
+static const float *DM35425_Recording_Map_Volts(DM35425_Recording_Map *map, size_t chunk, int board, int channel, const int16_t *raw)
+{
+    const struct DM35425_Recording_Board *layout = &map->rec->boards[board];
+    float **table = __atomic_load_n(&map->volts[chunk], __ATOMIC_ACQUIRE);
+    float **expected_table = NULL;
+    float *volts, *expected = NULL;
+    int column = map->board_column[board] + channel;
+
+    if (table == NULL)
+    {
+        table = (float **)calloc(map->num_columns, sizeof(float *));
+        if (table == NULL)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+        if (!__atomic_compare_exchange_n(&map->volts[chunk], &expected_table, table, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            free(table);
+            table = expected_table;
+        }
+    }
+    volts = __atomic_load_n(&table[column], __ATOMIC_ACQUIRE);
+    if (volts != NULL)
+        return volts;
+
+    volts = (float *)malloc(layout->frame_samples * sizeof(float));
+    if (volts == NULL)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    // Widen a block at a time for the bulk conversion, which takes int32_t codes
+    int32_t codes[1024];
+    for (size_t i = 0; i < layout->frame_samples; i += 1024)
+    {
+        size_t n = layout->frame_samples - i < 1024 ? layout->frame_samples - i : 1024;
+        for (size_t k = 0; k < n; k++)
+            codes[k] = raw[i + k];
+        // ERANGE still converts every sample; a bad range was already checked for by the recorder
+        DM35425_Adc_Samples_To_Volts_Bulk((enum DM35425_Input_Ranges)layout->ranges[channel], codes, volts + i, n);
+    }
+    if (!__atomic_compare_exchange_n(&table[column], &expected, volts, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(volts);
+        volts = expected;
+    }
+    return volts;
+}
+
+/**
+ * @brief Check a chunk's checksum the first time it is used. Threads racing to check the same chunk each do the work.
+ *
+ * @param map Map.
+ * @param chunk Chunk index.
+ * @return int 0 if the chunk is intact, -1 with errno EBADMSG if it is corrupt.
+ */
+static int DM35425_Recording_Map_Check(DM35425_Recording_Map *map, size_t chunk)
+{
+    uint8_t checked = __atomic_load_n(&map->checked[chunk], __ATOMIC_RELAXED);
+
+    if (checked == 0)
+    {
+        uint64_t offset = map->rec->index[chunk].offset;
+        checked = DM35425_Recording_Check_Chunk(map->rec, map->base + offset, map->length - offset) ? 1 : 2;
+        __atomic_store_n(&map->checked[chunk], checked, __ATOMIC_RELAXED);
+    }
+    if (checked != 1)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode a checked compressed chunk on first use, like {@link DM35425_Recording_Map_Volts}.
+ *
+ * @param map Map.
+ * @param chunk Chunk index.
+ * @return const uint8_t* The chunk in the uncompressed layout, or NULL with errno ENOMEM or EBADMSG.
+ */
+static const uint8_t *DM35425_Recording_Map_Decoded(DM35425_Recording_Map *map, size_t chunk)
+{
+    uint8_t *decoded = __atomic_load_n(&map->decoded[chunk], __ATOMIC_ACQUIRE);
+    uint8_t *expected = NULL;
+
+    if (decoded != NULL)
+        return decoded;
+    decoded = (uint8_t *)malloc(map->rec->header.chunk_size);
+    if (decoded == NULL)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (DM35425_Recording_Decode_Chunk(map->rec, map->base + map->rec->index[chunk].offset, decoded) != 0)
+    {
+        free(decoded);
+        return NULL;
+    }
+    if (!__atomic_compare_exchange_n(&map->decoded[chunk], &expected, decoded, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(decoded);
+        decoded = expected;
+    }
+    return decoded;
+}
+
+int DM35425_Recording_Map_Release(DM35425_Recording_Map *map, size_t first_chunk, size_t num_chunks)
+{
+    if (map == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t total = map->rec->num_chunks;
+    if (first_chunk >= total)
+        return 0;
+    if (num_chunks > total - first_chunk)
+        num_chunks = total - first_chunk;
+
+    // The checksum results stay, they take a byte per chunk
+    for (size_t i = first_chunk; i < first_chunk + num_chunks; i++)
+    {
+        free(__atomic_exchange_n(&map->decoded[i], NULL, __ATOMIC_ACQ_REL));
+        float **table = __atomic_exchange_n(&map->volts[i], NULL, __ATOMIC_ACQ_REL);
+        if (table == NULL)
+            continue;
+        for (int c = 0; c < map->num_columns; c++)
+            free(table[c]);
+        free(table);
+    }
+    return 0;
+}
+
+int DM35425_Recording_Map_View(DM35425_Recording_Map *map, int board, int channel, uint64_t sample, bool volts, struct DM35425_Recording_View *view)
+{
+    if (map == NULL || view == NULL || board < 0 || (uint32_t)board >= map->rec->header.num_boards || channel < 0 ||
+        (uint32_t)channel >= map->rec->boards[board].num_channels)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Recording *rec = map->rec;
+    const struct DM35425_Recording_Board *layout = &rec->boards[board];
+    uint64_t from = layout->frame_samples, to = rec->boards[0].frame_samples;
+    uint64_t position = sample / from * to + (sample % from) * to / from; // as in Read
+    ssize_t found = DM35425_Recording_Search(rec, offsetof(struct DM35425_Recording_Index_Entry, first_sample), position);
+
+    if (found < 0)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    size_t chunk = (size_t)found;
+    const uint8_t *base = map->base + rec->index[chunk].offset;
+    if (rec->stored != NULL)
+    {
+        // The samples' positions are only known once the chunk is decoded
+        if (DM35425_Recording_Map_Check(map, chunk) != 0)
+            return -1;
+        base = DM35425_Recording_Map_Decoded(map, chunk);
+        if (base == NULL)
+            return -1;
+    }
+    const struct DM35425_Recording_Readout *readout = (const struct DM35425_Recording_Readout *)(base + map->board_offset[board]);
+    if (sample < readout->first_sample || sample >= readout->first_sample + layout->frame_samples)
+    {
+        errno = ENODATA;
+        return -1;
+    }
+    if (rec->stored == NULL && DM35425_Recording_Map_Check(map, chunk) != 0)
+        return -1;
+
+    const int16_t *raw = (const int16_t *)(readout + 1) + (size_t)channel * layout->frame_samples;
+    size_t skip = (size_t)(sample - readout->first_sample);
+    view->first_sample = sample;
+    view->count = layout->frame_samples - skip;
+    view->raw = raw + skip;
+    view->volts = NULL;
+    view->chunk = chunk;
+    if (volts)
+    {
+        const float *converted = DM35425_Recording_Map_Volts(map, chunk, board, channel, raw);
+        if (converted == NULL)
+            return -1;
+        view->volts = converted + skip;
+    }
+    return 0;
+}
@@ -0,0 +1,607 @@
+/**
+ * @file dm35425_adc_spectrum.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the real FFT and Welch power spectral density for the DM35425 ADC.
+ * @version 1.0
+ * @date 2023-05-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "dm35425_adc_spectrum.h"
+
+#define DM35425_FFT_MAX_SIZE (1UL << 24) /*!< Largest transform, keeps the bit-reversal table in 32 bits */
+
+struct _DM35425_Fft
+{
+    size_t size;        // real input points
+    size_t half;        // complex points of the inner transform, size / 2
+    uint32_t *reverse;  // reverse[half], bit-reversed index of each complex point
+    float *twiddles;    // for each radix-4 pass of quarter length h, h entries of w^2j, w^j, w^3j (re, im) with w = exp(-2 pi i / 4h)
+    float *split;       // split[half / 2 + 1] (re, im), exp(-2 pi i k / size) for separating the real spectrum
+    bool radix2;        // log2(half) is odd, so one radix-2 pass comes first
+};
+
+/**
+ * @brief Scratch of one thread working on the accumulator.
+ *
+ */
+struct DM35425_Psd_Worker
+{
+    DM35425_Psd *psd; // owning accumulator
+    pthread_t pid;    // thread id, unused for the calling thread's scratch
+    float *segment;   // windowed segment, size floats
+    float *spectrum;  // transform of the segment, size + 2 floats
+};
+
+struct _DM35425_Psd
+{
+    int num_channels;                   // number of channels
+    size_t size;                        // segment (FFT) size
+    size_t hop;                         // points between segment starts
+    size_t bins;                        // size / 2 + 1
+    DM35425_Fft *fft;                   // FFT plan, shared by every thread
+    float *window;                      // window[size]
+    double scale;                       // 1 / (sample_rate * sum of window^2), one-sided factor 2 applied in Get
+    float *pending;                     // pending[num_channels][size], start of each channel's next segment
+    size_t *fill;                       // fill[num_channels], samples in pending
+    double *sums;                       // sums[num_channels][bins], sum of |X|^2 over segments
+    uint64_t *segments;                 // segments[num_channels], number of segments summed
+    pthread_mutex_t lock;               // serializes feeding against Get and Reset
+    int board;                          // board fed by the processing stage
+    // worker pool
+    int num_threads;                    // number of worker threads
+    int started;                        // worker threads running, joined on destroy
+    struct DM35425_Psd_Worker *workers; // workers[num_threads + 1], the last one is the calling thread's scratch
+    pthread_mutex_t pool_lock;          // protects the job below
+    pthread_cond_t pool_cond;           // signalled when a job is posted or the pool stops
+    pthread_cond_t done_cond;           // signalled when the last worker finishes a job
+    uint64_t job;                       // job number, bumped to post a job
+    int busy;                           // workers still on the current job
+    int next_channel;                   // next channel to be taken, atomic
+    const float *const *job_volts;      // samples of the current job
+    size_t job_count;                   // samples per channel of the current job
+    bool stop;                          // workers must exit
+};
+
+int DM35425_Fft_Create(DM35425_Fft **_fft, size_t size)
+{
+    if (_fft == NULL || size < 4 || size > DM35425_FFT_MAX_SIZE || (size & (size - 1)) != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Fft *fft = (DM35425_Fft *)calloc(1, sizeof(DM35425_Fft));
+    if (fft == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    fft->size = size;
+    fft->half = size / 2;
+    int bits = 0;
+    while (((size_t)1 << bits) < fft->half)
+        bits++;
+    fft->radix2 = (bits & 1) != 0;
+
+    fft->reverse = (uint32_t *)malloc(fft->half * sizeof(uint32_t));
+    fft->twiddles = (float *)malloc(fft->half * 6 * sizeof(float));
+    fft->split = (float *)malloc((fft->half / 2 + 1) * 2 * sizeof(float));
+    if (fft->reverse == NULL || fft->twiddles == NULL || fft->split == NULL)
+    {
+        DM35425_Fft_Destroy(fft);
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = 0; i < fft->half; i++)
+    {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        fft->reverse[i] = r;
+    }
+    // Twiddles in the order the passes use them; the quarter lengths sum to less than half
+    float *tw = fft->twiddles;
+    for (size_t h = fft->radix2 ? 2 : 1; h < fft->half; h *= 4)
+    {
+        for (size_t j = 0; j < h; j++)
+        {
+            double angle = -2.0 * M_PI * (double)j / (double)(4 * h);
+            *tw++ = (float)cos(2 * angle);
+            *tw++ = (float)sin(2 * angle);
+            *tw++ = (float)cos(angle);
+            *tw++ = (float)sin(angle);
+            *tw++ = (float)cos(3 * angle);
+            *tw++ = (float)sin(3 * angle);
+        }
+    }
+    for (size_t k = 0; k <= fft->half / 2; k++)
+    {
+        double angle = -2.0 * M_PI * (double)k / (double)size;
+        fft->split[2 * k] = (float)cos(angle);
+        fft->split[2 * k + 1] = (float)sin(angle);
+    }
+    *_fft = fft;
+    return 0;
+}
+
+void DM35425_Fft_Destroy(DM35425_Fft *fft)
+{
+    if (fft == NULL)
+        return;
+    free(fft->reverse);
+    free(fft->twiddles);
+    free(fft->split);
+    free(fft);
+}
+
+size_t DM35425_Fft_Size(const DM35425_Fft *fft)
+{
+    return fft->size;
+}
+
+/**
+ * @brief One radix-4 decimation-in-time pass over `half` complex points in bit-reversed order. Each butterfly merges
+ * four transforms of length h into one of length 4h with three complex multiplies.
+ *
+ * @param x Data, interleaved (re, im).
+ * @param half Number of complex points.
+ * @param h Length of the transforms being merged.
+ * @param tw Twiddles of this pass, h entries of w^2j, w^j, w^3j.
+ */
+static inline void DM35425_Fft_Radix4_Pass(float *x, size_t half, size_t h, const float *tw)
+{
+    for (size_t base = 0; base < half; base += 4 * h)
+    {
+        float *p0 = x + 2 * base;
+        float *p1 = p0 + 2 * h;
+        float *p2 = p1 + 2 * h;
+        float *p3 = p2 + 2 * h;
+        const float *w = tw;
+        for (size_t j = 0; j < h; j++, w += 6)
+        {
+            float ar = p0[2 * j], ai = p0[2 * j + 1];
+            float br = p1[2 * j], bi = p1[2 * j + 1];
+            float cr = p2[2 * j], ci = p2[2 * j + 1];
+            float dr = p3[2 * j], di = p3[2 * j + 1];
+            float t1r = br * w[0] - bi * w[1], t1i = br * w[1] + bi * w[0];
+            float t2r = cr * w[2] - ci * w[3], t2i = cr * w[3] + ci * w[2];
+            float t3r = dr * w[4] - di * w[5], t3i = dr * w[5] + di * w[4];
+            float s0r = ar + t1r, s0i = ai + t1i;
+            float s1r = ar - t1r, s1i = ai - t1i;
+            float s2r = t2r + t3r, s2i = t2i + t3i;
+            float s3r = t2r - t3r, s3i = t2i - t3i;
+            p0[2 * j] = s0r + s2r;
+            p0[2 * j + 1] = s0i + s2i;
+            p2[2 * j] = s0r - s2r;
+            p2[2 * j + 1] = s0i - s2i;
+            p1[2 * j] = s1r + s3i; // s1 - i s3
+            p1[2 * j + 1] = s1i - s3r;
+            p3[2 * j] = s1r - s3i; // s1 + i s3
+            p3[2 * j + 1] = s1i + s3r;
+        }
+    }
+}
+
+void DM35425_Fft_Forward(const DM35425_Fft *fft, const float *in, float *out)
+{
+    size_t half = fft->half;
+    const uint32_t *reverse = fft->reverse;
+
+    // Even samples are the real parts and odd samples the imaginary parts of a half-length complex signal
+    for (size_t i = 0; i < half; i++)
+    {
+        size_t r = reverse[i];
+        out[2 * i] = in[2 * r];
+        out[2 * i + 1] = in[2 * r + 1];
+    }
+    size_t h = 1;
+    if (fft->radix2)
+    {
+        for (size_t i = 0; i < 2 * half; i += 4)
+        {
+            float ar = out[i], ai = out[i + 1], br = out[i + 2], bi = out[i + 3];
+            out[i] = ar + br;
+            out[i + 1] = ai + bi;
+            out[i + 2] = ar - br;
+            out[i + 3] = ai - bi;
+        }
+        h = 2;
+    }
+    const float *tw = fft->twiddles;
+    for (; h < half; tw += 6 * h, h *= 4)
+    {
+        DM35425_Fft_Radix4_Pass(out, half, h, tw);
+    }
+
+    // Separate the spectra of the even and odd samples, Z[k] = E[k] + i O[k], and combine them:
+    // X[k] = E[k] + w^k O[k], X[half - k] = conj(E[k] - w^k O[k])
+    float z0r = out[0], z0i = out[1];
+    out[0] = z0r + z0i;
+    out[1] = 0;
+    out[2 * half] = z0r - z0i;
+    out[2 * half + 1] = 0;
+    const float *split = fft->split;
+    for (size_t k = 1; k <= half / 2; k++)
+    {
+        size_t m = half - k;
+        float ar = out[2 * k], ai = out[2 * k + 1];
+        float br = out[2 * m], bi = -out[2 * m + 1];
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br); // -i (a - b) / 2
+        float wr = split[2 * k], wi = split[2 * k + 1];
+        float tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+        out[2 * m] = er - tr;
+        out[2 * m + 1] = -(ei - ti);
+        out[2 * k] = er + tr;
+        out[2 * k + 1] = ei + ti;
+    }
+}
+
+int DM35425_Window_Fill(enum DM35425_Window type, float *window, size_t size)
+{
+    if (window == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    // Periodic (DFT-even) windows, the right choice for spectral averaging
+    for (size_t n = 0; n < size; n++)
+    {
+        double x = 2.0 * M_PI * (double)n / (double)size;
+        switch (type)
+        {
+        case DM35425_WINDOW_RECTANGULAR:
+            window[n] = 1.0f;
+            break;
+        case DM35425_WINDOW_HANN:
+            window[n] = (float)(0.5 - 0.5 * cos(x));
+            break;
+        case DM35425_WINDOW_HAMMING:
+            window[n] = (float)(0.54 - 0.46 * cos(x));
+            break;
+        case DM35425_WINDOW_BLACKMAN:
+            window[n] = (float)(0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x));
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Window and transform one full segment of a channel and add its periodogram to the channel's sum.
+ *
+ * @param psd Accumulator.
+ * @param worker Scratch of the calling thread.
+ * @param channel Channel index.
+ * @param pending The segment, size samples.
+ */
+static void DM35425_Psd_Segment(DM35425_Psd *psd, struct DM35425_Psd_Worker *worker, int channel, const float *pending)
+{
+    float *segment = worker->segment;
+    float *spectrum = worker->spectrum;
+    double *sums = psd->sums + channel * psd->bins;
+
+    for (size_t n = 0; n < psd->size; n++)
+        segment[n] = pending[n] * psd->window[n];
+    DM35425_Fft_Forward(psd->fft, segment, spectrum);
+    for (size_t k = 0; k < psd->bins; k++)
+    {
+        float re = spectrum[2 * k], im = spectrum[2 * k + 1];
+        sums[k] += (double)(re * re + im * im);
+    }
+    psd->segments[channel]++;
+}
+
+/**
+ * @brief Append samples to a channel's pending segment, processing every segment that fills up.
+ *
+ * @param psd Accumulator.
+ * @param worker Scratch of the calling thread.
+ * @param channel Channel index.
+ * @param volts Samples.
+ * @param count Number of samples.
+ */
+static void DM35425_Psd_Feed(DM35425_Psd *psd, struct DM35425_Psd_Worker *worker, int channel, const float *volts, size_t count)
+{
+    size_t size = psd->size;
+    float *pending = psd->pending + channel * size;
+    size_t fill = psd->fill[channel];
+
+    while (count > 0)
+    {
+        size_t take = size - fill < count ? size - fill : count;
+        memcpy(pending + fill, volts, take * sizeof(float));
+        fill += take;
+        volts += take;
+        count -= take;
+        if (fill == size)
+        {
+            DM35425_Psd_Segment(psd, worker, channel, pending);
+            memmove(pending, pending + psd->hop, (size - psd->hop) * sizeof(float));
+            fill = size - psd->hop;
+        }
+    }
+    psd->fill[channel] = fill;
+}
+
+/**
+ * @brief Take channels of the current job until none are left.
+ *
+ * @param psd Accumulator.
+ * @param worker Scratch of the calling thread.
+ */
+static void DM35425_Psd_Run_Job(DM35425_Psd *psd, struct DM35425_Psd_Worker *worker)
+{
+    int channel;
+    while ((channel = __atomic_fetch_add(&psd->next_channel, 1, __ATOMIC_RELAXED)) < psd->num_channels)
+    {
+        DM35425_Psd_Feed(psd, worker, channel, psd->job_volts[channel], psd->job_count);
+    }
+}
+
+static void *DM35425_Psd_Worker_Thread(void *ptr)
+{
+    struct DM35425_Psd_Worker *worker = ptr;
+    DM35425_Psd *psd = worker->psd;
+    uint64_t job = 0;
+
+    pthread_mutex_lock(&psd->pool_lock);
+    for (;;)
+    {
+        while (!psd->stop && psd->job == job)
+            pthread_cond_wait(&psd->pool_cond, &psd->pool_lock);
+        if (psd->stop)
+            break;
+        job = psd->job;
+        pthread_mutex_unlock(&psd->pool_lock);
+        DM35425_Psd_Run_Job(psd, worker);
+        pthread_mutex_lock(&psd->pool_lock);
+        if (--psd->busy == 0)
+            pthread_cond_signal(&psd->done_cond);
+    }
+    pthread_mutex_unlock(&psd->pool_lock);
+    return NULL;
+}
+
+int DM35425_Psd_Create(DM35425_Psd **_psd, int num_channels, size_t size, size_t hop, enum DM35425_Window window, double sample_rate, int num_threads)
+{
+    if (_psd == NULL || num_channels < 1 || hop < 1 || hop > size || !(sample_rate > 0) || num_threads < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Psd *psd = (DM35425_Psd *)calloc(1, sizeof(DM35425_Psd));
+    if (psd == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    pthread_mutex_init(&psd->lock, NULL);
+    pthread_mutex_init(&psd->pool_lock, NULL);
+    pthread_cond_init(&psd->pool_cond, NULL);
+    pthread_cond_init(&psd->done_cond, NULL);
+    if (DM35425_Fft_Create(&psd->fft, size) != 0)
+    {
+        DM35425_Psd_Destroy(psd);
+        errno = EINVAL;
+        return -1;
+    }
+    psd->num_channels = num_channels;
+    psd->size = size;
+    psd->hop = hop;
+    psd->bins = size / 2 + 1;
+    psd->window = (float *)malloc(size * sizeof(float));
+    psd->fill = (size_t *)calloc(num_channels, sizeof(size_t));
+    psd->sums = (double *)calloc(num_channels * psd->bins, sizeof(double));
+    psd->segments = (uint64_t *)calloc(num_channels, sizeof(uint64_t));
+    psd->workers = (struct DM35425_Psd_Worker *)calloc(num_threads + 1, sizeof(struct DM35425_Psd_Worker));
+    if (psd->window == NULL || psd->fill == NULL || psd->sums == NULL || psd->segments == NULL || psd->workers == NULL ||
+        posix_memalign((void **)&psd->pending, 64, num_channels * size * sizeof(float)) != 0)
+    {
+        DM35425_Psd_Destroy(psd);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (DM35425_Window_Fill(window, psd->window, size) != 0)
+    {
+        DM35425_Psd_Destroy(psd);
+        errno = EINVAL;
+        return -1;
+    }
+    double power = 0;
+    for (size_t n = 0; n < size; n++)
+        power += (double)psd->window[n] * psd->window[n];
+    psd->scale = 1.0 / (sample_rate * power);
+
+    psd->num_threads = num_threads;
+    for (int i = 0; i <= num_threads; i++)
+    {
+        struct DM35425_Psd_Worker *worker = &psd->workers[i];
+        worker->psd = psd;
+        if (posix_memalign((void **)&worker->segment, 64, size * sizeof(float)) != 0 ||
+            posix_memalign((void **)&worker->spectrum, 64, (size + 2) * sizeof(float)) != 0)
+        {
+            DM35425_Psd_Destroy(psd);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        int status = pthread_create(&psd->workers[i].pid, NULL, DM35425_Psd_Worker_Thread, &psd->workers[i]);
+        if (status != 0)
+        {
+            DM35425_Psd_Destroy(psd);
+            errno = status;
+            return -1;
+        }
+        psd->started = i + 1;
+    }
+    *_psd = psd;
+    return 0;
+}
+
+void DM35425_Psd_Destroy(DM35425_Psd *psd)
+{
+    if (psd == NULL)
+        return;
+    pthread_mutex_lock(&psd->pool_lock);
+    psd->stop = true;
+    pthread_cond_broadcast(&psd->pool_cond);
+    pthread_mutex_unlock(&psd->pool_lock);
+    for (int i = 0; i < psd->started; i++)
+    {
+        pthread_join(psd->workers[i].pid, NULL);
+    }
+    if (psd->workers != NULL)
+    {
+        for (int i = 0; i <= psd->num_threads; i++)
+        {
+            free(psd->workers[i].segment);
+            free(psd->workers[i].spectrum);
+        }
+    }
+    pthread_mutex_destroy(&psd->lock);
+    pthread_mutex_destroy(&psd->pool_lock);
+    pthread_cond_destroy(&psd->pool_cond);
+    pthread_cond_destroy(&psd->done_cond);
+    DM35425_Fft_Destroy(psd->fft);
+    free(psd->workers);
+    free(psd->window);
+    free(psd->pending);
+    free(psd->fill);
+    free(psd->sums);
+    free(psd->segments);
+    free(psd);
+}
+
+int DM35425_Psd_Process(DM35425_Psd *psd, int channel, const float *volts, size_t count)
+{
+    if (psd == NULL || volts == NULL || channel < 0 || channel >= psd->num_channels)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&psd->lock);
+    DM35425_Psd_Feed(psd, &psd->workers[psd->num_threads], channel, volts, count);
+    pthread_mutex_unlock(&psd->lock);
+    return 0;
+}
+
+int DM35425_Psd_Process_All(DM35425_Psd *psd, const float *const *volts, size_t count)
+{
+    if (psd == NULL || volts == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&psd->lock);
+    psd->job_volts = volts;
+    psd->job_count = count;
+    psd->next_channel = 0;
+    if (psd->num_threads > 0)
+    {
+        pthread_mutex_lock(&psd->pool_lock);
+        psd->busy = psd->num_threads;
+        psd->job++;
+        pthread_cond_broadcast(&psd->pool_cond);
+        pthread_mutex_unlock(&psd->pool_lock);
+    }
+    DM35425_Psd_Run_Job(psd, &psd->workers[psd->num_threads]);
+    if (psd->num_threads > 0)
+    {
+        pthread_mutex_lock(&psd->pool_lock);
+        while (psd->busy > 0)
+            pthread_cond_wait(&psd->done_cond, &psd->pool_lock);
+        pthread_mutex_unlock(&psd->pool_lock);
+    }
+    pthread_mutex_unlock(&psd->lock);
+    return 0;
+}
+
+int DM35425_Psd_Get(DM35425_Psd *psd, int channel, double *density, uint64_t *segments)
+{
+    if (psd == NULL || density == NULL || channel < 0 || channel >= psd->num_channels)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock(&psd->lock);
+    uint64_t count = psd->segments[channel];
+    if (segments != NULL)
+        *segments = count;
+    if (count == 0)
+    {
+        pthread_mutex_unlock(&psd->lock);
+        errno = ENODATA;
+        return -1;
+    }
+    const double *sums = psd->sums + channel * psd->bins;
+    double scale = psd->scale / (double)count;
+    for (size_t k = 0; k < psd->bins; k++)
+    {
+        // One-sided: every bin but DC and Nyquist also holds the power of its negative frequency
+        density[k] = sums[k] * scale * ((k == 0 || k == psd->bins - 1) ? 1.0 : 2.0);
+    }
+    pthread_mutex_unlock(&psd->lock);
+    return 0;
+}
+
+void DM35425_Psd_Reset(DM35425_Psd *psd)
+{
+    pthread_mutex_lock(&psd->lock);
+    memset(psd->fill, 0, psd->num_channels * sizeof(size_t));
+    memset(psd->sums, 0, psd->num_channels * psd->bins * sizeof(double));
+    memset(psd->segments, 0, psd->num_channels * sizeof(uint64_t));
+    pthread_mutex_unlock(&psd->lock);
+}
+
+/**
+ * @brief Processing stage feeding one board's voltages to the accumulator.
+ *
+ * @param num_boards Number of boards.
+ * @param readouts The frame.
+ * @param ctx The accumulator.
+ * @return int 0, frames are never held back.
+ */
+static int DM35425_Psd_Stage(int num_boards, struct DM35425_ADCDMA_Readout *readouts, void *ctx)
+{
+    DM35425_Psd *psd = ctx;
+    if (psd->board >= num_boards)
+        return 0;
+    struct DM35425_ADCDMA_Readout *readout = &readouts[psd->board];
+    if (readout->voltages == NULL || readout->num_channels != psd->num_channels)
+        return 0;
+    if (readout->dropped != 0)
+    {
+        // A segment must not straddle a gap; the averages are kept
+        pthread_mutex_lock(&psd->lock);
+        memset(psd->fill, 0, psd->num_channels * sizeof(size_t));
+        pthread_mutex_unlock(&psd->lock);
+    }
+    DM35425_Psd_Process_All(psd, (const float *const *)readout->voltages, readout->num_samples);
+    return 0;
+}
+
+int DM35425_Psd_Add_Stage(DM35425_Multiboard_Descriptor *mbd, DM35425_Psd *psd, int board)
+{
+    if (mbd == NULL || psd == NULL || board < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    psd->board = board;
+    return DM35425_ADC_Multiboard_Add_Stage(mbd, DM35425_Psd_Stage, psd);
+}
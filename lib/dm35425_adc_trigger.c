@@ -0,0 +1,684 @@
+/**
+ * @file dm35425_adc_trigger.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Implementation of the software trigger on the multiboard ADC stream.
+ * @version 1.0
+ * @date 2023-05-26
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dm35425_adc_trigger.h"
+#include "dm35425_util_library.h"
+
+#define DM35425_TRIGGER_LANES 8                /*!< Samples per vector */
+#define DM35425_TRIGGER_MAX_LEVEL (1L << 20)   /*!< Largest level or hysteresis magnitude, far outside any ADC code */
+#define DM35425_TRIGGER_ROUND(size) (((size) + 7) & ~(size_t)7) /*!< Round an event memory block up to keep pointers aligned */
+
+/**
+ * @brief Eight raw codes, compared as unsigned offsets from the low edge of a range.
+ *
+ */
+typedef uint32_t DM35425_Trigger_Vec __attribute__((vector_size(DM35425_TRIGGER_LANES * sizeof(uint32_t))));
+
+/**
+ * @brief A range of codes a condition looks for.
+ *
+ */
+struct DM35425_Trigger_Range
+{
+    int32_t low;  // lowest code in the range
+    int32_t high; // highest code in the range
+    bool outside; // look for codes outside the range instead
+};
+
+/**
+ * @brief A condition and its scanning state.
+ *
+ */
+struct DM35425_Trigger_Watch
+{
+    struct DM35425_Trigger_Condition condition; // settings
+    struct DM35425_Trigger_Range arm;           // edges: codes that arm the edge
+    struct DM35425_Trigger_Range fire;          // codes that fire the trigger
+    bool edge;                                  // must be armed before it can fire
+    bool armed;                                 // edge armed since the last re-arm
+    uint64_t scanned;                           // position on its board up to which samples have been scanned
+};
+
+/**
+ * @brief History of one board. Positions count raw samples per channel since the ISR was installed.
+ *
+ */
+struct DM35425_Trigger_Board
+{
+    int num_channels;    // number of active channels
+    size_t frame_len;    // raw samples per channel in a frame
+    size_t pre;          // pre-trigger samples of this board
+    size_t post;         // post-trigger samples of this board
+    size_t capacity;     // history samples per channel
+    int32_t *history;    // history[num_channels][capacity], position p at p % capacity
+    uint64_t written;    // position just after the newest sample in the history
+    uint64_t valid_from; // positions before this are stale: before the first frame, or before the last lost buffers
+    uint64_t trigger;    // trigger position of the pending event on this board
+};
+
+struct _DM35425_Trigger
+{
+    int num_watches;                                                  // number of conditions
+    struct DM35425_Trigger_Watch watches[DM35425_TRIGGER_MAX_CONDITIONS]; // conditions
+    size_t pre;                                                       // pre-trigger samples of board 0
+    size_t post;                                                      // post-trigger samples of board 0
+    size_t holdoff;                                                   // samples of board 0 from the end of a capture to re-arming
+    size_t depth;                                                     // event queue depth
+    bool wide;                                                        // use the AVX2 build of the scan
+    // set up on the first frame
+    int num_boards;                                                   // number of boards, 0 before the first frame
+    struct DM35425_Trigger_Board *boards;                             // boards[num_boards]
+    struct DM35425_Trigger_Event *events;                             // events[depth]
+    void **event_memory;                                              // event_memory[depth], samples and tables of each event
+    // pending event
+    bool pending;                                                     // a trigger fired, waiting for its post-trigger samples
+    int pending_condition;                                            // condition that fired
+    uint64_t pending_sample;                                          // trigger position on the condition's board
+    uint64_t pending_timestamp_ns;                                    // timestamp of the frame holding the trigger
+    uint64_t rearm;                                                   // position of board 0 from which the conditions may fire again
+    // event queue, single producer (the stage) and single consumer
+    uint64_t head;                                                    // events published
+    uint64_t tail;                                                    // events released
+    uint64_t sequence;                                                // events fired, counting dropped ones
+    uint64_t dropped;                                                 // events dropped since the last published one
+    int waiting;                                                      // the consumer is asleep in Get_Event
+    int error;                                                        // errno that stopped the trigger, 0 while running
+    pthread_mutex_t lock;                                             // protects waiting consumers
+    pthread_cond_t cond;                                              // signalled on publish and on error
+};
+
+/**
+ * @brief Convert a position between boards running at different rates, rounding up.
+ *
+ * @param position Position on the source board.
+ * @param to Frame length of the destination board.
+ * @param from Frame length of the source board.
+ * @return uint64_t Position on the destination board.
+ */
+static inline uint64_t DM35425_Trigger_Scale(uint64_t position, size_t to, size_t from)
+{
+    if (to == from)
+        return position;
+    // Whole frames and the remainder separately, so the product cannot overflow
+    return position / from * to + ((position % from) * to + from - 1) / from;
+}
+
+/**
+ * @brief Find the first sample in or, for an outside range, out of a range. Sixteen samples are tested at a time, and
+ * only the block holding the hit is scanned one sample at a time.
+ *
+ * @param x Samples.
+ * @param from Index to start at.
+ * @param count Number of samples.
+ * @param range Range to look for.
+ * @return size_t Index of the first match, or count if there is none.
+ */
+static inline size_t DM35425_Trigger_Find_Range(const int32_t *x, size_t from, size_t count, const struct DM35425_Trigger_Range *range)
+{
+    // low <= x <= high is one unsigned compare: x - low <= high - low
+    uint32_t low = (uint32_t)range->low;
+    uint32_t span = (uint32_t)range->high - low;
+    uint32_t invert = range->outside ? UINT32_MAX : 0;
+    DM35425_Trigger_Vec vlow = (DM35425_Trigger_Vec){0} + low;
+    DM35425_Trigger_Vec vspan = (DM35425_Trigger_Vec){0} + span;
+    DM35425_Trigger_Vec vinvert = (DM35425_Trigger_Vec){0} + invert;
+    size_t i = from;
+
+    for (; i + 2 * DM35425_TRIGGER_LANES <= count; i += 2 * DM35425_TRIGGER_LANES)
+    {
+        DM35425_Trigger_Vec a, b;
+        memcpy(&a, x + i, sizeof(a));
+        memcpy(&b, x + i + DM35425_TRIGGER_LANES, sizeof(b));
+        DM35425_Trigger_Vec in_a = (DM35425_Trigger_Vec)(a - vlow <= vspan);
+        DM35425_Trigger_Vec in_b = (DM35425_Trigger_Vec)(b - vlow <= vspan);
+        DM35425_Trigger_Vec hit = (in_a ^ vinvert) | (in_b ^ vinvert);
+        uint64_t words[DM35425_TRIGGER_LANES / 2];
+        memcpy(words, &hit, sizeof(words));
+        if ((words[0] | words[1] | words[2] | words[3]) != 0)
+            break;
+    }
+    for (; i < count; i++)
+    {
+        if ((((uint32_t)x[i] - low) <= span) != range->outside)
+            return i;
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief {@link DM35425_Trigger_Find_Range} with 256-bit registers.
+ *
+ * @param x Samples.
+ * @param from Index to start at.
+ * @param count Number of samples.
+ * @param range Range to look for.
+ * @return size_t Index of the first match, or count if there is none.
+ */
+__attribute__((target("avx2"))) static size_t DM35425_Trigger_Find_Range_Avx2(const int32_t *x, size_t from, size_t count, const struct DM35425_Trigger_Range *range)
+{
+    return DM35425_Trigger_Find_Range(x, from, count, range);
+}
+#endif
+
+/**
+ * @brief Find the first sample in a range with the widest build of {@link DM35425_Trigger_Find_Range} the CPU runs.
+ *
+ * @param trig Trigger.
+ * @param x Samples.
+ * @param from Index to start at.
+ * @param count Number of samples.
+ * @param range Range to look for.
+ * @return size_t Index of the first match, or count if there is none.
+ */
+static size_t DM35425_Trigger_Find(const DM35425_Trigger *trig, const int32_t *x, size_t from, size_t count, const struct DM35425_Trigger_Range *range)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (trig->wide)
+        return DM35425_Trigger_Find_Range_Avx2(x, from, count, range);
+#endif
+    return DM35425_Trigger_Find_Range(x, from, count, range);
+}
+
+int DM35425_Trigger_Create(DM35425_Trigger **_trig, const struct DM35425_Trigger_Config *config)
+{
+    if (_trig == NULL || config == NULL || config->conditions == NULL || config->num_conditions < 1 ||
+        config->num_conditions > DM35425_TRIGGER_MAX_CONDITIONS || config->post_samples < 1 || config->queue_depth < 1)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    DM35425_Trigger *trig = (DM35425_Trigger *)calloc(1, sizeof(DM35425_Trigger));
+    if (trig == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (int i = 0; i < config->num_conditions; i++)
+    {
+        const struct DM35425_Trigger_Condition *condition = &config->conditions[i];
+        struct DM35425_Trigger_Watch *watch = &trig->watches[i];
+        int32_t level = condition->level;
+
+        if (condition->board < 0 || condition->channel < 0 ||
+            labs(condition->level) > DM35425_TRIGGER_MAX_LEVEL || labs(condition->high) > DM35425_TRIGGER_MAX_LEVEL ||
+            condition->hysteresis < 0 || condition->hysteresis > DM35425_TRIGGER_MAX_LEVEL)
+            goto invalid;
+        watch->condition = *condition;
+        switch (condition->type)
+        {
+        case DM35425_TRIGGER_ABOVE:
+            watch->fire = (struct DM35425_Trigger_Range){level, INT32_MAX, false};
+            break;
+        case DM35425_TRIGGER_BELOW:
+            watch->fire = (struct DM35425_Trigger_Range){INT32_MIN, level, false};
+            break;
+        case DM35425_TRIGGER_RISING:
+            watch->edge = true;
+            watch->arm = (struct DM35425_Trigger_Range){INT32_MIN, level - condition->hysteresis - 1, false};
+            watch->fire = (struct DM35425_Trigger_Range){level, INT32_MAX, false};
+            break;
+        case DM35425_TRIGGER_FALLING:
+            watch->edge = true;
+            watch->arm = (struct DM35425_Trigger_Range){level + condition->hysteresis + 1, INT32_MAX, false};
+            watch->fire = (struct DM35425_Trigger_Range){INT32_MIN, level, false};
+            break;
+        case DM35425_TRIGGER_INSIDE:
+        case DM35425_TRIGGER_OUTSIDE:
+            if (condition->high < level)
+                goto invalid;
+            watch->fire = (struct DM35425_Trigger_Range){level, condition->high, condition->type == DM35425_TRIGGER_OUTSIDE};
+            break;
+        default:
+            goto invalid;
+        }
+    }
+    trig->num_watches = config->num_conditions;
+    trig->pre = config->pre_samples;
+    trig->post = config->post_samples;
+    trig->holdoff = config->holdoff;
+    trig->depth = config->queue_depth;
+#if defined(__x86_64__) || defined(__i386__)
+    enum DM35425_Simd_Isa isa = DM35425_Simd_Best_Isa();
+    trig->wide = (isa == DM35425_SIMD_AVX2 || isa == DM35425_SIMD_AVX512);
+#endif
+    pthread_mutex_init(&trig->lock, NULL);
+    pthread_condattr_t cond_attr; // Get_Event's deadline is on the monotonic clock
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&trig->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    *_trig = trig;
+    return 0;
+
+invalid:
+    free(trig);
+    errno = EINVAL;
+    return -1;
+}
+
+void DM35425_Trigger_Destroy(DM35425_Trigger *trig)
+{
+    if (trig == NULL)
+        return;
+    if (trig->boards != NULL)
+    {
+        for (int b = 0; b < trig->num_boards; b++)
+            free(trig->boards[b].history);
+    }
+    if (trig->event_memory != NULL)
+    {
+        for (size_t i = 0; i < trig->depth; i++)
+            free(trig->event_memory[i]);
+    }
+    pthread_mutex_destroy(&trig->lock);
+    pthread_cond_destroy(&trig->cond);
+    free(trig->boards);
+    free(trig->events);
+    free(trig->event_memory);
+    free(trig);
+}
+
+/**
+ * @brief Stop the trigger with an error and wake the consumer to report it.
+ *
+ * @param trig Trigger.
+ * @param error errno value.
+ */
+static void DM35425_Trigger_Fail(DM35425_Trigger *trig, int error)
+{
+    pthread_mutex_lock(&trig->lock);
+    __atomic_store_n(&trig->error, error, __ATOMIC_RELEASE);
+    pthread_cond_signal(&trig->cond);
+    pthread_mutex_unlock(&trig->lock);
+}
+
+/**
+ * @brief Size the history and the event queue from the first frame.
+ *
+ * @param trig Trigger.
+ * @param num_boards Number of boards.
+ * @param readouts The first frame.
+ * @return int 0 on success, or the errno value to stop with.
+ */
+static int DM35425_Trigger_Setup(DM35425_Trigger *trig, int num_boards, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    for (int i = 0; i < trig->num_watches; i++)
+    {
+        const struct DM35425_Trigger_Condition *condition = &trig->watches[i].condition;
+        if (condition->board >= num_boards || condition->channel >= readouts[condition->board].num_channels)
+            return EINVAL;
+    }
+    trig->boards = (struct DM35425_Trigger_Board *)calloc(num_boards, sizeof(struct DM35425_Trigger_Board));
+    trig->events = (struct DM35425_Trigger_Event *)calloc(trig->depth, sizeof(struct DM35425_Trigger_Event));
+    trig->event_memory = (void **)calloc(trig->depth, sizeof(void *));
+    if (trig->boards == NULL || trig->events == NULL || trig->event_memory == NULL)
+        return ENOMEM;
+    trig->num_boards = num_boards;
+
+    size_t base_len = readouts[0].num_samples * readouts[0].decimation;
+    size_t event_size = num_boards * sizeof(struct DM35425_Trigger_Capture);
+    for (int b = 0; b < num_boards; b++)
+    {
+        struct DM35425_Trigger_Board *board = &trig->boards[b];
+        board->num_channels = readouts[b].num_channels;
+        board->frame_len = readouts[b].num_samples * readouts[b].decimation;
+        if (board->frame_len == 0 || base_len == 0)
+            return EINVAL;
+        board->pre = DM35425_Trigger_Scale(trig->pre, board->frame_len, base_len);
+        board->post = DM35425_Trigger_Scale(trig->post, board->frame_len, base_len);
+        // A capture completes on the first frame past its end, so the history must reach back a window and two frames
+        board->capacity = board->pre + board->post + 2 * board->frame_len + 1;
+        if (posix_memalign((void **)&board->history, 64, board->num_channels * board->capacity * sizeof(int32_t)) != 0)
+        {
+            board->history = NULL;
+            return ENOMEM;
+        }
+        memset(board->history, 0, board->num_channels * board->capacity * sizeof(int32_t));
+        event_size += board->num_channels * (sizeof(int32_t *) + DM35425_TRIGGER_ROUND((board->pre + board->post) * sizeof(int32_t))) +
+                      DM35425_TRIGGER_ROUND(board->num_channels * sizeof(enum DM35425_Input_Ranges));
+    }
+
+    for (size_t i = 0; i < trig->depth; i++)
+    {
+        struct DM35425_Trigger_Event *event = &trig->events[i];
+        char *memory = (char *)calloc(1, event_size);
+        if (memory == NULL)
+            return ENOMEM;
+        trig->event_memory[i] = memory;
+        event->num_boards = num_boards;
+        event->captures = (struct DM35425_Trigger_Capture *)memory;
+        memory += num_boards * sizeof(struct DM35425_Trigger_Capture);
+        for (int b = 0; b < num_boards; b++)
+        {
+            struct DM35425_Trigger_Capture *capture = &event->captures[b];
+            const struct DM35425_Trigger_Board *board = &trig->boards[b];
+            capture->num_channels = board->num_channels;
+            capture->raw = (int32_t **)memory;
+            memory += board->num_channels * sizeof(int32_t *);
+            for (int c = 0; c < board->num_channels; c++)
+            {
+                capture->raw[c] = (int32_t *)memory;
+                memory += DM35425_TRIGGER_ROUND((board->pre + board->post) * sizeof(int32_t));
+            }
+            capture->ranges = (enum DM35425_Input_Ranges *)memory;
+            memory += DM35425_TRIGGER_ROUND(board->num_channels * sizeof(enum DM35425_Input_Ranges));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Append a board's frame to its history.
+ *
+ * @param board Board history.
+ * @param readout The board's readout in the frame.
+ */
+static void DM35425_Trigger_Record(struct DM35425_Trigger_Board *board, const struct DM35425_ADCDMA_Readout *readout)
+{
+    uint64_t start = readout->first_sample * readout->decimation;
+    size_t at = start % board->capacity;
+    size_t first = board->capacity - at < board->frame_len ? board->capacity - at : board->frame_len;
+
+    if (start != board->written)
+        board->valid_from = start;
+    for (int c = 0; c < board->num_channels; c++)
+    {
+        int32_t *history = board->history + c * board->capacity;
+        memcpy(history + at, readout->raw[c], first * sizeof(int32_t));
+        memcpy(history, readout->raw[c] + first, (board->frame_len - first) * sizeof(int32_t));
+    }
+    board->written = start + board->frame_len;
+}
+
+/**
+ * @brief Scan the newest frame for the earliest sample meeting a condition, from the re-arm position on, and make it
+ * the pending event.
+ *
+ * @param trig Trigger.
+ * @param readouts The frame.
+ * @return bool true if a condition was met.
+ */
+static bool DM35425_Trigger_Scan(DM35425_Trigger *trig, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    size_t base_len = trig->boards[0].frame_len;
+    int best = -1;
+    uint64_t best_time = UINT64_MAX; // position of the best hit on board 0
+    uint64_t best_position = 0;      // position of the best hit on its own board
+
+    for (int i = 0; i < trig->num_watches; i++)
+    {
+        struct DM35425_Trigger_Watch *watch = &trig->watches[i];
+        const struct DM35425_Trigger_Board *board = &trig->boards[watch->condition.board];
+        const int32_t *x = readouts[watch->condition.board].raw[watch->condition.channel];
+        uint64_t start = board->written - board->frame_len;
+        uint64_t from = DM35425_Trigger_Scale(trig->rearm, board->frame_len, base_len);
+        size_t count = board->frame_len;
+
+        if (watch->scanned > from)
+            from = watch->scanned;
+        size_t idx = from > start ? from - start : 0;
+        size_t hit = count;
+        if (idx < count && watch->edge && !watch->armed)
+        {
+            size_t armed = DM35425_Trigger_Find(trig, x, idx, count, &watch->arm);
+            watch->armed = armed < count;
+            idx = armed < count ? armed + 1 : count;
+        }
+        if (idx < count)
+            hit = DM35425_Trigger_Find(trig, x, idx, count, &watch->fire);
+        watch->scanned = start + hit;
+        if (hit < count)
+        {
+            uint64_t time = DM35425_Trigger_Scale(start + hit, base_len, board->frame_len);
+            if (time < best_time)
+            {
+                best = i;
+                best_time = time;
+                best_position = start + hit;
+            }
+        }
+    }
+    if (best < 0)
+        return false;
+
+    const struct DM35425_Trigger_Condition *condition = &trig->watches[best].condition;
+    trig->pending = true;
+    trig->pending_condition = best;
+    trig->pending_sample = best_position;
+    trig->pending_timestamp_ns = readouts[condition->board].timestamp_ns;
+    for (int b = 0; b < trig->num_boards; b++)
+    {
+        struct DM35425_Trigger_Board *board = &trig->boards[b];
+        board->trigger = b == condition->board ? best_position : DM35425_Trigger_Scale(best_time, board->frame_len, base_len);
+    }
+    trig->rearm = best_time + trig->post + trig->holdoff;
+    for (int i = 0; i < trig->num_watches; i++)
+    {
+        trig->watches[i].armed = false;
+        trig->watches[i].scanned = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Check whether every board has the post-trigger samples of the pending event.
+ *
+ * @param trig Trigger.
+ * @return bool true once the event can be captured.
+ */
+static bool DM35425_Trigger_Complete(const DM35425_Trigger *trig)
+{
+    for (int b = 0; b < trig->num_boards; b++)
+    {
+        const struct DM35425_Trigger_Board *board = &trig->boards[b];
+        if (board->written < board->trigger + board->post)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copy the windows of the pending event into the next free event and publish it, or drop it if the queue is full.
+ *
+ * @param trig Trigger.
+ * @param readouts The current frame, for the channel numbers and ranges.
+ */
+static void DM35425_Trigger_Publish(DM35425_Trigger *trig, const struct DM35425_ADCDMA_Readout *readouts)
+{
+    uint64_t head = trig->head;
+    uint64_t sequence = trig->sequence++;
+
+    trig->pending = false;
+    if (head - __atomic_load_n(&trig->tail, __ATOMIC_ACQUIRE) == trig->depth)
+    {
+        trig->dropped++;
+        return;
+    }
+
+    struct DM35425_Trigger_Event *event = &trig->events[head % trig->depth];
+    event->sequence = sequence;
+    event->dropped = trig->dropped;
+    trig->dropped = 0;
+    event->condition = trig->pending_condition;
+    event->trigger_sample = trig->pending_sample;
+    event->timestamp_ns = trig->pending_timestamp_ns;
+    event->gap = false;
+    for (int b = 0; b < trig->num_boards; b++)
+    {
+        const struct DM35425_Trigger_Board *board = &trig->boards[b];
+        struct DM35425_Trigger_Capture *capture = &event->captures[b];
+        uint64_t start = board->trigger > board->pre ? board->trigger - board->pre : 0;
+        size_t count = board->trigger + board->post - start;
+        size_t at = start % board->capacity;
+        size_t first = board->capacity - at < count ? board->capacity - at : count;
+
+        if (start < board->valid_from)
+            event->gap = true;
+        capture->channels = readouts[b].channels;
+        memcpy(capture->ranges, readouts[b].ranges, board->num_channels * sizeof(enum DM35425_Input_Ranges));
+        capture->num_samples = count;
+        capture->pre_samples = board->trigger - start;
+        capture->first_sample = start;
+        for (int c = 0; c < board->num_channels; c++)
+        {
+            const int32_t *history = board->history + c * board->capacity;
+            memcpy(capture->raw[c], history + at, first * sizeof(int32_t));
+            memcpy(capture->raw[c] + first, history, (count - first) * sizeof(int32_t));
+        }
+    }
+
+    // Publishing head and checking for a sleeping consumer must not be reordered, see Get_Event
+    __atomic_store_n(&trig->head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&trig->waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&trig->lock);
+        pthread_cond_signal(&trig->cond);
+        pthread_mutex_unlock(&trig->lock);
+    }
+}
+
+/**
+ * @brief Processing stage: record the frame, finish a pending capture, and look for new triggers in the rest of it.
+ *
+ * @param num_boards Number of boards.
+ * @param readouts The frame.
+ * @param ctx The trigger.
+ * @return int 0, frames are never held back.
+ */
+static int DM35425_Trigger_Stage(int num_boards, struct DM35425_ADCDMA_Readout *readouts, void *ctx)
+{
+    DM35425_Trigger *trig = ctx;
+
+    if (__atomic_load_n(&trig->error, __ATOMIC_RELAXED) != 0)
+        return 0;
+    if (trig->num_boards == 0)
+    {
+        int error = DM35425_Trigger_Setup(trig, num_boards, readouts);
+        if (error != 0)
+        {
+            DM35425_Trigger_Fail(trig, error);
+            return 0;
+        }
+    }
+    for (int b = 0; b < num_boards; b++)
+    {
+        if ((size_t)(readouts[b].num_samples * readouts[b].decimation) != trig->boards[b].frame_len)
+        {
+            DM35425_Trigger_Fail(trig, EINVAL);
+            return 0;
+        }
+        DM35425_Trigger_Record(&trig->boards[b], &readouts[b]);
+    }
+    for (;;)
+    {
+        if (trig->pending)
+        {
+            if (!DM35425_Trigger_Complete(trig))
+                break;
+            DM35425_Trigger_Publish(trig, readouts);
+        }
+        if (!DM35425_Trigger_Scan(trig, readouts))
+            break;
+    }
+    return 0;
+}
+
+int DM35425_Trigger_Add_Stage(DM35425_Multiboard_Descriptor *mbd, DM35425_Trigger *trig)
+{
+    if (mbd == NULL || trig == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return DM35425_ADC_Multiboard_Add_Stage(mbd, DM35425_Trigger_Stage, trig);
+}
+
+int DM35425_Trigger_Get_Event(DM35425_Trigger *trig, struct DM35425_Trigger_Event **event, int64_t timeout_ns)
+{
+    if (trig == NULL || event == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    uint64_t tail = trig->tail;
+
+    if (__atomic_load_n(&trig->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        int error = __atomic_load_n(&trig->error, __ATOMIC_ACQUIRE);
+        if (timeout_ns == 0 || error != 0)
+        {
+            errno = error != 0 ? error : EAGAIN;
+            return -1;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        if (timeout_ns > 0)
+        {
+            deadline.tv_sec += timeout_ns / 1000000000LL;
+            deadline.tv_nsec += timeout_ns % 1000000000LL;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        }
+
+        int rc = 0;
+        pthread_mutex_lock(&trig->lock);
+        // Announce the wait before checking head again; Publish stores head before checking waiting
+        __atomic_store_n(&trig->waiting, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&trig->head, __ATOMIC_SEQ_CST) == tail && trig->error == 0 && rc != ETIMEDOUT)
+        {
+            if (timeout_ns < 0)
+                rc = pthread_cond_wait(&trig->cond, &trig->lock);
+            else
+                rc = pthread_cond_timedwait(&trig->cond, &trig->lock, &deadline);
+        }
+        __atomic_store_n(&trig->waiting, 0, __ATOMIC_RELAXED);
+        error = trig->error;
+        pthread_mutex_unlock(&trig->lock);
+
+        if (__atomic_load_n(&trig->head, __ATOMIC_ACQUIRE) == tail)
+        {
+            errno = error != 0 ? error : ETIMEDOUT;
+            return -1;
+        }
+    }
+
+    *event = &trig->events[tail % trig->depth];
+    return 0;
+}
+
+int DM35425_Trigger_Release_Event(DM35425_Trigger *trig)
+{
+    if (trig == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    uint64_t tail = trig->tail;
+
+    if (__atomic_load_n(&trig->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        errno = ENODATA; // nothing to release
+        return -1;
+    }
+    __atomic_store_n(&trig->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
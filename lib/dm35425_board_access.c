@@ -74,6 +74,7 @@ DM35425_Board_Open(uint8_t dev_num, struct DM35425_Board_Descriptor **handle)
 
 	(*handle)->file_descriptor = descriptor;
 	(*handle)->isr = NULL;
+	pthread_mutex_init(&((*handle)->isr_lock), NULL);
 	return 0;
 }
 
@@ -85,6 +86,9 @@ int DM35425_Board_Close(struct DM35425_Board_Descriptor *handle)
 		return -1;
 	}
 
+	free(handle->isr_latency);
+	pthread_mutex_destroy(&(handle->isr_lock));
+
 	if (close(handle->file_descriptor) == -1) {
 		free(handle);
 		return -1;
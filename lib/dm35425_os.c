@@ -21,8 +21,17 @@
 //  license terms listed above.
 //----------------------------------------------------------------------------
 
+#define _GNU_SOURCE
+
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/select.h>
+#include <alloca.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
 #include <pthread.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -39,6 +48,8 @@
 
 #define DEVICE_NAME_PATH_PREFIX "/dev/rtd-dm35425"
 
+#define ONE_SEC_IN_NANO 1000000000UL
+
 
 int DM35425_Dma_Initialize(struct DM35425_Board_Descriptor *handle,
 				const struct DM35425_Function_Block *func_block,
@@ -206,30 +217,128 @@ DM35425_Dma_Write(struct DM35425_Board_Descriptor *handle,
 }
 
 
+/*
+ * RemoveISR() clears the ISR pointer from another thread, so the ISR thread
+ * loads it exactly once before each call.  Returns -1 if the ISR has been
+ * removed.
+ */
+static int
+DM35425_General_Call_ISR(struct DM35425_Board_Descriptor *handle,
+			 struct dm35425_ioctl_interrupt_info_request info)
+{
+	void (*isr) () = __atomic_load_n(&handle->isr, __ATOMIC_ACQUIRE);
+
+	if (isr == NULL) {
+		return -1;
+	}
+
+	(*isr) (info);
+
+	return 0;
+}
+
+
+static int
+DM35425_General_ISR_Installed(struct DM35425_Board_Descriptor *handle)
+{
+	return (__atomic_load_n(&handle->isr, __ATOMIC_ACQUIRE) != NULL);
+}
+
+
 int DM35425_General_RemoveISR(struct DM35425_Board_Descriptor *handle)
 {
 
-	/*
-	 * Check to make sure there exists an ISR to remove
-	 */
+	int result;
 
-	if (!handle->isr) {
-		return -EFAULT;
-	}
+	pthread_mutex_lock(&(handle->isr_lock));
 
 	/*
 	 * Make ISR pointer NULL this will be seen by the thread and is a signal
-	 * for it to quit.
+	 * for it to quit.  Check to make sure there existed an ISR to remove.
 	 */
 
-	handle->isr = NULL;
+	if (__atomic_exchange_n(&handle->isr, NULL, __ATOMIC_ACQ_REL) == NULL) {
+		pthread_mutex_unlock(&(handle->isr_lock));
+		return -EFAULT;
+	}
+
 	/*
 	 * Join back up with ISR thread
 	 */
 
 	ioctl(handle->file_descriptor, DM35425_IOCTL_WAKEUP);
 
-	return pthread_join(handle->pid, NULL);
+	result = pthread_join(handle->pid, NULL);
+
+	pthread_mutex_unlock(&(handle->isr_lock));
+
+	return result;
+}
+
+
+/*
+ * ISR timeout in nanoseconds, 0 if none.  DM35425_General_SetISRTimeout()
+ * may change it while the ISR thread runs.
+ */
+static inline uint64_t
+DM35425_General_ISR_Timeout(struct DM35425_Board_Descriptor *handle)
+{
+	return __atomic_load_n(&handle->isr_timeout_ns, __ATOMIC_ACQUIRE);
+}
+
+
+/*
+ * Convert the time left until the ISR timeout into a select() timeout.
+ * Returns NULL when no timeout is set.
+ */
+static struct timeval *
+DM35425_General_Timeout_Left(struct DM35425_Board_Descriptor *handle,
+			     uint64_t last_activity, struct timeval *timeout)
+{
+	uint64_t timeout_ns = DM35425_General_ISR_Timeout(handle);
+	uint64_t now;
+	uint64_t left = 0;
+
+	if (timeout_ns == 0) {
+		return NULL;
+	}
+
+	now = DM35425_Get_Monotonic_Ns();
+	if (now - last_activity < timeout_ns) {
+		left = timeout_ns - (now - last_activity);
+	}
+
+	timeout->tv_sec = left / ONE_SEC_IN_NANO;
+	timeout->tv_usec = (left % ONE_SEC_IN_NANO + 999) / 1000;
+
+	return timeout;
+}
+
+
+/*
+ * Report that no interrupt arrived within the ISR timeout.  Returns 0 if
+ * the thread should keep waiting and -1 if it should exit.
+ */
+static int
+DM35425_General_Timed_Out(struct DM35425_Board_Descriptor *handle,
+			  uint64_t waited_ns)
+{
+	union dm35425_ioctl_argument ioctl_arg;
+	void (*timeout_fnct) (struct DM35425_Board_Descriptor *, uint64_t) =
+		__atomic_load_n(&handle->isr_timeout, __ATOMIC_ACQUIRE);
+
+	if (timeout_fnct != NULL) {
+		(*timeout_fnct) (handle, waited_ns);
+		return 0;
+	}
+
+	errno = ETIMEDOUT;
+	memset(&ioctl_arg, 0, sizeof(ioctl_arg));
+	ioctl_arg.interrupt.error_occurred = 3;
+	ioctl_arg.interrupt.valid_interrupt = 0;
+	DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
+
+	return -1;
 }
 
 
@@ -242,6 +351,10 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 	struct DM35425_Board_Descriptor *handle;
 	handle = (struct DM35425_Board_Descriptor *) ptr;
 	union dm35425_ioctl_argument ioctl_arg;
+	struct timeval timeout;
+	uint64_t woke_up;
+	uint64_t timeout_ns;
+	uint64_t last_activity = DM35425_Get_Monotonic_Ns();
 
 	while (1) {
 
@@ -262,19 +375,23 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 		FD_SET(handle->file_descriptor, &exception_fds);
 
 		/*
-		 * Wait for the interrupt to happen.  No timeout is given, which means
-		 * the process will not be woken up until either an interrupt occurs or
-		 * a signal is delivered
+		 * Wait for the interrupt to happen.  Unless an ISR timeout is set,
+		 * the process will not be woken up until either an interrupt occurs
+		 * or a signal is delivered
 		 */
 
 		status = select((handle->file_descriptor) + 1,
-				&read_fds, NULL, &exception_fds, NULL);
+				&read_fds, NULL, &exception_fds,
+				DM35425_General_Timeout_Left(handle,
+							     last_activity,
+							     &timeout));
+		woke_up = DM35425_Get_Monotonic_Ns();
 
 		/*
 		 * The isr should be a null pointer if RemoveISR has been called
 		 * This checks if the user has asked the thread to quit.
 		 */
-		if (handle->isr == NULL) {
+		if (!DM35425_General_ISR_Installed(handle)) {
 			break;
 		}
 
@@ -287,12 +404,32 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 			/*
 			 * Some error occurred.
 			 */
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 			ioctl_arg.interrupt.error_occurred = 2;
 			ioctl_arg.interrupt.valid_interrupt = 0;
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 			break;
 		}
 
+		timeout_ns = DM35425_General_ISR_Timeout(handle);
+		if (status == 0 && timeout_ns != 0) {
+
+			/*
+			 * No interrupt within the timeout: the board has stalled
+			 */
+			if (woke_up - last_activity < timeout_ns) {
+				continue;
+			}
+
+			if (DM35425_General_Timed_Out(handle,
+						      woke_up - last_activity) != 0) {
+				break;
+			}
+
+			last_activity = DM35425_Get_Monotonic_Ns();
+			continue;
+		}
+
 		if (status == 0) {
 
 			/*
@@ -300,10 +437,11 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 			 * driver.
 			 */
 
-			errno = -ENODATA;
+			errno = ENODATA;
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 			ioctl_arg.interrupt.error_occurred = 3;
 			ioctl_arg.interrupt.valid_interrupt = 0;
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 			break;
 		}
 		/*
@@ -312,10 +450,11 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 		 */
 
 		if (FD_ISSET(handle->file_descriptor, &exception_fds)) {
-			errno = -EIO;
+			errno = EIO;
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 			ioctl_arg.interrupt.error_occurred = 4;
 			ioctl_arg.interrupt.valid_interrupt = 0;
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 			break;
 		}
 
@@ -329,10 +468,11 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 			/*
 			 * The device file is not readable.  This means something is broken.
 			 */
-			errno = -ENODATA;
+			errno = ENODATA;
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 			ioctl_arg.interrupt.error_occurred = 5;
 			ioctl_arg.interrupt.valid_interrupt = 0;
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 			break;
 		}
 
@@ -340,9 +480,10 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 			  &ioctl_arg);
 
 		if (status != 0) {
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 			ioctl_arg.interrupt.error_occurred = 6;
 			ioctl_arg.interrupt.valid_interrupt = 0;
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 			return handle;
 		}
 
@@ -350,10 +491,15 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
          * As an ioctl call can occur, one more check is needed before calling 
          * the ISR 
          */
-		if (handle->isr == NULL) {
+		if (!DM35425_General_ISR_Installed(handle)) {
             break;
         }
-		(*(handle->isr)) (ioctl_arg.interrupt);
+		if (handle->isr_latency != NULL) {
+			DM35425_Histogram_Record(handle->isr_latency,
+						 DM35425_Get_Monotonic_Ns() - woke_up);
+		}
+		DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
+		last_activity = DM35425_Get_Monotonic_Ns();
 
 		while (ioctl_arg.interrupt.interrupts_remaining > 0) {
 
@@ -366,9 +512,9 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 					&ioctl_arg);
 
 			if (status != 0) {
+				memset(&ioctl_arg, 0, sizeof(ioctl_arg));
 				ioctl_arg.interrupt.error_occurred = 7;
 				ioctl_arg.interrupt.valid_interrupt = 0;
-				ioctl_arg.interrupt.interrupts_remaining = 0;
 
 			}
 
@@ -377,14 +523,14 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
              * calling the ISR 
              */
         
-            if (handle->isr == NULL) {
+            if (!DM35425_General_ISR_Installed(handle)) {
                 break;
             }
 			
 			/*
 			* Call the Interrupt Service Routine and pass through the status
 			*/
-			(*(handle->isr)) (ioctl_arg.interrupt);
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
 		}
 	}
 
@@ -397,52 +543,594 @@ void *DM35425_General_WaitForInterrupt(void *ptr)
 
 
 
+/*
+ * Check the driver interrupt queue without removing anything from it.
+ * Returns 1 if interrupts are queued, 0 if not and -1 on error.  The first
+ * time the driver turns out not to support the status ioctl,
+ * *use_status_ioctl is cleared and a zero-timeout poll() is used from then on.
+ */
+static int
+DM35425_General_Interrupt_Pending(struct DM35425_Board_Descriptor *handle,
+				int *use_status_ioctl)
+{
+	union dm35425_ioctl_argument ioctl_arg;
+	struct pollfd poll_fd;
+
+	if (*use_status_ioctl) {
+		if (ioctl(handle->file_descriptor, DM35425_IOCTL_INTERRUPT_PENDING,
+			  &ioctl_arg) == 0) {
+			return (ioctl_arg.interrupt.interrupts_remaining > 0);
+		}
+
+		if (errno != ENOTTY) {
+			return -1;
+		}
+
+		*use_status_ioctl = 0;
+	}
+
+	poll_fd.fd = handle->file_descriptor;
+	poll_fd.events = POLLIN | POLLPRI;
+	poll_fd.revents = 0;
+
+	if (poll(&poll_fd, 1, 0) < 0) {
+		return -1;
+	}
+
+	/*
+	 * POLLPRI means no IRQ line was allocated to the device
+	 */
+	if (poll_fd.revents & POLLPRI) {
+		errno = EIO;
+		return -1;
+	}
+
+	return ((poll_fd.revents & POLLIN) != 0);
+}
+
+
+void *DM35425_General_PollForInterrupt(void *ptr)
+{
+
+	fd_set read_fds;
+	int status;
+	int pending;
+	int use_status_ioctl = 1;
+	uint64_t wait_start;
+	uint64_t last_empty;
+	uint64_t now;
+	uint64_t timeout_ns;
+	struct timespec sleep_time;
+	struct timeval timeout;
+	struct DM35425_Board_Descriptor *handle;
+	handle = (struct DM35425_Board_Descriptor *) ptr;
+	union dm35425_ioctl_argument ioctl_arg;
+
+	sleep_time.tv_sec = handle->poll_config.sleep_ns / ONE_SEC_IN_NANO;
+	sleep_time.tv_nsec = handle->poll_config.sleep_ns % ONE_SEC_IN_NANO;
+
+	wait_start = DM35425_Get_Monotonic_Ns();
+	last_empty = wait_start;
+
+	while (DM35425_General_ISR_Installed(handle)) {
+
+		pending = DM35425_General_Interrupt_Pending(handle,
+							    &use_status_ioctl);
+
+		if (pending < 0) {
+			memset(&ioctl_arg, 0, sizeof(ioctl_arg));
+			ioctl_arg.interrupt.error_occurred = 2;
+			ioctl_arg.interrupt.valid_interrupt = 0;
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
+			break;
+		}
+
+		if (pending == 0) {
+
+			now = DM35425_Get_Monotonic_Ns();
+			last_empty = now;
+
+			timeout_ns = DM35425_General_ISR_Timeout(handle);
+			if (timeout_ns != 0 && (now - wait_start) >= timeout_ns) {
+				if (DM35425_General_Timed_Out(handle,
+							      now - wait_start) != 0) {
+					break;
+				}
+				wait_start = DM35425_Get_Monotonic_Ns();
+				continue;
+			}
+
+			/*
+			 * Spin phase: check again straight away
+			 */
+			if ((now - wait_start) < handle->poll_config.spin_ns) {
+				continue;
+			}
+
+			/*
+			 * Sleep phase: either nap between checks, or block
+			 * until the driver wakes us.  Errors from select() show
+			 * up on the next status check.
+			 */
+			if (handle->poll_config.sleep_ns != 0) {
+				nanosleep(&sleep_time, NULL);
+			} else {
+				FD_ZERO(&read_fds);
+				FD_SET(handle->file_descriptor, &read_fds);
+				select((handle->file_descriptor) + 1,
+				       &read_fds, NULL, NULL,
+				       DM35425_General_Timeout_Left(handle,
+								    wait_start,
+								    &timeout));
+				last_empty = DM35425_Get_Monotonic_Ns();
+			}
+			continue;
+		}
+
+		/*
+		 * Drain the queue, calling the ISR for every interrupt
+		 */
+		do {
+			status = ioctl(handle->file_descriptor,
+					DM35425_IOCTL_INTERRUPT_GET,
+					&ioctl_arg);
+
+			if (status != 0) {
+				ioctl_arg.interrupt.error_occurred = 6;
+				ioctl_arg.interrupt.valid_interrupt = 0;
+			}
+
+			/*
+			 * As an ioctl call can occur, one more check is needed
+			 * before calling the ISR
+			 */
+			if (!DM35425_General_ISR_Installed(handle)) {
+				break;
+			}
+
+			DM35425_Histogram_Record(handle->isr_latency,
+						 DM35425_Get_Monotonic_Ns() - last_empty);
+
+			DM35425_General_Call_ISR(handle, ioctl_arg.interrupt);
+
+		} while (ioctl_arg.interrupt.interrupts_remaining > 0);
+
+		wait_start = DM35425_Get_Monotonic_Ns();
+		last_empty = wait_start;
+	}
+
+	/*
+	 * Terminate polling thread
+	 */
+
+	return 0;
+}
+
+
+/*
+ * Allocate (or clear) the latency histogram for a board's ISR thread
+ */
+static int
+DM35425_General_Reset_Latency(struct DM35425_Board_Descriptor *handle)
+{
+	if (handle->isr_latency == NULL) {
+		handle->isr_latency = (struct DM35425_Histogram *)
+				malloc(sizeof(struct DM35425_Histogram));
+		if (handle->isr_latency == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	DM35425_Histogram_Reset(handle->isr_latency);
+
+	return 0;
+}
+
+
+void DM35425_ISR_Attr_Init(struct DM35425_ISR_Attr *attr)
+{
+	memset(attr, 0, sizeof(struct DM35425_ISR_Attr));
+	attr->sched_policy = SCHED_OTHER;
+}
+
+
+/*
+ * Layout of the kernel's struct sched_attr, which the C library may not
+ * provide
+ */
+struct DM35425_Sched_Attr {
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+};
+
+
+/*
+ * Startup handshake between DM35425_Thread_Create_RT() and the new thread.
+ * This lives on the creator's stack, so the thread must not touch it once
+ * finished has been set.
+ */
+struct DM35425_Thread_Startup {
+	const struct DM35425_ISR_Attr *attr;
+	int (*setup)(void *);
+	void *(*start_routine)(void *);
+	void *arg;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	int finished;
+	int result;
+};
+
+
+/*
+ * Switch the calling thread to SCHED_DEADLINE
+ */
+static int DM35425_Set_Deadline(const struct DM35425_ISR_Attr *attr)
+{
+#ifdef SYS_sched_setattr
+	struct DM35425_Sched_Attr sched_attr;
+
+	memset(&sched_attr, 0, sizeof(struct DM35425_Sched_Attr));
+	sched_attr.size = sizeof(struct DM35425_Sched_Attr);
+	sched_attr.sched_policy = SCHED_DEADLINE;
+	sched_attr.sched_runtime = attr->deadline_runtime_ns;
+	sched_attr.sched_deadline = attr->deadline_deadline_ns;
+	sched_attr.sched_period = attr->deadline_period_ns;
+
+	if (syscall(SYS_sched_setattr, 0, &sched_attr, 0) != 0) {
+		return errno;
+	}
+
+	return 0;
+#else
+	return ENOSYS;
+#endif
+}
+
+
+/*
+ * Touch the given number of bytes of stack below the caller so that the
+ * pages are mapped before they are needed.
+ */
+static void __attribute__((noinline))
+DM35425_Prefault_Stack(size_t size)
+{
+	volatile unsigned char *stack = alloca(size);
+
+	memset((unsigned char *) stack, 0, size);
+}
+
+
+static void *DM35425_Thread_Start_RT(void *ptr)
+{
+	struct DM35425_Thread_Startup *startup = ptr;
+	void *(*start_routine)(void *) = startup->start_routine;
+	void *arg = startup->arg;
+	int result = 0;
+
+	if (startup->attr->sched_policy == SCHED_DEADLINE) {
+		result = DM35425_Set_Deadline(startup->attr);
+	}
+
+	if (result == 0 && startup->attr->prefault_stack > 0) {
+		DM35425_Prefault_Stack(startup->attr->prefault_stack);
+	}
+
+	if (result == 0 && startup->setup != NULL) {
+		result = startup->setup(arg);
+	}
+
+	pthread_mutex_lock(&startup->lock);
+	startup->result = result;
+	startup->finished = 1;
+	pthread_cond_signal(&startup->done);
+	pthread_mutex_unlock(&startup->lock);
+
+	if (result != 0) {
+		return NULL;
+	}
+
+	return start_routine(arg);
+}
+
+
 int
-DM35425_General_InstallISR(struct DM35425_Board_Descriptor *handle, void (*isr_fnct))
+DM35425_Thread_Create_RT(pthread_t *thread,
+			const struct DM35425_ISR_Attr *attr,
+			int (*setup)(void *),
+			void *(*start_routine)(void *),
+			void *arg)
 {
+	struct DM35425_ISR_Attr defaults;
+	struct DM35425_Thread_Startup startup;
+	struct sched_param param;
+	pthread_attr_t thread_attr;
+	cpu_set_t cpus;
+	size_t stack_size;
+	int result;
+
+	if (attr == NULL) {
+		DM35425_ISR_Attr_Init(&defaults);
+		attr = &defaults;
+	}
+
+	pthread_attr_init(&thread_attr);
+
+	result = 0;
+
+	if (attr->stack_size > 0) {
+		result = pthread_attr_setstacksize(&thread_attr, attr->stack_size);
+	}
+
+	/*
+	 * Prefaulting the whole stack or more would run into the guard page
+	 */
+	if (result == 0 && attr->prefault_stack > 0) {
+		result = pthread_attr_getstacksize(&thread_attr, &stack_size);
+		if (result == 0 && attr->prefault_stack >= stack_size) {
+			result = EINVAL;
+		}
+	}
+
+	if (result == 0 && attr->cpuset != NULL) {
+		result = pthread_attr_setaffinity_np(&thread_attr,
+						     attr->cpusetsize,
+						     attr->cpuset);
+	} else if (result == 0 && attr->poll != NULL && attr->poll->cpu >= 0) {
+
+		/*
+		 * Pin a polling thread before it starts so that it never
+		 * spins on the wrong CPU
+		 */
+		if (attr->poll->cpu >= CPU_SETSIZE) {
+			result = EINVAL;
+		} else {
+			CPU_ZERO(&cpus);
+			CPU_SET(attr->poll->cpu, &cpus);
+			result = pthread_attr_setaffinity_np(&thread_attr,
+							     sizeof(cpu_set_t),
+							     &cpus);
+		}
+	}
+
+	if (result == 0 && (attr->sched_policy == SCHED_FIFO ||
+			    attr->sched_policy == SCHED_RR)) {
+		param.sched_priority = attr->sched_priority;
+		result = pthread_attr_setinheritsched(&thread_attr,
+						      PTHREAD_EXPLICIT_SCHED);
+		if (result == 0) {
+			result = pthread_attr_setschedpolicy(&thread_attr,
+							     attr->sched_policy);
+		}
+		if (result == 0) {
+			result = pthread_attr_setschedparam(&thread_attr, &param);
+		}
+	} else if (result == 0 && attr->sched_policy != SCHED_OTHER &&
+		   attr->sched_policy != SCHED_DEADLINE) {
+		result = EINVAL;
+	}
+
+	if (result == 0 && attr->lock_memory &&
+	    mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		result = errno;
+	}
+
+	if (result != 0) {
+		pthread_attr_destroy(&thread_attr);
+		errno = result;
+		return -1;
+	}
+
+	startup.attr = attr;
+	startup.setup = setup;
+	startup.start_routine = start_routine;
+	startup.arg = arg;
+	startup.finished = 0;
+	startup.result = 0;
+	pthread_mutex_init(&startup.lock, NULL);
+	pthread_cond_init(&startup.done, NULL);
+
+	result = pthread_create(thread, &thread_attr, DM35425_Thread_Start_RT,
+				&startup);
+
+	pthread_attr_destroy(&thread_attr);
+
+	if (result == 0) {
+
+		/*
+		 * Wait for the thread to finish its own set up
+		 */
+		pthread_mutex_lock(&startup.lock);
+		while (!startup.finished) {
+			pthread_cond_wait(&startup.done, &startup.lock);
+		}
+		pthread_mutex_unlock(&startup.lock);
+
+		result = startup.result;
+		if (result != 0) {
+			pthread_join(*thread, NULL);
+		}
+	}
+
+	pthread_cond_destroy(&startup.done);
+	pthread_mutex_destroy(&startup.lock);
+
+	if (result != 0) {
+		errno = result;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int
+DM35425_General_InstallISR_Attr(struct DM35425_Board_Descriptor *handle,
+				void (*isr_fnct),
+				const struct DM35425_ISR_Attr *attr)
+{
+	pthread_mutex_lock(&(handle->isr_lock));
+
 	/*
 	 * Check for ISR already installed
 	 */
 
-	if (handle->isr != NULL) {
+	if (DM35425_General_ISR_Installed(handle)) {
+		pthread_mutex_unlock(&(handle->isr_lock));
 		return -EBUSY;
 	}
 
+	if (DM35425_General_Reset_Latency(handle) != 0) {
+		pthread_mutex_unlock(&(handle->isr_lock));
+		return -1;
+	}
+
+	if (attr != NULL && attr->poll != NULL) {
+		handle->poll_config = *(attr->poll);
+	}
+
 	/*
 	 * Set devices isr to the passed userspace isr
 	 */
 
-	handle->isr = isr_fnct;
+	__atomic_store_n(&handle->isr, isr_fnct, __ATOMIC_RELEASE);
 
 	/*
 	 * Start the thread to wait for the interrupt
 	 */
 
-	if (pthread_create
-		(&(handle->pid), NULL, DM35425_General_WaitForInterrupt,
-		 handle) != 0) {
+	if (DM35425_Thread_Create_RT(&(handle->pid), attr, NULL,
+				     (attr != NULL && attr->poll != NULL) ?
+					DM35425_General_PollForInterrupt :
+					DM35425_General_WaitForInterrupt,
+				     handle) != 0) {
+		__atomic_store_n(&handle->isr, NULL, __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&(handle->isr_lock));
+		return -1;
+	}
+
+	pthread_mutex_unlock(&(handle->isr_lock));
+
+	return 0;
+}
+
+
+int
+DM35425_General_InstallISR(struct DM35425_Board_Descriptor *handle, void (*isr_fnct))
+{
+	int result;
+
+	result = DM35425_General_InstallISR_Attr(handle, isr_fnct, NULL);
+
+	if (result == -1) {
 		errno = EFAULT;
+	}
+
+	return result;
+}
+
+
+int
+DM35425_General_InstallISR_Polled(struct DM35425_Board_Descriptor *handle,
+				void (*isr_fnct),
+				const struct DM35425_ISR_Poll_Config *poll_config)
+{
+	struct DM35425_ISR_Attr attr;
+
+	if (poll_config == NULL) {
+		errno = EINVAL;
 		return -1;
 	}
 
+	DM35425_ISR_Attr_Init(&attr);
+	attr.poll = poll_config;
+
+	return DM35425_General_InstallISR_Attr(handle, isr_fnct, &attr);
+}
+
+
+int
+DM35425_General_SetISRTimeout(struct DM35425_Board_Descriptor *handle,
+			      uint64_t timeout_ns,
+			      void (*timeout_fnct) (struct DM35425_Board_Descriptor *,
+						    uint64_t))
+{
+	if (handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/*
+	 * The ISR thread may be reading these; it loads the timeout first, so
+	 * store the function before it
+	 */
+	__atomic_store_n(&handle->isr_timeout, timeout_fnct, __ATOMIC_RELEASE);
+	__atomic_store_n(&handle->isr_timeout_ns, timeout_ns, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+
+int
+DM35425_General_GetISRLatency(struct DM35425_Board_Descriptor *handle,
+			struct DM35425_Latency_Summary *summary)
+{
+	if (handle->isr_latency == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	DM35425_Histogram_Summarize(handle->isr_latency, summary);
+
 	return 0;
 }
 
+
 int 
 DM35425_General_SetISRPriority(struct DM35425_Board_Descriptor *handle,
 				   int priority)
 {
 	struct sched_param param;
+	int result;
 
 	param.sched_priority = priority;
-	if (handle->isr == NULL) {
-		errno = -EFAULT;
+	if (!DM35425_General_ISR_Installed(handle)) {
+		errno = EFAULT;
 		return -1;
 	}
 
-	if (getuid() != 0) {
-		return 0;
+	result = pthread_setschedparam(handle->pid, SCHED_FIFO, &param);
+	if (result != 0) {
+		errno = result;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int DM35425_General_SetISRAffinity(struct DM35425_Board_Descriptor *handle,
+				   size_t cpusetsize,
+				   const cpu_set_t *cpuset)
+{
+	int result;
+
+	if (!DM35425_General_ISR_Installed(handle)) {
+		errno = EFAULT;
+		return -1;
 	}
 
-	return pthread_setschedparam(handle->pid, SCHED_FIFO, &param);
+	result = pthread_setaffinity_np(handle->pid, cpusetsize, cpuset);
+	if (result != 0) {
+		errno = result;
+		return -1;
+	}
+
+	return 0;
 }
@@ -0,0 +1,981 @@
+/**
+	@file
+
+	@brief
+		DM35425 ADC bulk sample conversion and statistics source code
+
+		Every input range has an LSB of 5 * 2^-n volts, so for any sample
+		smaller than 2^21 in magnitude the single-precision product computed
+		here is exact and matches DM35425_Adc_Sample_To_Volts() bit for bit.
+*/
+
+//----------------------------------------------------------------------------
+//  COPYRIGHT (C) RTD EMBEDDED TECHNOLOGIES, INC.  ALL RIGHTS RESERVED.
+//
+//  This software package is dual-licensed.  Source code that is compiled for
+//  kernel mode execution is licensed under the GNU General Public License
+//  version 2.  For a copy of this license, refer to the file
+//  LICENSE_GPLv2.TXT (which should be included with this software) or contact
+//  the Free Software Foundation.  Source code that is compiled for user mode
+//  execution is licensed under the RTD End-User Software License Agreement.
+//  For a copy of this license, refer to LICENSE.TXT or contact RTD Embedded
+//  Technologies, Inc.  Using this software indicates agreement with the
+//  license terms listed above.
+//----------------------------------------------------------------------------
+
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "dm35425_util_library.h"
+#include "dm35425_adc_library.h"
+
+
+/******************************************************************************
+ * Conversion parameters for one input range
+ *****************************************************************************/
+struct DM35425_Adc_Conversion {
+	float lsb;
+	int32_t min;
+	int32_t max;
+};
+
+
+/*
+ * Look up the LSB and valid sample range for an input range once, instead of
+ * once per sample.
+ */
+static int
+DM35425_Adc_Get_Conversion(enum DM35425_Input_Ranges input_range,
+			   struct DM35425_Adc_Conversion *conv)
+{
+	switch (input_range) {
+	case DM35425_ADC_RNG_BIPOLAR_10V:
+		conv->lsb = (float) DM35425_ADC_RNG_20_LSB;
+		break;
+	case DM35425_ADC_RNG_BIPOLAR_5V:
+	case DM35425_ADC_RNG_UNIPOLAR_10V:
+		conv->lsb = (float) DM35425_ADC_RNG_10_LSB;
+		break;
+	case DM35425_ADC_RNG_BIPOLAR_2_5V:
+	case DM35425_ADC_RNG_UNIPOLAR_5V:
+		conv->lsb = (float) DM35425_ADC_RNG_5_LSB;
+		break;
+	case DM35425_ADC_RNG_BIPOLAR_1_25V:
+	case DM35425_ADC_RNG_UNIPOLAR_2_5V:
+		conv->lsb = (float) DM35425_ADC_RNG_2_5_LSB;
+		break;
+	case DM35425_ADC_RNG_BIPOLAR_625mV:
+	case DM35425_ADC_RNG_UNIPOLAR_1_25V:
+		conv->lsb = (float) DM35425_ADC_RNG_1_25_LSB;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+	switch (input_range) {
+	case DM35425_ADC_RNG_UNIPOLAR_10V:
+	case DM35425_ADC_RNG_UNIPOLAR_5V:
+	case DM35425_ADC_RNG_UNIPOLAR_2_5V:
+	case DM35425_ADC_RNG_UNIPOLAR_1_25V:
+		conv->min = DM35425_ADC_UNIPOLAR_MIN;
+		conv->max = DM35425_ADC_UNIPOLAR_MAX;
+		break;
+	default:
+		conv->min = DM35425_ADC_BIPOLAR_MIN;
+		conv->max = DM35425_ADC_BIPOLAR_MAX;
+		break;
+	}
+
+	return 0;
+}
+
+
+/******************************************************************************
+ * Kernels.  Each converts count samples and returns non-zero if any sample
+ * was outside the valid range.
+ *****************************************************************************/
+
+static int
+DM35425_Adc_Convert_Scalar(const struct DM35425_Adc_Conversion *conv,
+			   const int32_t *samples, float *volts, size_t count)
+{
+	size_t i;
+	int out_of_range = 0;
+
+	for (i = 0; i < count; i++) {
+		out_of_range |= (samples[i] < conv->min) | (samples[i] > conv->max);
+		volts[i] = (float) samples[i] * conv->lsb;
+	}
+
+	return out_of_range;
+}
+
+
+/******************************************************************************
+ * Statistics kernels.  Each adds count samples to the minimum, maximum, sum
+ * and sum of squares in stats.  Sums are kept in 64 bits, which is exact for
+ * any number of samples in the ADC range a program will see.
+ *****************************************************************************/
+
+static void
+DM35425_Adc_Stats_Scalar(const int32_t *samples, size_t count,
+			 struct DM35425_Adc_Sample_Stats *stats)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		int64_t x = samples[i];
+
+		if (samples[i] < stats->min) {
+			stats->min = samples[i];
+		}
+		if (samples[i] > stats->max) {
+			stats->max = samples[i];
+		}
+		stats->sum += x;
+		stats->sum_squares += (uint64_t) (x * x);
+	}
+}
+
+
+/******************************************************************************
+ * Interleaving kernels.  Each converts count samples of num_channels channels
+ * into volts[sample * stride + channel] and returns non-zero if any sample was
+ * outside the valid range.  The vector kernels convert a square block of
+ * channels by samples and transpose it in registers, so every sample is read
+ * and written exactly once.
+ *****************************************************************************/
+
+/*
+ * Samples per block of the scalar kernel.  The output rows of a block stay in
+ * the cache while each channel is written into them.
+ */
+#define DM35425_ADC_INTERLEAVE_BLOCK	64
+
+
+/*
+ * Convert channels first_channel to first_channel + num_channels - 1, samples
+ * first_sample onwards.  Also does the edges the vector kernels leave over.
+ */
+static int
+DM35425_Adc_Interleave_Scalar(const enum DM35425_Input_Ranges *input_ranges,
+			      const int32_t *const *samples, float *volts,
+			      size_t stride, int first_channel,
+			      int num_channels, size_t first_sample,
+			      size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	size_t block, end, i;
+	int channel;
+	int out_of_range = 0;
+
+	for (block = first_sample; block < first_sample + count;
+	     block += DM35425_ADC_INTERLEAVE_BLOCK) {
+
+		end = block + DM35425_ADC_INTERLEAVE_BLOCK;
+		if (end > first_sample + count) {
+			end = first_sample + count;
+		}
+
+		for (channel = first_channel;
+		     channel < first_channel + num_channels; channel++) {
+
+			DM35425_Adc_Get_Conversion(input_ranges[channel], &conv);
+
+			for (i = block; i < end; i++) {
+				int32_t x = samples[channel][i];
+
+				out_of_range |= (x < conv.min) | (x > conv.max);
+				volts[i * stride + channel] = (float) x * conv.lsb;
+			}
+		}
+	}
+
+	return out_of_range;
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static int
+DM35425_Adc_Convert_Sse2(const struct DM35425_Adc_Conversion *conv,
+			 const int32_t *samples, float *volts, size_t count)
+{
+	const __m128 lsb = _mm_set1_ps(conv->lsb);
+	const __m128i min = _mm_set1_epi32(conv->min);
+	const __m128i max = _mm_set1_epi32(conv->max);
+	__m128i bad = _mm_setzero_si128();
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *) &samples[i]);
+
+		bad = _mm_or_si128(bad, _mm_cmplt_epi32(x, min));
+		bad = _mm_or_si128(bad, _mm_cmpgt_epi32(x, max));
+		_mm_storeu_ps(&volts[i], _mm_mul_ps(_mm_cvtepi32_ps(x), lsb));
+	}
+
+	return _mm_movemask_epi8(bad) |
+		DM35425_Adc_Convert_Scalar(conv, &samples[i], &volts[i],
+					   count - i);
+}
+
+
+__attribute__((target("avx2")))
+static int
+DM35425_Adc_Convert_Avx2(const struct DM35425_Adc_Conversion *conv,
+			 const int32_t *samples, float *volts, size_t count)
+{
+	const __m256 lsb = _mm256_set1_ps(conv->lsb);
+	const __m256i min = _mm256_set1_epi32(conv->min);
+	const __m256i max = _mm256_set1_epi32(conv->max);
+	__m256i lo = max;
+	__m256i hi = min;
+	size_t i;
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) &samples[i]);
+
+		lo = _mm256_min_epi32(lo, x);
+		hi = _mm256_max_epi32(hi, x);
+		_mm256_storeu_ps(&volts[i],
+				 _mm256_mul_ps(_mm256_cvtepi32_ps(x), lsb));
+	}
+
+	return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi32(min, lo),
+						    _mm256_cmpgt_epi32(hi, max))) |
+		DM35425_Adc_Convert_Scalar(conv, &samples[i], &volts[i],
+					   count - i);
+}
+
+
+__attribute__((target("avx512f")))
+static int
+DM35425_Adc_Convert_Avx512(const struct DM35425_Adc_Conversion *conv,
+			   const int32_t *samples, float *volts, size_t count)
+{
+	const __m512 lsb = _mm512_set1_ps(conv->lsb);
+	const __m512i min = _mm512_set1_epi32(conv->min);
+	const __m512i max = _mm512_set1_epi32(conv->max);
+	__mmask16 bad = 0;
+	size_t i;
+
+	for (i = 0; i + 16 <= count; i += 16) {
+		__m512i x = _mm512_loadu_si512((const void *) &samples[i]);
+
+		bad |= _mm512_cmplt_epi32_mask(x, min);
+		bad |= _mm512_cmpgt_epi32_mask(x, max);
+		_mm512_storeu_ps(&volts[i],
+				 _mm512_mul_ps(_mm512_cvtepi32_ps(x), lsb));
+	}
+
+	/*
+	 * The tail is done with a masked load and store
+	 */
+	if (i < count) {
+		__mmask16 tail = (__mmask16) ((1U << (count - i)) - 1);
+		__m512i x = _mm512_maskz_loadu_epi32(tail, &samples[i]);
+
+		bad |= _mm512_mask_cmplt_epi32_mask(tail, x, min);
+		bad |= _mm512_mask_cmpgt_epi32_mask(tail, x, max);
+		_mm512_mask_storeu_ps(&volts[i], tail,
+				      _mm512_mul_ps(_mm512_cvtepi32_ps(x), lsb));
+	}
+
+	return (bad != 0);
+}
+
+
+__attribute__((target("sse2")))
+static int
+DM35425_Adc_Interleave_Sse2(const enum DM35425_Input_Ranges *input_ranges,
+			    const int32_t *const *samples, float *volts,
+			    size_t stride, int num_channels, size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	__m128 lsb[4];
+	__m128i min[4];
+	__m128i max[4];
+	__m128 row[4];
+	__m128i bad = _mm_setzero_si128();
+	int out_of_range = 0;
+	int channel, k;
+	size_t i;
+
+	for (channel = 0; channel + 4 <= num_channels; channel += 4) {
+
+		for (k = 0; k < 4; k++) {
+			DM35425_Adc_Get_Conversion(input_ranges[channel + k],
+						   &conv);
+			lsb[k] = _mm_set1_ps(conv.lsb);
+			min[k] = _mm_set1_epi32(conv.min);
+			max[k] = _mm_set1_epi32(conv.max);
+		}
+
+		for (i = 0; i + 4 <= count; i += 4) {
+			for (k = 0; k < 4; k++) {
+				__m128i x = _mm_loadu_si128((const __m128i *)
+							    &samples[channel + k][i]);
+
+				bad = _mm_or_si128(bad, _mm_cmplt_epi32(x, min[k]));
+				bad = _mm_or_si128(bad, _mm_cmpgt_epi32(x, max[k]));
+				row[k] = _mm_mul_ps(_mm_cvtepi32_ps(x), lsb[k]);
+			}
+
+			_MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+
+			for (k = 0; k < 4; k++) {
+				_mm_storeu_ps(&volts[(i + k) * stride + channel],
+					      row[k]);
+			}
+		}
+
+		out_of_range |= DM35425_Adc_Interleave_Scalar(input_ranges,
+							      samples, volts,
+							      stride, channel,
+							      4, i, count - i);
+	}
+
+	return _mm_movemask_epi8(bad) | out_of_range |
+		DM35425_Adc_Interleave_Scalar(input_ranges, samples, volts,
+					      stride, channel,
+					      num_channels - channel, 0, count);
+}
+
+
+/*
+ * Transpose eight rows of eight floats.
+ */
+__attribute__((target("avx2")))
+static inline void
+DM35425_Adc_Transpose8_Avx2(__m256 row[8])
+{
+	__m256 t0 = _mm256_unpacklo_ps(row[0], row[1]);
+	__m256 t1 = _mm256_unpackhi_ps(row[0], row[1]);
+	__m256 t2 = _mm256_unpacklo_ps(row[2], row[3]);
+	__m256 t3 = _mm256_unpackhi_ps(row[2], row[3]);
+	__m256 t4 = _mm256_unpacklo_ps(row[4], row[5]);
+	__m256 t5 = _mm256_unpackhi_ps(row[4], row[5]);
+	__m256 t6 = _mm256_unpacklo_ps(row[6], row[7]);
+	__m256 t7 = _mm256_unpackhi_ps(row[6], row[7]);
+	__m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	row[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+	row[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+	row[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+	row[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+	row[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+	row[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+	row[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+	row[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+
+__attribute__((target("avx2")))
+static int
+DM35425_Adc_Interleave_Avx2(const enum DM35425_Input_Ranges *input_ranges,
+			    const int32_t *const *samples, float *volts,
+			    size_t stride, int num_channels, size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	__m256 lsb[8];
+	__m256i min[8];
+	__m256i max[8];
+	__m256 row[8];
+	__m256i bad = _mm256_setzero_si256();
+	int out_of_range = 0;
+	int channel, k;
+	size_t i;
+
+	for (channel = 0; channel + 8 <= num_channels; channel += 8) {
+
+		for (k = 0; k < 8; k++) {
+			DM35425_Adc_Get_Conversion(input_ranges[channel + k],
+						   &conv);
+			lsb[k] = _mm256_set1_ps(conv.lsb);
+			min[k] = _mm256_set1_epi32(conv.min);
+			max[k] = _mm256_set1_epi32(conv.max);
+		}
+
+		for (i = 0; i + 8 <= count; i += 8) {
+			for (k = 0; k < 8; k++) {
+				__m256i x = _mm256_loadu_si256((const __m256i *)
+							       &samples[channel + k][i]);
+
+				bad = _mm256_or_si256(bad,
+						      _mm256_cmpgt_epi32(min[k], x));
+				bad = _mm256_or_si256(bad,
+						      _mm256_cmpgt_epi32(x, max[k]));
+				row[k] = _mm256_mul_ps(_mm256_cvtepi32_ps(x),
+						       lsb[k]);
+			}
+
+			DM35425_Adc_Transpose8_Avx2(row);
+
+			for (k = 0; k < 8; k++) {
+				_mm256_storeu_ps(&volts[(i + k) * stride + channel],
+						 row[k]);
+			}
+		}
+
+		out_of_range |= DM35425_Adc_Interleave_Scalar(input_ranges,
+							      samples, volts,
+							      stride, channel,
+							      8, i, count - i);
+	}
+
+	/*
+	 * Four to seven channels left over still fill half a register
+	 */
+	if (num_channels - channel >= 4) {
+		const int32_t *const *rest = &samples[channel];
+
+		out_of_range |= DM35425_Adc_Interleave_Sse2(&input_ranges[channel],
+							    rest,
+							    &volts[channel],
+							    stride,
+							    num_channels - channel,
+							    count);
+		channel = num_channels;
+	}
+
+	return _mm256_movemask_epi8(bad) | out_of_range |
+		DM35425_Adc_Interleave_Scalar(input_ranges, samples, volts,
+					      stride, channel,
+					      num_channels - channel, 0, count);
+}
+
+
+__attribute__((target("sse2")))
+static void
+DM35425_Adc_Stats_Sse2(const int32_t *samples, size_t count,
+		       struct DM35425_Adc_Sample_Stats *stats)
+{
+	__m128i lo = _mm_set1_epi32(stats->min);
+	__m128i hi = _mm_set1_epi32(stats->max);
+	__m128i sum = _mm_setzero_si128();
+	__m128i squares = _mm_setzero_si128();
+	int32_t lanes_min[4], lanes_max[4];
+	int64_t lanes[2];
+	size_t i;
+	int k;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *) &samples[i]);
+		__m128i sign = _mm_srai_epi32(x, 31);
+		__m128i magnitude = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+		__m128i less = _mm_cmplt_epi32(x, lo);
+		__m128i more = _mm_cmpgt_epi32(x, hi);
+
+		/*
+		 * SSE2 has no 32-bit minimum or maximum, so select by mask
+		 */
+		lo = _mm_or_si128(_mm_and_si128(less, x),
+				  _mm_andnot_si128(less, lo));
+		hi = _mm_or_si128(_mm_and_si128(more, x),
+				  _mm_andnot_si128(more, hi));
+
+		sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(x, sign));
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(x, sign));
+
+		/*
+		 * SSE2 only multiplies unsigned 32-bit lanes into 64 bits, so
+		 * square the magnitude
+		 */
+		squares = _mm_add_epi64(squares,
+					_mm_mul_epu32(magnitude, magnitude));
+		magnitude = _mm_srli_epi64(magnitude, 32);
+		squares = _mm_add_epi64(squares,
+					_mm_mul_epu32(magnitude, magnitude));
+	}
+
+	_mm_storeu_si128((__m128i *) lanes_min, lo);
+	_mm_storeu_si128((__m128i *) lanes_max, hi);
+	for (k = 0; k < 4; k++) {
+		if (lanes_min[k] < stats->min) {
+			stats->min = lanes_min[k];
+		}
+		if (lanes_max[k] > stats->max) {
+			stats->max = lanes_max[k];
+		}
+	}
+	_mm_storeu_si128((__m128i *) lanes, sum);
+	stats->sum += lanes[0] + lanes[1];
+	_mm_storeu_si128((__m128i *) lanes, squares);
+	stats->sum_squares += (uint64_t) lanes[0] + (uint64_t) lanes[1];
+
+	DM35425_Adc_Stats_Scalar(&samples[i], count - i, stats);
+}
+
+
+__attribute__((target("avx2")))
+static void
+DM35425_Adc_Stats_Avx2(const int32_t *samples, size_t count,
+		       struct DM35425_Adc_Sample_Stats *stats)
+{
+	__m256i lo = _mm256_set1_epi32(stats->min);
+	__m256i hi = _mm256_set1_epi32(stats->max);
+	__m256i sum = _mm256_setzero_si256();
+	__m256i squares = _mm256_setzero_si256();
+	int32_t lanes_min[8], lanes_max[8];
+	int64_t lanes[4];
+	size_t i;
+	int k;
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) &samples[i]);
+		__m256i odd = _mm256_srli_epi64(x, 32);
+
+		lo = _mm256_min_epi32(lo, x);
+		hi = _mm256_max_epi32(hi, x);
+		sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(
+					       _mm256_castsi256_si128(x)));
+		sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(
+					       _mm256_extracti128_si256(x, 1)));
+
+		/*
+		 * The signed multiply squares the even lanes; shifting brings
+		 * the odd lanes down
+		 */
+		squares = _mm256_add_epi64(squares, _mm256_mul_epi32(x, x));
+		squares = _mm256_add_epi64(squares,
+					   _mm256_mul_epi32(odd, odd));
+	}
+
+	_mm256_storeu_si256((__m256i *) lanes_min, lo);
+	_mm256_storeu_si256((__m256i *) lanes_max, hi);
+	for (k = 0; k < 8; k++) {
+		if (lanes_min[k] < stats->min) {
+			stats->min = lanes_min[k];
+		}
+		if (lanes_max[k] > stats->max) {
+			stats->max = lanes_max[k];
+		}
+	}
+	_mm256_storeu_si256((__m256i *) lanes, sum);
+	stats->sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	_mm256_storeu_si256((__m256i *) lanes, squares);
+	stats->sum_squares += (uint64_t) lanes[0] + (uint64_t) lanes[1] +
+			      (uint64_t) lanes[2] + (uint64_t) lanes[3];
+
+	DM35425_Adc_Stats_Scalar(&samples[i], count - i, stats);
+}
+
+#endif
+
+
+#if defined(__aarch64__)
+
+static int
+DM35425_Adc_Convert_Neon(const struct DM35425_Adc_Conversion *conv,
+			 const int32_t *samples, float *volts, size_t count)
+{
+	const int32x4_t min = vdupq_n_s32(conv->min);
+	const int32x4_t max = vdupq_n_s32(conv->max);
+	int32x4_t lo = max;
+	int32x4_t hi = min;
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		int32x4_t x = vld1q_s32(&samples[i]);
+
+		lo = vminq_s32(lo, x);
+		hi = vmaxq_s32(hi, x);
+		vst1q_f32(&volts[i], vmulq_n_f32(vcvtq_f32_s32(x), conv->lsb));
+	}
+
+	return (vminvq_s32(lo) < conv->min) | (vmaxvq_s32(hi) > conv->max) |
+		DM35425_Adc_Convert_Scalar(conv, &samples[i], &volts[i],
+					   count - i);
+}
+
+
+static int
+DM35425_Adc_Interleave_Neon(const enum DM35425_Input_Ranges *input_ranges,
+			    const int32_t *const *samples, float *volts,
+			    size_t stride, int num_channels, size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	float lsb[4];
+	int32x4_t min[4];
+	int32x4_t max[4];
+	float32x4_t row[4];
+	uint32x4_t bad = vdupq_n_u32(0);
+	int out_of_range = 0;
+	int channel, k;
+	size_t i;
+
+	for (channel = 0; channel + 4 <= num_channels; channel += 4) {
+
+		for (k = 0; k < 4; k++) {
+			DM35425_Adc_Get_Conversion(input_ranges[channel + k],
+						   &conv);
+			lsb[k] = conv.lsb;
+			min[k] = vdupq_n_s32(conv.min);
+			max[k] = vdupq_n_s32(conv.max);
+		}
+
+		for (i = 0; i + 4 <= count; i += 4) {
+			float32x4x2_t lo, hi;
+
+			for (k = 0; k < 4; k++) {
+				int32x4_t x = vld1q_s32(&samples[channel + k][i]);
+
+				bad = vorrq_u32(bad, vcltq_s32(x, min[k]));
+				bad = vorrq_u32(bad, vcgtq_s32(x, max[k]));
+				row[k] = vmulq_n_f32(vcvtq_f32_s32(x), lsb[k]);
+			}
+
+			lo = vtrnq_f32(row[0], row[1]);
+			hi = vtrnq_f32(row[2], row[3]);
+
+			vst1q_f32(&volts[i * stride + channel],
+				  vcombine_f32(vget_low_f32(lo.val[0]),
+					       vget_low_f32(hi.val[0])));
+			vst1q_f32(&volts[(i + 1) * stride + channel],
+				  vcombine_f32(vget_low_f32(lo.val[1]),
+					       vget_low_f32(hi.val[1])));
+			vst1q_f32(&volts[(i + 2) * stride + channel],
+				  vcombine_f32(vget_high_f32(lo.val[0]),
+					       vget_high_f32(hi.val[0])));
+			vst1q_f32(&volts[(i + 3) * stride + channel],
+				  vcombine_f32(vget_high_f32(lo.val[1]),
+					       vget_high_f32(hi.val[1])));
+		}
+
+		out_of_range |= DM35425_Adc_Interleave_Scalar(input_ranges,
+							      samples, volts,
+							      stride, channel,
+							      4, i, count - i);
+	}
+
+	return (vmaxvq_u32(bad) != 0) | out_of_range |
+		DM35425_Adc_Interleave_Scalar(input_ranges, samples, volts,
+					      stride, channel,
+					      num_channels - channel, 0, count);
+}
+
+
+static void
+DM35425_Adc_Stats_Neon(const int32_t *samples, size_t count,
+		       struct DM35425_Adc_Sample_Stats *stats)
+{
+	int32x4_t lo = vdupq_n_s32(stats->min);
+	int32x4_t hi = vdupq_n_s32(stats->max);
+	int64x2_t sum = vdupq_n_s64(0);
+	int64x2_t squares = vdupq_n_s64(0);
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		int32x4_t x = vld1q_s32(&samples[i]);
+
+		lo = vminq_s32(lo, x);
+		hi = vmaxq_s32(hi, x);
+		sum = vpadalq_s32(sum, x);
+		squares = vmlal_s32(squares, vget_low_s32(x), vget_low_s32(x));
+		squares = vmlal_high_s32(squares, x, x);
+	}
+
+	if (vminvq_s32(lo) < stats->min) {
+		stats->min = vminvq_s32(lo);
+	}
+	if (vmaxvq_s32(hi) > stats->max) {
+		stats->max = vmaxvq_s32(hi);
+	}
+	stats->sum += vaddvq_s64(sum);
+	stats->sum_squares += (uint64_t) vaddvq_s64(squares);
+
+	DM35425_Adc_Stats_Scalar(&samples[i], count - i, stats);
+}
+
+#endif
+
+
+/******************************************************************************
+ * ADC Bulk Conversion Functions
+ *****************************************************************************/
+
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Bulk_Isa(enum DM35425_Simd_Isa isa,
+					  enum DM35425_Input_Ranges input_range,
+					  const int32_t *samples,
+					  float *volts,
+					  size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	int out_of_range;
+
+	if (DM35425_Adc_Get_Conversion(input_range, &conv) != 0) {
+		return -1;
+	}
+
+	if (!DM35425_Simd_Isa_Supported(isa)) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+	case DM35425_SIMD_SSE2:
+		out_of_range = DM35425_Adc_Convert_Sse2(&conv, samples, volts,
+							count);
+		break;
+	case DM35425_SIMD_AVX2:
+		out_of_range = DM35425_Adc_Convert_Avx2(&conv, samples, volts,
+							count);
+		break;
+	case DM35425_SIMD_AVX512:
+		out_of_range = DM35425_Adc_Convert_Avx512(&conv, samples, volts,
+							  count);
+		break;
+#endif
+#if defined(__aarch64__)
+	case DM35425_SIMD_NEON:
+		out_of_range = DM35425_Adc_Convert_Neon(&conv, samples, volts,
+							count);
+		break;
+#endif
+	default:
+		out_of_range = DM35425_Adc_Convert_Scalar(&conv, samples, volts,
+							  count);
+		break;
+	}
+
+	if (out_of_range) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Bulk(enum DM35425_Input_Ranges input_range,
+				      const int32_t *samples,
+				      float *volts,
+				      size_t count)
+{
+	return DM35425_Adc_Samples_To_Volts_Bulk_Isa(DM35425_Simd_Best_Isa(),
+						     input_range, samples,
+						     volts, count);
+}
+
+
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Interleaved_Isa(
+				enum DM35425_Simd_Isa isa,
+				int num_channels,
+				const enum DM35425_Input_Ranges *input_ranges,
+				const int32_t *const *samples,
+				float *volts,
+				size_t stride,
+				size_t count)
+{
+	struct DM35425_Adc_Conversion conv;
+	int out_of_range;
+	int channel;
+
+	if (num_channels < 0 || stride < (size_t) num_channels) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (channel = 0; channel < num_channels; channel++) {
+		if (DM35425_Adc_Get_Conversion(input_ranges[channel], &conv) != 0) {
+			return -1;
+		}
+	}
+
+	if (!DM35425_Simd_Isa_Supported(isa)) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+	case DM35425_SIMD_SSE2:
+		out_of_range = DM35425_Adc_Interleave_Sse2(input_ranges, samples,
+							   volts, stride,
+							   num_channels, count);
+		break;
+	/*
+	 * A 16 x 16 transpose costs more shuffles than it saves, so AVX-512
+	 * uses the AVX2 kernel.
+	 */
+	case DM35425_SIMD_AVX2:
+	case DM35425_SIMD_AVX512:
+		out_of_range = DM35425_Adc_Interleave_Avx2(input_ranges, samples,
+							   volts, stride,
+							   num_channels, count);
+		break;
+#endif
+#if defined(__aarch64__)
+	case DM35425_SIMD_NEON:
+		out_of_range = DM35425_Adc_Interleave_Neon(input_ranges, samples,
+							   volts, stride,
+							   num_channels, count);
+		break;
+#endif
+	default:
+		out_of_range = DM35425_Adc_Interleave_Scalar(input_ranges,
+							     samples, volts,
+							     stride, 0,
+							     num_channels, 0,
+							     count);
+		break;
+	}
+
+	if (out_of_range) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+DM35425LIB_API
+int DM35425_Adc_Samples_To_Volts_Interleaved(
+				int num_channels,
+				const enum DM35425_Input_Ranges *input_ranges,
+				const int32_t *const *samples,
+				float *volts,
+				size_t stride,
+				size_t count)
+{
+	return DM35425_Adc_Samples_To_Volts_Interleaved_Isa(
+				DM35425_Simd_Best_Isa(), num_channels,
+				input_ranges, samples, volts, stride, count);
+}
+
+
+/******************************************************************************
+ * ADC Statistics Functions
+ *****************************************************************************/
+
+DM35425LIB_API
+void DM35425_Adc_Stats_Init(struct DM35425_Adc_Sample_Stats *stats)
+{
+	stats->min = INT32_MAX;
+	stats->max = INT32_MIN;
+	stats->sum = 0;
+	stats->sum_squares = 0;
+	stats->count = 0;
+}
+
+
+DM35425LIB_API
+int DM35425_Adc_Samples_Stats_Isa(enum DM35425_Simd_Isa isa,
+				  const int32_t *samples,
+				  size_t count,
+				  struct DM35425_Adc_Sample_Stats *stats)
+{
+	if (!DM35425_Simd_Isa_Supported(isa)) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+	case DM35425_SIMD_SSE2:
+		DM35425_Adc_Stats_Sse2(samples, count, stats);
+		break;
+	/*
+	 * Memory bound like the conversion, so AVX-512 gains nothing
+	 */
+	case DM35425_SIMD_AVX2:
+	case DM35425_SIMD_AVX512:
+		DM35425_Adc_Stats_Avx2(samples, count, stats);
+		break;
+#endif
+#if defined(__aarch64__)
+	case DM35425_SIMD_NEON:
+		DM35425_Adc_Stats_Neon(samples, count, stats);
+		break;
+#endif
+	default:
+		DM35425_Adc_Stats_Scalar(samples, count, stats);
+		break;
+	}
+
+	stats->count += count;
+	return 0;
+}
+
+
+DM35425LIB_API
+void DM35425_Adc_Samples_Stats(const int32_t *samples,
+			       size_t count,
+			       struct DM35425_Adc_Sample_Stats *stats)
+{
+	DM35425_Adc_Samples_Stats_Isa(DM35425_Simd_Best_Isa(), samples, count,
+				      stats);
+}
+
+
+DM35425LIB_API
+void DM35425_Adc_Stats_Merge(struct DM35425_Adc_Sample_Stats *total,
+			     const struct DM35425_Adc_Sample_Stats *stats)
+{
+	if (stats->min < total->min) {
+		total->min = stats->min;
+	}
+	if (stats->max > total->max) {
+		total->max = stats->max;
+	}
+	total->sum += stats->sum;
+	total->sum_squares += stats->sum_squares;
+	total->count += stats->count;
+}
+
+
+DM35425LIB_API
+int DM35425_Adc_Stats_To_Volts(enum DM35425_Input_Ranges input_range,
+			       const struct DM35425_Adc_Sample_Stats *stats,
+			       struct DM35425_Adc_Volt_Stats *volts)
+{
+	struct DM35425_Adc_Conversion conv;
+	double mean_square;
+
+	if (DM35425_Adc_Get_Conversion(input_range, &conv) != 0) {
+		return -1;
+	}
+
+	if (stats->count == 0) {
+		errno = ENODATA;
+		return -1;
+	}
+
+	mean_square = (double) stats->sum_squares / (double) stats->count;
+
+	volts->min = (float) stats->min * conv.lsb;
+	volts->max = (float) stats->max * conv.lsb;
+	volts->mean = (float) ((double) stats->sum / (double) stats->count *
+			       conv.lsb);
+	volts->rms = (float) (sqrt(mean_square) * conv.lsb);
+	volts->peak_to_peak = (float) (((int64_t) stats->max - stats->min) *
+				       (double) conv.lsb);
+	volts->count = stats->count;
+
+	return 0;
+}
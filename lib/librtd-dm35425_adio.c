@@ -1545,6 +1545,30 @@ int DM35425_Adio_Set_Output_Value(struct DM35425_Board_Descriptor *handle,
 
 
 
+DM35425LIB_API
+int DM35425_Adio_Modify_Output_Value(struct DM35425_Board_Descriptor *handle,
+				const struct DM35425_Function_Block *func_block,
+				uint32_t value,
+				uint32_t mask)
+{
+
+	union dm35425_ioctl_argument ioctl_request;
+	unsigned int channel_start_offset = func_block->control_offset +
+						DM35425_OFFSET_ADIO_CHAN_START;
+
+	ioctl_request.modify.access.offset = channel_start_offset +
+						DM35425_OFFSET_ADIO_OUTPUT_VAL;
+	ioctl_request.modify.access.region = DM35425_PCI_REGION_FB;
+	ioctl_request.modify.access.size = DM35425_PCI_REGION_ACCESS_32;
+	ioctl_request.modify.access.data.data32 = value;
+	ioctl_request.modify.mask.mask32 = mask;
+
+	return DM35425_Modify(handle, &ioctl_request);
+
+}
+
+
+
 DM35425LIB_API
 int DM35425_Adio_Get_Direction(struct DM35425_Board_Descriptor *handle,
 				const struct DM35425_Function_Block *func_block,
@@ -1593,6 +1617,30 @@ int DM35425_Adio_Set_Direction(struct DM35425_Board_Descriptor *handle,
 
 
 
+DM35425LIB_API
+int DM35425_Adio_Modify_Direction(struct DM35425_Board_Descriptor *handle,
+				const struct DM35425_Function_Block *func_block,
+				uint32_t direction,
+				uint32_t mask)
+{
+
+	union dm35425_ioctl_argument ioctl_request;
+	unsigned int channel_start_offset = func_block->control_offset +
+						DM35425_OFFSET_ADIO_CHAN_START;
+
+	ioctl_request.modify.access.offset = channel_start_offset +
+						DM35425_OFFSET_ADIO_DIRECTION;
+	ioctl_request.modify.access.region = DM35425_PCI_REGION_FB;
+	ioctl_request.modify.access.size = DM35425_PCI_REGION_ACCESS_32;
+	ioctl_request.modify.access.data.data32 = direction;
+	ioctl_request.modify.mask.mask32 = mask;
+
+	return DM35425_Modify(handle, &ioctl_request);
+
+}
+
+
+
 DM35425LIB_API
 int DM35425_Adio_Get_Adv_Int_Mode(struct DM35425_Board_Descriptor *handle,
 					const struct DM35425_Function_Block *func_block,
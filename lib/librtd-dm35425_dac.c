@@ -683,7 +683,7 @@ int DM35425_Dac_Set_Last_Conversion(struct DM35425_Board_Descriptor *handle,
 	value_to_write = (uint32_t) marker;
 
 	value_to_write <<= 24;
-	value_to_write |= (uint32_t) value;
+	value_to_write |= (uint16_t) value;
 
 	ioctl_request.readwrite.access.offset = func_block->control_offset +
 		DM35425_OFFSET_DAC_CHAN_CTRL_BLK_START +
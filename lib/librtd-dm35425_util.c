@@ -23,6 +23,7 @@
 
 #include <sys/time.h>
 #include <stdint.h>
+#include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
@@ -34,6 +35,7 @@
 #define DM35425_ONE_SEC_IN_MICRO	1000000
 #define DM35425_MICRO_TO_NANO(x)	((x) * 1000)
 #define DM35425_SEC_TO_MICRO(x)	((x) * 1000000)
+#define DM35425_SEC_TO_NANO(x)	((x) * 1000000000ULL)
 
 
 long DM35425_Get_Time_Diff(struct timeval last, struct timeval first) {
@@ -180,3 +182,211 @@ void check_result(int return_val, char *message) {
 
     	}
 }
+
+
+uint64_t DM35425_Get_Monotonic_Ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return DM35425_SEC_TO_NANO((uint64_t) now.tv_sec) + (uint64_t) now.tv_nsec;
+}
+
+
+/*
+ * Map a value to its bucket.  Values below DM35425_HISTOGRAM_SUB_BUCKETS get
+ * a bucket each, larger values keep their top SUB_BUCKET_BITS + 1 bits.
+ */
+static unsigned int DM35425_Histogram_Index(uint64_t value)
+{
+	unsigned int shift;
+
+	if (value < DM35425_HISTOGRAM_SUB_BUCKETS) {
+		return (unsigned int) value;
+	}
+
+	shift = (63 - __builtin_clzll(value)) - DM35425_HISTOGRAM_SUB_BUCKET_BITS;
+
+	return DM35425_HISTOGRAM_SUB_BUCKETS +
+		(shift * DM35425_HISTOGRAM_SUB_BUCKETS) +
+		(unsigned int) ((value >> shift) - DM35425_HISTOGRAM_SUB_BUCKETS);
+}
+
+
+/*
+ * Return the value in the middle of a bucket.
+ */
+static uint64_t DM35425_Histogram_Value(unsigned int index)
+{
+	unsigned int shift;
+	uint64_t sub;
+
+	if (index < DM35425_HISTOGRAM_SUB_BUCKETS) {
+		return index;
+	}
+
+	shift = (index - DM35425_HISTOGRAM_SUB_BUCKETS) / DM35425_HISTOGRAM_SUB_BUCKETS;
+	sub = (index - DM35425_HISTOGRAM_SUB_BUCKETS) % DM35425_HISTOGRAM_SUB_BUCKETS;
+
+	return ((DM35425_HISTOGRAM_SUB_BUCKETS + sub) << shift) +
+		((1ULL << shift) >> 1);
+}
+
+
+void DM35425_Histogram_Reset(struct DM35425_Histogram *hist)
+{
+	memset(hist, 0, sizeof(struct DM35425_Histogram));
+	hist->min = UINT64_MAX;
+}
+
+
+void DM35425_Histogram_Record(struct DM35425_Histogram *hist, uint64_t value_ns)
+{
+	uint64_t seen;
+
+	__atomic_fetch_add(&hist->buckets[DM35425_Histogram_Index(value_ns)], 1,
+			   __ATOMIC_RELAXED);
+	__atomic_fetch_add(&hist->sum, value_ns, __ATOMIC_RELAXED);
+
+	seen = __atomic_load_n(&hist->min, __ATOMIC_RELAXED);
+	while (value_ns < seen &&
+	       !__atomic_compare_exchange_n(&hist->min, &seen, value_ns, 1,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+
+	seen = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+	while (value_ns > seen &&
+	       !__atomic_compare_exchange_n(&hist->max, &seen, value_ns, 1,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+
+	/*
+	 * The count is published last so that a reader never sees more values
+	 * counted than are present in the buckets.
+	 */
+	__atomic_fetch_add(&hist->count, 1, __ATOMIC_RELEASE);
+}
+
+
+uint64_t DM35425_Histogram_Percentile(const struct DM35425_Histogram *hist,
+					double percentile)
+{
+	uint64_t count = __atomic_load_n(&hist->count, __ATOMIC_ACQUIRE);
+	uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+	uint64_t target;
+	uint64_t seen = 0;
+	unsigned int index;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	if (percentile < 0.0) {
+		percentile = 0.0;
+	}
+
+	if (percentile > 100.0) {
+		percentile = 100.0;
+	}
+
+	target = (uint64_t) ((percentile / 100.0) * (double) count + 0.5);
+	if (target < 1) {
+		target = 1;
+	}
+
+	for (index = 0; index < DM35425_HISTOGRAM_NUM_BUCKETS; index++) {
+		seen += __atomic_load_n(&hist->buckets[index], __ATOMIC_RELAXED);
+		if (seen >= target) {
+			uint64_t value = DM35425_Histogram_Value(index);
+
+			return (value > max) ? max : value;
+		}
+	}
+
+	return max;
+}
+
+
+void DM35425_Histogram_Summarize(const struct DM35425_Histogram *hist,
+				struct DM35425_Latency_Summary *summary)
+{
+	summary->count = __atomic_load_n(&hist->count, __ATOMIC_ACQUIRE);
+
+	if (summary->count == 0) {
+		memset(summary, 0, sizeof(struct DM35425_Latency_Summary));
+		return;
+	}
+
+	summary->min_ns = __atomic_load_n(&hist->min, __ATOMIC_RELAXED);
+	summary->max_ns = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+	summary->mean_ns = __atomic_load_n(&hist->sum, __ATOMIC_RELAXED) /
+				summary->count;
+	summary->p50_ns = DM35425_Histogram_Percentile(hist, 50.0);
+	summary->p90_ns = DM35425_Histogram_Percentile(hist, 90.0);
+	summary->p99_ns = DM35425_Histogram_Percentile(hist, 99.0);
+	summary->p999_ns = DM35425_Histogram_Percentile(hist, 99.9);
+}
+
+
+int DM35425_Simd_Isa_Supported(enum DM35425_Simd_Isa isa)
+{
+	switch (isa) {
+	case DM35425_SIMD_SCALAR:
+		return 1;
+#if defined(__x86_64__) || defined(__i386__)
+	case DM35425_SIMD_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case DM35425_SIMD_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case DM35425_SIMD_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+#if defined(__aarch64__)
+	case DM35425_SIMD_NEON:
+		return 1;
+#endif
+	default:
+		return 0;
+	}
+}
+
+
+enum DM35425_Simd_Isa DM35425_Simd_Best_Isa(void)
+{
+	static const enum DM35425_Simd_Isa preference[] = {
+		DM35425_SIMD_AVX2,
+		DM35425_SIMD_AVX512,
+		DM35425_SIMD_SSE2,
+		DM35425_SIMD_NEON
+	};
+	unsigned int i;
+
+	for (i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+		if (DM35425_Simd_Isa_Supported(preference[i])) {
+			return preference[i];
+		}
+	}
+
+	return DM35425_SIMD_SCALAR;
+}
+
+
+const char *DM35425_Simd_Isa_Name(enum DM35425_Simd_Isa isa)
+{
+	switch (isa) {
+	case DM35425_SIMD_SCALAR:
+		return "scalar";
+	case DM35425_SIMD_SSE2:
+		return "sse2";
+	case DM35425_SIMD_AVX2:
+		return "avx2";
+	case DM35425_SIMD_AVX512:
+		return "avx512";
+	case DM35425_SIMD_NEON:
+		return "neon";
+	default:
+		return "unknown";
+	}
+}
+
@@ -0,0 +1,257 @@
+/**
+    @file
+
+    @brief
+        Test of the ADC channel configuration of the multiboard interface,
+        against a simulated board.
+
+    @verbatim
+
+        The program opens the simulated board of dm35425_sim.c with
+        DM35425_ADCDMA_Open() and configures it with
+        DM35425_ADCDMA_Configure_ADC_Channels(), first with every channel
+        single ended and then with a mix of single ended channels and
+        differential pairs, each with its own input range.
+
+        It then opens the board a second time with the ADC library, reads
+        the front end configuration of every channel back with
+        DM35425_Adc_Channel_Get_Front_End_Config() and checks that
+        each configured channel has the input mode, polarity, gain and
+        delay it was given and is enabled, and that every other channel,
+        including the negative input of each pair, was switched off.  The
+        program exits with a non-zero status if any check failed.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <stdint.h>
+
+#include "dm35425.h"
+#include "dm35425_board_access.h"
+#include "dm35425_board_access_structs.h"
+#include "dm35425_adc_library.h"
+#include "dm35425_adc_multiboard.h"
+#include "dm35425_sim.h"
+
+/**
+ * Sample rate the board is configured with.
+ */
+#define RATE			1000
+
+/**
+ * Samples per channel per DMA buffer the board is configured with.
+ */
+#define SAMPLES_PER_BUFFER	256
+
+/**
+ * Channels sampled by the mixed configuration: the differential pairs
+ * also take the input eight channels above.
+ */
+static const struct DM35425_ADCDMA_Channel_Config mixed_config[] = {
+	{ 0, DM35425_ADC_INPUT_DIFFERENTIAL, DM35425_ADC_RNG_BIPOLAR_10V },
+	{ 1, DM35425_ADC_INPUT_SINGLE_ENDED, DM35425_ADC_RNG_UNIPOLAR_5V },
+	{ 2, DM35425_ADC_INPUT_DIFFERENTIAL, DM35425_ADC_RNG_UNIPOLAR_1_25V },
+	{ 16, DM35425_ADC_INPUT_SINGLE_ENDED, DM35425_ADC_RNG_BIPOLAR_625mV },
+	{ 17, DM35425_ADC_INPUT_DIFFERENTIAL, DM35425_ADC_RNG_BIPOLAR_2_5V },
+	{ 22, DM35425_ADC_INPUT_DIFFERENTIAL, DM35425_ADC_RNG_UNIPOLAR_2_5V },
+	{ 31, DM35425_ADC_INPUT_SINGLE_ENDED, DM35425_ADC_RNG_UNIPOLAR_10V },
+};
+
+/**
+ * Number of failed checks.
+ */
+static unsigned long failures;
+
+/**
+*******************************************************************************
+@brief
+    Report a failed check.
+ *******************************************************************************
+*/
+
+static void check_failed(const char *what, unsigned int channel,
+			 uint16_t fe_config)
+{
+	failures++;
+	fprintf(stderr, "FAILED: Channel %u %s (front end config 0x%04x)\n",
+		channel, what, fe_config);
+}
+
+/**
+*******************************************************************************
+@brief
+    Front end polarity and gain bits the board manual gives for an input
+    range.
+ *******************************************************************************
+*/
+
+static uint16_t range_bits(enum DM35425_Input_Ranges range)
+{
+	switch (range) {
+	case DM35425_ADC_RNG_BIPOLAR_10V:
+		return DM35425_ADC_FE_CONFIG_BIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_05;
+	case DM35425_ADC_RNG_BIPOLAR_5V:
+		return DM35425_ADC_FE_CONFIG_BIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_1;
+	case DM35425_ADC_RNG_BIPOLAR_2_5V:
+		return DM35425_ADC_FE_CONFIG_BIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_2;
+	case DM35425_ADC_RNG_BIPOLAR_1_25V:
+		return DM35425_ADC_FE_CONFIG_BIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_4;
+	case DM35425_ADC_RNG_BIPOLAR_625mV:
+		return DM35425_ADC_FE_CONFIG_BIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_8;
+	case DM35425_ADC_RNG_UNIPOLAR_10V:
+		return DM35425_ADC_FE_CONFIG_UNIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_1;
+	case DM35425_ADC_RNG_UNIPOLAR_5V:
+		return DM35425_ADC_FE_CONFIG_UNIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_2;
+	case DM35425_ADC_RNG_UNIPOLAR_2_5V:
+		return DM35425_ADC_FE_CONFIG_UNIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_4;
+	case DM35425_ADC_RNG_UNIPOLAR_1_25V:
+		return DM35425_ADC_FE_CONFIG_UNIPOLAR |
+		       DM35425_ADC_FE_CONFIG_GAIN_8;
+	}
+	return 0xFFFF;
+}
+
+/**
+*******************************************************************************
+@brief
+    Read the front end configuration of every channel back and check it
+    against the mixed configuration.
+ *******************************************************************************
+*/
+
+static void check_mixed_config(struct DM35425_Board_Descriptor *board,
+			       struct DM35425_Function_Block *adc_block)
+{
+	const struct DM35425_ADCDMA_Channel_Config *config;
+	uint16_t fe_config, mode;
+	unsigned int channel;
+	size_t i;
+
+	for (channel = 0; channel < DM35425_NUM_ADC_DMA_CHANNELS; channel++) {
+		if (DM35425_Adc_Channel_Get_Front_End_Config(board, adc_block,
+							     channel,
+							     &fe_config) != 0) {
+			error(EXIT_FAILURE, errno,
+			      "ERROR: Could not read the front end config");
+		}
+
+		config = NULL;
+		for (i = 0; i < sizeof(mixed_config) / sizeof(mixed_config[0]);
+		     i++) {
+			if (mixed_config[i].channel == (int) channel) {
+				config = &mixed_config[i];
+			}
+		}
+
+		if (config == NULL) {
+			if ((fe_config & DM35425_ADC_FE_CONFIG_ENABLE_MASK) !=
+			    DM35425_ADC_FE_CONFIG_DISABLED) {
+				check_failed("not switched off", channel,
+					     fe_config);
+			}
+			continue;
+		}
+
+		mode = config->input_mode == DM35425_ADC_INPUT_DIFFERENTIAL ?
+		       DM35425_ADC_FE_CONFIG_DIFFERENTIAL :
+		       DM35425_ADC_FE_CONFIG_SINGLE_ENDED;
+
+		if ((fe_config & DM35425_ADC_FE_CONFIG_ENABLE_MASK) !=
+		    DM35425_ADC_FE_CONFIG_ENABLED) {
+			check_failed("not enabled", channel, fe_config);
+		}
+		if ((fe_config & DM35425_ADC_FE_CONFIG_MODE_MASK) != mode) {
+			check_failed("has the wrong input mode", channel,
+				     fe_config);
+		}
+		if ((fe_config & (DM35425_ADC_FE_CONFIG_POLARITY_MASK |
+				  DM35425_ADC_FE_CONFIG_GAIN_MASK)) !=
+		    range_bits(config->range)) {
+			check_failed("has the wrong input range", channel,
+				     fe_config);
+		}
+		if ((fe_config & DM35425_ADC_FE_CONFIG_DELAY_MASK) !=
+		    DM35425_ADC_FE_CONFIG_FULL_SAMPL_DELAY) {
+			check_failed("has the wrong delay", channel, fe_config);
+		}
+	}
+}
+
+int main(void)
+{
+	DM35425_ADCDMA_Descriptor *adc;
+	struct DM35425_Board_Descriptor *board;
+	struct DM35425_Function_Block adc_block;
+
+	if (sim_board_init() != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not set up the simulated board");
+	}
+
+	if (DM35425_ADCDMA_Open(0, &adc) != 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not open the board");
+	}
+
+	/*
+	 * Every channel single ended first, so the mixed configuration has to
+	 * switch channels off and change the mode of others
+	 */
+	if (DM35425_ADCDMA_Configure_ADC(adc, RATE, SAMPLES_PER_BUFFER,
+					 DM35425_ADC_NO_DELAY,
+					 DM35425_ADC_INPUT_SINGLE_ENDED,
+					 DM35425_ADC_RNG_BIPOLAR_5V) != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not configure single ended channels");
+	}
+
+	if (DM35425_ADCDMA_Configure_ADC_Channels(adc, RATE, SAMPLES_PER_BUFFER,
+						  DM35425_ADC_FULL_SAMPLE_DELAY,
+						  sizeof(mixed_config) /
+						  sizeof(mixed_config[0]),
+						  mixed_config) != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not configure mixed channels");
+	}
+
+	if (DM35425_Board_Open(0, &board) != 0 ||
+	    DM35425_Adc_Open(board, 0, &adc_block) != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not open the board to read it back");
+	}
+
+	check_mixed_config(board, &adc_block);
+
+	DM35425_Board_Close(board);
+	DM35425_ADCDMA_Close(adc);
+
+	printf("%lu ADC channels configured, %lu failures\n",
+	       (unsigned long) (sizeof(mixed_config) / sizeof(mixed_config[0])),
+	       failures);
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,521 @@
+/**
+    @file
+
+    @brief
+        Simulated DM35425 board for the tests.  See dm35425_sim.h.
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "dm35425.h"
+#include "dm35425_types.h"
+#include "dm35425_board_access.h"
+#include "dm35425_registers.h"
+#include "dm35425_board_access_structs.h"
+#include "dm35425_ioctl.h"
+#include "dm35425_dma_library.h"
+#include "dm35425_sim.h"
+
+/**
+ * Device file name prefix the library opens.
+ */
+#define DEVICE_NAME_PATH_PREFIX	"/dev/rtd-dm35425"
+
+/**
+ * Bytes of each simulated PCI region, all a 16-bit offset can reach.
+ */
+#define REGION_BYTES		65536
+
+/**
+ * Number of simulated PCI regions, up to DM35425_PCI_REGION_FB.
+ */
+#define NUM_REGIONS		(DM35425_PCI_REGION_FB + 1)
+
+/**
+ * Most interrupts queued on the simulated board at once.
+ */
+#define MAX_QUEUED		256
+
+/**
+ * Bus address reported for the first DMA buffer; each buffer gets its own.
+ */
+#define DMA_BUS_ADDRESS		0x10000000
+
+/**
+ * Layout of a simulated function block.
+ */
+struct sim_block {
+	/**
+	 * Type, one of DM35425_FUNC_BLOCK_*.
+	 */
+	uint32_t type;
+
+	/**
+	 * Offsets of its registers and of its DMA control blocks in the
+	 * function block region.
+	 */
+	uint32_t fb_offset;
+	uint32_t dma_offset;
+
+	/**
+	 * DMA channels and buffers per channel.
+	 */
+	int num_channels;
+	int num_buffers;
+};
+
+/**
+ * The function blocks, indexed by their number.
+ */
+static const struct sim_block blocks[] = {
+	[SIM_ADC_FB] = {DM35425_FUNC_BLOCK_ADC, 0x1000, 0x4000,
+			DM35425_NUM_ADC_DMA_CHANNELS, DM35425_NUM_ADC_DMA_BUFFERS},
+	[SIM_DAC_FB] = {DM35425_FUNC_BLOCK_DAC, 0x2000, 0x6000,
+			DM35425_NUM_DAC_DMA_CHANNELS, DM35425_NUM_DAC_DMA_BUFFERS},
+	[SIM_ADIO_FB] = {DM35425_FUNC_BLOCK_ADIO, 0x3000, 0x7000, 0, 0},
+};
+
+/**
+ * Number of function blocks.
+ */
+#define NUM_BLOCKS		((int) (sizeof(blocks) / sizeof(blocks[0])))
+
+/**
+ * The simulated board.
+ */
+static struct {
+	/**
+	 * Register file of each region.
+	 */
+	uint8_t regions[NUM_REGIONS][REGION_BYTES + sizeof(uint32_t)];
+
+	/**
+	 * Bytes of each DMA buffer, 0 until it is initialized.
+	 */
+	uint32_t dma_sizes[NUM_BLOCKS][MAX_DMA_CHANNELS][MAX_DMA_BUFFERS];
+
+	/**
+	 * Word every DMA buffer is filled with.
+	 */
+	uint32_t dma_stamps[NUM_BLOCKS][MAX_DMA_CHANNELS][MAX_DMA_BUFFERS];
+
+	/**
+	 * Interrupts queued and not yet fetched, and the function block of
+	 * each, oldest first.
+	 */
+	int queued;
+	int queued_fbs[MAX_QUEUED];
+
+	/**
+	 * The device file: a pipe with one byte per queued interrupt or
+	 * wakeup, so select() and poll() wake up as for the driver.
+	 */
+	int pipe_fds[2];
+
+	/**
+	 * Serializes every access, like the driver's device spinlock.
+	 */
+	pthread_mutex_t lock;
+} board = {
+	.pipe_fds = {-1, -1},
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+int __real_open(const char *path, int flags, ...);
+int __real_close(int fd);
+int __real_ioctl(int fd, unsigned long request, ...);
+
+/**
+*******************************************************************************
+@brief
+    Store a 32-bit register of the simulated board, little-endian as on the
+    PCI bus.
+ *******************************************************************************
+*/
+
+static void store32(int region, uint32_t offset, uint32_t value)
+{
+	memcpy(&board.regions[region][offset], &value, sizeof(value));
+}
+
+/**
+*******************************************************************************
+@brief
+    Offset of a DMA channel's control block.
+ *******************************************************************************
+*/
+
+static uint32_t dma_channel_offset(const struct sim_block *block, int channel)
+{
+	return block->dma_offset +
+	       (DM35425_DMA_CTRL_BLOCK_SIZE +
+		DM35425_DMA_BUFFER_CTRL_BLOCK_SIZE * block->num_buffers) *
+	       channel;
+}
+
+/**
+*******************************************************************************
+@brief
+    Offset of a DMA buffer's control block.
+ *******************************************************************************
+*/
+
+static uint32_t dma_buffer_offset(const struct sim_block *block, int channel,
+				  int buffer)
+{
+	return dma_channel_offset(block, channel) +
+	       DM35425_DMA_CTRL_BLOCK_SIZE +
+	       DM35425_DMA_BUFFER_CTRL_BLOCK_SIZE * buffer;
+}
+
+/**
+*******************************************************************************
+@brief
+    The DMA engine takes every action at once: a write of a DMA channel's
+    action register shows up in its last action register.  Called with the
+    board lock held.
+ *******************************************************************************
+*/
+
+static void take_dma_action(uint32_t offset, uint8_t action)
+{
+	const struct sim_block *block;
+	uint32_t stride;
+	int fb;
+
+	for (fb = 0; fb < NUM_BLOCKS; fb++) {
+		block = &blocks[fb];
+		stride = dma_channel_offset(block, 1) - dma_channel_offset(block, 0);
+		if (block->num_channels == 0 || offset < block->dma_offset ||
+		    offset >= dma_channel_offset(block, block->num_channels)) {
+			continue;
+		}
+		if ((offset - block->dma_offset) % stride ==
+		    DM35425_OFFSET_DMA_ACTION) {
+			board.regions[DM35425_PCI_REGION_FB]
+				     [offset + DM35425_OFFSET_DMA_LAST_ACTION] =
+				action;
+		}
+		return;
+	}
+}
+
+/**
+*******************************************************************************
+@brief
+    Read or write one register of the simulated board.  Called with the
+    board lock held.
+ *******************************************************************************
+*/
+
+static int access_register(struct dm35425_pci_access_request *access,
+			   uint32_t mask, int write)
+{
+	uint8_t *reg;
+	uint32_t value = 0;
+	size_t size;
+
+	switch (access->size) {
+	case DM35425_PCI_REGION_ACCESS_8:
+		size = 1;
+		break;
+	case DM35425_PCI_REGION_ACCESS_16:
+		size = 2;
+		break;
+	case DM35425_PCI_REGION_ACCESS_32:
+		size = 4;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+	if ((unsigned) access->region >= NUM_REGIONS) {
+		errno = EINVAL;
+		return -1;
+	}
+	reg = &board.regions[access->region][access->offset];
+
+	memcpy(&value, reg, size);
+	if (write) {
+		value = (value & ~mask) | (access->data.data32 & mask);
+		memcpy(reg, &value, size);
+		if (access->region == DM35425_PCI_REGION_FB && size == 1) {
+			take_dma_action(access->offset, (uint8_t) value);
+		}
+	}
+	access->data.data32 = value;
+
+	return 0;
+}
+
+/**
+*******************************************************************************
+@brief
+    Carry out a DMA request of the driver.  Called with the board lock held.
+ *******************************************************************************
+*/
+
+static int do_dma(struct dm35425_ioctl_dma *dma)
+{
+	uint32_t *size, *stamp;
+	uint32_t i;
+
+	if (dma->fb_num >= (uint32_t) NUM_BLOCKS || dma->channel < 0 ||
+	    dma->channel >= blocks[dma->fb_num].num_channels ||
+	    dma->buffer < 0 ||
+	    dma->buffer >= blocks[dma->fb_num].num_buffers) {
+		errno = EINVAL;
+		return -1;
+	}
+	size = &board.dma_sizes[dma->fb_num][dma->channel][dma->buffer];
+	stamp = &board.dma_stamps[dma->fb_num][dma->channel][dma->buffer];
+
+	switch (dma->function) {
+	case DM35425_DMA_INITIALIZE:
+		*size = dma->buffer_size;
+		*stamp = 0;
+		if ((unsigned) dma->pci.region >= NUM_REGIONS) {
+			errno = EINVAL;
+			return -1;
+		}
+		store32(dma->pci.region, dma->pci.offset,
+			DMA_BUS_ADDRESS +
+			(uint32_t) (dma->channel * MAX_DMA_BUFFERS +
+				    dma->buffer) * 0x10000);
+		return 0;
+	case DM35425_DMA_READ:
+		if (*size == 0 || dma->buffer_size > *size) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (i = 0; i + sizeof(uint32_t) <= dma->buffer_size;
+		     i += sizeof(uint32_t)) {
+			memcpy((uint8_t *) dma->buffer_ptr + i, stamp,
+			       sizeof(*stamp));
+		}
+		return 0;
+	case DM35425_DMA_WRITE:
+		if (*size == 0 || dma->buffer_size > *size ||
+		    dma->buffer_size < sizeof(uint32_t)) {
+			errno = EINVAL;
+			return -1;
+		}
+		memcpy(stamp, dma->buffer_ptr, sizeof(*stamp));
+		return 0;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+}
+
+int sim_board_init(void)
+{
+	const struct sim_block *block;
+	uint32_t entry;
+	int fb;
+
+	if (pipe(board.pipe_fds) != 0 ||
+	    fcntl(board.pipe_fds[0], F_SETFL, O_NONBLOCK) != 0 ||
+	    fcntl(board.pipe_fds[1], F_SETFL, O_NONBLOCK) != 0) {
+		return -1;
+	}
+
+	/*
+	 * The directory in the GBC region, and the ID and DMA counts at the
+	 * start of each block; the other entries stay 0, an invalid block
+	 */
+	for (fb = 0; fb < NUM_BLOCKS; fb++) {
+		block = &blocks[fb];
+		entry = DM35425_OFFSET_GBC_FB_START + fb * DM35425_GBC_FB_BLK_SIZE;
+		store32(DM35425_PCI_REGION_GBC, entry + DM35425_OFFSET_GBC_FB_ID,
+			block->type);
+		store32(DM35425_PCI_REGION_GBC,
+			entry + DM35425_OFFSET_GBC_FB_OFFSET, block->fb_offset);
+		store32(DM35425_PCI_REGION_GBC,
+			entry + DM35425_OFFSET_GBC_FB_DMA_OFFSET,
+			block->dma_offset);
+
+		store32(DM35425_PCI_REGION_FB, block->fb_offset, block->type);
+		board.regions[DM35425_PCI_REGION_FB]
+			     [block->fb_offset + DM35425_OFFSET_FB_DMA_CHANNELS] =
+			(uint8_t) block->num_channels;
+		board.regions[DM35425_PCI_REGION_FB]
+			     [block->fb_offset + DM35425_OFFSET_FB_DMA_BUFFERS] =
+			(uint8_t) block->num_buffers;
+	}
+
+	return 0;
+}
+
+void sim_raise_interrupt(int fb)
+{
+	char byte = 1;
+
+	pthread_mutex_lock(&board.lock);
+	if (board.queued < MAX_QUEUED &&
+	    write(board.pipe_fds[1], &byte, 1) == 1) {
+		board.queued_fbs[board.queued++] = fb;
+	}
+	pthread_mutex_unlock(&board.lock);
+}
+
+int sim_dma_fill(int fb, int channel, int buffer, uint32_t stamp)
+{
+	uint32_t status;
+	int result = 0;
+
+	if (fb < 0 || fb >= NUM_BLOCKS || channel < 0 ||
+	    channel >= blocks[fb].num_channels || buffer < 0 ||
+	    buffer >= blocks[fb].num_buffers) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&board.lock);
+	if (board.dma_sizes[fb][channel][buffer] == 0) {
+		errno = EINVAL;
+		result = -1;
+	} else {
+		board.dma_stamps[fb][channel][buffer] = stamp;
+		status = dma_buffer_offset(&blocks[fb], channel, buffer) +
+			 DM35425_OFFSET_DMA_BUFFER_STAT;
+		board.regions[DM35425_PCI_REGION_FB][status] |=
+			DM35425_DMA_BUFFER_STATUS_USED_MASK;
+	}
+	pthread_mutex_unlock(&board.lock);
+
+	return result;
+}
+
+/**
+*******************************************************************************
+@brief
+    open() of the library: the device file is the simulated board.
+ *******************************************************************************
+*/
+
+int __wrap_open(const char *path, int flags, ...)
+{
+	va_list args;
+	mode_t mode;
+
+	if (strncmp(path, DEVICE_NAME_PATH_PREFIX,
+		    strlen(DEVICE_NAME_PATH_PREFIX)) == 0) {
+		return board.pipe_fds[0];
+	}
+
+	va_start(args, flags);
+	mode = va_arg(args, mode_t);
+	va_end(args);
+
+	return __real_open(path, flags, mode);
+}
+
+/**
+*******************************************************************************
+@brief
+    close() of the library: the simulated board stays open.
+ *******************************************************************************
+*/
+
+int __wrap_close(int fd)
+{
+	if (fd == board.pipe_fds[0]) {
+		return 0;
+	}
+
+	return __real_close(fd);
+}
+
+/**
+*******************************************************************************
+@brief
+    ioctl() of the library: register access, DMA and the interrupt queue of
+    the simulated board.
+ *******************************************************************************
+*/
+
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+	union dm35425_ioctl_argument *arg;
+	va_list args;
+	char byte;
+	int result = 0;
+
+	va_start(args, request);
+	arg = va_arg(args, union dm35425_ioctl_argument *);
+	va_end(args);
+
+	if (fd != board.pipe_fds[0]) {
+		return __real_ioctl(fd, request, arg);
+	}
+
+	pthread_mutex_lock(&board.lock);
+
+	switch (request) {
+	case DM35425_IOCTL_REGION_READ:
+		result = access_register(&arg->readwrite.access, 0, 0);
+		break;
+	case DM35425_IOCTL_REGION_WRITE:
+		result = access_register(&arg->readwrite.access, 0xFFFFFFFF, 1);
+		break;
+	case DM35425_IOCTL_REGION_MODIFY:
+		result = access_register(&arg->modify.access,
+					 arg->modify.mask.mask32, 1);
+		break;
+	case DM35425_IOCTL_DMA_FUNCTION:
+		result = do_dma(&arg->dma);
+		break;
+	case DM35425_IOCTL_WAKEUP:
+		byte = 0;
+		if (write(board.pipe_fds[1], &byte, 1) != 1) {
+			result = -1;
+		}
+		break;
+	case DM35425_IOCTL_INTERRUPT_GET:
+		memset(&arg->interrupt, 0, sizeof(arg->interrupt));
+		if (read(board.pipe_fds[0], &byte, 1) == 1 && byte != 0 &&
+		    board.queued > 0) {
+			arg->interrupt.valid_interrupt = 1;
+			arg->interrupt.interrupt_fb = board.queued_fbs[0];
+			board.queued--;
+			memmove(&board.queued_fbs[0], &board.queued_fbs[1],
+				board.queued * sizeof(board.queued_fbs[0]));
+		}
+		arg->interrupt.interrupts_remaining = board.queued;
+		break;
+	case DM35425_IOCTL_INTERRUPT_PENDING:
+		memset(&arg->interrupt, 0, sizeof(arg->interrupt));
+		arg->interrupt.interrupts_remaining = board.queued;
+		break;
+	default:
+		errno = ENOTTY;
+		result = -1;
+		break;
+	}
+
+	pthread_mutex_unlock(&board.lock);
+
+	return result;
+}
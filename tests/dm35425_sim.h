@@ -0,0 +1,108 @@
+/**
+    @file
+
+    @brief
+        Simulated DM35425 board for the tests.
+
+    @verbatim
+
+        The library reaches the hardware only through open(), close() and
+        ioctl() on the device file.  A test linked with dm35425_sim.o and
+        -Wl,--wrap for those calls (see the Makefile) talks to the
+        simulated board in dm35425_sim.c instead: a register file updated
+        under one lock, as the driver does under its device spinlock, a
+        function block directory with an ADC, a DAC and an ADIO block, DMA
+        buffers the test fills in place of the hardware, and an interrupt
+        queue behind a pipe that select() and poll() can wait on.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#ifndef __DM35425_SIM_H__
+#define __DM35425_SIM_H__
+
+#include <stdint.h>
+
+/**
+ * Function block number of the simulated ADC.
+ */
+#define SIM_ADC_FB		0
+
+/**
+ * Function block number of the simulated DAC.
+ */
+#define SIM_DAC_FB		1
+
+/**
+ * Function block number of the simulated ADIO.
+ */
+#define SIM_ADIO_FB		2
+
+/**
+ * Function block number the simulated board reports with interrupts that
+ * are not of a DMA block.
+ */
+#define SIM_INTERRUPT_FB	5
+
+/**
+*******************************************************************************
+@brief
+    Set up the simulated board.  Call before the library opens the board.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    Failure.  errno is set.
+ *******************************************************************************
+*/
+
+int sim_board_init(void);
+
+/**
+*******************************************************************************
+@brief
+    Raise one simulated interrupt of a function block, unless too many are
+    queued.
+ *******************************************************************************
+*/
+
+void sim_raise_interrupt(int fb);
+
+/**
+*******************************************************************************
+@brief
+    Fill a DMA buffer as the hardware would: every 32-bit word of it becomes
+    stamp, and its status register is marked used.
+
+@retval
+    0
+
+    Success.
+
+@retval
+    -1
+
+    The buffer was not initialized.  errno is EINVAL.
+ *******************************************************************************
+*/
+
+int sim_dma_fill(int fb, int channel, int buffer, uint32_t stamp);
+
+#endif
@@ -0,0 +1,690 @@
+/**
+    @file
+
+    @brief
+        Multithreaded stress test of a shared board descriptor, against a
+        simulated board.
+
+    @verbatim
+
+        The program runs against the simulated board of dm35425_sim.c, and
+        opens the ADC, DAC and ADIO function blocks the library finds on it.
+        On one descriptor it then runs at the same time:
+
+            - threads that each own one bit of the ADIO output value and
+              direction registers, flip it with
+              DM35425_Adio_Modify_Output_Value() and
+              DM35425_Adio_Modify_Direction(), and read the registers back
+              to check no other thread's update lost their bit;
+
+            - threads that each own one DAC channel, set its last conversion
+              and marker with DM35425_Dac_Set_Last_Conversion() and read
+              them back with DM35425_Dac_Get_Last_Conversion();
+
+            - threads that each own one ADC DMA channel, initialize and
+              start it, and then for buffer after buffer have the simulated
+              board fill it, check it is used, read it with
+              DM35425_Dma_Read(), reset it and check its status, control
+              and size registers, as the ADC readout does;
+
+            - threads that install the ISR, blocking or polled, and remove
+              it again, checking that each call either succeeds or fails
+              with EBUSY / EFAULT because another thread got there first;
+
+            - a thread raising simulated interrupts, which the ISR checks
+              arrive with the function block the board reported, and
+              changing the ISR timeout while the ISR thread reads it.
+
+        After the last ISR is removed any further call of it is an error,
+        and so is a crash from a stale or NULL ISR pointer.  The program
+        exits with a non-zero status if any check failed.  Build the
+        library and this program with -fsanitize=thread to look for data
+        races as well.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "dm35425.h"
+#include "dm35425_board_access.h"
+#include "dm35425_board_access_structs.h"
+#include "dm35425_adc_library.h"
+#include "dm35425_dac_library.h"
+#include "dm35425_adio_library.h"
+#include "dm35425_dma_library.h"
+#include "dm35425_os.h"
+#include "dm35425_examples.h"
+#include "dm35425_sim.h"
+
+/**
+ * Bytes of each ADC DMA buffer.
+ */
+#define DMA_BUFFER_BYTES	1024
+
+/**
+ * Threads of each kind, if the user does not provide a number.
+ */
+#define DEFAULT_THREADS		4
+
+/**
+ * Iterations of each thread, if the user does not provide a number.
+ */
+#define DEFAULT_COUNT		2000
+
+/**
+ * Function blocks of the simulated board.
+ */
+static struct DM35425_Function_Block adc_block;
+static struct DM35425_Function_Block dac_block;
+static struct DM35425_Function_Block adio_block;
+
+/**
+ * The shared descriptor.
+ */
+static struct DM35425_Board_Descriptor *handle;
+
+/**
+ * Iterations of each thread.
+ */
+static unsigned long count = DEFAULT_COUNT;
+
+/**
+ * Set once the last ISR has been removed.
+ */
+static int finished;
+
+/**
+ * Set once the test is over, to stop the interrupt thread.
+ */
+static int stopping;
+
+/**
+ * Totals, updated atomically.
+ */
+static unsigned long isr_calls;
+static unsigned long installs;
+static unsigned long removes;
+static unsigned long dac_updates;
+static unsigned long dma_buffers;
+static unsigned long failures;
+
+/**
+ * Name of the program as invoked on the command line
+ */
+static char *program_name;
+
+/**
+*******************************************************************************
+@brief
+    Report a failed check.  Safe to call from any thread.
+ *******************************************************************************
+*/
+
+static void check_failed(const char *what, long value)
+{
+	__atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+	fprintf(stderr, "FAILED: %s (%ld)\n", what, value);
+}
+
+/**
+*******************************************************************************
+@brief
+    Sleep for a few microseconds.
+ *******************************************************************************
+*/
+
+static void nap(long microseconds)
+{
+	struct timespec sleep_time = {0, microseconds * 1000};
+
+	nanosleep(&sleep_time, NULL);
+}
+
+/**
+*******************************************************************************
+@brief
+    The user ISR.  Checks that every call carries a simulated interrupt or a
+    wakeup, and that none comes after the last ISR was removed.
+ *******************************************************************************
+*/
+
+static void isr(struct dm35425_ioctl_interrupt_info_request info)
+{
+	__atomic_fetch_add(&isr_calls, 1, __ATOMIC_RELAXED);
+
+	if (__atomic_load_n(&finished, __ATOMIC_ACQUIRE)) {
+		check_failed("ISR called after it was removed", 0);
+	}
+	if (info.error_occurred != 0) {
+		check_failed("ISR called with an error", info.error_occurred);
+	}
+	if (info.valid_interrupt && info.interrupt_fb != SIM_INTERRUPT_FB) {
+		check_failed("ISR called with a bad function block",
+			     info.interrupt_fb);
+	}
+}
+
+/**
+*******************************************************************************
+@brief
+    Thread that owns one ADIO bit and flips it through the library's
+    read-modify-write calls.
+ *******************************************************************************
+*/
+
+static void *adio_thread(void *arg)
+{
+	uint32_t bit = 1U << (uintptr_t) arg;
+	uint32_t value, direction;
+	unsigned long i;
+
+	for (i = 0; i < count; i++) {
+		value = (i & 1) ? bit : 0;
+		direction = (i & 2) ? bit : 0;
+
+		if (DM35425_Adio_Modify_Output_Value(handle, &adio_block,
+						     value, bit) != 0 ||
+		    DM35425_Adio_Modify_Direction(handle, &adio_block,
+						  direction, bit) != 0) {
+			check_failed("ADIO modify failed", errno);
+			break;
+		}
+
+		if (DM35425_Adio_Get_Output_Value(handle, &adio_block,
+						  &value) != 0 ||
+		    DM35425_Adio_Get_Direction(handle, &adio_block,
+					       &direction) != 0) {
+			check_failed("ADIO read failed", errno);
+			break;
+		}
+
+		if ((value & bit) != ((i & 1) ? bit : 0)) {
+			check_failed("Output value bit lost", (long) i);
+		}
+		if ((direction & bit) != ((i & 2) ? bit : 0)) {
+			check_failed("Direction bit lost", (long) i);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    Thread that owns one DAC channel and sets its last conversion, checking
+    that the value and marker read back are the ones it wrote.
+ *******************************************************************************
+*/
+
+static void *dac_thread(void *arg)
+{
+	unsigned int channel = (unsigned int) (uintptr_t) arg;
+	unsigned int seed = channel + 1;
+	int16_t value, value_read;
+	uint8_t marker, marker_read;
+	unsigned long i;
+
+	for (i = 0; i < count; i++) {
+		value = (int16_t) (rand_r(&seed) & 0xFFFF);
+		marker = (uint8_t) rand_r(&seed);
+
+		if (DM35425_Dac_Set_Last_Conversion(handle, &dac_block, channel,
+						    marker, value) != 0 ||
+		    DM35425_Dac_Get_Last_Conversion(handle, &dac_block, channel,
+						    &marker_read,
+						    &value_read) != 0) {
+			check_failed("DAC last conversion access failed", errno);
+			break;
+		}
+
+		if (value_read != value) {
+			check_failed("DAC last conversion torn", (long) i);
+		}
+		if (marker_read != marker) {
+			check_failed("DAC marker torn", (long) i);
+		}
+	}
+
+	__atomic_fetch_add(&dac_updates, i, __ATOMIC_RELAXED);
+
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    Buffer control the DMA threads set up, the last buffer looping back to
+    the first.
+ *******************************************************************************
+*/
+
+static uint8_t dma_buffer_control(int buffer)
+{
+	uint8_t control = DM35425_DMA_BUFFER_CTRL_VALID |
+			  DM35425_DMA_BUFFER_CTRL_INTR;
+
+	if (buffer == adc_block.num_dma_buffers - 1) {
+		control |= DM35425_DMA_BUFFER_CTRL_LOOP;
+	}
+	return control;
+}
+
+/**
+*******************************************************************************
+@brief
+    Thread that owns one ADC DMA channel and reads its buffers as the
+    simulated board fills them.
+ *******************************************************************************
+*/
+
+static void *dma_thread(void *arg)
+{
+	unsigned int channel = (unsigned int) (uintptr_t) arg;
+	uint32_t data[DMA_BUFFER_BYTES / sizeof(uint32_t)];
+	uint32_t stamp, size;
+	uint8_t status, control;
+	unsigned long i;
+	size_t word;
+	int buffer, used;
+
+	if (DM35425_Dma_Initialize(handle, &adc_block, channel,
+				   adc_block.num_dma_buffers,
+				   DMA_BUFFER_BYTES) != 0 ||
+	    DM35425_Dma_Setup(handle, &adc_block, channel,
+			      DM35425_DMA_SETUP_DIRECTION_READ,
+			      NOT_IGNORE_USED) != 0) {
+		check_failed("DMA setup failed", errno);
+		return NULL;
+	}
+	for (buffer = 0; buffer < adc_block.num_dma_buffers; buffer++) {
+		if (DM35425_Dma_Buffer_Setup(handle, &adc_block, channel,
+					     buffer,
+					     dma_buffer_control(buffer)) != 0) {
+			check_failed("DMA buffer setup failed", errno);
+			return NULL;
+		}
+	}
+	if (DM35425_Dma_Start(handle, &adc_block, channel) != 0) {
+		check_failed("DMA start failed", errno);
+		return NULL;
+	}
+
+	for (i = 0; i < count / 10; i++) {
+		buffer = (int) (i % adc_block.num_dma_buffers);
+		stamp = (channel << 24) | (uint32_t) (i & 0xFFFFFF);
+
+		if (sim_dma_fill(SIM_ADC_FB, channel, buffer, stamp) != 0) {
+			check_failed("DMA fill failed", errno);
+			break;
+		}
+
+		if (DM35425_Dma_Check_Buffer_Used(handle, &adc_block, channel,
+						  buffer, &used) != 0 ||
+		    DM35425_Dma_Read(handle, &adc_block, channel, buffer,
+				     DMA_BUFFER_BYTES, data) != 0 ||
+		    DM35425_Dma_Reset_Buffer(handle, &adc_block, channel,
+					     buffer) != 0 ||
+		    DM35425_Dma_Buffer_Status(handle, &adc_block, channel,
+					      buffer, &status, &control,
+					      &size) != 0) {
+			check_failed("DMA buffer access failed", errno);
+			break;
+		}
+
+		if (!used) {
+			check_failed("Filled DMA buffer not used", (long) i);
+		}
+		for (word = 0; word < DMA_BUFFER_BYTES / sizeof(uint32_t);
+		     word++) {
+			if (data[word] != stamp) {
+				check_failed("DMA buffer data torn", (long) i);
+				break;
+			}
+		}
+		if (status != DM35425_DMA_BUFFER_STATUS_CLEAR) {
+			check_failed("DMA buffer status not reset", status);
+		}
+		if (control != dma_buffer_control(buffer)) {
+			check_failed("DMA buffer control lost", control);
+		}
+		if (size != DMA_BUFFER_BYTES) {
+			check_failed("DMA buffer size lost", (long) size);
+		}
+	}
+
+	__atomic_fetch_add(&dma_buffers, i, __ATOMIC_RELAXED);
+
+	if (DM35425_Dma_Stop(handle, &adc_block, channel) != 0) {
+		check_failed("DMA stop failed", errno);
+	}
+
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    Thread that keeps installing and removing the ISR, alternating between
+    the blocking and the busy-polling ISR thread.
+ *******************************************************************************
+*/
+
+static void *isr_thread(void *arg)
+{
+	struct DM35425_ISR_Poll_Config poll_config = {
+		.spin_ns = 20000,
+		.sleep_ns = 0,
+		.cpu = -1,
+	};
+	unsigned int seed = (unsigned int) (uintptr_t) arg + 1;
+	unsigned long i;
+	int result;
+
+	for (i = 0; i < count / 10; i++) {
+		if (i & 1) {
+			result = DM35425_General_InstallISR_Polled(handle, isr,
+								   &poll_config);
+		} else {
+			result = DM35425_General_InstallISR(handle, isr);
+		}
+		if (result == 0) {
+			__atomic_fetch_add(&installs, 1, __ATOMIC_RELAXED);
+		} else if (result != -EBUSY) {
+			check_failed("Install ISR failed", result);
+		}
+
+		nap(rand_r(&seed) % 200);
+
+		result = DM35425_General_RemoveISR(handle);
+		if (result == 0) {
+			__atomic_fetch_add(&removes, 1, __ATOMIC_RELAXED);
+		} else if (result != -EFAULT) {
+			check_failed("Remove ISR failed", result);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    ISR timeout callback.  The timeout is far longer than the gaps between
+    simulated interrupts, so this is never called.
+ *******************************************************************************
+*/
+
+static void stall(struct DM35425_Board_Descriptor *board, uint64_t waited_ns)
+{
+	(void) board;
+
+	check_failed("ISR timed out (ns)", (long) waited_ns);
+}
+
+/**
+*******************************************************************************
+@brief
+    Thread that raises simulated interrupts until the test is over, turning
+    the ISR timeout on and off as it goes.
+ *******************************************************************************
+*/
+
+static void *interrupt_thread(void *arg)
+{
+	unsigned long i;
+
+	(void) arg;
+
+	for (i = 0; !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE); i++) {
+		sim_raise_interrupt(SIM_INTERRUPT_FB);
+		DM35425_General_SetISRTimeout(handle, i % 2 ? 10000000000ULL : 0,
+					      i % 2 ? stall : NULL);
+		nap(20);
+	}
+
+	return NULL;
+}
+
+/**
+*******************************************************************************
+@brief
+    Print information on stderr about how the program is to be used.  After
+    doing so, the program is exited.
+ *******************************************************************************
+*/
+
+static void usage(void)
+{
+	fprintf(stderr, "\n");
+	fprintf(stderr, "NAME\n\n\t%s\n\n", program_name);
+	fprintf(stderr, "USAGE\n\n\t%s [OPTIONS]\n\n", program_name);
+
+	fprintf(stderr, "OPTIONS\n\n");
+
+	fprintf(stderr, "\t--help\n");
+	fprintf(stderr, "\t\tShow this help screen and exit.\n");
+
+	fprintf(stderr, "\t--threads NUM\n");
+	fprintf(stderr,
+		"\t\tThreads of each kind, 1 to 16.  Defaults to %d.\n",
+		DEFAULT_THREADS);
+
+	fprintf(stderr, "\t--count NUM\n");
+	fprintf(stderr,
+		"\t\tRegister updates per ADIO and DAC thread; ISR threads\n");
+	fprintf(stderr,
+		"\t\tinstall and DMA threads read a buffer one tenth as often.\n");
+	fprintf(stderr, "\t\tDefaults to %d.\n", DEFAULT_COUNT);
+
+	fprintf(stderr, "\n");
+
+	exit(EXIT_FAILURE);
+}
+
+/**
+*******************************************************************************
+@brief
+    Parse an integer option argument within a range, exiting through usage()
+    if it is not valid.
+ *******************************************************************************
+*/
+
+static unsigned long parse_count(const char *name, unsigned long minimum,
+				 unsigned long maximum)
+{
+	char *invalid_char_p;
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(optarg, &invalid_char_p, 10);
+
+	if ((value == ULONG_MAX && errno == ERANGE) ||
+	    *invalid_char_p != '\0' || value < minimum || value > maximum) {
+		error(0, 0, "ERROR: %s must be an integer from %lu to %lu",
+		      name, minimum, maximum);
+		usage();
+	}
+
+	return value;
+}
+
+/**
+*******************************************************************************
+@brief
+    The main program.
+
+@param
+    argument_count
+
+    Number of args passed on the command line, including the executable name
+
+@param
+    arguments
+
+    Pointer to array of character strings, which are the args themselves.
+
+@retval
+    0
+
+    Every check passed.
+
+@retval
+    Non-zero
+
+    Failure.
+ *******************************************************************************
+*/
+
+int main(int argument_count, char **arguments)
+{
+	unsigned long num_threads = DEFAULT_THREADS;
+	pthread_t adio_threads[16];
+	pthread_t dac_threads[DM35425_NUM_DAC_DMA_CHANNELS];
+	pthread_t dma_threads[16];
+	pthread_t isr_threads[16];
+	pthread_t interrupter;
+	unsigned long num_dac_threads;
+	unsigned long i;
+	unsigned long calls;
+	int result;
+	int status;
+
+	struct option options[] = {
+		{"help", 0, 0, HELP_OPTION},
+		{"threads", 1, 0, THREADS_OPTION},
+		{"count", 1, 0, COUNT_OPTION},
+		{0, 0, 0, 0}
+	};
+
+	program_name = arguments[0];
+
+	while (1) {
+		status = getopt_long(argument_count,
+				     arguments, "", options, NULL);
+
+		if (status == -1) {
+			break;
+		}
+
+		switch (status) {
+		case THREADS_OPTION:
+			num_threads = parse_count("Number of threads", 1, 16);
+			break;
+		case COUNT_OPTION:
+			count = parse_count("Count", 10, ULONG_MAX);
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+
+	if (sim_board_init() != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not set up the simulated board");
+	}
+
+	if (DM35425_Board_Open(0, &handle) != 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not open the board");
+	}
+	if (DM35425_Adc_Open(handle, ADC_0, &adc_block) != 0 ||
+	    DM35425_Dac_Open(handle, DAC_0, &dac_block) != 0 ||
+	    DM35425_Adio_Open(handle, ADIO_0, &adio_block) != 0) {
+		error(EXIT_FAILURE, errno,
+		      "ERROR: Could not open the function blocks");
+	}
+
+	/*
+	 * One thread per DAC channel at most, so none shares a channel
+	 */
+	num_dac_threads = num_threads < DM35425_NUM_DAC_DMA_CHANNELS ?
+			  num_threads : DM35425_NUM_DAC_DMA_CHANNELS;
+
+	result = pthread_create(&interrupter, NULL, interrupt_thread, NULL);
+	if (result != 0) {
+		error(EXIT_FAILURE, result, "ERROR: Could not start a thread");
+	}
+	for (i = 0; i < num_threads; i++) {
+		result = pthread_create(&adio_threads[i], NULL, adio_thread,
+					(void *) (uintptr_t) i);
+		if (result == 0) {
+			result = pthread_create(&dma_threads[i], NULL,
+						dma_thread, (void *) (uintptr_t) i);
+		}
+		if (result == 0) {
+			result = pthread_create(&isr_threads[i], NULL,
+						isr_thread, (void *) (uintptr_t) i);
+		}
+		if (result == 0 && i < num_dac_threads) {
+			result = pthread_create(&dac_threads[i], NULL,
+						dac_thread, (void *) (uintptr_t) i);
+		}
+		if (result != 0) {
+			error(EXIT_FAILURE, result,
+			      "ERROR: Could not start a thread");
+		}
+	}
+
+	for (i = 0; i < num_threads; i++) {
+		pthread_join(adio_threads[i], NULL);
+		pthread_join(dma_threads[i], NULL);
+		pthread_join(isr_threads[i], NULL);
+		if (i < num_dac_threads) {
+			pthread_join(dac_threads[i], NULL);
+		}
+	}
+
+	/*
+	 * Every thread removes what it installs unless another thread got there
+	 * first, so nothing can be left installed
+	 */
+	if (DM35425_General_RemoveISR(handle) != -EFAULT) {
+		check_failed("An ISR was left installed", 0);
+	}
+	if (installs != removes) {
+		check_failed("Installs and removes differ",
+			     (long) installs - (long) removes);
+	}
+
+	__atomic_store_n(&finished, 1, __ATOMIC_RELEASE);
+	calls = __atomic_load_n(&isr_calls, __ATOMIC_RELAXED);
+	nap(20000);
+
+	__atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+	pthread_join(interrupter, NULL);
+
+	if (DM35425_Board_Close(handle) != 0) {
+		check_failed("Board close failed", errno);
+	}
+
+	printf("%lu ADIO threads x %lu updates, %lu DAC threads: %lu updates, %lu DMA threads: %lu buffers, %lu ISR threads: %lu installs, %lu ISR calls, %lu failures\n",
+	       num_threads, count, num_dac_threads, dac_updates, num_threads,
+	       dma_buffers, num_threads, installs, calls, failures);
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
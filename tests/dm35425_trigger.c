@@ -0,0 +1,381 @@
+/**
+    @file
+
+    @brief
+        Test of the software trigger's event queue.
+
+    @verbatim
+
+        The program is linked with -Wl,--wrap=DM35425_ADC_Multiboard_Add_Stage
+        (see the Makefile), so DM35425_Trigger_Add_Stage() hands the
+        trigger's processing stage to this program instead of an
+        acquisition.  The program then calls the stage with frames it makes
+        up, as the multiboard ISR would, and checks:
+
+            - that DM35425_Trigger_Get_Event() polling an empty queue fails
+              with EAGAIN, and that waiting on it fails with ETIMEDOUT after
+              the timeout and not before;
+
+            - that a consumer waiting in DM35425_Trigger_Get_Event() wakes
+              up when a frame completes a capture, and gets an event with
+              the trigger sample, windows and samples of the frames;
+
+            - that an event whose pre-trigger window reaches into buffers
+              the board lost has its gap flag set, and one without lost
+              buffers does not;
+
+            - that DM35425_Trigger_Release_Event() gives the event back, and
+              fails with ENODATA when there is none.
+
+        The program exits with a non-zero status if any check failed.
+
+    @endverbatim
+
+    @verbatim
+    --------------------------------------------------------------------------
+    This file and its contents are copyright (C) RTD Embedded Technologies,
+    Inc.  All Rights Reserved.
+
+    This software is licensed as described in the RTD End-User Software License
+    Agreement.  For a copy of this agreement, refer to the file LICENSE.TXT
+    (which should be included with this software) or contact RTD Embedded
+    Technologies, Inc.
+    --------------------------------------------------------------------------
+    @endverbatim
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <error.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "dm35425_adc_multiboard.h"
+#include "dm35425_adc_trigger.h"
+
+/**
+ * Channels of the made-up board.
+ */
+#define NUM_CHANNELS		2
+
+/**
+ * Samples per channel of each made-up frame.
+ */
+#define FRAME_SAMPLES		16
+
+/**
+ * Samples captured before and from the trigger.
+ */
+#define PRE_SAMPLES		4
+#define POST_SAMPLES		8
+
+/**
+ * Level of the trigger condition, and the code the frames have elsewhere.
+ */
+#define TRIGGER_LEVEL		1000
+#define QUIET_LEVEL		10
+
+/**
+ * How long the timed waits wait, in nanoseconds.
+ */
+#define WAIT_NS			200000000LL
+
+/**
+ * The trigger's processing stage and its context, as given to
+ * DM35425_ADC_Multiboard_Add_Stage().
+ */
+static DM35425_Multiboard_Stage stage;
+static void *stage_context;
+
+/**
+ * Number of failed checks.
+ */
+static unsigned long failures;
+
+/**
+*******************************************************************************
+@brief
+    DM35425_ADC_Multiboard_Add_Stage() of the trigger: keep the stage.
+ *******************************************************************************
+*/
+
+int __wrap_DM35425_ADC_Multiboard_Add_Stage(DM35425_Multiboard_Descriptor *mbd,
+					    DM35425_Multiboard_Stage new_stage,
+					    void *ctx)
+{
+	(void) mbd;
+
+	stage = new_stage;
+	stage_context = ctx;
+	return 0;
+}
+
+/**
+*******************************************************************************
+@brief
+    Report a failed check.
+ *******************************************************************************
+*/
+
+static void check_failed(const char *what, long value)
+{
+	failures++;
+	fprintf(stderr, "FAILED: %s (%ld)\n", what, value);
+}
+
+/**
+*******************************************************************************
+@brief
+    Current CLOCK_MONOTONIC time in nanoseconds.
+ *******************************************************************************
+*/
+
+static int64_t now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+*******************************************************************************
+@brief
+    Run the stage on a frame of the made-up board.  Channel 0 is quiet but
+    for sample trigger_at, which is at the trigger level, if it falls in the
+    frame; channel 1 holds the sample index.
+ *******************************************************************************
+*/
+
+static void feed_frame(uint64_t frame_number, uint64_t trigger_at)
+{
+	static int32_t samples[NUM_CHANNELS][FRAME_SAMPLES];
+	static int32_t *raw[NUM_CHANNELS] = { samples[0], samples[1] };
+	static const int channels[NUM_CHANNELS] = { 0, 1 };
+	static enum DM35425_Input_Ranges ranges[NUM_CHANNELS] = {
+		DM35425_ADC_RNG_BIPOLAR_10V, DM35425_ADC_RNG_BIPOLAR_10V
+	};
+	struct DM35425_ADCDMA_Readout readout;
+	uint64_t first_sample = frame_number * FRAME_SAMPLES;
+	int sample;
+
+	for (sample = 0; sample < FRAME_SAMPLES; sample++) {
+		samples[0][sample] = first_sample + sample == trigger_at ?
+				     TRIGGER_LEVEL : QUIET_LEVEL;
+		samples[1][sample] = (int32_t) (first_sample + sample);
+	}
+
+	memset(&readout, 0, sizeof(readout));
+	readout.num_channels = NUM_CHANNELS;
+	readout.channels = channels;
+	readout.num_samples = FRAME_SAMPLES;
+	readout.raw = raw;
+	readout.ranges = ranges;
+	readout.sequence = frame_number;
+	readout.first_sample = first_sample;
+	readout.timestamp_ns = (uint64_t) now_ns();
+	readout.decimation = 1;
+
+	stage(1, &readout, stage_context);
+}
+
+/**
+*******************************************************************************
+@brief
+    Check an event against a trigger at sample trigger_at.
+ *******************************************************************************
+*/
+
+static void check_event(const struct DM35425_Trigger_Event *event,
+			uint64_t trigger_at, int gap)
+{
+	const struct DM35425_Trigger_Capture *capture = &event->captures[0];
+	size_t sample;
+
+	if (event->trigger_sample != trigger_at) {
+		check_failed("Wrong trigger sample", (long) event->trigger_sample);
+	}
+	if (event->condition != 0) {
+		check_failed("Wrong condition", event->condition);
+	}
+	if (event->gap != gap) {
+		check_failed("Wrong gap flag", event->gap);
+	}
+	if (event->num_boards != 1 || capture->num_channels != NUM_CHANNELS) {
+		check_failed("Wrong capture shape", capture->num_channels);
+		return;
+	}
+	if (capture->pre_samples != PRE_SAMPLES ||
+	    capture->num_samples != PRE_SAMPLES + POST_SAMPLES ||
+	    capture->first_sample != trigger_at - PRE_SAMPLES) {
+		check_failed("Wrong capture window", (long) capture->first_sample);
+		return;
+	}
+	if (capture->raw[0][PRE_SAMPLES] != TRIGGER_LEVEL) {
+		check_failed("Trigger sample not at the trigger instant",
+			     capture->raw[0][PRE_SAMPLES]);
+	}
+
+	/*
+	 * Samples of lost buffers are stale, so only check the rest
+	 */
+	for (sample = gap ? PRE_SAMPLES : 0; sample < capture->num_samples;
+	     sample++) {
+		if (capture->raw[1][sample] !=
+		    (int32_t) (capture->first_sample + sample)) {
+			check_failed("Wrong sample in the capture",
+				     (long) sample);
+			break;
+		}
+	}
+}
+
+/**
+*******************************************************************************
+@brief
+    Consumer thread: wait for one event with a timeout, and return how long
+    it took, or -1 if none came.
+ *******************************************************************************
+*/
+
+static void *consumer_thread(void *arg)
+{
+	DM35425_Trigger *trigger = arg;
+	struct DM35425_Trigger_Event *event;
+	int64_t start = now_ns();
+
+	if (DM35425_Trigger_Get_Event(trigger, &event, 10 * WAIT_NS) != 0) {
+		check_failed("Waiting consumer got no event", errno);
+		return (void *) (intptr_t) -1;
+	}
+
+	return (void *) (intptr_t) (now_ns() - start);
+}
+
+int main(void)
+{
+	const struct DM35425_Trigger_Condition condition = {
+		.type = DM35425_TRIGGER_ABOVE,
+		.board = 0,
+		.channel = 0,
+		.level = TRIGGER_LEVEL,
+	};
+	const struct DM35425_Trigger_Config config = {
+		.num_conditions = 1,
+		.conditions = &condition,
+		.pre_samples = PRE_SAMPLES,
+		.post_samples = POST_SAMPLES,
+		.holdoff = 0,
+		.queue_depth = 2,
+	};
+	static char multiboard_placeholder;
+	DM35425_Trigger *trigger;
+	struct DM35425_Trigger_Event *event;
+	pthread_t consumer;
+	void *waited;
+	int64_t start, elapsed;
+	int result;
+
+	if (DM35425_Trigger_Create(&trigger, &config) != 0) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not create the trigger");
+	}
+	if (DM35425_Trigger_Add_Stage(
+		(DM35425_Multiboard_Descriptor *) &multiboard_placeholder,
+		trigger) != 0 || stage == NULL) {
+		error(EXIT_FAILURE, errno, "ERROR: Could not add the stage");
+	}
+
+	/*
+	 * Empty queue: polling fails at once, waiting after the timeout
+	 */
+	if (DM35425_Trigger_Get_Event(trigger, &event, 0) == 0 ||
+	    errno != EAGAIN) {
+		check_failed("Polling an empty queue did not fail with EAGAIN",
+			     errno);
+	}
+
+	start = now_ns();
+	result = DM35425_Trigger_Get_Event(trigger, &event, WAIT_NS);
+	elapsed = now_ns() - start;
+	if (result == 0 || errno != ETIMEDOUT) {
+		check_failed("Waiting on an empty queue did not time out", errno);
+	}
+	if (elapsed < WAIT_NS) {
+		check_failed("Wait timed out early (ns)", (long) elapsed);
+	}
+	if (elapsed > 5 * WAIT_NS) {
+		check_failed("Wait timed out late (ns)", (long) elapsed);
+	}
+
+	/*
+	 * A consumer waits while frames 0 to 2 arrive; the trigger at sample
+	 * 20 completes with frame 1, since its post-trigger window ends at 28
+	 */
+	result = pthread_create(&consumer, NULL, consumer_thread, trigger);
+	if (result != 0) {
+		error(EXIT_FAILURE, result, "ERROR: Could not start a thread");
+	}
+	nanosleep(&(struct timespec) { 0, WAIT_NS / 4 }, NULL);
+	feed_frame(0, 20);
+	feed_frame(1, 20);
+	feed_frame(2, 20);
+	pthread_join(consumer, &waited);
+	if ((intptr_t) waited >= 10 * WAIT_NS) {
+		check_failed("Waiting consumer did not wake up (ns)",
+			     (long) (intptr_t) waited);
+	}
+
+	if (DM35425_Trigger_Get_Event(trigger, &event, 0) != 0) {
+		check_failed("Published event not in the queue", errno);
+	} else {
+		check_event(event, 20, 0);
+		if (event->sequence != 0 || event->dropped != 0) {
+			check_failed("Wrong first event sequence",
+				     (long) event->sequence);
+		}
+	}
+	if (DM35425_Trigger_Release_Event(trigger) != 0) {
+		check_failed("Could not release the event", errno);
+	}
+	if (DM35425_Trigger_Release_Event(trigger) == 0 || errno != ENODATA) {
+		check_failed("Releasing with no event did not fail with ENODATA",
+			     errno);
+	}
+
+	/*
+	 * The board loses frames 3 and 4, and triggers at sample 81 of frame 5:
+	 * the pre-trigger window starts at 77, in the lost frame 4
+	 */
+	feed_frame(5, 81);
+	feed_frame(6, 81);
+	if (DM35425_Trigger_Get_Event(trigger, &event, WAIT_NS) != 0) {
+		check_failed("Event after lost frames not in the queue", errno);
+	} else {
+		check_event(event, 81, 1);
+		DM35425_Trigger_Release_Event(trigger);
+	}
+
+	/*
+	 * Contiguous again from frame 6 on: no gap at sample 120
+	 */
+	feed_frame(7, 120);
+	feed_frame(8, 120);
+	if (DM35425_Trigger_Get_Event(trigger, &event, WAIT_NS) != 0) {
+		check_failed("Event after the gap not in the queue", errno);
+	} else {
+		check_event(event, 120, 0);
+		DM35425_Trigger_Release_Event(trigger);
+	}
+
+	DM35425_Trigger_Destroy(trigger);
+
+	printf("Timed wait took %ld ms, consumer woke after %ld ms, %lu failures\n",
+	       (long) (elapsed / 1000000), (long) ((intptr_t) waited / 1000000),
+	       failures);
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}